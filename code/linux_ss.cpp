@@ -0,0 +1,869 @@
+#include "linux_ss.h"
+#include "ss_tools.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+internal void
+LinuxGetEXEFileName(LinuxState *state)
+{
+    ssize_t sizeOfFilename = readlink("/proc/self/exe", state->EXEFileName, sizeof(state->EXEFileName) - 1);
+    if (sizeOfFilename < 0)
+    {
+        sizeOfFilename = 0;
+    }
+    state->EXEFileName[sizeOfFilename] = 0;
+
+    state->OnePastLastEXEFileNameSlash = state->EXEFileName;
+    for (char *scan = state->EXEFileName; *scan; ++scan)
+    {
+        if (*scan == '/')
+        {
+            state->OnePastLastEXEFileNameSlash = scan + 1;
+        }
+    }
+}
+
+internal void
+LinuxBuildEXEPathFileName(LinuxState *state, char *fileName, int destCount, char *dest)
+{
+    CatStrings(state->OnePastLastEXEFileNameSlash - state->EXEFileName, state->EXEFileName,
+               StringLength(fileName), fileName, destCount, dest);
+}
+
+DEBUG_PLATFORM_FREE_FILE_MEMORY(DEBUGPlatformFreeFileMemory)
+{
+    if (memory)
+    {
+        // NOTE: The size is stashed in front of the block by DEBUGPlatformReadEntireFile.
+        u64 *block = (u64 *)memory - 2;
+        munmap(block, block[0]);
+    }
+}
+
+DEBUG_PLATFORM_READ_ENTIRE_FILE(DEBUGPlatformReadEntireFile)
+{
+    DebugReadFileResult result = {};
+
+    int fileHandle = open(filename, O_RDONLY);
+    if (fileHandle != -1)
+    {
+        struct stat fileStatus;
+        if (fstat(fileHandle, &fileStatus) == 0)
+        {
+            u32 fileSize32 = TruncateU64(fileStatus.st_size);
+            u64 blockSize = fileSize32 + 2 * sizeof(u64);
+            void *block = mmap(0, blockSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (block != MAP_FAILED)
+            {
+                ((u64 *)block)[0] = blockSize;
+                result.Contents = (u64 *)block + 2;
+
+                ssize_t bytesRead = read(fileHandle, result.Contents, fileSize32);
+                if (bytesRead == (ssize_t)fileSize32)
+                {
+                    // NOTE: File read successfully
+                    result.ContentsSize = fileSize32;
+                }
+                else
+                {
+                    // TODO: Logging
+                    DEBUGPlatformFreeFileMemory(thread, result.Contents);
+                    result.Contents = 0;
+                }
+            }
+            else
+            {
+                // TODO: Logging
+            }
+        }
+        else
+        {
+            // TODO: Logging
+        }
+
+        close(fileHandle);
+    }
+    else
+    {
+        // TODO: Logging
+    }
+
+    return result;
+}
+
+DEBUG_PLATFORM_WRITE_ENTIRE_FILE(DEBUGPlatformWriteEntireFile)
+{
+    b32 result = false;
+
+    int fileHandle = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fileHandle != -1)
+    {
+        ssize_t bytesWritten = write(fileHandle, memory, memorySize);
+        if (bytesWritten >= 0)
+        {
+            // NOTE: File written successfully
+            result = (bytesWritten == (ssize_t)memorySize);
+        }
+        else
+        {
+            // TODO: Logging
+        }
+
+        close(fileHandle);
+    }
+    else
+    {
+        // TODO: Logging
+    }
+
+    return result;
+}
+
+// NOTE: Also hashes the copied bytes (FNV-1a) into *hash when it is not 0.
+internal b32
+LinuxCopyFile(char *sourceFileName, char *destFileName, u64 *hash = 0)
+{
+    u64 hashValue = 14695981039346656037ULL;
+
+    b32 result = false;
+
+    int source = open(sourceFileName, O_RDONLY);
+    if (source != -1)
+    {
+        // NOTE: Unlink first so a still-mapped old copy keeps its inode
+        // instead of being truncated under the loader.
+        unlink(destFileName);
+        int dest = open(destFileName, O_WRONLY | O_CREAT | O_TRUNC, 0755);
+        if (dest != -1)
+        {
+            char buffer[64 * 1024];
+            ssize_t bytesRead;
+            result = true;
+            while ((bytesRead = read(source, buffer, sizeof(buffer))) > 0)
+            {
+                if (write(dest, buffer, bytesRead) != bytesRead)
+                {
+                    result = false;
+                    break;
+                }
+                for (ssize_t index = 0; index < bytesRead; ++index)
+                {
+                    hashValue ^= (u8)buffer[index];
+                    hashValue *= 1099511628211ULL;
+                }
+            }
+            if (bytesRead < 0)
+            {
+                result = false;
+            }
+            close(dest);
+        }
+        close(source);
+    }
+
+    if (hash)
+    {
+        *hash = result ? hashValue : 0;
+    }
+
+    return result;
+}
+
+internal LinuxAppCode
+LinuxLoadAppCode(char *sourceSOName, char *tempSOName)
+{
+    LinuxAppCode result = {};
+
+    if (LinuxCopyFile(sourceSOName, tempSOName, &result.CodeIdentity))
+    {
+        result.AppCodeSO = dlopen(tempSOName, RTLD_NOW | RTLD_LOCAL);
+    }
+
+    if (result.AppCodeSO)
+    {
+        result.Calculate = (CalculateType *)dlsym(result.AppCodeSO, "Calculate");
+
+        result.IsValid = (result.Calculate != 0);
+    }
+    else
+    {
+        // TODO: Logging
+        fprintf(stderr, "Unable to load %s: %s\n", sourceSOName, dlerror());
+    }
+
+    if (!result.IsValid)
+    {
+        result.Calculate = CalculateStub;
+    }
+
+    return result;
+}
+
+internal void
+LinuxUnloadAppCode(LinuxAppCode *appCode)
+{
+    if (appCode->AppCodeSO)
+    {
+        dlclose(appCode->AppCodeSO);
+        appCode->AppCodeSO = 0;
+    }
+
+    appCode->IsValid = false;
+    appCode->Calculate = CalculateStub;
+}
+
+// Watches the executable's directory: the compiler writes ss.so there,
+// and inotify wakes us the moment the new file is closed or renamed in.
+internal void
+LinuxWatchAppCode(LinuxState *state)
+{
+    char directory[LINUX_STATE_FILE_NAME_COUNT];
+    LinuxBuildEXEPathFileName(state, (char *)".", sizeof(directory), directory);
+
+    state->AppCodeWatch = inotify_init1(IN_CLOEXEC);
+    if (state->AppCodeWatch != -1)
+    {
+        if (inotify_add_watch(state->AppCodeWatch, directory, IN_CLOSE_WRITE | IN_MOVED_TO) == -1)
+        {
+            // TODO: Logging
+            close(state->AppCodeWatch);
+            state->AppCodeWatch = -1;
+        }
+    }
+}
+
+// Blocks (no polling) until a new version of soName has been written.
+internal b32
+LinuxWaitForAppCodeChange(LinuxState *state, char *soName)
+{
+    b32 result = false;
+
+    alignas(struct inotify_event) char buffer[4096];
+    while (!result)
+    {
+        ssize_t length = read(state->AppCodeWatch, buffer, sizeof(buffer));
+        if (length <= 0)
+        {
+            if ((length < 0) && (errno == EINTR))
+            {
+                continue;
+            }
+            break;
+        }
+
+        for (char *at = buffer; at < buffer + length;)
+        {
+            auto event = (struct inotify_event *)at;
+            if (event->len && (strcmp(event->name, soName) == 0))
+            {
+                result = true;
+            }
+            at += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    return result;
+}
+
+// Reserves the whole app memory block in one mapping. Explicit huge pages
+// (hugetlbfs) are tried first; without a reserved pool we fall back to normal
+// pages and ask for transparent huge pages instead. The huge page attempt
+// must not use MAP_NORESERVE: with an empty pool it would succeed and then
+// fault with SIGBUS on first touch.
+internal void *
+LinuxAllocateMemoryBlock(void *baseAddress, u64 totalSize, b32 *largePages)
+{
+    int fixedFlag = 0;
+#ifdef MAP_FIXED_NOREPLACE
+    if (baseAddress)
+    {
+        fixedFlag = MAP_FIXED_NOREPLACE;
+    }
+#endif
+
+    *largePages = false;
+
+    u64 hugePageSize = Megabytes(2);
+    u64 hugeSize = (totalSize + hugePageSize - 1) & ~(hugePageSize - 1);
+    void *result = mmap(baseAddress, hugeSize, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | fixedFlag, -1, 0);
+    if (result != MAP_FAILED)
+    {
+        *largePages = true;
+    }
+    else
+    {
+        result = mmap(baseAddress, totalSize, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | fixedFlag, -1, 0);
+        if (result != MAP_FAILED)
+        {
+            madvise(result, totalSize, MADV_HUGEPAGE);
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+internal void
+LinuxGetSnapshotFileName(LinuxState *state, i32 slotIndex, int destCount, char *dest)
+{
+    char temp[64];
+    snprintf(temp, sizeof(temp), "ss_snapshot_%d.sss", slotIndex);
+    LinuxBuildEXEPathFileName(state, temp, destCount, dest);
+}
+
+internal void
+LinuxBeginRecordingInput(LinuxState *state, i32 inputRecordingIndex)
+{
+    char fileName[LINUX_STATE_FILE_NAME_COUNT];
+    LinuxGetSnapshotFileName(state, inputRecordingIndex, sizeof(fileName), fileName);
+
+    state->RecordingHandle = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (state->RecordingHandle != -1)
+    {
+        state->InputRecordingIndex = inputRecordingIndex;
+    }
+    else
+    {
+        // TODO: Logging
+        fprintf(stderr, "Unable to create snapshot %s\n", fileName);
+    }
+}
+
+internal void
+LinuxEndRecordingInput(LinuxState *state)
+{
+    close(state->RecordingHandle);
+    state->RecordingHandle = -1;
+    state->InputRecordingIndex = 0;
+}
+
+// Writes the input set and the used part of permanent storage (the input
+// lives there) through a shared mapping of the snapshot file. Re-recording
+// truncates first, so stale bytes past the new data read back as zero.
+internal b32
+LinuxRecordSnapshot(LinuxState *state, AppMemory *memory)
+{
+    b32 result = false;
+
+    u64 dataSize = (memory->PermanentStorageUsed + SNAPSHOT_DATA_ALIGNMENT - 1) & ~(SNAPSHOT_DATA_ALIGNMENT - 1);
+    if (dataSize > memory->PermanentStorageSize)
+    {
+        dataSize = memory->PermanentStorageSize;
+    }
+    u64 fileSize = SNAPSHOT_DATA_OFFSET + dataSize;
+
+    int file = state->RecordingHandle;
+    if ((ftruncate(file, 0) == 0) && (ftruncate(file, fileSize) == 0))
+    {
+        void *view = mmap(0, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        if (view != MAP_FAILED)
+        {
+            auto header = (SnapshotHeader *)view;
+            header->Magic = SNAPSHOT_MAGIC;
+            header->HeaderSize = sizeof(SnapshotHeader);
+            header->BaseAddress = (u64)state->AppMemoryBlock;
+            header->PermanentStorageSize = memory->PermanentStorageSize;
+            header->TransientStorageSize = memory->TransientStorageSize;
+            header->DataSize = dataSize;
+
+            // NOTE: Only the used bytes are copied; the rest of the data stays a hole.
+            memcpy((u8 *)view + SNAPSHOT_DATA_OFFSET, memory->PermanentStorage, memory->PermanentStorageUsed);
+
+            munmap(view, fileSize);
+            result = true;
+        }
+    }
+
+    if (!result)
+    {
+        // TODO: Logging
+        fprintf(stderr, "Unable to write snapshot %d\n", state->InputRecordingIndex);
+    }
+
+    return result;
+}
+
+// Opens a snapshot and reads its header; the caller has to allocate the app
+// memory block at header->BaseAddress before LinuxBeginInputPlayBack.
+internal b32
+LinuxOpenSnapshot(LinuxState *state, i32 inputPlayingIndex, SnapshotHeader *header)
+{
+    b32 result = false;
+
+    char fileName[LINUX_STATE_FILE_NAME_COUNT];
+    LinuxGetSnapshotFileName(state, inputPlayingIndex, sizeof(fileName), fileName);
+
+    state->PlaybackHandle = open(fileName, O_RDONLY);
+    if (state->PlaybackHandle != -1)
+    {
+        struct stat fileStatus;
+        if ((pread(state->PlaybackHandle, header, sizeof(*header), 0) == sizeof(*header)) &&
+            (header->Magic == SNAPSHOT_MAGIC) &&
+            (header->HeaderSize == sizeof(SnapshotHeader)) &&
+            (fstat(state->PlaybackHandle, &fileStatus) == 0) &&
+            ((u64)fileStatus.st_size >= SNAPSHOT_DATA_OFFSET + header->DataSize))
+        {
+            state->InputPlayingIndex = inputPlayingIndex;
+            result = true;
+        }
+        else
+        {
+            close(state->PlaybackHandle);
+            state->PlaybackHandle = -1;
+        }
+    }
+
+    if (!result)
+    {
+        // TODO: Logging
+        fprintf(stderr, "Unable to open snapshot %s\n", fileName);
+    }
+
+    return result;
+}
+
+// Restores permanent storage with a single private mapping of the snapshot
+// over the start of the block: pages are faulted in from the page cache on
+// first touch and copied on write, the file itself is never modified.
+internal b32
+LinuxBeginInputPlayBack(LinuxState *state, AppMemory *memory, SnapshotHeader *header)
+{
+    b32 result = false;
+
+    if ((header->BaseAddress == (u64)state->AppMemoryBlock) &&
+        (header->PermanentStorageSize == memory->PermanentStorageSize) &&
+        (header->DataSize <= memory->PermanentStorageSize))
+    {
+        void *mapped = mmap(state->AppMemoryBlock, header->DataSize, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_FIXED, state->PlaybackHandle, SNAPSHOT_DATA_OFFSET);
+        result = (mapped == state->AppMemoryBlock);
+    }
+
+    if (result)
+    {
+        memory->IsInitialized = true;
+        memory->PlayingBack = true;
+    }
+    else
+    {
+        // TODO: Logging
+        fprintf(stderr, "Snapshot %d does not fit this app memory layout\n", state->InputPlayingIndex);
+    }
+
+    return result;
+}
+
+internal void
+LinuxEndInputPlayBack(LinuxState *state)
+{
+    // NOTE: The mapping keeps its own reference to the file.
+    close(state->PlaybackHandle);
+    state->PlaybackHandle = -1;
+    state->InputPlayingIndex = 0;
+}
+
+// Maps the fuel library read-only; records are used in place, so pages are
+// only read from the page cache as fuels are touched.
+internal b32
+LinuxMapFuelLibrary(char *fileName, AppMemory *memory)
+{
+    b32 result = false;
+
+    int file = open(fileName, O_RDONLY);
+    if (file != -1)
+    {
+        struct stat fileStatus;
+        if ((fstat(file, &fileStatus) == 0) && (fileStatus.st_size > 0))
+        {
+            void *view = mmap(0, fileStatus.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+            if (view != MAP_FAILED)
+            {
+                memory->FuelLibrary = view;
+                memory->FuelLibrarySize = fileStatus.st_size;
+                result = true;
+            }
+        }
+
+        // NOTE: The mapping keeps its own reference to the file.
+        close(file);
+    }
+
+    return result;
+}
+
+// NOTE: The context of the pool worker (or of the main thread) running on
+// this thread, so entries run by AddEntry and CompleteAllWork on the caller's
+// thread get the caller's context.
+global thread_local ThreadContext *LinuxCurrentThread;
+global ThreadContext LinuxMainThread;
+
+// Takes and runs one entry; false if the queue was empty.
+internal b32
+LinuxDoNextWorkQueueEntry(PlatformWorkQueue *queue)
+{
+    u64 position = queue->NextEntryToRead.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        LinuxWorkQueueEntry *entry = queue->Entries + (position & (LINUX_WORK_QUEUE_SIZE - 1));
+        u64 sequence = entry->Sequence.load(std::memory_order_acquire);
+        i64 difference = (i64)(sequence - (position + 1));
+        if (difference == 0)
+        {
+            if (queue->NextEntryToRead.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                PlatformWorkQueueCallback *callback = entry->Callback;
+                void *data = entry->Data;
+                entry->Sequence.store(position + LINUX_WORK_QUEUE_SIZE, std::memory_order_release);
+
+                ThreadContext *thread = LinuxCurrentThread ? LinuxCurrentThread : &LinuxMainThread;
+                callback(thread, queue, data);
+                ++queue->CompletionCount;
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            return false;
+        }
+        else
+        {
+            position = queue->NextEntryToRead.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+internal PLATFORM_ADD_ENTRY(LinuxAddEntry)
+{
+    ++queue->CompletionGoal;
+
+    u64 position = queue->NextEntryToWrite.load(std::memory_order_relaxed);
+    LinuxWorkQueueEntry *entry;
+    for (;;)
+    {
+        entry = queue->Entries + (position & (LINUX_WORK_QUEUE_SIZE - 1));
+        u64 sequence = entry->Sequence.load(std::memory_order_acquire);
+        i64 difference = (i64)(sequence - position);
+        if (difference == 0)
+        {
+            if (queue->NextEntryToWrite.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            // NOTE: Full; make room by doing an entry here rather than wait
+            // (with no workers nobody else would).
+            LinuxDoNextWorkQueueEntry(queue);
+            position = queue->NextEntryToWrite.load(std::memory_order_relaxed);
+        }
+        else
+        {
+            position = queue->NextEntryToWrite.load(std::memory_order_relaxed);
+        }
+    }
+
+    entry->Callback = callback;
+    entry->Data = data;
+    entry->Sequence.store(position + 1, std::memory_order_release);
+
+    sem_post(&queue->Semaphore);
+}
+
+internal PLATFORM_COMPLETE_ALL_WORK(LinuxCompleteAllWork)
+{
+    for (;;)
+    {
+        // NOTE: Count first: Count never passes Goal, so equal values mean
+        // that at the moment Count was read everything added was done.
+        u64 count = queue->CompletionCount;
+        if (count == queue->CompletionGoal)
+        {
+            break;
+        }
+        if (!LinuxDoNextWorkQueueEntry(queue))
+        {
+            _mm_pause();
+        }
+    }
+}
+
+internal void *
+LinuxWorkerThreadProc(void *parameter)
+{
+    auto startup = (LinuxWorkerStartup *)parameter;
+    LinuxCurrentThread = &startup->Context;
+
+    PlatformWorkQueue *queue = startup->Queue;
+    for (;;)
+    {
+        if (!LinuxDoNextWorkQueueEntry(queue))
+        {
+            // NOTE: Every entry posts once, so a post between the failed take
+            // and this wait is not lost; extra posts only cost a spurious wake.
+            while ((sem_wait(&queue->Semaphore) == -1) && (errno == EINTR))
+            {
+            }
+        }
+    }
+
+    return 0;
+}
+
+// Starts up to workerCount workers; the main thread works in CompleteAllWork.
+// Returns the number of threads running entries, main included, 0 on failure.
+internal u32
+LinuxMakeWorkQueue(PlatformWorkQueue *queue, LinuxWorkerStartup *startups, u32 workerCount)
+{
+    queue->NextEntryToWrite = 0;
+    queue->NextEntryToRead = 0;
+    queue->CompletionGoal = 0;
+    queue->CompletionCount = 0;
+    for (u32 index = 0; index < LINUX_WORK_QUEUE_SIZE; ++index)
+    {
+        queue->Entries[index].Sequence = index;
+    }
+    if (sem_init(&queue->Semaphore, 0, 0) != 0)
+    {
+        return 0;
+    }
+
+    LinuxCurrentThread = &LinuxMainThread;
+    u32 result = 1;
+    for (u32 workerIndex = 0; workerIndex < workerCount; ++workerIndex)
+    {
+        LinuxWorkerStartup *startup = startups + workerIndex;
+        startup->Context.ThreadIndex = workerIndex + 1;
+        startup->Queue = queue;
+
+        pthread_t threadHandle;
+        if (pthread_create(&threadHandle, 0, LinuxWorkerThreadProc, startup) != 0)
+        {
+            // NOTE: Entries still get done by whoever waits for them.
+            break;
+        }
+        pthread_detach(threadHandle);
+        ++result;
+    }
+
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    LinuxState linuxState = {};
+    LinuxGetEXEFileName(&linuxState);
+
+    char sourceAppCodeSOFullPath[LINUX_STATE_FILE_NAME_COUNT];
+    LinuxBuildEXEPathFileName(&linuxState, (char *)"ss.so",
+                              sizeof(sourceAppCodeSOFullPath), sourceAppCodeSOFullPath);
+
+    char tempAppCodeSOFullPath[LINUX_STATE_FILE_NAME_COUNT];
+    LinuxBuildEXEPathFileName(&linuxState, (char *)"ss_temp.so",
+                              sizeof(tempAppCodeSOFullPath), tempAppCodeSOFullPath);
+
+    linuxState.RecordingHandle = -1;
+    linuxState.PlaybackHandle = -1;
+
+    b32 watch = false;
+    i32 recordIndex = 0;
+    i32 playIndex = 0;
+    u32 reportFormat = ReportFormat_Table;
+    b32 reportSweep = false;
+    u32 mathMode = EDITOR_FAST_MATH ? MathMode_Fast : MathMode_Reference;
+    char *fuelLibraryFileName = 0;
+    for (int argIndex = 1; argIndex < argc; ++argIndex)
+    {
+        if (strcmp(argv[argIndex], "-watch") == 0)
+        {
+            watch = true;
+        }
+        else if ((strcmp(argv[argIndex], "-record") == 0) && (argIndex + 1 < argc))
+        {
+            recordIndex = atoi(argv[++argIndex]);
+        }
+        else if ((strcmp(argv[argIndex], "-play") == 0) && (argIndex + 1 < argc))
+        {
+            playIndex = atoi(argv[++argIndex]);
+        }
+        else if ((strcmp(argv[argIndex], "-format") == 0) && (argIndex + 1 < argc))
+        {
+            char *format = argv[++argIndex];
+            if (strcmp(format, "csv") == 0)
+            {
+                reportFormat = ReportFormat_CSV;
+            }
+            else if (strcmp(format, "binary") == 0)
+            {
+                reportFormat = ReportFormat_Binary;
+            }
+            else
+            {
+                reportFormat = ReportFormat_Table;
+            }
+        }
+        else if (strcmp(argv[argIndex], "-rows") == 0)
+        {
+            reportSweep = true;
+        }
+        else if ((strcmp(argv[argIndex], "-math") == 0) && (argIndex + 1 < argc))
+        {
+            char *mode = argv[++argIndex];
+            mathMode = (strcmp(mode, "fast") == 0) ? MathMode_Fast : MathMode_Reference;
+        }
+        else if ((strcmp(argv[argIndex], "-fuels") == 0) && (argIndex + 1 < argc))
+        {
+            fuelLibraryFileName = argv[++argIndex];
+        }
+    }
+
+    if (watch)
+    {
+        // NOTE: Start watching before the first load so a rebuild that
+        // lands while Calculate runs is not missed.
+        LinuxWatchAppCode(&linuxState);
+    }
+
+#if EDITOR_INTERNAL
+    void *baseAddress = (void *)Terabytes(2);
+#else
+    void *baseAddress = 0;
+#endif
+
+    // NOTE: A snapshot stores raw pointers, so the block has to live where
+    // it lived when the snapshot was recorded.
+    SnapshotHeader snapshotHeader = {};
+    if (playIndex)
+    {
+        if (!LinuxOpenSnapshot(&linuxState, playIndex, &snapshotHeader))
+        {
+            return 1;
+        }
+        baseAddress = (void *)snapshotHeader.BaseAddress;
+    }
+
+    AppMemory appMemory = {};
+    appMemory.PermanentStorageSize = Megabytes(64);
+    appMemory.TransientStorageSize = Gigabytes(1);
+    appMemory.ReportFormat = reportFormat;
+    appMemory.ReportSweep = reportSweep;
+    appMemory.MathMode = mathMode;
+
+    // NOTE: Without -fuels the library next to the executable is optional.
+    if (fuelLibraryFileName)
+    {
+        if (!LinuxMapFuelLibrary(fuelLibraryFileName, &appMemory))
+        {
+            fprintf(stderr, "Unable to map fuel library %s\n", fuelLibraryFileName);
+            return 1;
+        }
+    }
+    else
+    {
+        char defaultFuelLibraryFileName[LINUX_STATE_FILE_NAME_COUNT];
+        LinuxBuildEXEPathFileName(&linuxState, (char *)"fuels.ssf",
+                                  sizeof(defaultFuelLibraryFileName), defaultFuelLibraryFileName);
+        LinuxMapFuelLibrary(defaultFuelLibraryFileName, &appMemory);
+    }
+
+    linuxState.TotalSize = appMemory.PermanentStorageSize + appMemory.TransientStorageSize;
+    linuxState.AppMemoryBlock = LinuxAllocateMemoryBlock(baseAddress, linuxState.TotalSize, &appMemory.LargePages);
+    if (!linuxState.AppMemoryBlock)
+    {
+        fprintf(stderr, "Unable to allocate %llu MB of app memory\n",
+                (unsigned long long)ToMegabytes(linuxState.TotalSize));
+        return 1;
+    }
+
+    appMemory.PermanentStorage = linuxState.AppMemoryBlock;
+    appMemory.TransientStorage = ((u8 *)appMemory.PermanentStorage + appMemory.PermanentStorageSize);
+
+    if (linuxState.InputPlayingIndex)
+    {
+        if (!LinuxBeginInputPlayBack(&linuxState, &appMemory, &snapshotHeader))
+        {
+            return 1;
+        }
+        LinuxEndInputPlayBack(&linuxState);
+    }
+
+    if (recordIndex)
+    {
+        LinuxBeginRecordingInput(&linuxState, recordIndex);
+    }
+
+#if EDITOR_PROFILE
+    // NOTE: Static, so a code reload does not lose it; zero until the first timed block.
+    local DebugCounterTable debugTable;
+    debugTable.Generation = 1;
+    appMemory.DebugTable = &debugTable;
+#endif
+
+    // NOTE: Created once; the pool and its threads outlive every code reload.
+    local PlatformWorkQueue workQueue;
+    local LinuxWorkerStartup workerStartups[LINUX_MAX_WORKER_THREADS];
+    long coreCount = sysconf(_SC_NPROCESSORS_ONLN);
+    u32 workerCount = (u32)LimitI((coreCount > 0) ? (coreCount - 1) : 0, 0, LINUX_MAX_WORKER_THREADS);
+    u32 poolThreadCount = LinuxMakeWorkQueue(&workQueue, workerStartups, workerCount);
+    if (poolThreadCount)
+    {
+        appMemory.Platform.WorkQueue = &workQueue;
+        appMemory.Platform.ThreadCount = poolThreadCount;
+        appMemory.Platform.AddEntry = LinuxAddEntry;
+        appMemory.Platform.CompleteAllWork = LinuxCompleteAllWork;
+    }
+
+    ThreadContext *thread = &LinuxMainThread;
+
+    auto app = LinuxLoadAppCode(sourceAppCodeSOFullPath, tempAppCodeSOFullPath);
+    appMemory.CodeIdentity = app.CodeIdentity;
+
+    app.Calculate(thread, &appMemory);
+#if EDITOR_PROFILE
+    ReportDebugCounters(appMemory.DebugTable, stderr);
+#endif
+    if (linuxState.InputRecordingIndex)
+    {
+        LinuxRecordSnapshot(&linuxState, &appMemory);
+    }
+
+    if (watch && (linuxState.AppCodeWatch != -1))
+    {
+        while (LinuxWaitForAppCodeChange(&linuxState, (char *)"ss.so"))
+        {
+            LinuxUnloadAppCode(&app);
+            app = LinuxLoadAppCode(sourceAppCodeSOFullPath, tempAppCodeSOFullPath);
+            appMemory.CodeIdentity = app.CodeIdentity;
+
+            app.Calculate(thread, &appMemory);
+#if EDITOR_PROFILE
+            ReportDebugCounters(appMemory.DebugTable, stderr);
+#endif
+            if (linuxState.InputRecordingIndex)
+            {
+                LinuxRecordSnapshot(&linuxState, &appMemory);
+            }
+            fflush(stdout);
+        }
+    }
+
+    if (linuxState.InputRecordingIndex)
+    {
+        LinuxEndRecordingInput(&linuxState);
+    }
+
+    return 0;
+}
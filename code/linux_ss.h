@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ss.h"
+
+#include <dlfcn.h>
+#include <limits.h>
+#include <semaphore.h>
+#include <sys/types.h>
+
+#define LINUX_STATE_FILE_NAME_COUNT PATH_MAX
+struct LinuxState
+{
+    u64 TotalSize;
+    void *AppMemoryBlock;
+
+    int RecordingHandle;
+    i32 InputRecordingIndex;
+
+    int PlaybackHandle;
+    i32 InputPlayingIndex;
+
+    char EXEFileName[LINUX_STATE_FILE_NAME_COUNT];
+    char *OnePastLastEXEFileNameSlash;
+
+    int AppCodeWatch; // inotify descriptor watching the executable's directory
+};
+
+struct LinuxAppCode
+{
+    void *AppCodeSO;
+    u64 CodeIdentity; // FNV-1a of the loaded image
+
+    CalculateType *Calculate;
+
+    b32 IsValid;
+};
+
+// NOTE: Bounded MPMC ring (D. Vyukov): every slot carries a sequence number
+// that tells producers and consumers whose turn it is, so adding and taking
+// an entry is one compare-exchange on the shared position plus a store to
+// the slot. The semaphore only puts idle workers to sleep.
+#define LINUX_WORK_QUEUE_SIZE 256 // NOTE: Must be a power of two
+#define LINUX_MAX_WORKER_THREADS 63
+
+struct LinuxWorkQueueEntry
+{
+    std::atomic<u64> Sequence;
+    PlatformWorkQueueCallback *Callback;
+    void *Data;
+};
+
+struct PlatformWorkQueue
+{
+    alignas(64) std::atomic<u64> NextEntryToWrite;
+    alignas(64) std::atomic<u64> NextEntryToRead;
+
+    // NOTE: Goal is bumped before an entry is published, Count after its
+    // callback returns, so Count == Goal means everything added is done.
+    alignas(64) std::atomic<u64> CompletionGoal;
+    std::atomic<u64> CompletionCount;
+
+    sem_t Semaphore;
+
+    LinuxWorkQueueEntry Entries[LINUX_WORK_QUEUE_SIZE];
+};
+
+struct LinuxWorkerStartup
+{
+    ThreadContext Context;
+    PlatformWorkQueue *Queue;
+};
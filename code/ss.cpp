@@ -1,16 +1,43 @@
 #include "ss.h"
 
 #include "ss_boiler.cpp"
+#include "ss_boiler_dual.cpp"
 #include "ss_gear.cpp"
+#include "ss_boiler_wide.cpp"
+#include "ss_firetube.cpp"
+#include "ss_gaspath.cpp"
+#include "ss_fuel.cpp"
+#include "ss_batch.cpp"
+#include "ss_batch_f32.cpp"
+#include "ss_graph.cpp"
+#include "ss_sweep.cpp"
+#include "ss_sweep_cache.cpp"
+#include "ss_inverse.cpp"
+#include "ss_draft.cpp"
+#include "ss_traction.cpp"
+#include "ss_fleet.cpp"
+#include "ss_optimize.cpp"
+#include "ss_montecarlo.cpp"
+#include "ss_report.cpp"
+#include "ss_stage_cache.cpp"
 
-extern "C" CALCULATE(Calculate)
+// Входные данные по умолчанию: расчетный котел и перебор вокруг него.
+// library - отображенная библиотека топлив, 0 - ее нет.
+internal void
+SetDefaultInput(CalculationInput *input, FuelLibrary *library)
 {
+    ZeroStruct(*input);
+
+    // NOTE: While working on one stage, leave only its bit here: the next
+    // code reload then reruns just that stage (the design point always runs).
+    // Add CalculationStage_SweepF32 to also time the f32 screen of the sweep.
+    input->Stages = CalculationStage_All;
+
     const f64 U = 550.0; // напряжение колосниковой решетки
 
     const f64 t = 0.0; // температура окружающего воздуха °C
-    const f64 v = 0.0; // скорость км/ч
 
-    const f64 q22 = 36.0; // суммарная потеря от уноса, шлака и провала угля в %
+    f64 q22 = 36.0; // суммарная потеря от уноса, шлака и провала угля в %
     const f64 tk = 190.0;
 
     FireChamber fireChamber = {};
@@ -36,7 +63,6 @@ extern "C" CALCULATE(Calculate)
     */
 
     fireChamber.U = 550;
-    CalculateFireChamber(fireChamber);
 
     //const f64 R = 2.8;       // площадь колосниковой решетки
     //const f64 Ht = 15.6;     // поверхность нагрева огневой коробки
@@ -45,47 +71,292 @@ extern "C" CALCULATE(Calculate)
     dd.DOut = MillimeterToMeter(51.0);
     dd.DIn = MillimeterToMeter(46.0);
 
-    const f64 Ld = MillimeterToMeter(4550); // длина труб дымогарных
-    const u16 nd = 210;                     // число дымогарных труб
+    f64 Ld = MillimeterToMeter(4550); // длина труб дымогарных
+    u16 nd = 210;                     // число дымогарных труб
 
-    auto Hd = GetHPipes(dd, nd, Ld);
+    // топливо из библиотеки: по имени, если оно задано, иначе по Id; без
+    // библиотеки или без такой записи - встроенное расчетное (CalculateFuel)
+    const u32 fuelId = 1; // Расчетный уголь
+    const char *fuelName = "";
 
     Fuel fuel = {};
     CalculateFuel(fuel);
+    FuelRecord *fuelRecord = FindFuel(library, fuelId, fuelName);
+    if (fuelRecord)
+    {
+        fuel = fuelRecord->Composition;
+        input->FuelId = fuelRecord->Id;
+        memcpy(input->FuelName, fuelRecord->Name, sizeof(input->FuelName));
+    }
 
-    auto Bh = GetBh(fireChamber);                    // сжигаемое топливо в час (кг)
-    auto BhFact = GetBhFact(fireChamber, q22, fuel); // фактически сжигаемое топливо в час (кг)
+    input->Chamber = fireChamber;
+    input->Dd = dd;
+    input->Ld = Ld;
+    input->Nd = nd;
+    input->q22 = q22;
+    input->t = t;
+    input->tk = tk;
+    input->BaseFuel = fuel;
 
-    HeatCoefficient heatCoefficient = {};
-    GetHeatCoefficient(heatCoefficient, fuel, BhFact);
+    // тот же котел с пароперегревателем: часть дымогарных труб заменена
+    // жаровыми трубами с элементами перегревателя
+    Boiler *superheated = &input->Superheated;
+    superheated->Ld = Ld;
+    superheated->Nd = 130;
+    superheated->Dd = dd;
+    superheated->Nz = 24;
+    superheated->Lz1 = MillimeterToMeter(550);
+    superheated->Lz2 = Ld - superheated->Lz1;
+    superheated->Dz1.DOut = MillimeterToMeter(133.0);
+    superheated->Dz1.DIn = MillimeterToMeter(125.0);
+    superheated->Dz2 = superheated->Dz1;
+    superheated->Di.DOut = MillimeterToMeter(38.0);
+    superheated->Di.DIn = MillimeterToMeter(31.0);
+    superheated->Hi = 52.0;
+    input->ti = 300.0;
 
-    auto Q0 = GetQ0(Bh, t, fuel, heatCoefficient);
-    auto Q21 = GetQ21(BhFact, fuel);
-    auto Q22 = GetQ22(Q0, q22);
+    // тяга: решетка, трубы и конус расчетного котла; конус подобран так, чтобы
+    // тяги хватало на напряжение решетки около расчетного
+    DraftSpec *draft = &input->Draft;
+    draft->UMin = 100.0;
+    draft->UMax = 1200.0;
+    draft->ChimneyDraft = 5.0;
+    draft->BlastCoefficient = 15.0;
+    draft->BlastExponent = 1.0;
+    draft->GrateResistance = 300.0;
+    draft->TubeFriction = 0.025;
+    draft->TubeEntryExit = 1.5;
+    draft->SteamEnthalpy = 666.0;
+    draft->FeedT = 20.0;
 
-    auto T1 = GetT1(Q0, Q21, Q22, BhFact, fuel, heatCoefficient);
-    auto T2 = GetT2(BhFact, fireChamber.Ht, fuel);
+    // паровоз с расчетным котлом и движение по участку
+    Locomotive *locomotive = &input->Engine;
+    locomotive->CylinderD = 65.0;
+    locomotive->Stroke = 70.0;
+    locomotive->Pressure = 14.0;
+    locomotive->WheelD = 132.0;
+    locomotive->AdhesionMass = 82.0;
+    locomotive->Mass = 150.0;
+    locomotive->SteamRate = 9.5;
+    locomotive->H0 = 60.0;
+    locomotive->Phi = 0.9;
 
-    //auto Q4 = GetQ4(.4, 51.9, v, t);
-    auto Q4 = GetQ4(Q0, 1); // 1% потерь от Q0
+    TractionSpec *traction = &input->Traction;
+    traction->Dt = 1.0;
+    traction->MaxTime = 4.0 * 3600.0;
+    traction->UIdle = 150.0;
+    traction->UMax = U;
+    traction->FiringLag = 120.0;
+    traction->Adhesion = 0.22;
+    traction->ResistanceA = 1.0;
+    traction->ResistanceB = 0.01;
+    traction->ResistanceC = 0.0003;
+    traction->Rotating = 0.06;
+    traction->Brake = 0.3;
+    traction->SteamEnthalpy = draft->SteamEnthalpy;
+    traction->FeedT = draft->FeedT;
+    traction->tk = tk;
 
-    auto L0 = GetL0(fuel); // теоретический расход воздуха для сжигания 1 кг топлива
+    // перебор вокруг расчетного котла: длина и число дымогарных труб,
+    // длина и ширина огневой коробки
+    SweepSpec *sweep = &input->Sweep;
+    sweep->Ranges[SweepParameter_TopLengh] = {MillimeterToMeter(2000), MillimeterToMeter(2600), 8};
+    sweep->Ranges[SweepParameter_TopWidth] = {fireChamber.TopWidth, fireChamber.TopWidth, 1};
+    sweep->Ranges[SweepParameter_BottomLength] = {fireChamber.BottomLength, fireChamber.BottomLength, 1};
+    sweep->Ranges[SweepParameter_BottomWidth] = {MillimeterToMeter(900), MillimeterToMeter(1200), 8};
+    sweep->Ranges[SweepParameter_FrontHeight] = {fireChamber.FrontHeight, fireChamber.FrontHeight, 1};
+    sweep->Ranges[SweepParameter_RearHeight] = {fireChamber.RearHeight, fireChamber.RearHeight, 1};
+    sweep->Ranges[SweepParameter_DOut] = {dd.DOut, dd.DOut, 1};
+    sweep->Ranges[SweepParameter_DIn] = {dd.DIn, dd.DIn, 1};
+    sweep->Ranges[SweepParameter_Ld] = {MillimeterToMeter(3500), MillimeterToMeter(5500), 64};
+    sweep->Ranges[SweepParameter_Nd] = {150, 260, 64};
+    sweep->Ranges[SweepParameter_U] = {fireChamber.U, fireChamber.U, 1};
+    sweep->Ranges[SweepParameter_q22] = {q22, q22, 1};
+    sweep->BaseFuel = fuel;
+    sweep->t = t;
 
-    printf("Коэффициент избытка топлива alpha\t\t%.2lf\n", fuel.alpha);
-    printf("Химическая характеристика топлива b0 \t\t%.2lf\n", fuel.beta0);
+    // оптимизация: огневая коробка и дымогарные трубы с минимальной потерей
+    // тепла с уходящими газами (в долях Q0) при заданной решетке, скорости
+    // газов и поверхности нагрева не больше расчетной
+    OptimizeSpec *optimize = &input->Optimize;
+    for (u32 parameter = 0; parameter < SweepParameter_Count; ++parameter)
+    {
+        optimize->Min[parameter] = optimize->Max[parameter] = sweep->Ranges[parameter].Min;
+    }
+    optimize->Min[SweepParameter_TopLengh] = MillimeterToMeter(1800);
+    optimize->Max[SweepParameter_TopLengh] = MillimeterToMeter(2800);
+    optimize->Min[SweepParameter_TopWidth] = MillimeterToMeter(1100);
+    optimize->Max[SweepParameter_TopWidth] = MillimeterToMeter(1500);
+    optimize->Min[SweepParameter_BottomLength] = MillimeterToMeter(1800);
+    optimize->Max[SweepParameter_BottomLength] = MillimeterToMeter(2900);
+    optimize->Min[SweepParameter_BottomWidth] = MillimeterToMeter(900);
+    optimize->Max[SweepParameter_BottomWidth] = MillimeterToMeter(1300);
+    optimize->Min[SweepParameter_FrontHeight] = MillimeterToMeter(1500);
+    optimize->Max[SweepParameter_FrontHeight] = MillimeterToMeter(2000);
+    optimize->Min[SweepParameter_RearHeight] = MillimeterToMeter(1400);
+    optimize->Max[SweepParameter_RearHeight] = MillimeterToMeter(1900);
+    optimize->Min[SweepParameter_DOut] = MillimeterToMeter(44.5);
+    optimize->Max[SweepParameter_DOut] = MillimeterToMeter(57.0);
+    optimize->Min[SweepParameter_DIn] = MillimeterToMeter(39.0);
+    optimize->Max[SweepParameter_DIn] = MillimeterToMeter(53.0);
+    optimize->Min[SweepParameter_Ld] = MillimeterToMeter(3500);
+    optimize->Max[SweepParameter_Ld] = MillimeterToMeter(5500);
+    optimize->Min[SweepParameter_Nd] = 150;
+    optimize->Max[SweepParameter_Nd] = 260;
 
-    /*
-    printf("Коэффициент уравнения тепла M \t\t\t%.2lf\n", heatCoefficient.M);
-    printf("Коэффициент уравнения тепла N \t\t\t%.5lf\n", heatCoefficient.N);
-    */
+    optimize->Start[SweepParameter_TopLengh] = fireChamber.TopLengh;
+    optimize->Start[SweepParameter_TopWidth] = fireChamber.TopWidth;
+    optimize->Start[SweepParameter_BottomLength] = fireChamber.BottomLength;
+    optimize->Start[SweepParameter_BottomWidth] = fireChamber.BottomWidth;
+    optimize->Start[SweepParameter_FrontHeight] = fireChamber.FrontHeight;
+    optimize->Start[SweepParameter_RearHeight] = fireChamber.RearHeight;
+    optimize->Start[SweepParameter_DOut] = dd.DOut;
+    optimize->Start[SweepParameter_DIn] = dd.DIn;
+    optimize->Start[SweepParameter_Ld] = Ld;
+    optimize->Start[SweepParameter_Nd] = nd;
+
+    optimize->BaseFuel = fuel;
+    optimize->t = t;
+    optimize->Weights[OptimizeQuantity_Q3] = 1.0;
+    optimize->PerQ0 = true;
+
+    optimize->Constraints[optimize->ConstraintCount++] = {OptimizeQuantity_R, 2.2, 2.6};
+    optimize->Constraints[optimize->ConstraintCount++] = {OptimizeQuantity_Omega, -HUGE_VAL, 6000.0};
+    optimize->Constraints[optimize->ConstraintCount++] = {OptimizeQuantity_Hi, -HUGE_VAL, 170.0};
+    optimize->Constraints[optimize->ConstraintCount++] = {OptimizeQuantity_Wall, MillimeterToMeter(2.5),
+                                                          MillimeterToMeter(4.0)};
+    optimize->Seed = 1;
+
+    // Монте-Карло: диапазоны состава топлива из комментариев ss_boiler.cpp,
+    // мода - топливо расчета (диапазон расширяется, если топливо библиотеки
+    // выходит за него). Полнота сгорания u - вокруг расчетной u0 = 1 - q22/100
+    // (как в GetBhFact) с разбросом 0.04, как у u = 0.8-0.88 в ss_boiler.cpp
+    MonteCarloSpec *monteCarlo = &input->MonteCarlo;
+    monteCarlo->Variables[MonteCarloVariable_C] = {Minimum(75.0, fuel.C), fuel.C, Maximum(92.0, fuel.C)};
+    monteCarlo->Variables[MonteCarloVariable_H] = {Minimum(2.5, fuel.H), fuel.H, Maximum(5.7, fuel.H)};
+    monteCarlo->Variables[MonteCarloVariable_O] = {Minimum(1.5, fuel.O), fuel.O, Maximum(15.0, fuel.O)};
+    monteCarlo->Variables[MonteCarloVariable_alpha] = {Minimum(1.30, fuel.alpha), fuel.alpha,
+                                                       Maximum(1.60, fuel.alpha)};
+    f64 u0 = (100.0 - q22) / 100.0;
+    monteCarlo->Variables[MonteCarloVariable_u] = {Maximum(u0 - 0.04, 0.0), u0, Minimum(u0 + 0.04, 1.0)};
+    monteCarlo->Variables[MonteCarloVariable_K] = {Minimum(7000.0, fuel.K), fuel.K, Maximum(7610.0, fuel.K)};
+    monteCarlo->BaseFuel = fuel;
+    monteCarlo->Chamber = fireChamber;
+    monteCarlo->Dd = dd;
+    monteCarlo->Ld = Ld;
+    monteCarlo->Nd = nd;
+    monteCarlo->t = t;
+    monteCarlo->SampleCount = 1 << 21;
+    monteCarlo->Seed = 1;
+}
+
+extern "C" CALCULATE(Calculate)
+{
+    GlobalPlatform = memory->Platform;
+#if EDITOR_PROFILE
+    GlobalDebugTable = memory->DebugTable;
+#endif
+    TIMED_BLOCK(Calculate);
+
+    Assert(sizeof(AppState) <= memory->PermanentStorageSize);
+    AppState *appState = (AppState *)memory->PermanentStorage;
+    b32 inputRestored = memory->PlayingBack;
+    if (!memory->IsInitialized ||
+        (appState->LayoutVersion != APP_STATE_LAYOUT_VERSION) ||
+        (appState->LayoutSize != sizeof(AppState)))
+    {
+        if (memory->PlayingBack)
+        {
+            fprintf(stderr, "Снимок записан другой версией, входные данные по умолчанию\n");
+        }
+        inputRestored = false;
 
-    printf("Теоретический расход воздуха L0\t\t\t%.2lf кг\n", L0);
+        ZeroStruct(*appState);
+        appState->LayoutVersion = APP_STATE_LAYOUT_VERSION;
+        appState->LayoutSize = sizeof(AppState);
 
-    printf("Сжигаемое топливо в час  Bh \t\t\t%.2lf кг\n", Bh);
-    printf("Сжигаемое топливо в час по факту \t\t%.2lf кг\n", BhFact);
+        InitializeArena(&appState->PermanentArena, memory->PermanentStorageSize - sizeof(AppState),
+                        (u8 *)memory->PermanentStorage + sizeof(AppState));
+        InitializeArena(&appState->Stages.Arena, STAGE_CACHE_SIZE, PushSize(&appState->PermanentArena, STAGE_CACHE_SIZE));
 
-    printf("Действительная температура горения T1\t\t%.2lf °C\n", T1);
-    printf("Температура при входе газов в отверстия T2\t%.2lf °C\n", T2);
+        memory->IsInitialized = true;
+    }
+
+    // точность pow/log/Root выбирает платформа (-math)
+    SetMathMode((math_mode)memory->MathMode);
+
+    // временная память не сохраняется между вызовами
+    InitializeArena(&appState->TransientArena, memory->TransientStorageSize, memory->TransientStorage);
+    auto transientArena = &appState->TransientArena;
+
+    // при воспроизведении снимка входные данные берутся из него, иначе -
+    // из кода, чтобы правка значений подхватывалась перезагрузкой
+    // NOTE: Records are read in place from the host's mapping.
+    FuelLibrary fuelLibrary;
+    b32 haveFuelLibrary = OpenFuelLibrary(memory->FuelLibrary, memory->FuelLibrarySize, &fuelLibrary);
+
+    auto calculationInput = &appState->Input;
+    if (!inputRestored)
+    {
+        SetDefaultInput(calculationInput, haveFuelLibrary ? &fuelLibrary : 0);
+    }
+
+    FireChamber fireChamber = calculationInput->Chamber;
+    PipeDiameter dd = calculationInput->Dd;
+    f64 Ld = calculationInput->Ld;
+    u16 nd = calculationInput->Nd;
+    f64 q22 = calculationInput->q22;
+    f64 t = calculationInput->t;
+    Fuel fuel = calculationInput->BaseFuel;
+    u32 stages = calculationInput->Stages;
+
+    // одиночный расчет - это пакет из одного варианта
+    BoilerBatchInput input = {};
+    input.Count = 1;
+    input.TopLengh = &fireChamber.TopLengh;
+    input.TopWidth = &fireChamber.TopWidth;
+    input.BottomLength = &fireChamber.BottomLength;
+    input.BottomWidth = &fireChamber.BottomWidth;
+    input.FrontHeight = &fireChamber.FrontHeight;
+    input.RearHeight = &fireChamber.RearHeight;
+    input.DOut = &dd.DOut;
+    input.DIn = &dd.DIn;
+    input.Ld = &Ld;
+    input.Nd = &nd;
+    input.U = &fireChamber.U;
+    input.q22 = &q22;
+    input.Fuels = &fuel;
+    input.t = t;
+
+    f64 R, Ht, Hd, L0, Bh, BhFact, T1, T2, T3, Tabs, Q0, Q21, Q22, Q3, Q4, Qt, omega, k1, M, N;
+
+    BoilerBatchOutput output = {};
+    output.R = &R;
+    output.Ht = &Ht;
+    output.Hd = &Hd;
+    output.L0 = &L0;
+    output.Bh = &Bh;
+    output.BhFact = &BhFact;
+    output.T1 = &T1;
+    output.T2 = &T2;
+    output.T3 = &T3;
+    output.Tabs = &Tabs;
+    output.Q0 = &Q0;
+    output.Q21 = &Q21;
+    output.Q22 = &Q22;
+    output.Q3 = &Q3;
+    output.Q4 = &Q4;
+    output.Qt = &Qt;
+    output.Omega = &omega;
+    output.K1 = &k1;
+    output.M = &M;
+    output.N = &N;
+
+    BEGIN_TIMED_BLOCK(Design);
+    CalculateBoilerBatch(&input, &output);
+    END_TIMED_BLOCK(Design);
+
+    //auto Q4 = GetQ4(.4, 51.9, v, t);
 
     /*
     const f64 betaN = 0.000001; // слой сажи в метрах
@@ -98,39 +369,893 @@ extern "C" CALCULATE(Calculate)
     printf("Температура стенки со стороны воды\t\t%.2lf °C\n", TWaterSide);
     */
 
-    auto T3 = GetT3(dd, nd, Ld, BhFact, fireChamber.Ht, fuel);
-    auto Tabs = GetTabs(T2, T3);
+    auto Hi = Ht + Hd;
+
+    // машинные форматы пишут в stdout только отчет, остальное - в stderr
+    u32 reportFormat = memory->ReportFormat;
+    FILE *log = (reportFormat == ReportFormat_Table) ? stdout : stderr;
+    auto reportWriter = BeginReportWriter(transientArena, stdout);
+
+    // отчеты стадий в постоянной памяти: стадии с прежним ключом не пересчитываются
+    auto stageCache = &appState->Stages;
+    PrepareStageCache(stageCache, GetStageCacheKey(calculationInput, memory));
+
+    if (calculationInput->FuelId)
+    {
+        fprintf(log, "Топливо\t\t\t\t\t\t[%u] %s\n", calculationInput->FuelId, calculationInput->FuelName);
+    }
+    else
+    {
+        fprintf(log, "Топливо\t\t\t\t\t\tвстроенное расчетное\n");
+    }
+
+    Report designReport;
+    BeginReport(&designReport, "design");
+    AddReportField(&designReport, "alpha", "Коэффициент избытка топлива alpha\t\t", 0, &fuel.alpha);
+    AddReportField(&designReport, "beta0", "Химическая характеристика топлива b0 \t\t", 0, &fuel.beta0);
+    AddReportField(&designReport, "L0", "Теоретический расход воздуха L0\t\t\t", "кг", &L0);
+    AddReportField(&designReport, "Bh", "Сжигаемое топливо в час  Bh \t\t\t", "кг", &Bh);
+    AddReportField(&designReport, "BhFact", "Сжигаемое топливо в час по факту \t\t", "кг", &BhFact);
+    AddReportField(&designReport, "T1", "Действительная температура горения T1\t\t", "°C", &T1);
+    AddReportField(&designReport, "T2", "Температура при входе газов в отверстия T2\t", "°C", &T2);
+    AddReportField(&designReport, "T3", "Температура газов на выходе котла T3\t\t", "°C", &T3);
+    AddReportField(&designReport, "Tabs", "Ср. абс. температура газов в д.трубах Tabs\t", "°C", &Tabs);
+    u32 q0Field = AddReportField(&designReport, "Q0", "Располагаемое тепло Q0 \t\t\t\t", "кал/час", &Q0);
+    AddReportField(&designReport, "Q21", "Химические потери тепла Q2'\t\t\t", "кал/час", &Q21);
+    AddReportField(&designReport, "Q22", "Механические потери тепла Q2''\t\t\t", "кал/час", &Q22);
+    AddReportField(&designReport, "Q3", "Потеря тепла с уходящими газами Q3\t\t", "кал/час", &Q3);
+    AddReportField(&designReport, "Q4", "Потери на внешнее охлаждение Q4\t\t\t", "кал/час", &Q4);
+    u32 qtField = AddReportField(&designReport, "Qt", "Тепло проходящее в котел через топочную Qt\t", "кал/час", &Qt);
+    for (u32 field = q0Field; field <= qtField; ++field)
+    {
+        designReport.Fields[field].ShareOf = q0Field;
+    }
+    AddReportField(&designReport, "R", "Площадь колосниковой решетки R\t\t\t", 0, &R);
+    AddReportField(&designReport, "Ht", "Поверхность нагрева огневой коробки Ht\t\t", "м2", &Ht);
+    AddReportField(&designReport, "Hd", "Поверхность нагрева дымогарных труб Hd\t\t", "м2", &Hd);
+    AddReportField(&designReport, "Hi", "Полная испаряющая поверхность Hi\t\t", "м2", &Hi);
+    AddReportField(&designReport, "k1", "k1 \t\t\t\t\t\t", 0, &k1);
+
+    WriteStageReport(stageCache, memory, &reportWriter, &designReport);
+
+    // итоги остальных стадий, по одному отчету на стадию
+    Report stageReport;
+
+    if ((stages & CalculationStage_Sweep) &&
+        BeginStage(stageCache, CalculationStage_Sweep, memory, &reportWriter, log))
+    {
+        TIMED_BLOCK(Sweep);
+
+        SweepSpec sweep = calculationInput->Sweep;
+
+        // результаты перебора живут в постоянной памяти и переживают перезагрузку кода
+        auto sweepCache = &appState->Sweep;
+        // режим математики меняет результаты так же, как другая сборка кода
+        u64 codeIdentity = memory->CodeIdentity;
+        if (codeIdentity)
+        {
+            codeIdentity = HashBytes(&memory->MathMode, sizeof(memory->MathMode), codeIdentity);
+        }
+        auto staleStages = PrepareSweepCache(appState, &sweep, codeIdentity);
+        auto sweepCount = sweepCache->VariantCount;
+        auto sweepOutput = sweepCache->Output;
+        auto chunkStages = sweepCache->ChunkStages;
+        if (!chunkStages)
+        {
+            // кэш не поместился в постоянную память: перебор целиком во временной, без кэша
+            sweepOutput = PushBoilerBatchOutput(transientArena, sweepCount);
+            if (sweepOutput.T3)
+            {
+                chunkStages = PushArray(transientArena, sweepCache->ChunkCount, u8);
+            }
+            if (chunkStages)
+            {
+                ZeroSize(sweepCache->ChunkCount, chunkStages);
+                fprintf(log, "Кэш перебора\t\t\t\t\tне помещается в постоянную память, перебор без кэша\n");
+            }
+        }
+        if (chunkStages)
+        {
+            auto stats = RunSweep(transientArena, &sweep, &sweepOutput, chunkStages, 0);
+
+            u64 best = 0;
+            for (u64 index = 1; index < sweepCount; ++index)
+            {
+                if (sweepOutput.T3[index] < sweepOutput.T3[best])
+                {
+                    best = index;
+                }
+            }
+
+            f64 bestValues[SweepParameter_Count];
+            GetSweepVariant(&sweep, best, bestValues);
+
+            fprintf(log, "Перебор вариантов\t\t\t\t%llu, посчитано %llu за %.3lf с, %.2lf млн/с (потоков %u, кусков %u, украдено %u)\n",
+                    (unsigned long long)stats.VariantCount, (unsigned long long)stats.ComputedVariants, stats.Seconds,
+                    stats.VariantsPerSecond / 1000000.0, stats.ThreadCount, stats.ChunkCount, stats.StolenChunks);
+            fprintf(log, "Кэш перебора\t\t\t\t\tвариантов из кэша %llu (кусков %u), пересчет стадий:%s%s%s%s\n",
+                    (unsigned long long)stats.ReusedVariants, stats.ReusedChunks,
+                    (staleStages & BoilerStage_Front) ? " топка" : "",
+                    (staleStages & BoilerStage_FireTubes) ? " дымогарные трубы" : "",
+                    (staleStages & BoilerStage_Losses) ? " потери" : "",
+                    staleStages ? "" : " нет");
+            BeginReport(&stageReport, "sweep");
+            AddReportValue(&stageReport, "VariantCount", "Перебор: вариантов\t\t\t\t", 0, (f64)stats.VariantCount, 0);
+            AddReportValue(&stageReport, "T3Min", "Перебор: наименьшая T3\t\t\t\t", "°C", sweepOutput.T3[best]);
+            AddReportValue(&stageReport, "Ld", "Перебор: Ld при наименьшей T3\t\t\t", "м", bestValues[SweepParameter_Ld], 3);
+            AddReportValue(&stageReport, "Nd", "Перебор: nd при наименьшей T3\t\t\t", 0, bestValues[SweepParameter_Nd], 0);
+            AddReportValue(&stageReport, "TopLengh", "Перебор: TopLengh при наименьшей T3\t\t", "м", bestValues[SweepParameter_TopLengh], 3);
+            AddReportValue(&stageReport, "BottomWidth", "Перебор: BottomWidth при наименьшей T3\t\t", "м", bestValues[SweepParameter_BottomWidth], 3);
+            WriteStageReport(stageCache, memory, &reportWriter, &stageReport);
+
+            // отбор: тот же перебор в f32 и сравнение с результатом в f64
+            if (stages & CalculationStage_SweepF32)
+            {
+                auto tempMem = BeginTemporaryMemory(transientArena);
+                auto screenOutput = PushBoilerBatchOutput(transientArena, sweepCount);
+                if (screenOutput.T3)
+                {
+                    auto screenStats = RunSweep(transientArena, &sweep, &screenOutput, 0, 0, true);
+
+                    f64 worst = GetBoilerBatchDeviation(&screenOutput, &sweepOutput, sweepCount);
+
+                    u64 screenBest = 0;
+                    for (u64 index = 1; index < sweepCount; ++index)
+                    {
+                        if (screenOutput.T3[index] < screenOutput.T3[screenBest])
+                        {
+                            screenBest = index;
+                        }
+                    }
+
+                    fprintf(log, "Перебор в f32 (отбор)\t\t\t\t%.3lf с, %.2lf млн/с\n",
+                            screenStats.Seconds, screenStats.VariantsPerSecond / 1000000.0);
+                    BeginReport(&stageReport, "sweep_f32");
+                    AddReportValue(&stageReport, "FallbackCount", "Отбор в f32: пересчитано в f64\t\t\t", 0, (f64)screenStats.FallbackCount, 0);
+                    AddReportValue(&stageReport, "MaxDeviation", "Отбор в f32: отклонение выходов до\t\t", "млн^-1", worst * 1e6, 3);
+                    AddReportValue(&stageReport, "SameBest", "Отбор в f32: лучший вариант тот же (1 - да)\t", 0, (screenBest == best) ? 1.0 : 0.0, 0);
+                    WriteStageReport(stageCache, memory, &reportWriter, &stageReport);
+                }
+                EndTemporaryMemory(tempMem);
+            }
+
+            if (memory->ReportSweep)
+            {
+                Report sweepReport;
+                if (BuildSweepReport(transientArena, &sweepReport, &sweep, &sweepOutput, sweepCount))
+                {
+                    WriteStageReport(stageCache, memory, &reportWriter, &sweepReport, true);
+                }
+                else
+                {
+                    fprintf(log, "Отчет перебора - не хватает памяти\n");
+                }
+            }
+        }
+        else
+        {
+            fprintf(log, "Перебор вариантов\t\t\t\t%llu - не хватает памяти\n", (unsigned long long)GetSweepVariantCount(&sweep));
+        }
+
+        EndStage(stageCache);
+    }
+
+    // обратная задача: длина дымогарных труб расчетного котла под таблицу
+    // целевых температур уходящих газов T3
+    if ((stages & CalculationStage_Inverse) &&
+        BeginStage(stageCache, CalculationStage_Inverse, memory, &reportWriter, log))
+    {
+        TIMED_BLOCK(Inverse);
+        auto tempMem = BeginTemporaryMemory(transientArena);
+
+        const u32 inverseCount = 1000;
+        auto inverseBase = PushBoilerBatchInput(transientArena, inverseCount);
+        auto targetT3 = PushArray(transientArena, inverseCount, f64);
+        auto solvedLd = PushArray(transientArena, inverseCount, f64);
+        auto achievedT3 = PushArray(transientArena, inverseCount, f64);
+        if (inverseBase.Ld && targetT3 && solvedLd && achievedT3)
+        {
+            inverseBase.Fuels = &fuel;
+            inverseBase.t = t;
+            for (u32 index = 0; index < inverseCount; ++index)
+            {
+                CopyBoilerBatchVariant(&inverseBase, index, &input, 0);
+                targetT3[index] = 350.0 + 150.0 * index / (inverseCount - 1);
+            }
+
+            InverseSpec inverseSpec = {};
+            inverseSpec.UnknownCount = 1;
+            inverseSpec.Unknowns[0] = InverseUnknown_Ld;
+            inverseSpec.Min[0] = MillimeterToMeter(2000);
+            inverseSpec.Max[0] = MillimeterToMeter(7000);
+            inverseSpec.Targets[0] = InverseTarget_T3;
+
+            InverseBatch inverseBatch = {};
+            inverseBatch.Base = &inverseBase;
+            inverseBatch.TargetValues[0] = targetT3;
+            inverseBatch.Solution[0] = solvedLd;
+            inverseBatch.Achieved[0] = achievedT3;
+
+            auto inverseStats = SolveInverseBatch(transientArena, &inverseSpec, &inverseBatch);
+
+            u32 middle = inverseCount / 2;
+            fprintf(log, "Обратная задача Ld(T3)\t\t\t\t%u целей за %.2lf мс (итераций %u)\n",
+                    inverseStats.RowCount, inverseStats.Seconds * 1000.0, inverseStats.Iterations);
+            BeginReport(&stageReport, "inverse");
+            AddReportValue(&stageReport, "Converged", "Обратная задача Ld(T3): сошлось\t\t\t", 0, inverseStats.Converged, 0);
+            AddReportValue(&stageReport, "OutOfBounds", "Обратная задача Ld(T3): вне границ\t\t", 0, inverseStats.OutOfBounds, 0);
+            AddReportValue(&stageReport, "NoConvergence", "Обратная задача Ld(T3): не сошлось\t\t", 0, inverseStats.NoConvergence, 0);
+            AddReportValue(&stageReport, "TargetT3", "Заданная T3\t\t\t\t\t", "°C", targetT3[middle]);
+            AddReportValue(&stageReport, "Ld", "Длина труб для заданной T3\t\t\t", "м", solvedLd[middle], 4);
+            AddReportValue(&stageReport, "AchievedT3", "Достигнутая T3\t\t\t\t\t", "°C", achievedT3[middle], 4);
+            WriteStageReport(stageCache, memory, &reportWriter, &stageReport);
+        }
+
+        EndTemporaryMemory(tempMem);
+
+        EndStage(stageCache);
+    }
+
+    // тяга: установившееся напряжение решетки расчетного котла и перебора
+    // длины и числа дымогарных труб вокруг него; напряжение расчетного котла
+    // нужно поездкам ниже, остальное живет только в этом блоке
+    b32 haveDraftU = false;
+    f64 draftU = 0.0;
+    if ((stages & CalculationStage_Draft) &&
+        BeginStage(stageCache, CalculationStage_Draft, memory, &reportWriter, log))
+    {
+        TIMED_BLOCK(Draft);
+        auto tempMem = BeginTemporaryMemory(transientArena);
+
+        const u32 draftSteps = 64;
+        const u32 draftCount = draftSteps * draftSteps;
+        auto draftBase = PushBoilerBatchInput(transientArena, draftCount);
+        DraftBatch draftBatch = {};
+        draftBatch.U = PushArray(transientArena, draftCount, f64);
+        draftBatch.Bh = PushArray(transientArena, draftCount, f64);
+        draftBatch.T3 = PushArray(transientArena, draftCount, f64);
+        draftBatch.Draft = PushArray(transientArena, draftCount, f64);
+        draftBatch.Evaporation = PushArray(transientArena, draftCount, f64);
+        if (draftBase.Ld && draftBatch.Evaporation)
+        {
+            draftBase.Fuels = &fuel;
+            draftBase.t = t;
+            for (u32 index = 0; index < draftCount; ++index)
+            {
+                CopyBoilerBatchVariant(&draftBase, index, &input, 0);
+                if (index)
+                {
+                    draftBase.Ld[index] = Map(index % draftSteps, 0, draftSteps - 1, MillimeterToMeter(3500),
+                                              MillimeterToMeter(5500));
+                    draftBase.Nd[index] = (u16)(150 + (index / draftSteps) * (260 - 150) / (draftSteps - 1));
+                }
+            }
+            draftBatch.Base = &draftBase;
+
+            auto draftStats = SolveDraftBatch(transientArena, &calculationInput->Draft, &draftBatch);
+            haveDraftU = true;
+            draftU = draftBatch.U[0];
+
+            u32 best = 0;
+            for (u32 index = 1; index < draftCount; ++index)
+            {
+                if (draftBatch.Evaporation[index] > draftBatch.Evaporation[best])
+                {
+                    best = index;
+                }
+            }
+            fprintf(log, "Тяга, пакет\t\t\t\t\t%u котлов за %.2lf мс (итераций %u)\n",
+                    draftStats.RowCount, draftStats.Seconds * 1000.0, draftStats.Iterations);
+            BeginReport(&stageReport, "draft");
+            AddReportValue(&stageReport, "U", "Тяга: напряжение решетки U\t\t\t", "кг/м2 час", draftBatch.U[0]);
+            AddReportValue(&stageReport, "Bh", "Тяга: сжигаемое топливо Bh\t\t\t", "кг/час", draftBatch.Bh[0], 1);
+            AddReportValue(&stageReport, "T3", "Тяга: T3\t\t\t\t\t", "°C", draftBatch.T3[0]);
+            AddReportValue(&stageReport, "Draft", "Тяга: разрежение\t\t\t\t", "мм", draftBatch.Draft[0], 1);
+            AddReportValue(&stageReport, "Evaporation", "Тяга: испарение котла\t\t\t\t", "кг/час", draftBatch.Evaporation[0], 0);
+            AddReportValue(&stageReport, "EvaporationMax", "Тяга: наибольшее испарение в переборе\t\t", "кг/час", draftBatch.Evaporation[best], 0);
+            AddReportValue(&stageReport, "EvaporationMaxLd", "Тяга: Ld при наибольшем испарении\t\t", "м", draftBase.Ld[best], 3);
+            AddReportValue(&stageReport, "EvaporationMaxNd", "Тяга: nd при наибольшем испарении\t\t", 0, draftBase.Nd[best], 0);
+            AddReportValue(&stageReport, "Converged", "Тяга: сошлось\t\t\t\t\t", 0, draftStats.Converged, 0);
+            AddReportValue(&stageReport, "OutOfBounds", "Тяга: вне границ\t\t\t\t", 0, draftStats.OutOfBounds, 0);
+            AddReportValue(&stageReport, "NoConvergence", "Тяга: не сошлось\t\t\t\t", 0, draftStats.NoConvergence, 0);
+            WriteStageReport(stageCache, memory, &reportWriter, &stageReport);
+        }
 
-    auto Q3 = GetQ3(T3, heatCoefficient);
+        EndTemporaryMemory(tempMem);
 
-    // Qt  - тепло проходящее в котел через топочную
-    auto Qt = GetQt(Q0, Q21, Q22, T2, heatCoefficient);
+        EndStage(stageCache);
+    }
+    else if (stages & CalculationStage_Draft)
+    {
+        // отчет тяги выведен из кэша, напряжение решетки для поездок - из него же
+        haveDraftU = GetStageCacheValue(stageCache, "draft", "U", &draftU);
+    }
 
-    printf("Температура газов на выходе котла T3\t\t%.2lf °C\n", T3);
-    printf("Ср. абс. температура газов в д.трубах Tabs\t%.2lf °C\n", Tabs);
-    printf("Располагаемое тепло Q0 \t\t\t\t%.2lf кал/час \t\t%.1lf%%\n", Q0, Q0 / Q0 * 100);
-    printf("Химические потери тепла Q2'\t\t\t%.2lf кал/час \t\t%.1lf%%\n", Q21, Q21 / Q0 * 100);
-    printf("Механические потери тепла Q2''\t\t\t%.2lf кал/час \t\t%.1lf%%\n", Q22, Q22 / Q0 * 100);
-    printf("Потеря тепла с уходящими газами Q3\t\t%.2lf кал/час \t\t%.1lf%%\n", Q3, Q3 / Q0 * 100);
-    printf("Потери на внешнее охлаждение Q4\t\t\t%.2lf кал/час \t\t%.1lf%%\n", Q4, Q4 / Q0 * 100);
+    // движение поездов: маршруты со случайным профилем, паровозы с котлами
+    // разного числа дымогарных труб, составы разной массы
+    if (stages & (CalculationStage_Traction | CalculationStage_Fleet))
+    {
+        TIMED_BLOCK(Traction);
+        auto tempMem = BeginTemporaryMemory(transientArena);
 
-    printf("Тепло проходящее в котел через топочную Qt\t%.2lf кал/час \t\t%.1lf%%\n", Qt, Qt / Q0 * 100);
+        const u32 routeCount = 16;
+        const u32 sectionCount = 40;
+        const u32 locomotiveCount = 4;
+        const u32 massCount = 16;
+        const u32 tripCount = routeCount * locomotiveCount * massCount;
 
-    auto Hi = fireChamber.Ht + Hd;
+        auto routes = PushArray(transientArena, routeCount, TractionRoute);
+        auto sections = PushArray(transientArena, routeCount * sectionCount, RouteSection);
+        auto locomotives = PushArray(transientArena, locomotiveCount, Locomotive);
+        auto boilers = PushBoilerBatchInput(transientArena, locomotiveCount);
+        TractionBatch traction = {};
+        traction.RouteIndex = PushArray(transientArena, tripCount, u32);
+        traction.LocomotiveIndex = PushArray(transientArena, tripCount, u32);
+        traction.TrainMass = PushArray(transientArena, tripCount, f64);
+        traction.Time = PushArray(transientArena, tripCount, f64);
+        traction.Fuel = PushArray(transientArena, tripCount, f64);
+        traction.Steam = PushArray(transientArena, tripCount, f64);
+        traction.MaxSpeed = PushArray(transientArena, tripCount, f64);
+        if (routes && sections && locomotives && boilers.Ld && traction.MaxSpeed)
+        {
+            const f64 speedLimits[] = {40.0, 60.0, 80.0, 100.0};
+            for (u32 route = 0; route < routeCount; ++route)
+            {
+                routes[route].Sections = sections + route * sectionCount;
+                routes[route].SectionCount = sectionCount;
+                for (u32 index = 0; index < sectionCount; ++index)
+                {
+                    auto bits = Philox4x32(route, index, 0, 0, 0x7AC7, 0);
+                    RouteSection *section = routes[route].Sections + index;
+                    section->Length = 300.0 + 1700.0 * UnitF64FromBits(bits.V[0], bits.V[1]);
+                    section->Grade = -8.0 + 16.0 * UnitF64FromBits(bits.V[2], bits.V[3]);
+                    section->CurveRadius = ((bits.V[0] & 3) == 0) ? (400.0 + (bits.V[1] & 0x3FF)) : 0.0;
+                    section->SpeedLimit = speedLimits[bits.V[2] & 3];
+                }
+            }
 
-    printf("Площадь колосниковой решетки R\t\t\t%.2lf\n", fireChamber.R);
-    printf("Поверхность нагрева огневой коробки Ht\t\t%.2lf м2\n", fireChamber.Ht);
-    printf("Поверхность нагрева дымогарных труб Hd\t\t%.2lf м2\n", Hd);
-    printf("Полная испаряющая поверхность Hi\t\t%.2lf м2\n", Hi);
+            boilers.Fuels = &fuel;
+            boilers.t = t;
+            for (u32 locomotive = 0; locomotive < locomotiveCount; ++locomotive)
+            {
+                locomotives[locomotive] = calculationInput->Engine;
+                CopyBoilerBatchVariant(&boilers, locomotive, &input, 0);
+                boilers.Nd[locomotive] = (u16)(input.Nd[0] - 20 * locomotive);
+            }
 
-    auto omega = GetOmega(fuel, dd, Tabs, L0, BhFact);
-    auto k1 = GetK(dd, omega);
-    auto k2 = GetK(heatCoefficient, Hd, tk, T3, T3);
+            for (u32 index = 0; index < tripCount; ++index)
+            {
+                traction.RouteIndex[index] = index % routeCount;
+                traction.LocomotiveIndex[index] = (index / routeCount) % locomotiveCount;
+                traction.TrainMass[index] = 800.0 + 100.0 * (index / (routeCount * locomotiveCount));
+            }
 
-    auto rd = GetHydraulicRadius(dd);
-    auto sqrD = GetPipeSquare(dd);
+            traction.Count = tripCount;
+            traction.Routes = routes;
+            traction.Locomotives = locomotives;
+            traction.Boilers = &boilers;
 
-    //auto bb = GetBeta(Ld, rd, sqrD, 0, 0, 0, 0, 0, 0);
+            // NOTE: The fireman can push the grate only as hard as the draft allows.
+            TractionSpec tractionSpec = calculationInput->Traction;
+            if (haveDraftU)
+            {
+                tractionSpec.UMax = draftU;
+            }
 
-    printf("k1 \t\t\t\t\t\t%.2lf\n", k1);
+            if ((stages & CalculationStage_Traction) &&
+                BeginStage(stageCache, CalculationStage_Traction, memory, &reportWriter, log))
+            {
+                auto tractionStats = SolveTractionBatch(transientArena, &tractionSpec, &traction);
+
+                // расчетный паровоз на маршруте 0 с составом 1500 т
+                u32 design = 7 * routeCount * locomotiveCount;
+                f64 routeLength = 0.0;
+                for (u32 index = 0; index < sectionCount; ++index)
+                {
+                    routeLength += routes[0].Sections[index].Length;
+                }
+                fprintf(log, "Поездки, пакет\t\t\t\t\t%u поездок за %.2lf мс (%.1lf мкс на поездку, %llu шагов)\n",
+                        tractionStats.TripCount, tractionStats.Seconds * 1000.0,
+                        tractionStats.Seconds * 1e6 / tractionStats.TripCount, (unsigned long long)tractionStats.Steps);
+                BeginReport(&stageReport, "traction");
+                AddReportValue(&stageReport, "RouteLength", "Поездка: длина маршрута\t\t\t\t", "км", routeLength / 1000.0, 1);
+                AddReportValue(&stageReport, "TrainMass", "Поездка: состав\t\t\t\t\t", "т", traction.TrainMass[design], 0);
+                AddReportValue(&stageReport, "Time", "Поездка: время\t\t\t\t\t", "мин", traction.Time[design] / 60.0, 1);
+                AddReportValue(&stageReport, "AverageSpeed", "Поездка: средняя скорость\t\t\t", "км/ч", routeLength / traction.Time[design] * 3.6, 1);
+                AddReportValue(&stageReport, "MaxSpeed", "Поездка: наибольшая скорость\t\t\t", "км/ч", traction.MaxSpeed[design], 1);
+                AddReportValue(&stageReport, "Fuel", "Поездка: топливо\t\t\t\t", "кг", traction.Fuel[design], 0);
+                AddReportValue(&stageReport, "Steam", "Поездка: пар\t\t\t\t\t", "кг", traction.Steam[design], 0);
+                AddReportValue(&stageReport, "UMax", "Поездка: UMax\t\t\t\t\t", "кг/м2 час", tractionSpec.UMax);
+                AddReportValue(&stageReport, "Arrived", "Поездки: доехали\t\t\t\t", 0, tractionStats.Arrived, 0);
+                AddReportValue(&stageReport, "Stalled", "Поездки: встали\t\t\t\t\t", 0, tractionStats.Stalled, 0);
+                AddReportValue(&stageReport, "TimedOut", "Поездки: не успели\t\t\t\t", 0, tractionStats.TimedOut, 0);
+                WriteStageReport(stageCache, memory, &reportWriter, &stageReport);
+
+                EndStage(stageCache);
+            }
+
+            if ((stages & CalculationStage_Fleet) &&
+                BeginStage(stageCache, CalculationStage_Fleet, memory, &reportWriter, log))
+            {
+                // парк: паровозы с разными цилиндрами, колесами, давлением и
+                // котлами на всех рейсах (маршрут, состав) выше
+                const u32 fleetLocomotiveCount = 16;
+                const u32 dutyCount = routeCount * massCount;
+                auto fleetLocomotives = PushArray(transientArena, fleetLocomotiveCount, Locomotive);
+                auto fleetBoilers = PushBoilerBatchInput(transientArena, fleetLocomotiveCount);
+                auto duties = PushArray(transientArena, dutyCount, DutyCycle);
+                FleetBatch fleet = {};
+                fleet.Time = PushArray(transientArena, fleetLocomotiveCount * dutyCount, f64);
+                fleet.Coal = PushArray(transientArena, fleetLocomotiveCount * dutyCount, f64);
+                fleet.Water = PushArray(transientArena, fleetLocomotiveCount * dutyCount, f64);
+                fleet.Status = PushArray(transientArena, fleetLocomotiveCount * dutyCount, u8);
+                if (fleetLocomotives && fleetBoilers.Ld && duties && fleet.Status)
+                {
+                    fleetBoilers.Fuels = &fuel;
+                    fleetBoilers.t = t;
+                    for (u32 locomotive = 0; locomotive < fleetLocomotiveCount; ++locomotive)
+                    {
+                        u32 cylinder = locomotive & 3;
+                        u32 size = locomotive >> 2;
+
+                        Locomotive *engine = fleetLocomotives + locomotive;
+                        *engine = calculationInput->Engine;
+                        engine->CylinderD *= 1.0 - 0.04 * cylinder;
+                        engine->WheelD *= 1.0 + 0.06 * size;
+                        engine->Pressure *= 1.0 - 0.05 * size;
+
+                        CopyBoilerBatchVariant(&fleetBoilers, locomotive, &input, 0);
+                        fleetBoilers.Nd[locomotive] = (u16)(input.Nd[0] - 10 * cylinder);
+                        fleetBoilers.Ld[locomotive] = input.Ld[0] * (1.0 - 0.05 * size);
+                    }
+
+                    for (u32 duty = 0; duty < dutyCount; ++duty)
+                    {
+                        duties[duty].RouteIndex = duty % routeCount;
+                        duties[duty].TrainMass = 800.0 + 100.0 * (duty / routeCount);
+                    }
+
+                    fleet.LocomotiveCount = fleetLocomotiveCount;
+                    fleet.Locomotives = fleetLocomotives;
+                    fleet.Boilers = &fleetBoilers;
+                    fleet.DutyCount = dutyCount;
+                    fleet.Duties = duties;
+                    fleet.Routes = routes;
+
+                    FleetStats fleetStats;
+                    if (RunFleet(transientArena, &tractionSpec, &fleet, 0, &fleetStats))
+                    {
+                        // NOTE: Locomotive 0 is the design engine, so its duty
+                        // (route 0, 1500 t) is the design trip of the batch above.
+                        u32 designDuty = 7 * routeCount;
+                        fprintf(log, "Парк\t\t\t\t\t\t%llu поездок за %.2lf мс на %u потоках (%.0lf поездок/с, %llu шагов)\n",
+                                (unsigned long long)fleetStats.TripCount, fleetStats.Seconds * 1000.0,
+                                fleetStats.ThreadCount, fleetStats.TripsPerSecond, (unsigned long long)fleetStats.Steps);
+                        BeginReport(&stageReport, "fleet");
+                        AddReportValue(&stageReport, "TripCount", "Парк: поездок\t\t\t\t\t", 0, (f64)fleetStats.TripCount, 0);
+                        AddReportValue(&stageReport, "Arrived", "Парк: доехали\t\t\t\t\t", 0, (f64)fleetStats.Arrived, 0);
+                        AddReportValue(&stageReport, "Stalled", "Парк: встали\t\t\t\t\t", 0, (f64)fleetStats.Stalled, 0);
+                        AddReportValue(&stageReport, "TimedOut", "Парк: не успели\t\t\t\t\t", 0, (f64)fleetStats.TimedOut, 0);
+                        AddReportValue(&stageReport, "Coal", "Парк: топливо\t\t\t\t\t", "т", fleetStats.Coal / 1000.0, 1);
+                        AddReportValue(&stageReport, "Water", "Парк: вода\t\t\t\t\t", "т", fleetStats.Water / 1000.0, 1);
+                        AddReportValue(&stageReport, "DesignTime", "Парк: расчетная поездка\t\t\t\t", "мин", fleet.Time[designDuty] / 60.0, 1);
+                        AddReportValue(&stageReport, "DesignCoal", "Парк: топливо расчетной поездки\t\t\t", "кг", fleet.Coal[designDuty], 0);
+                        WriteStageReport(stageCache, memory, &reportWriter, &stageReport);
+                    }
+                }
+
+                EndStage(stageCache);
+            }
+        }
+
+        EndTemporaryMemory(tempMem);
+    }
+
+    // оптимизация геометрии под ограничения
+    if ((stages & CalculationStage_Optimize) &&
+        BeginStage(stageCache, CalculationStage_Optimize, memory, &reportWriter, log))
+    {
+        TIMED_BLOCK(Optimize);
+
+        auto optimizeSpec = &calculationInput->Optimize;
+        auto optimum = RunOptimize(transientArena, optimizeSpec, 0);
+        f64 designQuantities[OptimizeQuantity_Count];
+        GetOptimizeQuantities(&input, &output, 0, designQuantities);
+        fprintf(log, "Оптимизация (CMA-ES)\t\t\t\t%u запусков, %llu расчетов за %.3lf с (потоков %u)\n",
+                optimum.RunCount, (unsigned long long)optimum.Evaluations, optimum.Seconds, optimum.ThreadCount);
+        BeginReport(&stageReport, "optimize");
+        AddReportValue(&stageReport, "FeasibleRuns", "Оптимизация: допустимых запусков\t\t", 0, optimum.FeasibleRuns, 0);
+        AddReportValue(&stageReport, "Feasible", "Оптимизация: ограничения выполнены (1 - да)\t", 0, optimum.Feasible ? 1.0 : 0.0, 0);
+        AddReportValue(&stageReport, "q3", "Потеря с уходящими газами q3\t\t\t", "%", optimum.Objective * 100.0, 4);
+        AddReportValue(&stageReport, "q3Design", "q3 расчетного котла\t\t\t\t", "%", GetOptimizeObjective(optimizeSpec, designQuantities) * 100.0, 4);
+        AddReportValue(&stageReport, "TopLengh", "Огневая коробка: длина\t\t\t\t", "м", optimum.Values[SweepParameter_TopLengh], 3);
+        AddReportValue(&stageReport, "TopWidth", "Огневая коробка: ширина\t\t\t\t", "м", optimum.Values[SweepParameter_TopWidth], 3);
+        AddReportValue(&stageReport, "BottomLength", "Решетка: длина\t\t\t\t\t", "м", optimum.Values[SweepParameter_BottomLength], 3);
+        AddReportValue(&stageReport, "BottomWidth", "Решетка: ширина\t\t\t\t\t", "м", optimum.Values[SweepParameter_BottomWidth], 3);
+        AddReportValue(&stageReport, "FrontHeight", "Огневая коробка: высота спереди\t\t\t", "м", optimum.Values[SweepParameter_FrontHeight], 3);
+        AddReportValue(&stageReport, "RearHeight", "Огневая коробка: высота сзади\t\t\t", "м", optimum.Values[SweepParameter_RearHeight], 3);
+        AddReportValue(&stageReport, "Nd", "Дымогарные трубы: число\t\t\t\t", 0, optimum.Values[SweepParameter_Nd], 0);
+        AddReportValue(&stageReport, "DOut", "Дымогарные трубы: наружный диаметр\t\t", "мм", optimum.Values[SweepParameter_DOut] * 1000.0, 1);
+        AddReportValue(&stageReport, "DIn", "Дымогарные трубы: внутренний диаметр\t\t", "мм", optimum.Values[SweepParameter_DIn] * 1000.0, 1);
+        AddReportValue(&stageReport, "Ld", "Дымогарные трубы: длина Ld\t\t\t", "м", optimum.Values[SweepParameter_Ld], 3);
+        AddReportValue(&stageReport, "R", "Оптимум: R\t\t\t\t\t", "м2", optimum.Quantities[OptimizeQuantity_R], 3);
+        AddReportValue(&stageReport, "Hi", "Оптимум: Hi\t\t\t\t\t", "м2", optimum.Quantities[OptimizeQuantity_Hi]);
+        AddReportValue(&stageReport, "Omega", "Оптимум: omega\t\t\t\t\t", 0, optimum.Quantities[OptimizeQuantity_Omega], 3);
+        AddReportValue(&stageReport, "T3", "Оптимум: T3\t\t\t\t\t", "°C", optimum.Quantities[OptimizeQuantity_T3]);
+        WriteStageReport(stageCache, memory, &reportWriter, &stageReport);
+
+        EndStage(stageCache);
+    }
+
+    // разброс результатов по составу топлива
+    if ((stages & CalculationStage_MonteCarlo) &&
+        BeginStage(stageCache, CalculationStage_MonteCarlo, memory, &reportWriter, log))
+    {
+        TIMED_BLOCK(MonteCarlo);
+
+        MonteCarloStats monteCarloStats;
+        if (RunMonteCarlo(transientArena, &calculationInput->MonteCarlo, 0, &monteCarloStats))
+        {
+            fprintf(log, "Монте-Карло по составу топлива\t\t\t%llu выборок за %.3lf с, %.2lf млн/с (потоков %u)\n",
+                    (unsigned long long)monteCarloStats.SampleCount, monteCarloStats.Seconds,
+                    monteCarloStats.SamplesPerSecond / 1e6, monteCarloStats.ThreadCount);
+
+            // строка на каждый выход: столбец Output - номер monte_carlo_output
+            const f64 percents[] = {1.0, 5.0, 50.0, 95.0, 99.0};
+            const char *percentNames[] = {"P1", "P5", "P50", "P95", "P99"};
+            f64 statValues[2 + ArrayCount(percents)][MonteCarloOutput_Count];
+            f64 outputIndices[MonteCarloOutput_Count];
+            for (u32 outputIndex = 0; outputIndex < MonteCarloOutput_Count; ++outputIndex)
+            {
+                outputIndices[outputIndex] = outputIndex;
+                statValues[0][outputIndex] = monteCarloStats.Mean[outputIndex];
+                statValues[1][outputIndex] = monteCarloStats.StdDev[outputIndex];
+                for (u32 percent = 0; percent < ArrayCount(percents); ++percent)
+                {
+                    statValues[2 + percent][outputIndex] =
+                        GetMonteCarloPercentile(&monteCarloStats, outputIndex, percents[percent]);
+                }
+            }
+
+            BeginReport(&stageReport, "montecarlo", MonteCarloOutput_Count);
+            stageReport.Title = "Монте-Карло по составу топлива, Output: 0 - T1 °C, 1 - T3 °C, 2 - q2' %, 3 - q2'' %, 4 - q3 %, 5 - qt %";
+            AddReportField(&stageReport, "Output", 0, 0, outputIndices, 0);
+            AddReportField(&stageReport, "Mean", 0, 0, statValues[0], 3);
+            AddReportField(&stageReport, "StdDev", 0, 0, statValues[1], 3);
+            for (u32 percent = 0; percent < ArrayCount(percents); ++percent)
+            {
+                AddReportField(&stageReport, percentNames[percent], 0, 0, statValues[2 + percent], 3);
+            }
+            WriteStageReport(stageCache, memory, &reportWriter, &stageReport);
+
+            // гистограмма T3 между P0.5 и P99.5
+            const u32 barCount = 16;
+            const u32 barWidth = 50;
+            u64 counts[barCount];
+            f64 low = GetMonteCarloPercentile(&monteCarloStats, MonteCarloOutput_T3, 0.5);
+            f64 high = GetMonteCarloPercentile(&monteCarloStats, MonteCarloOutput_T3, 99.5);
+            GetMonteCarloHistogram(&monteCarloStats, MonteCarloOutput_T3, low, high, barCount, counts);
+            u64 largest = 1;
+            for (u32 bar = 0; bar < barCount; ++bar)
+            {
+                largest = Maximum(largest, counts[bar]);
+            }
+            for (u32 bar = 0; bar < barCount; ++bar)
+            {
+                char line[barWidth + 1];
+                u32 length = (u32)(counts[bar] * barWidth / largest);
+                for (u32 index = 0; index < length; ++index)
+                {
+                    line[index] = '#';
+                }
+                line[length] = 0;
+                fprintf(log, "T3 %8.2lf °C %9llu %s\n", Map(bar + 0.5, 0.0, barCount, low, high),
+                        (unsigned long long)counts[bar], line);
+            }
+        }
+        else
+        {
+            fprintf(log, "Монте-Карло по составу топлива - не хватает памяти\n");
+        }
+
+        EndStage(stageCache);
+    }
+
+    // расчетный котел на всех топливах библиотеки; записи берутся прямо из
+    // отображенного файла, свойства топлив уже посчитаны при сборке
+    if ((stages & CalculationStage_FuelLibrary) &&
+        BeginStage(stageCache, CalculationStage_FuelLibrary, memory, &reportWriter, log))
+    {
+        TIMED_BLOCK(FuelLibrary);
+
+        if (haveFuelLibrary)
+        {
+            auto tempMem = BeginTemporaryMemory(transientArena);
+
+            u32 fuelCount = fuelLibrary.RecordCount;
+            auto fuelInput = PushBoilerBatchInput(transientArena, fuelCount);
+            auto fuelOutput = PushBoilerBatchOutput(transientArena, fuelCount);
+            if (fuelCount && fuelInput.Ld && fuelOutput.T3)
+            {
+                for (u32 index = 0; index < fuelCount; ++index)
+                {
+                    CopyBoilerBatchVariant(&fuelInput, index, &input, 0);
+                    fuelInput.FuelIndex[index] = index;
+                }
+                fuelInput.FuelRecords = fuelLibrary.Records;
+                fuelInput.t = t;
+                CalculateBoilerBatch(&fuelInput, &fuelOutput);
+
+                // NOTE: The table is cut to FUEL_REPORT_MAX_ROWS rows, the machine
+                // formats get every fuel. Names stay in the library, Id keys them.
+                u32 rowCount = fuelCount;
+                if ((reportFormat == ReportFormat_Table) && (rowCount > FUEL_REPORT_MAX_ROWS))
+                {
+                    rowCount = FUEL_REPORT_MAX_ROWS;
+                }
+                auto ids = PushArray(transientArena, rowCount, f64);
+                auto q3 = PushArray(transientArena, rowCount, f64);
+                if (ids && q3)
+                {
+                    for (u32 index = 0; index < rowCount; ++index)
+                    {
+                        ids[index] = fuelLibrary.Records[index].Id;
+                        q3[index] = fuelOutput.Q3[index] / fuelOutput.Q0[index] * 100.0;
+                    }
+
+                    BeginReport(&stageReport, "fuels", rowCount);
+                    stageReport.Title = "Библиотека топлив";
+                    AddReportField(&stageReport, "Id", 0, 0, ids, 0);
+                    AddReportField(&stageReport, "T1", 0, "°C", fuelOutput.T1);
+                    AddReportField(&stageReport, "T3", 0, "°C", fuelOutput.T3);
+                    AddReportField(&stageReport, "q3", 0, "%", q3);
+                    WriteStageReport(stageCache, memory, &reportWriter, &stageReport);
+                }
+                if (rowCount < fuelCount)
+                {
+                    fprintf(log, "... еще %u топлив\n", fuelCount - rowCount);
+                }
+            }
+
+            EndTemporaryMemory(tempMem);
+        }
+        else if (memory->FuelLibrary)
+        {
+            fprintf(log, "Библиотека топлив повреждена или другой версии\n");
+        }
+
+        EndStage(stageCache);
+    }
+
+    // чувствительность расчетного котла: производные за один проход
+    if ((stages & CalculationStage_Sensitivity) &&
+        BeginStage(stageCache, CalculationStage_Sensitivity, memory, &reportWriter, log))
+    {
+        TIMED_BLOCK(Sensitivity);
+
+        BoilerSensitivity sensitivity;
+        CalculateBoilerSensitivity(&input, 0, &sensitivity);
+        BeginReport(&stageReport, "sensitivity");
+        AddReportValue(&stageReport, "dT3/dLd", "dT3/dLd\t\t\t\t\t\t", "°C/м", sensitivity.T3.D[BoilerInput_Ld], 4);
+        AddReportValue(&stageReport, "dT3/dU", "dT3/dU\t\t\t\t\t\t", "°C на кг/(м2 час)", sensitivity.T3.D[BoilerInput_U], 4);
+        AddReportValue(&stageReport, "dk1/dDIn", "dk1/dDIn\t\t\t\t\t", "1/м", sensitivity.K1.D[BoilerInput_DIn], 4);
+        AddReportValue(&stageReport, "dQt/dK", "dQt/dK\t\t\t\t\t\t", "кал/час на кал/кг", sensitivity.Qt.D[BoilerInput_K], 4);
+        WriteStageReport(stageCache, memory, &reportWriter, &stageReport);
+
+        EndStage(stageCache);
+    }
+
+    // граф зависимостей: изменение одного входа пересчитывает только
+    // зависящие от него величины
+    if ((stages & CalculationStage_Graph) &&
+        BeginStage(stageCache, CalculationStage_Graph, memory, &reportWriter, log))
+    {
+        TIMED_BLOCK(Graph);
+
+        BoilerGraph graph;
+        InitializeBoilerGraph(&graph, fireChamber, dd, Ld, nd, q22, t, fuel);
+        u32 fullNodeCount = UpdateBoilerGraph(&graph);
+
+        SetBoilerGraphInput(&graph, BoilerNode_Ld, Ld + MillimeterToMeter(100));
+        u32 ldNodeCount = UpdateBoilerGraph(&graph);
+        f64 graphLdT3 = graph.Values[BoilerNode_T3];
+        SetBoilerGraphInput(&graph, BoilerNode_Ld, Ld);
+        UpdateBoilerGraph(&graph);
+
+        SetBoilerGraphInput(&graph, BoilerNode_alpha, fuel.alpha + 0.05);
+        u32 alphaNodeCount = UpdateBoilerGraph(&graph);
+        f64 graphAlphaOmega = graph.Values[BoilerNode_Omega];
+        SetBoilerGraphInput(&graph, BoilerNode_alpha, fuel.alpha);
+        UpdateBoilerGraph(&graph);
+
+        const u32 graphStepCount = 64;
+        f64 graphT3[graphStepCount];
+        u32 sweepNodeCount = SweepBoilerGraph(&graph, BoilerNode_Ld, MillimeterToMeter(3500), MillimeterToMeter(5500),
+                                              graphStepCount, BoilerNode_T3, graphT3);
+        BeginReport(&stageReport, "graph");
+        AddReportValue(&stageReport, "NodeCount", "Граф: величин\t\t\t\t\t", 0, fullNodeCount, 0);
+        AddReportValue(&stageReport, "LdT3", "Граф: T3 при Ld + 100 мм\t\t\t", "°C", graphLdT3);
+        AddReportValue(&stageReport, "LdNodes", "Граф: Ld + 100 мм, пересчитано величин\t\t", 0, ldNodeCount, 0);
+        AddReportValue(&stageReport, "AlphaOmega", "Граф: omega при alpha + 0.05\t\t\t", 0, graphAlphaOmega);
+        AddReportValue(&stageReport, "AlphaNodes", "Граф: alpha + 0.05, пересчитано величин\t\t", 0, alphaNodeCount, 0);
+        AddReportValue(&stageReport, "SweepT3Min", "Граф: T3 при Ld 5.5 м\t\t\t\t", "°C", graphT3[graphStepCount - 1]);
+        AddReportValue(&stageReport, "SweepT3Max", "Граф: T3 при Ld 3.5 м\t\t\t\t", "°C", graphT3[0]);
+        AddReportValue(&stageReport, "SweepNodes", "Граф: перебор Ld, пересчитано величин\t\t", 0, sweepNodeCount, 0);
+        AddReportValue(&stageReport, "SweepNodesFull", "Граф: перебор Ld, величин без графа\t\t", 0, graphStepCount * fullNodeCount, 0);
+        WriteStageReport(stageCache, memory, &reportWriter, &stageReport);
+
+        EndStage(stageCache);
+    }
+
+    // дымогарные трубы по участкам: профиль температуры газов расчетного
+    // котла и скорость на пакете котлов вокруг него
+    if ((stages & CalculationStage_FireTube) &&
+        BeginStage(stageCache, CalculationStage_FireTube, memory, &reportWriter, log))
+    {
+        TIMED_BLOCK(FireTube);
+        auto tempMem = BeginTemporaryMemory(transientArena);
+
+        auto tubes = PushFireTubeProfile(transientArena, &input, &output, calculationInput->tk, true);
+        if (tubes.T3)
+        {
+            CalculateFireTubeProfile(&tubes, 1);
+            u32 segmentCount = tubes.SegmentCount[0];
+            BeginReport(&stageReport, "firetube");
+            AddReportValue(&stageReport, "T3", "Дымогарные трубы по участкам: T3\t\t", "°C", tubes.T3[0]);
+            AddReportValue(&stageReport, "GetT3", "T3 по GetT3\t\t\t\t\t", "°C", T3);
+            AddReportValue(&stageReport, "SegmentCount", "Дымогарные трубы: участков\t\t\t", 0, segmentCount, 0);
+            AddReportValue(&stageReport, "K", "Дымогарные трубы: k\t\t\t\t", 0, tubes.K[0]);
+            WriteStageReport(stageCache, memory, &reportWriter, &stageReport);
+
+            // температура газов на границах участков
+            auto profileX = PushArray(transientArena, segmentCount + 1, f64);
+            if (profileX)
+            {
+                for (u32 row = 0; row <= segmentCount; ++row)
+                {
+                    profileX[row] = Ld * row / segmentCount;
+                }
+
+                BeginReport(&stageReport, "firetube_profile", segmentCount + 1);
+                stageReport.Title = "Температура газов по длине дымогарных труб";
+                AddReportField(&stageReport, "x", 0, "м", profileX, 3);
+                AddReportField(&stageReport, "T", 0, "°C", tubes.Profile, 0);
+                WriteStageReport(stageCache, memory, &reportWriter, &stageReport);
+            }
+        }
+
+        const u32 tubeBatchCount = 4096;
+        auto tubeInput = PushBoilerBatchInput(transientArena, tubeBatchCount);
+        auto tubeOutput = PushBoilerBatchOutput(transientArena, tubeBatchCount);
+        if (tubeInput.Ld && tubeOutput.T3)
+        {
+            tubeInput.Fuels = &fuel;
+            tubeInput.t = t;
+            for (u32 index = 0; index < tubeBatchCount; ++index)
+            {
+                CopyBoilerBatchVariant(&tubeInput, index, &input, 0);
+                tubeInput.Ld[index] = Map(index % 64, 0.0, 63.0, MillimeterToMeter(3500), MillimeterToMeter(5500));
+                tubeInput.Nd[index] = (u16)(150 + index / 64 * 110 / 63);
+            }
+            CalculateBoilerBatch(&tubeInput, &tubeOutput);
+
+            auto tubeBatch = PushFireTubeProfile(transientArena, &tubeInput, &tubeOutput, calculationInput->tk, false);
+            if (tubeBatch.T3)
+            {
+                auto startTime = std::chrono::steady_clock::now();
+                CalculateFireTubeProfile(&tubeBatch, tubeBatchCount);
+                auto endTime = std::chrono::steady_clock::now();
+                f64 seconds = std::chrono::duration<f64>(endTime - startTime).count();
+
+                u32 totalSegments = 0;
+                for (u32 index = 0; index < tubeBatchCount; ++index)
+                {
+                    totalSegments += tubeBatch.SegmentCount[index];
+                }
+                fprintf(log, "Дымогарные трубы по участкам, пакет\t\t%u котлов за %.2lf мс, %.0lf тыс/с (участков в среднем %.1lf)\n",
+                        tubeBatchCount, seconds * 1000.0, tubeBatchCount / seconds / 1000.0,
+                        (f64)totalSegments / tubeBatchCount);
+            }
+        }
+
+        EndTemporaryMemory(tempMem);
+
+        EndStage(stageCache);
+    }
+
+    // котел с пароперегревателем: раздел газов между дымогарными и жаровыми
+    // трубами, согласованный с температурами в них
+    if ((stages & CalculationStage_GasPath) &&
+        BeginStage(stageCache, CalculationStage_GasPath, memory, &reportWriter, log))
+    {
+        TIMED_BLOCK(GasPath);
+        auto tempMem = BeginTemporaryMemory(transientArena);
+
+        const u32 pathCount = 4096;
+        auto pathInput = PushBoilerBatchInput(transientArena, pathCount);
+        auto pathOutput = PushBoilerBatchOutput(transientArena, pathCount);
+        auto boilers = PushArray(transientArena, pathCount, Boiler);
+        GasPathBatch path = {};
+        path.Beta = PushArray(transientArena, pathCount, f64);
+        path.T3 = PushArray(transientArena, pathCount, f64);
+        path.T3d = PushArray(transientArena, pathCount, f64);
+        path.T3z = PushArray(transientArena, pathCount, f64);
+        path.Qw = PushArray(transientArena, pathCount, f64);
+        path.Qi = PushArray(transientArena, pathCount, f64);
+        path.Ki = PushArray(transientArena, pathCount, f64);
+        if (pathInput.Ld && pathOutput.T3 && boilers && path.Ki)
+        {
+            // строка 0 - расчетный котел, дальше - перебор числа дымогарных
+            // и жаровых труб вокруг него
+            pathInput.Fuels = &fuel;
+            pathInput.t = t;
+            for (u32 index = 0; index < pathCount; ++index)
+            {
+                CopyBoilerBatchVariant(&pathInput, index, &input, 0);
+                boilers[index] = calculationInput->Superheated;
+                boilers[index].Nd = (u16)(boilers[index].Nd - 30 + (index % 64));
+                boilers[index].Nz = (u16)(boilers[index].Nz - 8 + (index / 64) / 4);
+                boilers[index].Hi = calculationInput->Superheated.Hi * boilers[index].Nz / calculationInput->Superheated.Nz;
+            }
+            boilers[0] = calculationInput->Superheated;
+            CalculateBoilerBatch(&pathInput, &pathOutput);
+
+            path.Count = pathCount;
+            path.Boilers = boilers;
+            path.Input = &pathInput;
+            path.Output = &pathOutput;
+            path.tk = calculationInput->tk;
+            path.ti = calculationInput->ti;
+            auto pathStats = SolveGasPathBatch(transientArena, &path);
+
+            Boiler design = boilers[0];
+            CalculateBoiler(design, Ht);
+            auto rd = GetHydraulicRadius(design.Dd);
+            auto rz = GetHydraulicRadius(design.Dz1);
+            auto rzi = GetAnnulusHydraulicRadius(design.Dz2, design.Di);
+            auto assumedBeta = GetBeta(design.Ld, rd, GetPipeSquare(design.Dd) * design.Nd, design.Lz1, rz,
+                                       GetPipeSquare(design.Dz1) * design.Nz, design.Lz2, rzi,
+                                       GetAnnulusSquare(design.Dz2, design.Di) * design.Nz);
+            auto Qt0 = pathOutput.Q0[0];
+            fprintf(log, "Газовый тракт, пакет\t\t\t\t%u котлов за %.2lf мс (итераций %u)\n",
+                    pathStats.RowCount, pathStats.Seconds * 1000.0, pathStats.Iterations);
+            BeginReport(&stageReport, "gaspath");
+            AddReportValue(&stageReport, "Nd", "Котел с перегревателем: дымогарных труб\t\t", 0, design.Nd, 0);
+            AddReportValue(&stageReport, "Nz", "Котел с перегревателем: жаровых труб\t\t", 0, design.Nz, 0);
+            AddReportValue(&stageReport, "Hk", "Котел с перегревателем: Hk\t\t\t", "м2", design.Hk);
+            AddReportValue(&stageReport, "Hi", "Котел с перегревателем: Hi\t\t\t", "м2", design.Hi);
+            AddReportValue(&stageReport, "Beta", "Доля газов через жаровые трубы beta\t\t", 0, path.Beta[0], 4);
+            AddReportValue(&stageReport, "GetBeta", "beta по GetBeta\t\t\t\t\t", 0, assumedBeta, 4);
+            AddReportValue(&stageReport, "T3", "T3 после смешения\t\t\t\t", "°C", path.T3[0]);
+            AddReportValue(&stageReport, "T3d", "T3 дымогарных труб\t\t\t\t", "°C", path.T3d[0]);
+            AddReportValue(&stageReport, "T3z", "T3 жаровых труб\t\t\t\t\t", "°C", path.T3z[0]);
+            AddReportValue(&stageReport, "Qi", "Тепло пару в перегревателе\t\t\t", "кал/час", path.Qi[0], 0);
+            AddReportValue(&stageReport, "QiShare", "Тепло пару в перегревателе, доля Q0\t\t", "%", path.Qi[0] / Qt0 * 100.0);
+            AddReportValue(&stageReport, "Ki", "Перегреватель: Ki\t\t\t\t", 0, path.Ki[0]);
+            AddReportValue(&stageReport, "Converged", "Газовый тракт: сошлось\t\t\t\t", 0, pathStats.Converged, 0);
+            AddReportValue(&stageReport, "NoConvergence", "Газовый тракт: не сошлось\t\t\t", 0, pathStats.NoConvergence, 0);
+            WriteStageReport(stageCache, memory, &reportWriter, &stageReport);
+        }
+
+        EndTemporaryMemory(tempMem);
+
+        EndStage(stageCache);
+    }
+
+    CheckArena(&appState->PermanentArena);
+    CheckArena(transientArena);
+
+    fprintf(log, "Память: постоянная %llu из %llu МБ, временная (пик) %llu из %llu МБ%s\n",
+            (unsigned long long)ToMegabytes(appState->PermanentArena.HighWaterMark),
+            (unsigned long long)ToMegabytes(appState->PermanentArena.Size),
+            (unsigned long long)ToMegabytes(transientArena->HighWaterMark),
+            (unsigned long long)ToMegabytes(transientArena->Size),
+            memory->LargePages ? ", большие страницы" : "");
+
+    // снимок должен сохранить все, что занято в постоянной памяти
+    memory->PermanentStorageUsed = sizeof(AppState) + appState->PermanentArena.Used;
 }
+
+#if EDITOR_PROFILE
+static_assert(__COUNTER__ <= DEBUG_MAX_COUNTERS, "DEBUG_MAX_COUNTERS is too small for the timed blocks");
+#endif
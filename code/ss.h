@@ -16,9 +16,21 @@
 #define Assert(expression)
 #endif
 
+#define InvalidCodePath Assert(!"InvalidCodePath")
+#define InvalidDefaultCase \
+    default:               \
+    {                      \
+        InvalidCodePath;   \
+    }                      \
+    break
+
 #include "ss_math.h"
+#include "ss_dual.h"
+#include "ss_debug.h"
 
 #define ArrayCount(array) (sizeof(array) / sizeof((array)[0]))
+#define Minimum(a, b) ((a) < (b) ? (a) : (b))
+#define Maximum(a, b) ((a) > (b) ? (a) : (b))
 
 #define Kilobytes(bytes) ((bytes)*1024LL)
 #define Megabytes(bytes) (Kilobytes(bytes) * 1024LL)
@@ -32,67 +44,1117 @@
 
 #define MillimeterToMeter(m) ((m) / 1000.0)
 
-struct PipeDiameter
+//
+// NOTE: Arenas carve the memory block the platform layer passes to Calculate.
+// Nothing in the calculation code calls malloc; everything is pushed here and
+// released by popping back or by ending a temporary memory scope.
+//
+
+#define ARENA_DEFAULT_ALIGNMENT 64
+
+struct MemoryArena
+{
+    u64 Size;
+    u8 *Base;
+    u64 Used;
+    u64 HighWaterMark; // максимальное значение Used за все время
+
+    i32 TempCount;
+};
+
+struct TemporaryMemory
+{
+    MemoryArena *Arena;
+    u64 Used;
+};
+
+inline void
+InitializeArena(MemoryArena *arena, u64 size, void *base)
+{
+    arena->Size = size;
+    arena->Base = (u8 *)base;
+    arena->Used = 0;
+    arena->HighWaterMark = 0;
+    arena->TempCount = 0;
+}
+
+inline u64
+GetAlignmentOffset(MemoryArena *arena, u64 alignment)
+{
+    u64 alignmentOffset = 0;
+
+    u64 resultPointer = (u64)arena->Base + arena->Used;
+    u64 alignmentMask = alignment - 1;
+    if (resultPointer & alignmentMask)
+    {
+        alignmentOffset = alignment - (resultPointer & alignmentMask);
+    }
+
+    return alignmentOffset;
+}
+
+inline u64
+GetArenaSizeRemaining(MemoryArena *arena, u64 alignment = ARENA_DEFAULT_ALIGNMENT)
+{
+    u64 result = arena->Size - (arena->Used + GetAlignmentOffset(arena, alignment));
+    return result;
+}
+
+#define PushStruct(arena, type, ...) (type *)PushSize_(arena, sizeof(type), ##__VA_ARGS__)
+#define PushArray(arena, count, type, ...) (type *)PushSize_(arena, (count) * sizeof(type), ##__VA_ARGS__)
+#define PushSize(arena, size, ...) PushSize_(arena, size, ##__VA_ARGS__)
+
+// NOTE: Returns 0 when the arena is exhausted (and asserts in slow builds),
+// so the block size is a hard cap on memory use.
+inline void *
+PushSize_(MemoryArena *arena, u64 sizeInit, u64 alignment = ARENA_DEFAULT_ALIGNMENT)
+{
+    u64 alignmentOffset = GetAlignmentOffset(arena, alignment);
+    u64 size = sizeInit + alignmentOffset;
+
+    Assert((arena->Used + size) <= arena->Size);
+    if ((arena->Used + size) > arena->Size)
+    {
+        return 0;
+    }
+
+    void *result = arena->Base + arena->Used + alignmentOffset;
+    arena->Used += size;
+    if (arena->HighWaterMark < arena->Used)
+    {
+        arena->HighWaterMark = arena->Used;
+    }
+
+    return result;
+}
+
+// Frees pointer and everything pushed after it.
+inline void
+PopTo(MemoryArena *arena, void *pointer)
+{
+    u64 used = (u8 *)pointer - arena->Base;
+    Assert(used <= arena->Used);
+    arena->Used = used;
+}
+
+inline TemporaryMemory
+BeginTemporaryMemory(MemoryArena *arena)
+{
+    TemporaryMemory result;
+
+    result.Arena = arena;
+    result.Used = arena->Used;
+
+    ++arena->TempCount;
+
+    return result;
+}
+
+inline void
+EndTemporaryMemory(TemporaryMemory tempMem)
+{
+    MemoryArena *arena = tempMem.Arena;
+    Assert(arena->Used >= tempMem.Used);
+    arena->Used = tempMem.Used;
+    Assert(arena->TempCount > 0);
+    --arena->TempCount;
+}
+
+inline void
+CheckArena(MemoryArena *arena)
+{
+    Assert(arena->TempCount == 0);
+}
+
+// FNV-1a
+inline u64
+HashBytes(const void *data, u64 size, u64 hash = 14695981039346656037ULL)
+{
+    const u8 *byte = (const u8 *)data;
+    while (size--)
+    {
+        hash ^= *byte++;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+#define ZeroStruct(instance) ZeroSize(sizeof(instance), &(instance))
+inline void
+ZeroSize(u64 size, void *ptr)
+{
+    u8 *byte = (u8 *)ptr;
+    while (size--)
+    {
+        *byte++ = 0;
+    }
+}
+
+#include "ss_boiler.h"
+
+// Свойства, которые зависят только от топлива: считаются один раз на
+// топливо (GetFuelConstants), а не на каждый вариант котла.
+struct FuelConstants
+{
+    f64 L0;  // теоретический расход воздуха на 1 кг топлива
+    f64 Gbc; // M = Gbc * Bh
+    f64 Gbb; // N = Gbb * Bh
+};
+
+// Библиотека топлив - двоичный файл, который собирает ss_fuelc из текстового
+// каталога, а платформа отображает в память только для чтения
+// (AppMemory::FuelLibrary). Файл: заголовок, записи FuelRecord по возрастанию
+// Id с RecordOffset, затем индекс имен - номера записей по возрастанию Name
+// (u32[RecordCount]) с NameIndexOffset.
+// NOTE: Records are used in place from the mapping, so the layout is fixed:
+// 64-byte aligned, the part the batch reads (Composition and Constants) in
+// the first three cache lines, the name only for lookup.
+#define FUEL_LIBRARY_MAGIC 0x31465353 // "SSF1"
+#define FUEL_NAME_COUNT 108
+
+struct alignas(64) FuelLibraryHeader
+{
+    u32 Magic;
+    u32 HeaderSize;
+    u32 RecordSize;
+    u32 RecordCount;
+    u64 RecordOffset;
+    u64 NameIndexOffset;
+    u64 FileSize;
+};
+
+struct alignas(64) FuelRecord
+{
+    Fuel Composition; // элементарный состав, K, alpha, beta0 и состав газов
+    FuelConstants Constants;
+    u32 Id;
+    char Name[FUEL_NAME_COUNT]; // UTF-8, с нулем в конце
+};
+
+static_assert(sizeof(FuelLibraryHeader) == 64, "Fuel library header layout changed");
+static_assert(sizeof(FuelRecord) == 256, "Fuel library record layout changed");
+
+// Пакетный расчет: входные и выходные данные хранятся массивами
+// (по одному элементу на вариант котла), чтобы за один вызов
+// рассчитать тысячи вариантов.
+struct BoilerBatchInput
+{
+    u32 Count;
+
+    // огневая коробка
+    f64 *TopLengh;
+    f64 *TopWidth;
+    f64 *BottomLength;
+    f64 *BottomWidth;
+    f64 *FrontHeight;
+    f64 *RearHeight;
+
+    // дымогарные трубы
+    f64 *DOut; // внешний диаметр в метрах
+    f64 *DIn;  // внутренний диаметр в метрах
+    f64 *Ld;   // длина труб
+    u16 *Nd;   // число труб
+
+    f64 *U;   // напряжение колосниковой решетки
+    f64 *q22; // суммарная потеря от уноса, шлака и провала угля в %
+
+    Fuel *Fuels;    // таблица топлив
+    u32 *FuelIndex; // индекс топлива в Fuels, 0 - все варианты используют Fuels[0]
+
+    // записи библиотеки топлив вместо Fuels: FuelIndex - номер записи, L0, M и N
+    // берутся из готовых FuelConstants
+    FuelRecord *FuelRecords;
+
+    f64 t; // температура окружающего воздуха °C
+};
+
+inline Fuel *
+GetBatchFuel(BoilerBatchInput *input, u32 index)
+{
+    u32 fuelIndex = input->FuelIndex ? input->FuelIndex[index] : 0;
+    Fuel *result = input->FuelRecords ? &input->FuelRecords[fuelIndex].Composition : &input->Fuels[fuelIndex];
+    return result;
+}
+
+struct BoilerBatchOutput
+{
+    f64 *R;      // площадь колосниковой решетки
+    f64 *Ht;     // поверхность нагрева огневой коробки
+    f64 *Hd;     // поверхность нагрева дымогарных труб
+    f64 *L0;     // теоретический расход воздуха
+    f64 *Bh;     // сжигаемое топливо в час
+    f64 *BhFact; // фактически сжигаемое топливо в час
+    f64 *T1;     // действительная температура горения
+    f64 *T2;     // температура при входе газов в отверстия
+    f64 *T3;     // температура газов на выходе котла
+    f64 *Tabs;   // ср. абс. температура газов в дымогарных трубах
+    f64 *Q0;     // располагаемое тепло
+    f64 *Q21;    // химические потери тепла
+    f64 *Q22;    // механические потери тепла
+    f64 *Q3;     // потеря тепла с уходящими газами
+    f64 *Q4;     // потери на внешнее охлаждение
+    f64 *Qt;     // тепло проходящее в котел через топочную
+    f64 *Omega;  // скорость газов в дымогарных трубах
+    f64 *K1;     // коэффициент теплопередачи
+    f64 *M;      // коэффициенты уравнения тепла
+    f64 *N;
+};
+
+// Стадии пакетного расчета, каждую можно пересчитать отдельно
+enum boiler_stage
+{
+    BoilerStage_Front = 0x1,     // R, Ht, Hd, L0, Bh, BhFact, M, N, Q0, Q21, Q22, T1, Q4
+    BoilerStage_FireTubes = 0x2, // T2, T3, Tabs, Omega, K1
+    BoilerStage_Losses = 0x4,    // Q3, Qt
+
+    BoilerStage_All = 0x7,
+};
+
+// Цепочка расчета дымогарных труб GetT2 -> GetT3 -> GetTabs -> GetOmega -> GetK
+// для массива вариантов (см. ss_boiler_wide.cpp)
+struct FireTubeChain
+{
+    // входные данные
+    f64 *BhFact; // фактически сжигаемое топливо в час
+    f64 *Ht;     // поверхность нагрева огневой коробки
+    f64 *K;      // теплопроизводительность топлива
+    f64 *Alpha;  // коэффициент избытка воздуха
+    f64 *L0;     // теоретический расход воздуха
+    f64 *DOut;   // внешний диаметр дымогарной трубы
+    f64 *DIn;    // внутренний диаметр дымогарной трубы
+    f64 *Ld;     // длина труб
+    u16 *Nd;     // число труб
+
+    // выходные данные
+    f64 *T2;
+    f64 *T3;
+    f64 *Tabs;
+    f64 *Omega;
+    f64 *K1;
+};
+
+// Дымогарные трубы по участкам (см. ss_firetube.cpp): длина Ld делится на
+// SegmentCount участков, на каждом скорость газов GetWd и коэффициент
+// теплопередачи GetKd берутся при местной температуре газов.
+// Массивы - по одному значению на группу труб.
+#define FIRE_TUBE_MAX_SEGMENTS 64
+#define FIRE_TUBE_SEGMENT_NTU 0.05 // единиц переноса на участок при выборе SegmentCount
+
+struct FireTubeProfile
+{
+    // входные данные
+    f64 *T2;     // температура газов на входе в трубы
+    f64 *M;      // коэффициенты уравнения тепла всего потока газов
+    f64 *N;
+    f64 *L0;     // теоретический расход воздуха
+    f64 *Alpha;  // коэффициент избытка воздуха
+    f64 *BhFact; // фактически сжигаемое топливо в час
+    f64 *DOut;   // внешний диаметр трубы
+    f64 *DIn;    // внутренний диаметр трубы
+    f64 *Ld;     // длина труб
+    u16 *Nd;     // число труб в группе
+    f64 *Beta;   // доля газов, идущая мимо группы; 0 - весь поток через нее
+    u16 *SegmentCount; // 1..FIRE_TUBE_MAX_SEGMENTS
+    f64 tk;      // температура воды в котле
+
+    // необязательно: элементы пароперегревателя внутри труб группы
+    f64 *DElement; // внешний диаметр элемента, газ идет по кольцевому сечению
+    f64 *SinkKH;   // Ki * Hi перегревателя на всю длину группы
+    f64 SinkT;     // средняя температура пара в перегревателе
+
+    // выходные данные
+    f64 *T3;    // температура газов на выходе из труб
+    f64 *Q;     // тепло, отданное газами, кал/час
+    f64 *K;     // средний по поверхности коэффициент теплопередачи воде
+    f64 *QSink; // необязательно: часть Q, ушедшая в перегреватель
+
+    // необязательно: температура газов на границах участков, строка s
+    // (0..SegmentCount группы) - Profile + s * ProfileStride
+    f64 *Profile;
+    u32 ProfileStride;
+};
+
+// Газовый тракт котла с пароперегревателем (см. ss_gaspath.cpp): газы из
+// топки делятся между дымогарными и жаровыми трубами (GetBeta), в жаровых
+// трубах за участком Lz1 стоят элементы перегревателя (GetKi)
+#define GAS_PATH_DEFAULT_TOLERANCE 1e-10
+#define GAS_PATH_DEFAULT_MAX_ITERATIONS 30
+
+enum gas_path_status
+{
+    GasPathStatus_Converged,
+    GasPathStatus_NoConvergence, // не сошлось за MaxIterations или beta вне (0, 1)
+};
+
+// Строка i - трубная часть Boilers[i] с топкой варианта i пакетного расчета
+struct GasPathBatch
+{
+    u32 Count;
+
+    // входные данные
+    Boiler *Boilers;           // Ld, Nd, Dd, Lz1, Lz2, Nz, Dz1, Dz2, Di, Hi
+    BoilerBatchInput *Input;   // топлива вариантов
+    BoilerBatchOutput *Output; // T2, M, N, L0, BhFact после CalculateBoilerBatch
+    f64 tk;                    // температура воды в котле
+    f64 ti;                    // средняя температура пара в перегревателе
+
+    f64 Tolerance;     // допустимая невязка beta, 0 - по умолчанию
+    u32 MaxIterations; // 0 - по умолчанию
+
+    // результат
+    f64 *Beta; // доля газов через жаровые трубы
+    f64 *T3;   // температура газов в дымовой коробке после смешения
+    f64 *T3d;  // на выходе дымогарных труб
+    f64 *T3z;  // на выходе жаровых труб
+    f64 *Qw;   // тепло воде, кал/час
+    f64 *Qi;   // тепло пару в перегревателе, кал/час
+    f64 *Ki;   // коэффициент теплопередачи перегревателя
+    u8 *Status;     // gas_path_status, необязательно
+    u8 *Iterations; // необязательно
+};
+
+struct GasPathStats
+{
+    u32 RowCount;
+    u32 Converged;
+    u32 NoConvergence;
+    u32 Iterations; // проходов по всему пакету
+    u64 Evaluations;
+    f64 Seconds;
+};
+
+// Перебор вариантов котла по сетке параметров
+enum sweep_parameter
+{
+    SweepParameter_TopLengh,
+    SweepParameter_TopWidth,
+    SweepParameter_BottomLength,
+    SweepParameter_BottomWidth,
+    SweepParameter_FrontHeight,
+    SweepParameter_RearHeight,
+    SweepParameter_DOut,
+    SweepParameter_DIn,
+    SweepParameter_Ld,
+    SweepParameter_Nd,
+    SweepParameter_U,
+    SweepParameter_q22,
+
+    SweepParameter_Count,
+};
+
+// Steps <= 1 - параметр не перебирается и равен Min
+struct SweepRange
+{
+    f64 Min;
+    f64 Max;
+    u32 Steps;
+};
+
+struct SweepSpec
+{
+    SweepRange Ranges[SweepParameter_Count];
+    Fuel BaseFuel;
+    f64 t; // температура окружающего воздуха °C
+};
+
+struct SweepStats
+{
+    u64 VariantCount;
+    u64 ComputedVariants; // посчитана хотя бы одна стадия
+    u64 ReusedVariants; // взяты из кэша без пересчета
+    u32 ChunkCount;
+    u32 ThreadCount;
+    u32 StolenChunks;
+    u32 ReusedChunks;
+    u64 FallbackCount; // отбор в f32: вариантов пересчитано в f64
+    f64 Seconds;
+    f64 VariantsPerSecond; // по посчитанным вариантам
+};
+
+// Обратная задача: по заданным выходам (T3, Q3, ...) найти геометрию
+// дымогарных труб. Неизвестных столько же, сколько целей.
+#define INVERSE_MAX_UNKNOWNS 3
+
+enum inverse_unknown
+{
+    InverseUnknown_Ld,   // длина труб
+    InverseUnknown_DOut, // внешний диаметр, толщина стенки остается как в исходном варианте
+    InverseUnknown_Nd,   // число труб, целое
+
+    InverseUnknown_Count,
+};
+
+enum inverse_target
+{
+    InverseTarget_T3,
+    InverseTarget_Q3,
+    InverseTarget_Omega,
+    InverseTarget_Hd,
+
+    InverseTarget_Count,
+};
+
+enum inverse_status
+{
+    InverseStatus_Converged,
+    InverseStatus_OutOfBounds,   // цель недостижима в границах, взята лучшая граница
+    InverseStatus_NoConvergence, // не сошлось за MaxIterations
+};
+
+struct InverseSpec
+{
+    u32 UnknownCount;
+    u32 Unknowns[INVERSE_MAX_UNKNOWNS]; // inverse_unknown
+    f64 Min[INVERSE_MAX_UNKNOWNS];
+    f64 Max[INVERSE_MAX_UNKNOWNS];
+    u32 Targets[INVERSE_MAX_UNKNOWNS]; // inverse_target
+
+    f64 Tolerance;      // допустимая относительная невязка, 0 - по умолчанию
+    u32 MaxIterations;  // 0 - по умолчанию
+};
+
+// Пакет обратных задач: строка i - исходный вариант Base[i] и его цели
+struct InverseBatch
+{
+    BoilerBatchInput *Base;
+    f64 *TargetValues[INVERSE_MAX_UNKNOWNS];
+
+    // результат
+    f64 *Solution[INVERSE_MAX_UNKNOWNS];
+    f64 *Achieved[INVERSE_MAX_UNKNOWNS]; // значения целей в найденной точке
+    u8 *Status;                          // inverse_status
+    u8 *Iterations;
+};
+
+struct InverseStats
+{
+    u32 RowCount;
+    u32 Converged;
+    u32 OutOfBounds;
+    u32 NoConvergence;
+    u32 Iterations; // проходов по всему пакету
+    u64 Evaluations;
+    f64 Seconds;
+};
+
+// Тяга: напряжение решетки U, при котором разрежение в дымовой коробке
+// (дымовая труба и конус) равно сопротивлению решетки со слоем топлива и
+// дымогарных труб. Разрежение конуса растет с испарением котла.
+#define DRAFT_DEFAULT_TOLERANCE 1e-9
+#define DRAFT_DEFAULT_MAX_ITERATIONS 60
+
+struct DraftSpec
+{
+    f64 UMin; // границы напряжения колосниковой решетки
+    f64 UMax;
+
+    f64 ChimneyDraft;     // тяга дымовой трубы, мм вод. ст.
+    f64 BlastCoefficient; // разрежение от конуса при 1 т/час пара, мм вод. ст.
+    f64 BlastExponent;    // показатель степени по расходу пара (меньше 2)
+
+    f64 GrateResistance; // коэффициент сопротивления решетки со слоем топлива
+    f64 TubeFriction;    // коэффициент трения в дымогарных трубах
+    f64 TubeEntryExit;   // сопротивление входа в трубы и выхода из них
+
+    f64 SteamEnthalpy; // теплосодержание пара в котле в кал/кг
+    f64 FeedT;         // температура питательной воды °C
+
+    f64 Tolerance;     // допустимая относительная невязка, 0 - по умолчанию
+    u32 MaxIterations; // 0 - по умолчанию
+};
+
+enum draft_status
+{
+    DraftStatus_Converged,
+    DraftStatus_OutOfBounds,   // тяги не хватает или хватает с избытком во всех границах U
+    DraftStatus_NoConvergence, // не сошлось за MaxIterations
+};
+
+// Пакет: строка i - вариант Base[i], его U не используется
+struct DraftBatch
+{
+    BoilerBatchInput *Base;
+
+    // результат
+    f64 *U;
+    f64 *Bh;
+    f64 *T3;
+    f64 *Draft;       // разрежение в дымовой коробке, мм вод. ст.
+    f64 *Evaporation; // испарение котла кг/час
+    u8 *Status;       // draft_status
+    u8 *Iterations;
+};
+
+struct DraftStats
+{
+    u32 RowCount;
+    u32 Converged;
+    u32 OutOfBounds;
+    u32 NoConvergence;
+    u32 Iterations; // проходов по всему пакету
+    u64 Evaluations;
+    f64 Seconds;
+};
+
+// Движение поезда по профилю пути (ss_traction.cpp): сила тяги по машине
+// (GetF), ограниченная сцеплением и паром, который котел дает при текущей
+// форсировке, против сопротивления поезда, подъема и кривых.
+#define TRACTION_FIRING_LEVELS 8 // точек таблицы котла по напряжению решетки
+
+// Участок пути
+struct RouteSection
+{
+    f64 Length;      // м
+    f64 Grade;       // уклон в тысячных, подъем положительный
+    f64 CurveRadius; // м, 0 - прямая
+    f64 SpeedLimit;  // км/ч
+};
+
+struct TractionRoute
+{
+    RouteSection *Sections;
+    u32 SectionCount;
+};
+
+// Паровоз; котел паровоза i - вариант i в TractionBatch::Boilers
+struct Locomotive
+{
+    f64 CylinderD;    // диаметр цилиндра в см
+    f64 Stroke;       // ход поршня в см
+    f64 Pressure;     // рабочее давление пара в котле по манометру в ат
+    f64 WheelD;       // диаметр движущих колес в см
+    f64 AdhesionMass; // сцепной вес в т
+    f64 Mass;         // паровоз с тендером в т
+    f64 SteamRate;    // расход пара кг на индикаторную л.с. в час
+    f64 H0;           // наружная поверхность котла м^2
+    f64 Phi;          // коэффициент качества изоляции
+};
+
+struct TractionSpec
+{
+    f64 Dt;      // шаг по времени, с
+    f64 MaxTime; // предел времени поездки, с
+
+    // форсировка: кочегар поднимает напряжение решетки до UMax, пока машина
+    // работает паром, и сбрасывает до UIdle на выбеге и торможении
+    f64 UIdle;
+    f64 UMax;
+    f64 FiringLag; // постоянная времени форсировки, с
+
+    f64 Adhesion;    // коэффициент сцепления
+    f64 ResistanceA; // основное удельное сопротивление A + B V + C V^2, кг/т
+    f64 ResistanceB;
+    f64 ResistanceC;
+    f64 Rotating; // доля инерции вращающихся масс
+    f64 Brake;    // замедление при торможении, м/с^2
+
+    f64 SteamEnthalpy; // теплосодержание пара в котле в кал/кг
+    f64 FeedT;         // температура питательной воды °C
+    f64 tk;            // температура воды в котле °C
+};
+
+enum traction_status
+{
+    TractionStatus_Arrived,
+    TractionStatus_Stalled, // не взял с места на подъеме
+    TractionStatus_TimeOut,
+};
+
+// Пакет поездок: строка i - маршрут RouteIndex[i], паровоз LocomotiveIndex[i]
+// и состав массой TrainMass[i]
+struct TractionBatch
+{
+    u32 Count;
+    TractionRoute *Routes;
+    u32 *RouteIndex;
+    Locomotive *Locomotives;
+    u32 *LocomotiveIndex;
+    BoilerBatchInput *Boilers; // по варианту на паровоз, U не используется
+    f64 *TrainMass;            // т
+
+    // результат
+    f64 *Time;     // с
+    f64 *Fuel;     // сожжено топлива, кг
+    f64 *Steam;    // израсходовано пара, кг
+    f64 *MaxSpeed; // км/ч
+    u8 *Status;    // traction_status
+};
+
+struct TractionStats
+{
+    u32 TripCount;
+    u32 Arrived;
+    u32 Stalled;
+    u32 TimedOut;
+    u64 Steps;
+    f64 Seconds;
+};
+
+// Парк (ss_fleet.cpp): все пары (паровоз, рейс) из двух таблиц
+struct DutyCycle
 {
-    f64 DOut; // внешний диаметр в метрах
-    f64 DIn;  // внутренний диаметр в метрах
+    u32 RouteIndex;
+    f64 TrainMass; // т
 };
 
-struct FireChamber
+struct FleetBatch
 {
-    f64 TopLengh;
-    f64 TopWidth;
-    f64 BottomLength;
-    f64 BottomWidth;
-    f64 FrontHeight;
-    f64 RearHeight;
+    u32 LocomotiveCount;
+    Locomotive *Locomotives;
+    BoilerBatchInput *Boilers; // котел паровоза i - вариант i, U не используется
 
-    f64 U;
-    f64 R;
-    f64 Ht;
+    u32 DutyCount;
+    DutyCycle *Duties;
+    TractionRoute *Routes;
+
+    // результат, строка locomotive * DutyCount + duty
+    f64 *Time;  // время в пути, с
+    f64 *Coal;  // сожжено топлива, кг
+    f64 *Water; // израсходовано воды (пара), кг
+    u8 *Status; // traction_status
+};
+
+struct FleetStats
+{
+    u64 TripCount;
+    u64 Arrived;
+    u64 Stalled;
+    u64 TimedOut;
+    u64 Steps;
+    u32 ThreadCount;
+    f64 Coal;  // всего по доехавшим, кг
+    f64 Water; // всего по доехавшим, кг
+    f64 Seconds;
+    f64 TripsPerSecond;
 };
 
-struct Boiler
+// Чувствительность: выходы варианта вместе с производными по всем входам
+// (dual.D[boiler_input]), см. ss_boiler_dual.cpp
+enum boiler_input
 {
-    f64 Hdg; // поверхность нагрева дымогарных труб (газовая)
-    f64 Hz1; // поверхность нагрева жаровых труб (газовая)
-    f64 Hz2; // поверхность нагрева жаровых труб (газовая)
-    f64 Hk;  // полная испаряющая поверхность нагрева котла (водяная)
-    f64 Hi;  // поверхность нагрева пароперегревателя (газовая)
-    f64 Ld;  // Длина труб дымогарных
-    f64 Lz1; // Длина труб жаровых до перегревателя
-    f64 Lz2; // Длина труб жаровых в области перегревателя
+    // огневая коробка
+    BoilerInput_TopLengh,
+    BoilerInput_TopWidth,
+    BoilerInput_BottomLength,
+    BoilerInput_BottomWidth,
+    BoilerInput_FrontHeight,
+    BoilerInput_RearHeight,
+    BoilerInput_U,
 
-    u16 Nd; // число дымогарных труб
-    u16 Nz; // число жаровых труб
+    // дымогарные трубы (число труб целое, производной по нему нет)
+    BoilerInput_DOut,
+    BoilerInput_DIn,
+    BoilerInput_Ld,
 
-    PipeDiameter Dd;  // диаметр труб дымогарных
-    PipeDiameter Dz1; // диаметр труб жаровых до перегревателя
-    PipeDiameter Dz2; // диаметр труб жаровых в области перегревателя
-    PipeDiameter Di;  // диаметр труб перегревательных
+    BoilerInput_q22,
+    BoilerInput_t,
+
+    // топливо
+    BoilerInput_C,
+    BoilerInput_H,
+    BoilerInput_S,
+    BoilerInput_O,
+    BoilerInput_N,
+    BoilerInput_W,
+    BoilerInput_A,
+    BoilerInput_CO,
+    BoilerInput_CO2,
+    BoilerInput_O2,
+    BoilerInput_N2,
+    BoilerInput_K,
+    BoilerInput_beta0,
+    BoilerInput_alpha,
+
+    BoilerInput_Count,
 };
+static_assert(BoilerInput_Count <= DUAL_WIDTH, "boiler_input does not fit into dual");
 
-struct Fuel
+// Те же столбцы, что в BoilerBatchOutput, для одного варианта
+struct BoilerSensitivity
 {
-    f64 C;
-    f64 H;
-    f64 S;
-    f64 O;
-    f64 N;
-    f64 W;
-    f64 A;
-    f64 CO;
-    f64 CO2;
-    f64 O2;
-    f64 N2;
-    f64 K;     // теплопроизводительность 1 кг топлива (низшая)
-    f64 beta0; // химическая характеристика топлива
-    f64 alpha; // коэффициент избытка топлива
-    f64 u;
+    dual R;
+    dual Ht;
+    dual Hd;
+    dual L0;
+    dual Bh;
+    dual BhFact;
+    dual T1;
+    dual T2;
+    dual T3;
+    dual Tabs;
+    dual Q0;
+    dual Q21;
+    dual Q22;
+    dual Q3;
+    dual Q4;
+    dual Qt;
+    dual Omega;
+    dual K1;
+    dual M;
+    dual N;
 };
 
-struct HeatCoefficient
+// Оптимизация геометрии котла с ограничениями (ss_optimize.cpp).
+// Переменные - параметры sweep_parameter, целевая функция и ограничения
+// задаются через величины optimize_quantity.
+#define OPTIMIZE_MAX_CONSTRAINTS 8
+
+enum optimize_quantity
 {
-    f64 M;
-    f64 N;
+    OptimizeQuantity_R,     // площадь колосниковой решетки
+    OptimizeQuantity_Ht,    // поверхность нагрева огневой коробки
+    OptimizeQuantity_Hd,    // поверхность нагрева дымогарных труб
+    OptimizeQuantity_Hi,    // полная испаряющая поверхность Ht + Hd
+    OptimizeQuantity_Wall,  // толщина стенки дымогарной трубы (DOut - DIn) / 2
+    OptimizeQuantity_T3,    // температура газов на выходе котла
+    OptimizeQuantity_Omega, // скорость газов в дымогарных трубах
+    OptimizeQuantity_K1,    // коэффициент теплопередачи
+    OptimizeQuantity_Q0,    // располагаемое тепло
+    OptimizeQuantity_Q21,   // химические потери тепла
+    OptimizeQuantity_Q22,   // механические потери тепла
+    OptimizeQuantity_Q3,    // потеря тепла с уходящими газами
+    OptimizeQuantity_Q4,    // потери на внешнее охлаждение
+    OptimizeQuantity_Qt,    // тепло проходящее в котел через топочную
+
+    OptimizeQuantity_Count,
+};
+
+// Min <= величина <= Max; для одностороннего ограничения вторая граница
+// -HUGE_VAL или HUGE_VAL
+struct OptimizeConstraint
+{
+    u32 Quantity; // optimize_quantity
+    f64 Min;
+    f64 Max;
+};
+
+struct OptimizeSpec
+{
+    // границы переменных, Min == Max - параметр закреплен
+    f64 Min[SweepParameter_Count];
+    f64 Max[SweepParameter_Count];
+    f64 Start[SweepParameter_Count]; // начальная точка первого запуска
+
+    Fuel BaseFuel;
+    f64 t; // температура окружающего воздуха °C
+
+    // минимизируется сумма Weights[i] * величина i (для максимизации вес
+    // отрицательный); PerQ0 - сумма делится на Q0, т.е. считается в долях
+    f64 Weights[OptimizeQuantity_Count];
+    b32 PerQ0;
+
+    u32 ConstraintCount;
+    OptimizeConstraint Constraints[OPTIMIZE_MAX_CONSTRAINTS];
+
+    u32 RunCount;       // независимых запусков, 0 - по умолчанию
+    u32 MaxEvaluations; // расчетов на запуск, 0 - по умолчанию
+    u64 Seed;
+};
+
+struct OptimizeResult
+{
+    b32 Feasible;   // все ограничения выполнены
+    f64 Objective;  // значение целевой функции
+    f64 Violation;  // суммарное относительное нарушение ограничений
+    f64 Values[SweepParameter_Count];
+    f64 Quantities[OptimizeQuantity_Count];
+
+    u32 BestRun;
+    u32 RunCount;
+    u32 FeasibleRuns;
+    u32 ThreadCount;
+    u64 Evaluations;
+    f64 Seconds;
+};
+
+// Метод Монте-Карло: разброс состава топлива (ss_montecarlo.cpp)
+enum monte_carlo_variable
+{
+    MonteCarloVariable_C,
+    MonteCarloVariable_H,
+    MonteCarloVariable_O,
+    MonteCarloVariable_alpha, // коэффициент избытка воздуха
+    MonteCarloVariable_u,     // коэффициент механической полноты сгорания
+    MonteCarloVariable_K,     // теплопроизводительность 1 кг топлива
+
+    MonteCarloVariable_Count,
+};
+
+enum monte_carlo_output
+{
+    MonteCarloOutput_T1,
+    MonteCarloOutput_T3,
+    MonteCarloOutput_q21, // потери в % от Q0
+    MonteCarloOutput_q22,
+    MonteCarloOutput_q3,
+    MonteCarloOutput_qt, // тепло через топочную в % от Q0
+
+    MonteCarloOutput_Count,
+};
+
+// треугольное распределение, Mode = Min = Max - величина постоянна
+struct MonteCarloDistribution
+{
+    f64 Min;
+    f64 Mode;
+    f64 Max;
+};
+
+struct MonteCarloSpec
+{
+    MonteCarloDistribution Variables[MonteCarloVariable_Count];
+    Fuel BaseFuel; // остальные поля топлива
+
+    FireChamber Chamber;
+    PipeDiameter Dd;
+    f64 Ld;
+    u16 Nd;
+    f64 t;
+
+    u64 SampleCount;
+    u64 Seed;
+};
+
+#define MONTE_CARLO_HISTOGRAM_BINS 1024
+
+// Границы гистограммы берутся по первому куску выборки с запасом, значения
+// за границами попадают в Below и Above
+struct MonteCarloHistogram
+{
+    f64 Min;
+    f64 Max;
+    u64 Below;
+    u64 Above;
+    u64 Counts[MONTE_CARLO_HISTOGRAM_BINS];
+};
+
+struct MonteCarloStats
+{
+    u64 SampleCount;
+    u32 ChunkCount;
+    u32 ThreadCount;
+    f64 Seconds;
+    f64 SamplesPerSecond;
+
+    f64 Mean[MonteCarloOutput_Count];
+    f64 StdDev[MonteCarloOutput_Count];
+    f64 Lowest[MonteCarloOutput_Count];
+    f64 Highest[MonteCarloOutput_Count];
+    MonteCarloHistogram Histograms[MonteCarloOutput_Count];
+};
+
+// Граф зависимостей величин одного котла (ss_graph.cpp): входы и
+// рассчитываемые величины - узлы, после изменения входа пересчитываются
+// только зависящие от него узлы. Порядок перечисления - топологический:
+// узел зависит только от узлов выше него.
+enum boiler_node
+{
+    // входы: огневая коробка
+    BoilerNode_TopLengh,
+    BoilerNode_TopWidth,
+    BoilerNode_BottomLength,
+    BoilerNode_BottomWidth,
+    BoilerNode_FrontHeight,
+    BoilerNode_RearHeight,
+    BoilerNode_U,
+
+    // входы: дымогарные трубы
+    BoilerNode_DOut,
+    BoilerNode_DIn,
+    BoilerNode_Ld,
+    BoilerNode_Nd,
+
+    BoilerNode_q22,
+    BoilerNode_t,
+
+    // входы: топливо
+    BoilerNode_C,
+    BoilerNode_H,
+    BoilerNode_S,
+    BoilerNode_O,
+    BoilerNode_N,
+    BoilerNode_W,
+    BoilerNode_A,
+    BoilerNode_CO,
+    BoilerNode_CO2,
+    BoilerNode_O2,
+    BoilerNode_N2,
+    BoilerNode_K,
+    BoilerNode_alpha,
+
+    BoilerNode_InputCount,
+
+    // величины цепочки Calculate()
+    BoilerNode_R = BoilerNode_InputCount,
+    BoilerNode_Ht,
+    BoilerNode_Hd,
+    BoilerNode_Bh,
+    BoilerNode_BhFact,
+    BoilerNode_L0,
+    BoilerNode_HeatM, // коэффициенты уравнения тепла HeatCoefficient
+    BoilerNode_HeatN,
+    BoilerNode_Q0,
+    BoilerNode_Q21,
+    BoilerNode_Q22,
+    BoilerNode_T1,
+    BoilerNode_Q4,
+    BoilerNode_T2,
+    BoilerNode_T3,
+    BoilerNode_Tabs,
+    BoilerNode_Omega,
+    BoilerNode_K1,
+    BoilerNode_Q3,
+    BoilerNode_Qt,
+
+    BoilerNode_Count,
+};
+static_assert(BoilerNode_Count <= 64, "boiler_node masks are u64");
+
+struct BoilerGraph
+{
+    f64 Values[BoilerNode_Count];
+    u64 Dependents[BoilerNode_Count]; // узлы, которые напрямую зависят от узла
+    u64 Dirty;                        // узлы, которые надо пересчитать
+
+    u64 Evaluations; // пересчитано узлов за все время
+};
+
+// Результаты перебора, переживающие перезагрузку кода
+struct SweepCache
+{
+    u64 InputHash;    // хэш SweepSpec
+    u64 CodeIdentity; // AppMemory::CodeIdentity сборки, посчитавшей кэш
+    u64 VariantCount;
+    u32 ChunkCount;
+
+    u8 *ChunkStages; // для каждого куска - маска уже посчитанных boiler_stage
+    BoilerBatchOutput Output;
+
+    u8 *Memory; // начало памяти кэша в постоянной арене
+};
+
+// Отчет - набор именованных столбцов одинаковой длины. Расчет только
+// заполняет столбцы, форматирование выполняет ReportWriter потом.
+#define REPORT_MAX_FIELDS 64
+
+struct ReportField
+{
+    const char *Name;  // машинное имя: заголовок CSV и двоичной записи
+    const char *Label; // подпись в таблице, 0 - использовать Name
+    const char *Unit;
+    u32 Decimals;
+    i32 ShareOf; // индекс поля, процент от которого выводится в таблице, -1 - нет
+
+    f64 *Values; // RecordCount значений
+};
+
+// NOTE: Fields added with AddReportValue point into Scalars, so a report
+// that uses them must not be copied.
+struct Report
+{
+    const char *Name;  // имя стадии: строка "# имя" перед блоком CSV, имя в двоичной записи
+    const char *Title; // подпись над таблицей из нескольких записей, 0 - без подписи
+    u64 RecordCount;
+    u32 FieldCount;
+    ReportField Fields[REPORT_MAX_FIELDS];
+    f64 Scalars[REPORT_MAX_FIELDS]; // значения отчета из одной записи
+};
+
+// Буфер вывода: отчет форматируется в него и уходит одной большой записью
+struct ReportWriter
+{
+    FILE *File;
+
+    u64 Size;
+    u64 Used;
+    u8 *Base;
+
+    u64 BytesWritten;
+};
+
+// Стадии Calculate. Расчетный котел считается всегда, остальные - по маске
+// CalculationInput::Stages.
+enum calculation_stage
+{
+    CalculationStage_Sweep = 0x1,
+    CalculationStage_Inverse = 0x2,
+    CalculationStage_Draft = 0x4,
+    CalculationStage_Traction = 0x8, // поездки; UMax - из стадии тяги, если она включена
+    CalculationStage_Fleet = 0x10,
+    CalculationStage_Optimize = 0x20,
+    CalculationStage_MonteCarlo = 0x40,
+    CalculationStage_FuelLibrary = 0x80,
+    CalculationStage_Sensitivity = 0x100,
+    CalculationStage_Graph = 0x200,
+    CalculationStage_FireTube = 0x400,
+    CalculationStage_GasPath = 0x800,
+
+    CalculationStage_All = 0xFFF,
+
+    // отбор перебора в f32 со сравнением с f64 - только по запросу: в
+    // CalculationStage_All не входит, считается в стадии перебора
+    CalculationStage_SweepF32 = 0x1000,
+};
+
+// Полный набор входных данных расчета. Хранится в постоянной памяти,
+// поэтому попадает в снимок и при воспроизведении берется из него.
+struct CalculationInput
+{
+    u32 Stages; // маска calculation_stage
+
+    FireChamber Chamber;
+    PipeDiameter Dd; // дымогарная труба
+    f64 Ld;          // длина труб дымогарных
+    u16 Nd;          // число дымогарных труб
+    f64 q22;         // суммарная потеря от уноса, шлака и провала угля в %
+    f64 t;           // температура окружающего воздуха °C
+    f64 tk;          // температура воды в котле °C
+    Fuel BaseFuel;
+    u32 FuelId;                      // запись библиотеки топлив, 0 - встроенное топливо
+    char FuelName[FUEL_NAME_COUNT];
+
+    Boiler Superheated; // трубная часть котла с пароперегревателем
+    f64 ti;             // средняя температура пара в перегревателе °C
+
+    SweepSpec Sweep;
+    OptimizeSpec Optimize;
+    MonteCarloSpec MonteCarlo;
+    DraftSpec Draft;
+    TractionSpec Traction;
+    Locomotive Engine; // паровоз с расчетным котлом
+};
+
+// Отчеты стадий Calculate в постоянной памяти (см. ss_stage_cache.cpp)
+#define STAGE_CACHE_SIZE Megabytes(1)
+#define STAGE_CACHE_MAX_REPORTS 32
+
+struct StageCache
+{
+    u64 Key;         // хэш входных данных, библиотеки топлив, формата и сборки кода; 0 - кэш выключен
+    u32 ValidStages; // calculation_stage, все отчеты которых сохранены
+    u32 ReportCount;
+    u32 ReportStages[STAGE_CACHE_MAX_REPORTS];
+    b32 ReportRows[STAGE_CACHE_MAX_REPORTS]; // таблица перебора, пишется и с -rows
+    Report *Reports[STAGE_CACHE_MAX_REPORTS];
+    MemoryArena Arena; // STAGE_CACHE_SIZE из постоянной арены
+
+    u32 Stage; // считаемая сейчас стадия, 0 - нет
+    b32 StoreFailed;
+};
+
+// NOTE: Bump the version whenever AppState changes shape; a stale layout
+// found in the block after a reload is then thrown away instead of misread.
+#define APP_STATE_LAYOUT_VERSION 12
+
+struct AppState
+{
+    u32 LayoutVersion; // NOTE: Must stay the first member
+    u32 LayoutSize;
+
+    MemoryArena PermanentArena;
+    MemoryArena TransientArena;
+
+    CalculationInput Input;
+    SweepCache Sweep;
+    StageCache Stages;
 };
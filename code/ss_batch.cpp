@@ -0,0 +1,216 @@
+#define BOILER_BATCH_BLOCK 256
+
+// Пакетный расчет всей цепочки Calculate() для вариантов [first, onePastLast).
+// Варианты обрабатываются блоками: сначала скалярные формулы ss_boiler.cpp
+// до T1, затем цепочка дымогарных труб T2..k1 (векторная, если процессор
+// позволяет), затем потери Q3 и Qt.
+// stages - какие стадии считать (boiler_stage); выходы пропущенных стадий
+// должны быть уже посчитаны в output.
+internal void
+CalculateBoilerBatch(BoilerBatchInput *input, BoilerBatchOutput *output, u32 first, u32 onePastLast,
+                     u32 stages = BoilerStage_All)
+{
+    TIMED_FUNCTION();
+
+    Assert(onePastLast <= input->Count);
+
+    for (u32 blockFirst = first; blockFirst < onePastLast; blockFirst += BOILER_BATCH_BLOCK)
+    {
+        u32 blockCount = onePastLast - blockFirst;
+        if (blockCount > BOILER_BATCH_BLOCK)
+        {
+            blockCount = BOILER_BATCH_BLOCK;
+        }
+
+        for (u32 blockIndex = 0; (stages & BoilerStage_Front) && (blockIndex < blockCount); ++blockIndex)
+        {
+            u32 index = blockFirst + blockIndex;
+
+            FireChamber fireChamber = {};
+            fireChamber.TopLengh = input->TopLengh[index];
+            fireChamber.TopWidth = input->TopWidth[index];
+            fireChamber.BottomLength = input->BottomLength[index];
+            fireChamber.BottomWidth = input->BottomWidth[index];
+            fireChamber.FrontHeight = input->FrontHeight[index];
+            fireChamber.RearHeight = input->RearHeight[index];
+            fireChamber.U = input->U[index];
+            CalculateFireChamber(fireChamber);
+
+            PipeDiameter dd = {};
+            dd.DOut = input->DOut[index];
+            dd.DIn = input->DIn[index];
+
+            auto q22 = input->q22[index];
+
+            // GetBhFact меняет fuel.u, поэтому работаем с копией
+            Fuel fuel = *GetBatchFuel(input, index);
+
+            auto Hd = GetHPipes(dd, input->Nd[index], input->Ld[index]);
+
+            auto Bh = GetBh(fireChamber);
+            auto BhFact = GetBhFact(fireChamber, q22, fuel);
+
+            HeatCoefficient heatCoefficient = {};
+            f64 L0;
+            if (input->FuelRecords)
+            {
+                FuelConstants *constants = &input->FuelRecords[input->FuelIndex ? input->FuelIndex[index] : 0].Constants;
+                heatCoefficient.M = constants->Gbc * BhFact;
+                heatCoefficient.N = constants->Gbb * BhFact;
+                L0 = constants->L0;
+            }
+            else
+            {
+                GetHeatCoefficient(heatCoefficient, fuel, BhFact);
+                L0 = GetL0(fuel);
+            }
+
+            auto Q0 = GetQ0(Bh, input->t, fuel, heatCoefficient);
+            auto Q21 = GetQ21(BhFact, fuel);
+            auto Q22 = GetQ22(Q0, q22);
+
+            auto T1 = GetT1(Q0, Q21, Q22, heatCoefficient);
+
+            auto Q4 = GetQ4(Q0, 1); // 1% потерь от Q0
+
+            output->R[index] = fireChamber.R;
+            output->Ht[index] = fireChamber.Ht;
+            output->Hd[index] = Hd;
+            output->L0[index] = L0;
+            output->Bh[index] = Bh;
+            output->BhFact[index] = BhFact;
+            output->M[index] = heatCoefficient.M;
+            output->N[index] = heatCoefficient.N;
+            output->T1[index] = T1;
+            output->Q0[index] = Q0;
+            output->Q21[index] = Q21;
+            output->Q22[index] = Q22;
+            output->Q4[index] = Q4;
+        }
+
+        if (stages & BoilerStage_FireTubes)
+        {
+            f64 K[BOILER_BATCH_BLOCK];
+            f64 alpha[BOILER_BATCH_BLOCK];
+            for (u32 blockIndex = 0; blockIndex < blockCount; ++blockIndex)
+            {
+                u32 index = blockFirst + blockIndex;
+                auto fuel = GetBatchFuel(input, index);
+                K[blockIndex] = fuel->K;
+                alpha[blockIndex] = fuel->alpha;
+            }
+
+            FireTubeChain chain = {};
+            chain.BhFact = output->BhFact + blockFirst;
+            chain.Ht = output->Ht + blockFirst;
+            chain.K = K;
+            chain.Alpha = alpha;
+            chain.L0 = output->L0 + blockFirst;
+            chain.DOut = input->DOut + blockFirst;
+            chain.DIn = input->DIn + blockFirst;
+            chain.Ld = input->Ld + blockFirst;
+            chain.Nd = input->Nd + blockFirst;
+            chain.T2 = output->T2 + blockFirst;
+            chain.T3 = output->T3 + blockFirst;
+            chain.Tabs = output->Tabs + blockFirst;
+            chain.Omega = output->Omega + blockFirst;
+            chain.K1 = output->K1 + blockFirst;
+            CalculateFireTubeChain(&chain, blockCount);
+        }
+
+        for (u32 blockIndex = 0; (stages & BoilerStage_Losses) && (blockIndex < blockCount); ++blockIndex)
+        {
+            u32 index = blockFirst + blockIndex;
+
+            HeatCoefficient heatCoefficient = {};
+            heatCoefficient.M = output->M[index];
+            heatCoefficient.N = output->N[index];
+
+            output->Q3[index] = GetQ3(output->T3[index], heatCoefficient);
+            output->Qt[index] = GetQt(output->Q0[index], output->Q21[index], output->Q22[index],
+                                      output->T2[index], heatCoefficient);
+        }
+    }
+}
+
+internal void
+CalculateBoilerBatch(BoilerBatchInput *input, BoilerBatchOutput *output, u32 stages = BoilerStage_All)
+{
+    CalculateBoilerBatch(input, output, 0, input->Count, stages);
+}
+
+// Память под выходные массивы на count вариантов
+inline u64
+GetBoilerBatchOutputSize(u64 count)
+{
+    u64 columnCount = sizeof(BoilerBatchOutput) / sizeof(f64 *);
+    return columnCount * (count * sizeof(f64) + ARENA_DEFAULT_ALIGNMENT);
+}
+
+// Если памяти не хватает, все указатели результата нулевые
+internal BoilerBatchOutput
+PushBoilerBatchOutput(MemoryArena *arena, u64 count)
+{
+    BoilerBatchOutput result = {};
+    if (GetBoilerBatchOutputSize(count) > GetArenaSizeRemaining(arena))
+    {
+        return result;
+    }
+
+    f64 **columns = (f64 **)&result;
+    for (u32 column = 0; column < sizeof(result) / sizeof(f64 *); ++column)
+    {
+        columns[column] = PushArray(arena, count, f64);
+    }
+    return result;
+}
+
+// Память под входные столбцы на count вариантов (без таблицы топлив).
+// Если памяти не хватает, все указатели результата нулевые.
+internal BoilerBatchInput
+PushBoilerBatchInput(MemoryArena *arena, u32 count)
+{
+    BoilerBatchInput result = {};
+
+    u64 size = 12 * (count * sizeof(f64) + ARENA_DEFAULT_ALIGNMENT) +
+               count * (sizeof(u16) + sizeof(u32)) + 2 * ARENA_DEFAULT_ALIGNMENT;
+    if (size > GetArenaSizeRemaining(arena))
+    {
+        return result;
+    }
+
+    result.Count = count;
+    result.TopLengh = PushArray(arena, count, f64);
+    result.TopWidth = PushArray(arena, count, f64);
+    result.BottomLength = PushArray(arena, count, f64);
+    result.BottomWidth = PushArray(arena, count, f64);
+    result.FrontHeight = PushArray(arena, count, f64);
+    result.RearHeight = PushArray(arena, count, f64);
+    result.DOut = PushArray(arena, count, f64);
+    result.DIn = PushArray(arena, count, f64);
+    result.Ld = PushArray(arena, count, f64);
+    result.Nd = PushArray(arena, count, u16);
+    result.U = PushArray(arena, count, f64);
+    result.q22 = PushArray(arena, count, f64);
+    result.FuelIndex = PushArray(arena, count, u32);
+    return result;
+}
+
+// Копирует вариант sourceIndex в destIndex. Таблица топлив у обоих общая.
+inline void
+CopyBoilerBatchVariant(BoilerBatchInput *dest, u32 destIndex, BoilerBatchInput *source, u32 sourceIndex)
+{
+    dest->TopLengh[destIndex] = source->TopLengh[sourceIndex];
+    dest->TopWidth[destIndex] = source->TopWidth[sourceIndex];
+    dest->BottomLength[destIndex] = source->BottomLength[sourceIndex];
+    dest->BottomWidth[destIndex] = source->BottomWidth[sourceIndex];
+    dest->FrontHeight[destIndex] = source->FrontHeight[sourceIndex];
+    dest->RearHeight[destIndex] = source->RearHeight[sourceIndex];
+    dest->DOut[destIndex] = source->DOut[sourceIndex];
+    dest->DIn[destIndex] = source->DIn[sourceIndex];
+    dest->Ld[destIndex] = source->Ld[sourceIndex];
+    dest->Nd[destIndex] = source->Nd[sourceIndex];
+    dest->U[destIndex] = source->U[sourceIndex];
+    dest->q22[destIndex] = source->q22[sourceIndex];
+    dest->FuelIndex[destIndex] = source->FuelIndex ? source->FuelIndex[sourceIndex] : 0;
+}
@@ -0,0 +1,273 @@
+// Пакетный расчет всей цепочки CalculateBoilerBatch в одинарной точности,
+// для отбора вариантов в больших переборах. Вариант считается целиком в f32
+// и векторно: 8 вариантов за инструкцию на AVX2, 16 на AVX-512.
+//
+// Для каждого варианта считается оценка относительной ошибки выходов: единица
+// округления f32, умноженная на запас на округления всей цепочки и на числа
+// обусловленности вычитаний, где f32 теряет знаки:
+//  - T1 - больший корень N T^2 + M T - Q = 0, (sqrt(D) - M) / 2N; при малом N
+//    sqrt(D) почти равен M и разность теряет (sqrt(D) + M) / (sqrt(D) - M);
+//  - Q0 - (Q2' + Q2'') перед T1 и Qt = Q0 - Q2' - Q2'' - (M T2 + N T2^2).
+// Варианты с оценкой больше tolerance (и без положительного корня T1)
+// пересчитываются CalculateBoilerBatch в f64, их выходы совпадают с ним бит в
+// бит. У остальных относительная ошибка выходов не больше tolerance (ss_bench
+// -accuracy проверяет это на рабочем диапазоне).
+// Свойства топлива (L0, M/Bh, N/Bh, Q2' на кг) считаются в f64 один раз на
+// топливо и только потом округляются: коэффициенты GetGbb порядка 1e-6
+// складывать в f32 нельзя.
+// На SimdLevel_Scalar весь пакет считается в f64.
+
+#define BOILER_BATCH_F32_TOLERANCE 1.0e-5    // допустимая относительная ошибка по умолчанию
+#define BOILER_BATCH_F32_CHAIN_ERROR 64.0f   // запас на округления цепочки, в единицах округления
+#define BOILER_BATCH_F32_UNIT_ROUNDOFF 5.9604644775390625e-8 // 2^-24
+#define BOILER_BATCH_F32_ABS_FLOOR 1.0e-6    // знаменатель отклонения для выходов около нуля
+
+#define BOILER_BATCH_INPUT_COLUMNS 11 // столбцы f64 в BoilerBatchInput
+#define BOILER_BATCH_OUTPUT_COLUMNS (sizeof(BoilerBatchOutput) / sizeof(f64 *))
+
+// NOTE: BoilerBatchInput is Count, the f64 columns, four other pointers (Nd,
+// Fuels, FuelIndex, FuelRecords) and t. A new member fails this until
+// BOILER_BATCH_INPUT_COLUMNS and GetBoilerBatchScratchInput follow it.
+static_assert(sizeof(BoilerBatchInput) ==
+                  sizeof(u64) + (BOILER_BATCH_INPUT_COLUMNS + 4) * sizeof(void *) + sizeof(f64),
+              "BoilerBatchInput columns changed");
+
+// Топливо вариантов блока в f32 и оценка ошибки
+struct BoilerBatchF32Block
+{
+    f32 K[BOILER_BATCH_BLOCK];
+    f32 Alpha[BOILER_BATCH_BLOCK];
+    f32 L0[BOILER_BATCH_BLOCK];
+    f32 Gbc[BOILER_BATCH_BLOCK];     // M / BhFact
+    f32 Gbb[BOILER_BATCH_BLOCK];     // N / BhFact
+    f32 Q21Rate[BOILER_BATCH_BLOCK]; // Q2' / BhFact
+    f32 Error[BOILER_BATCH_BLOCK];   // оценка относительной ошибки варианта
+
+    // варианты, пересчитываемые в f64, одним пакетом
+    u32 FallbackLane[BOILER_BATCH_BLOCK];
+    f64 FallbackInput[BOILER_BATCH_INPUT_COLUMNS * BOILER_BATCH_BLOCK];
+    u16 FallbackNd[BOILER_BATCH_BLOCK];
+    u32 FallbackFuelIndex[BOILER_BATCH_BLOCK];
+    f64 FallbackOutput[BOILER_BATCH_OUTPUT_COLUMNS * BOILER_BATCH_BLOCK];
+};
+
+// Пакет из count вариантов в рабочих массивах: columns - столбцы f64 входа
+// подряд по count, топлива и t - как у input.
+inline BoilerBatchInput
+GetBoilerBatchScratchInput(BoilerBatchInput *input, u32 count, f64 *columns, u16 *nd, u32 *fuelIndex)
+{
+    BoilerBatchInput result = *input;
+    result.Count = count;
+    result.TopLengh = columns + 0 * count;
+    result.TopWidth = columns + 1 * count;
+    result.BottomLength = columns + 2 * count;
+    result.BottomWidth = columns + 3 * count;
+    result.FrontHeight = columns + 4 * count;
+    result.RearHeight = columns + 5 * count;
+    result.DOut = columns + 6 * count;
+    result.DIn = columns + 7 * count;
+    result.Ld = columns + 8 * count;
+    result.U = columns + 9 * count;
+    result.q22 = columns + 10 * count;
+    result.Nd = nd;
+    result.FuelIndex = fuelIndex;
+    return result;
+}
+
+inline BoilerBatchOutput
+GetBoilerBatchScratchOutput(u32 count, f64 *columns)
+{
+    BoilerBatchOutput result;
+    f64 **resultColumns = (f64 **)&result;
+    for (u32 column = 0; column < BOILER_BATCH_OUTPUT_COLUMNS; ++column)
+    {
+        resultColumns[column] = columns + column * count;
+    }
+    return result;
+}
+
+inline void
+CopyBoilerBatchResult(BoilerBatchOutput *dest, u32 destIndex, BoilerBatchOutput *source, u32 sourceIndex)
+{
+    f64 **destColumns = (f64 **)dest;
+    f64 **sourceColumns = (f64 **)source;
+    for (u32 column = 0; column < BOILER_BATCH_OUTPUT_COLUMNS; ++column)
+    {
+        destColumns[column][destIndex] = sourceColumns[column][sourceIndex];
+    }
+}
+
+// Свойства топлива для вариантов блока [0, laneCount); варианты за
+// blockCount повторяют последний, чтобы хвост шел через те же дорожки.
+internal void
+SetBoilerBatchF32Fuels(BoilerBatchInput *input, BoilerBatchF32Block *block, u32 blockFirst, u32 blockCount,
+                       u32 laneCount)
+{
+    Assert(laneCount <= BOILER_BATCH_BLOCK);
+
+    u32 lastFuelIndex = 0xFFFFFFFF;
+    f32 K = 0.0f, alpha = 0.0f, L0 = 0.0f, Gbc = 0.0f, Gbb = 0.0f, Q21Rate = 0.0f;
+    for (u32 lane = 0; lane < laneCount; ++lane)
+    {
+        // NOTE: Sweeps use one fuel for every variant, so the fuel is only
+        // recomputed when the index changes.
+        u32 index = blockFirst + Minimum(lane, blockCount - 1);
+        u32 fuelIndex = input->FuelIndex ? input->FuelIndex[index] : 0;
+        if (fuelIndex != lastFuelIndex)
+        {
+            lastFuelIndex = fuelIndex;
+
+            Fuel *fuel = GetBatchFuel(input, index);
+            K = (f32)fuel->K;
+            alpha = (f32)fuel->alpha;
+            Q21Rate = (f32)GetQ21Rate(*fuel);
+            if (input->FuelRecords)
+            {
+                FuelConstants *constants = &input->FuelRecords[fuelIndex].Constants;
+                L0 = (f32)constants->L0;
+                Gbc = (f32)constants->Gbc;
+                Gbb = (f32)constants->Gbb;
+            }
+            else
+            {
+                L0 = (f32)GetL0(*fuel);
+                Gbc = (f32)GetGbc(*fuel);
+                Gbb = (f32)GetGbb(*fuel);
+            }
+        }
+
+        block->K[lane] = K;
+        block->Alpha[lane] = alpha;
+        block->L0[lane] = L0;
+        block->Gbc[lane] = Gbc;
+        block->Gbb[lane] = Gbb;
+        block->Q21Rate[lane] = Q21Rate;
+    }
+}
+
+BEGIN_TARGET_AVX2
+#define WIDE f32x8
+#define WIDE_FUNCTION(name) name##AVX2
+#include "ss_batch_f32_wide.inl"
+#undef WIDE_FUNCTION
+#undef WIDE
+END_TARGET
+
+BEGIN_TARGET_AVX512
+#define WIDE f32x16
+#define WIDE_FUNCTION(name) name##AVX512
+#include "ss_batch_f32_wide.inl"
+#undef WIDE_FUNCTION
+#undef WIDE
+END_TARGET
+
+// Все стадии для вариантов [first, onePastLast) в f32 с пересчетом в f64
+// вариантов, где оценка ошибки больше tolerance. block - рабочая память
+// (около 72 КБ, PushStruct в arena). Возвращает число пересчитанных вариантов.
+internal u32
+CalculateBoilerBatchF32(BoilerBatchF32Block *block, BoilerBatchInput *input, BoilerBatchOutput *output, u32 first,
+                        u32 onePastLast, f64 tolerance = BOILER_BATCH_F32_TOLERANCE)
+{
+    TIMED_FUNCTION();
+
+    Assert(onePastLast <= input->Count);
+
+    if (!GlobalSimdLevelInitialized)
+    {
+        SetSimdLevel(SimdLevel_AVX512);
+    }
+    if (GlobalSimdLevel == SimdLevel_Scalar)
+    {
+        CalculateBoilerBatch(input, output, first, onePastLast);
+        return 0;
+    }
+
+    u32 result = 0;
+    for (u32 blockFirst = first; blockFirst < onePastLast; blockFirst += BOILER_BATCH_BLOCK)
+    {
+        u32 blockCount = onePastLast - blockFirst;
+        if (blockCount > BOILER_BATCH_BLOCK)
+        {
+            blockCount = BOILER_BATCH_BLOCK;
+        }
+
+        if (GlobalSimdLevel == SimdLevel_AVX512)
+        {
+            CalculateBoilerBatchF32BlockAVX512(input, output, block, blockFirst, blockCount);
+        }
+        else
+        {
+            CalculateBoilerBatchF32BlockAVX2(input, output, block, blockFirst, blockCount);
+        }
+
+        u32 fallbackCount = 0;
+        for (u32 lane = 0; lane < blockCount; ++lane)
+        {
+            if (!(block->Error[lane] <= tolerance))
+            {
+                block->FallbackLane[fallbackCount++] = lane;
+            }
+        }
+
+        if (fallbackCount)
+        {
+            auto fallback = GetBoilerBatchScratchInput(input, fallbackCount, block->FallbackInput, block->FallbackNd,
+                                                       block->FallbackFuelIndex);
+            auto fallbackOutput = GetBoilerBatchScratchOutput(fallbackCount, block->FallbackOutput);
+            for (u32 index = 0; index < fallbackCount; ++index)
+            {
+                CopyBoilerBatchVariant(&fallback, index, input, blockFirst + block->FallbackLane[index]);
+            }
+
+            CalculateBoilerBatch(&fallback, &fallbackOutput);
+
+            for (u32 index = 0; index < fallbackCount; ++index)
+            {
+                CopyBoilerBatchResult(output, blockFirst + block->FallbackLane[index], &fallbackOutput, index);
+            }
+            result += fallbackCount;
+        }
+    }
+
+    return result;
+}
+
+// Стадия boiler_stage каждого столбца BoilerBatchOutput, по порядку полей
+global u8 BoilerBatchOutputColumnStages[] = {
+    BoilerStage_Front,     BoilerStage_Front,     BoilerStage_Front,     BoilerStage_Front,
+    BoilerStage_Front,     BoilerStage_Front,     BoilerStage_Front,     BoilerStage_FireTubes,
+    BoilerStage_FireTubes, BoilerStage_FireTubes, BoilerStage_Front,     BoilerStage_Front,
+    BoilerStage_Front,     BoilerStage_Losses,    BoilerStage_Front,     BoilerStage_Losses,
+    BoilerStage_FireTubes, BoilerStage_FireTubes, BoilerStage_Front,     BoilerStage_Front,
+};
+static_assert(ArrayCount(BoilerBatchOutputColumnStages) == BOILER_BATCH_OUTPUT_COLUMNS,
+              "BoilerBatchOutput columns changed");
+
+// Наибольшее отклонение выходов fast от reference на вариантах [0, count):
+// |a - b| / max(|b|, absFloor) по столбцам стадий stages. absFloor не дает
+// выходам около нуля (Qt, Q2'' при q22 = 0) раздувать отклонение.
+internal f64
+GetBoilerBatchDeviation(BoilerBatchOutput *fast, BoilerBatchOutput *reference, u64 count,
+                        u32 stages = BoilerStage_All, f64 absFloor = BOILER_BATCH_F32_ABS_FLOOR)
+{
+    f64 result = 0.0;
+    f64 **fastColumns = (f64 **)fast;
+    f64 **referenceColumns = (f64 **)reference;
+    for (u32 column = 0; column < BOILER_BATCH_OUTPUT_COLUMNS; ++column)
+    {
+        if (!(stages & BoilerBatchOutputColumnStages[column]))
+        {
+            continue;
+        }
+
+        for (u64 index = 0; index < count; ++index)
+        {
+            f64 value = referenceColumns[column][index];
+            f64 deviation = fabs(fastColumns[column][index] - value) / Maximum(fabs(value), absFloor);
+            // NOTE: Written so that a NaN deviation wins.
+            result = (deviation <= result) ? result : deviation;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,155 @@
+// NOTE: Wide single-precision chain. ss_batch_f32.cpp includes this once per
+// f32 wide type with WIDE and WIDE_FUNCTION defined, inside the matching
+// target region. The formulas follow CalculateBoilerBatch stage by stage;
+// inputs are converted from the f64 columns on load and results back on
+// store, fuel properties come from the block (computed in f64 per fuel).
+
+inline void
+WIDE_FUNCTION(BoilerBatchF32Lanes)(BoilerBatchInput *input, BoilerBatchOutput *output, u32 index,
+                                   BoilerBatchF32Block *block, u32 lane)
+{
+    // огневая коробка
+    WIDE TopLengh = WIDE::Load(input->TopLengh + index);
+    WIDE TopWidth = WIDE::Load(input->TopWidth + index);
+    WIDE BottomLength = WIDE::Load(input->BottomLength + index);
+    WIDE BottomWidth = WIDE::Load(input->BottomWidth + index);
+    WIDE FrontHeight = WIDE::Load(input->FrontHeight + index);
+    WIDE RearHeight = WIDE::Load(input->RearHeight + index);
+    WIDE U = WIDE::Load(input->U + index);
+    WIDE q22 = WIDE::Load(input->q22 + index);
+
+    // дымогарные трубы
+    WIDE DOut = WIDE::Load(input->DOut + index);
+    WIDE DIn = WIDE::Load(input->DIn + index);
+    WIDE Ld = WIDE::Load(input->Ld + index);
+    WIDE nd = WIDE::Load(input->Nd + index);
+
+    // топливо
+    WIDE K = WIDE::Load(block->K + lane);
+    WIDE alpha = WIDE::Load(block->Alpha + lane);
+    WIDE L0 = WIDE::Load(block->L0 + lane);
+    WIDE Gbc = WIDE::Load(block->Gbc + lane);
+    WIDE Gbb = WIDE::Load(block->Gbb + lane);
+    WIDE Q21Rate = WIDE::Load(block->Q21Rate + lane);
+    f32 t = (f32)input->t;
+
+    // CalculateFireChamber, GetHPipes, GetBh, GetBhFact
+    WIDE R = BottomLength * BottomWidth;
+    WIDE Ht = TopLengh * TopWidth + RearHeight * TopWidth + FrontHeight * TopWidth + FrontHeight * TopLengh +
+              RearHeight * TopLengh;
+    WIDE Hd = (f32)PI * DOut * nd * Ld;
+    WIDE Bh = R * U;
+    WIDE BhFact = (100.0f - q22) / 100.0f * R * U;
+
+    // GetHeatCoefficient, GetQ0, GetQ21, GetQ22
+    WIDE M = Gbc * BhFact;
+    WIDE N = Gbb * BhFact;
+    WIDE Q0 = Bh * K + M * t + N * t * t;
+    WIDE Q21 = Q21Rate * BhFact;
+    WIDE Q22 = Q0 * q22 / 100.0f;
+
+    // GetT1: больший корень N T^2 + M T - Q = 0
+    WIDE heat = Q0 - (Q21 + Q22);
+    WIDE Q = heat / 0.84f;
+    WIDE D = M * M + 4.0f * N * Q;
+    WIDE sqrtD = SquareRoot(Max(D, WIDE::Set(0.0f)));
+    WIDE T1 = (sqrtD - M) / (2.0f * N);
+
+    WIDE Q4 = Q0 / 100.0f;
+
+    // GetT2
+    WIDE heatT = (BhFact * K) / Ht;
+    WIDE T2 = 1350.0f * Root((heatT + 4400.0f) / (heatT + 223000.0f), 1.6f);
+
+    // GetT3
+    WIDE H = Ht + Hd;
+    WIDE r = DIn / 4.0f;
+    WIDE A = Pow(r / 0.0105f, 0.15f) * (710.0f + 332000.0f / (Ld / r + 105.0f));
+    WIDE heatH = (BhFact * K) / H;
+    WIDE T3 = A * Root((heatH + 4400.0f) / (heatH + 223000.0f), 1.6f);
+
+    // GetTabs, GetOmega, GetK
+    WIDE Tabs = (T2 + T3) / 2.0f + 273.0f;
+    WIDE Od = ((f32)PI * (DIn * DIn)) / 4.0f;
+    WIDE v = (29.27f * Tabs) / 10330.0f;
+    WIDE omega = ((L0 * alpha + 1.0f) * BhFact * v) / (3600.0f * Od);
+    WIDE k1 = (6.0f + 2.45f * Pow(omega, 0.7f)) * Pow(0.0115f / r, 0.214f);
+
+    // GetQ3, GetQt
+    WIDE Q3 = M * T3 + N * T3 * T3;
+    WIDE Q2 = M * T2 + N * T2 * T2;
+    WIDE Qt = Q0 - Q21 - Q22 - Q2;
+
+    // оценка ошибки: запас на цепочку плюс обусловленность вычитаний
+    WIDE conditionQ = (Q0 + Q21 + Q22) / heat;
+    WIDE conditionT1 = (sqrtD + M) / (sqrtD - M);
+    WIDE conditionQt = (Q0 + Q21 + Q22 + Q2) / Max(Qt, -Qt);
+    WIDE error = (f32)BOILER_BATCH_F32_UNIT_ROUNDOFF *
+                 (BOILER_BATCH_F32_CHAIN_ERROR + conditionQ + conditionT1 + conditionQt);
+
+    // NOTE: Lanes where the f64 path may take another branch of
+    // SolveQuadratic (no positive root) always go back to f64.
+    auto regular = GreaterThan(N, 0.0f) & GreaterThan(heat, 0.0f) & GreaterThan(sqrtD, M);
+    error = Select(regular, error, WIDE::Set(INFINITY));
+
+    WIDE::Store(output->R + index, R);
+    WIDE::Store(output->Ht + index, Ht);
+    WIDE::Store(output->Hd + index, Hd);
+    WIDE::Store(output->L0 + index, L0);
+    WIDE::Store(output->Bh + index, Bh);
+    WIDE::Store(output->BhFact + index, BhFact);
+    WIDE::Store(output->T1 + index, T1);
+    WIDE::Store(output->T2 + index, T2);
+    WIDE::Store(output->T3 + index, T3);
+    WIDE::Store(output->Tabs + index, Tabs);
+    WIDE::Store(output->Q0 + index, Q0);
+    WIDE::Store(output->Q21 + index, Q21);
+    WIDE::Store(output->Q22 + index, Q22);
+    WIDE::Store(output->Q3 + index, Q3);
+    WIDE::Store(output->Q4 + index, Q4);
+    WIDE::Store(output->Qt + index, Qt);
+    WIDE::Store(output->Omega + index, omega);
+    WIDE::Store(output->K1 + index, k1);
+    WIDE::Store(output->M + index, M);
+    WIDE::Store(output->N + index, N);
+    WIDE::Store(block->Error + lane, error);
+}
+
+internal void
+WIDE_FUNCTION(CalculateBoilerBatchF32Block)(BoilerBatchInput *input, BoilerBatchOutput *output,
+                                            BoilerBatchF32Block *block, u32 blockFirst, u32 blockCount)
+{
+    const u32 width = WIDE::Width;
+    SetBoilerBatchF32Fuels(input, block, blockFirst, blockCount, (blockCount + width - 1) / width * width);
+
+    u32 lane = 0;
+    for (; lane + width <= blockCount; lane += width)
+    {
+        WIDE_FUNCTION(BoilerBatchF32Lanes)(input, output, blockFirst + lane, block, lane);
+    }
+
+    if (lane < blockCount)
+    {
+        // NOTE: As in the fire-tube chain, the tail is padded with its first
+        // variant and goes through the same lanes.
+        f64 inputColumns[BOILER_BATCH_INPUT_COLUMNS * width];
+        u16 nd[width];
+        u32 fuelIndex[width];
+        f64 outputColumns[BOILER_BATCH_OUTPUT_COLUMNS * width];
+        auto tail = GetBoilerBatchScratchInput(input, width, inputColumns, nd, fuelIndex);
+        auto tailOutput = GetBoilerBatchScratchOutput(width, outputColumns);
+
+        for (u32 tailLane = 0; tailLane < width; ++tailLane)
+        {
+            u32 source = (lane + tailLane < blockCount) ? (lane + tailLane) : lane;
+            CopyBoilerBatchVariant(&tail, tailLane, input, blockFirst + source);
+        }
+
+        WIDE_FUNCTION(BoilerBatchF32Lanes)(&tail, &tailOutput, 0, block, lane);
+
+        for (u32 tailLane = 0; lane + tailLane < blockCount; ++tailLane)
+        {
+            CopyBoilerBatchResult(output, blockFirst + lane + tailLane, &tailOutput, tailLane);
+        }
+    }
+}
@@ -0,0 +1,2022 @@
+// Микробенчмарки формул ss_boiler.cpp, ss_gear.cpp, ss_math.h и всей цепочки
+// расчета котла. Отдельная программа: включает код расчета целиком (unity build).
+//
+//   ss_bench [-out result.json] [-baseline baseline.json] [-threshold 10]
+//            [-filter GetT] [-seconds 0.05] [-math fast|reference]
+//   ss_bench -accuracy
+//
+// Входы - случайные (с фиксированным зерном, так что прогоны сравнимы) котлы
+// и топлива из реалистичных диапазонов; промежуточные величины (Bh, Q0, T2,
+// T3, ...) для отдельных формул берутся из расчета этих же котлов.
+// cycles/call считается по rdtsc, то есть в опорных тактах TSC.
+// С -baseline время каждой функции сравнивается с сохраненным прогоном, и
+// замедление больше порога (в процентах) дает код возврата 1.
+// -math fast меряет все с быстрой математикой (MathMode_Fast).
+// -accuracy вместо замеров запускает проверки RunAccuracyChecks: ядра
+// ss_math_wide.inl против libm (в ULP), быструю математику против эталонной,
+// пакет в f32 против пакета в f64 и
+// проверки расчета с известным ответом; код возврата 1, если ошибка больше
+// указанной (в ss_math_wide.inl, для f32 - BOILER_BATCH_F32_TOLERANCE) или
+// проверка не прошла. make test запускает именно это.
+
+#include "ss.cpp"
+
+#include <stdlib.h>
+
+#define BENCH_SAMPLE_COUNT 4096 // NOTE: Must be a multiple of BOILER_BATCH_BLOCK
+#define BENCH_ROUND_COUNT 5
+#define BENCH_MAX_RESULTS 128
+#define BENCH_DEFAULT_THRESHOLD 10.0
+
+struct BenchSamples
+{
+    FireChamber Chamber[BENCH_SAMPLE_COUNT];
+    PipeDiameter Dd[BENCH_SAMPLE_COUNT];
+    f64 Ld[BENCH_SAMPLE_COUNT];
+    u16 Nd[BENCH_SAMPLE_COUNT];
+    f64 q22[BENCH_SAMPLE_COUNT];
+    u32 FuelIndex[BENCH_SAMPLE_COUNT];
+
+    // столбцы для BoilerBatchInput
+    f64 TopLengh[BENCH_SAMPLE_COUNT];
+    f64 TopWidth[BENCH_SAMPLE_COUNT];
+    f64 BottomLength[BENCH_SAMPLE_COUNT];
+    f64 BottomWidth[BENCH_SAMPLE_COUNT];
+    f64 FrontHeight[BENCH_SAMPLE_COUNT];
+    f64 RearHeight[BENCH_SAMPLE_COUNT];
+    f64 DOut[BENCH_SAMPLE_COUNT];
+    f64 DIn[BENCH_SAMPLE_COUNT];
+    f64 U[BENCH_SAMPLE_COUNT];
+
+    // величины, которых нет в цепочке
+    f64 t[BENCH_SAMPLE_COUNT];      // температура наружного воздуха
+    f64 tk[BENCH_SAMPLE_COUNT];     // температура воды в котле
+    f64 V[BENCH_SAMPLE_COUNT];      // скорость км/ч
+    f64 Phi[BENCH_SAMPLE_COUNT];    // качество изоляции
+    f64 H0[BENCH_SAMPLE_COUNT];     // наружная поверхность котла
+    f64 LossK[BENCH_SAMPLE_COUNT];  // потеря на охлаждение в % от Q0
+    f64 BetaN[BENCH_SAMPLE_COUNT];  // слой накипи
+    f64 BetaS[BENCH_SAMPLE_COUNT];  // слой сажи
+    f64 Lg[BENCH_SAMPLE_COUNT];     // длина жаровых труб
+    f64 Dg[BENCH_SAMPLE_COUNT];     // внутренний диаметр жаровых труб
+    f64 BetaGas[BENCH_SAMPLE_COUNT];
+    f64 OmegaZ[BENCH_SAMPLE_COUNT];
+    f64 CylinderD[BENCH_SAMPLE_COUNT]; // GetF: диаметр цилиндра, см
+    f64 Stroke[BENCH_SAMPLE_COUNT];    // ход поршня, см
+    f64 Pk[BENCH_SAMPLE_COUNT];        // давление пара, ат
+    f64 WheelD[BENCH_SAMPLE_COUNT];    // диаметр движущих колес, см
+
+    Fuel Fuels[BENCH_SAMPLE_COUNT];
+    HeatCoefficient Heat[BENCH_SAMPLE_COUNT];
+
+    BoilerBatchInput Input;
+    BoilerBatchOutput Output;
+};
+
+#define BENCH_FUEL_COUNT 16
+global Fuel BenchFuelTable[BENCH_FUEL_COUNT];
+
+struct BenchResult
+{
+    const char *Name;
+    u64 Calls;
+    f64 NsPerCall;
+    f64 CyclesPerCall;
+    f64 CallsPerSecond;
+
+    b32 HasBaseline;
+    f64 BaselineNsPerCall;
+};
+
+struct BenchContext
+{
+    BenchSamples *Samples;
+    const char *Filter;
+    f64 RoundSeconds;
+
+    u32 ResultCount;
+    BenchResult Results[BENCH_MAX_RESULTS];
+};
+
+// NOTE: Results are folded into this so the compiler cannot drop the calls.
+global volatile f64 GlobalBenchSink;
+
+struct BenchRandom
+{
+    u64 State;
+};
+
+inline f64
+RandomBetween(BenchRandom *random, f64 min, f64 max)
+{
+    // xorshift64*
+    u64 x = random->State;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    random->State = x;
+    f64 unit = (f64)((x * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+    return min + (max - min) * unit;
+}
+
+inline f64
+GetBenchSeconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+}
+
+internal void
+InitializeBenchSamples(BenchSamples *samples, MemoryArena *arena)
+{
+    BenchRandom random = {0x9E3779B97F4A7C15ULL};
+
+    for (u32 fuelIndex = 0; fuelIndex < BENCH_FUEL_COUNT; ++fuelIndex)
+    {
+        Fuel fuel = {};
+        CalculateFuel(fuel);
+        fuel.C = RandomBetween(&random, 70.0, 85.0);
+        fuel.H = RandomBetween(&random, 2.5, 4.5);
+        fuel.W = RandomBetween(&random, 2.0, 8.0);
+        fuel.K = RandomBetween(&random, 6000.0, 7600.0);
+        fuel.alpha = RandomBetween(&random, 1.2, 1.6);
+        fuel.CO = RandomBetween(&random, 0.5, 2.5);
+        fuel.CO2 = RandomBetween(&random, 11.0, 14.0);
+        GetBeta0(fuel);
+        BenchFuelTable[fuelIndex] = fuel;
+    }
+
+    for (u32 index = 0; index < BENCH_SAMPLE_COUNT; ++index)
+    {
+        FireChamber chamber = {};
+        chamber.TopLengh = RandomBetween(&random, 1.8, 2.8);
+        chamber.TopWidth = RandomBetween(&random, 1.0, 1.5);
+        chamber.BottomLength = chamber.TopLengh + RandomBetween(&random, 0.0, 0.15);
+        chamber.BottomWidth = RandomBetween(&random, 0.8, 1.3);
+        chamber.FrontHeight = RandomBetween(&random, 1.5, 2.0);
+        chamber.RearHeight = chamber.FrontHeight - RandomBetween(&random, 0.1, 0.3);
+        chamber.U = RandomBetween(&random, 400.0, 700.0);
+        CalculateFireChamber(chamber);
+        samples->Chamber[index] = chamber;
+
+        samples->TopLengh[index] = chamber.TopLengh;
+        samples->TopWidth[index] = chamber.TopWidth;
+        samples->BottomLength[index] = chamber.BottomLength;
+        samples->BottomWidth[index] = chamber.BottomWidth;
+        samples->FrontHeight[index] = chamber.FrontHeight;
+        samples->RearHeight[index] = chamber.RearHeight;
+        samples->U[index] = chamber.U;
+
+        PipeDiameter dd = {};
+        dd.DOut = RandomBetween(&random, 0.044, 0.057);
+        dd.DIn = dd.DOut - RandomBetween(&random, 0.004, 0.006);
+        samples->Dd[index] = dd;
+        samples->DOut[index] = dd.DOut;
+        samples->DIn[index] = dd.DIn;
+
+        samples->Ld[index] = RandomBetween(&random, 3.5, 5.5);
+        samples->Nd[index] = (u16)RandomBetween(&random, 150.0, 261.0);
+        samples->q22[index] = RandomBetween(&random, 20.0, 40.0);
+        samples->FuelIndex[index] = (u32)RandomBetween(&random, 0.0, BENCH_FUEL_COUNT);
+
+        samples->t[index] = RandomBetween(&random, -30.0, 30.0);
+        samples->tk[index] = RandomBetween(&random, 180.0, 200.0);
+        samples->V[index] = RandomBetween(&random, 0.0, 80.0);
+        samples->Phi[index] = RandomBetween(&random, 0.3, 0.5);
+        samples->H0[index] = RandomBetween(&random, 40.0, 60.0);
+        samples->LossK[index] = RandomBetween(&random, 0.5, 2.0);
+        samples->BetaN[index] = RandomBetween(&random, 0.0, 0.001);
+        samples->BetaS[index] = RandomBetween(&random, 0.0, 0.001);
+        samples->Lg[index] = samples->Ld[index];
+        samples->Dg[index] = RandomBetween(&random, 0.125, 0.143);
+        samples->BetaGas[index] = RandomBetween(&random, 0.6, 0.9);
+        samples->OmegaZ[index] = RandomBetween(&random, 3.0, 8.0);
+        samples->CylinderD[index] = RandomBetween(&random, 50.0, 65.0);
+        samples->Stroke[index] = RandomBetween(&random, 60.0, 80.0);
+        samples->Pk[index] = RandomBetween(&random, 12.0, 16.0);
+        samples->WheelD[index] = RandomBetween(&random, 130.0, 185.0);
+    }
+
+    BoilerBatchInput *input = &samples->Input;
+    input->Count = BENCH_SAMPLE_COUNT;
+    input->TopLengh = samples->TopLengh;
+    input->TopWidth = samples->TopWidth;
+    input->BottomLength = samples->BottomLength;
+    input->BottomWidth = samples->BottomWidth;
+    input->FrontHeight = samples->FrontHeight;
+    input->RearHeight = samples->RearHeight;
+    input->DOut = samples->DOut;
+    input->DIn = samples->DIn;
+    input->Ld = samples->Ld;
+    input->Nd = samples->Nd;
+    input->U = samples->U;
+    input->q22 = samples->q22;
+    input->Fuels = BenchFuelTable;
+    input->FuelIndex = samples->FuelIndex;
+    input->t = 0.0;
+
+    // промежуточные величины для отдельных формул - из расчета этих котлов
+    samples->Output = PushBoilerBatchOutput(arena, BENCH_SAMPLE_COUNT);
+    CalculateBoilerBatch(input, &samples->Output);
+
+    for (u32 index = 0; index < BENCH_SAMPLE_COUNT; ++index)
+    {
+        Fuel fuel = BenchFuelTable[samples->FuelIndex[index]];
+        fuel.u = (100.0 - samples->q22[index]) / 100.0;
+        samples->Fuels[index] = fuel;
+        samples->Heat[index].M = samples->Output.M[index];
+        samples->Heat[index].N = samples->Output.N[index];
+    }
+}
+
+internal b32
+IsBenchSelected(BenchContext *context, const char *name)
+{
+    return !context->Filter || strstr(name, context->Filter);
+}
+
+// Вызывает call(index) для всех образцов, пока не наберется RoundSeconds,
+// и так BENCH_ROUND_COUNT раз; в результат идет самый быстрый раунд.
+// callsPerPass - сколько вызовов (вариантов) считает один проход по образцам.
+template <typename bench_call>
+internal void
+RunBench(BenchContext *context, const char *name, bench_call call, u32 sampleCount = BENCH_SAMPLE_COUNT,
+         u64 callsPerPass = BENCH_SAMPLE_COUNT)
+{
+    if (!IsBenchSelected(context, name))
+    {
+        return;
+    }
+    Assert(context->ResultCount < BENCH_MAX_RESULTS);
+
+    BenchResult *result = context->Results + context->ResultCount++;
+    ZeroStruct(*result);
+    result->Name = name;
+
+    f64 sink = 0.0;
+    for (u32 index = 0; index < sampleCount; ++index)
+    {
+        sink += call(index);
+    }
+
+    f64 bestNs = 0.0;
+    f64 bestCycles = 0.0;
+    for (u32 round = 0; round < BENCH_ROUND_COUNT; ++round)
+    {
+        u64 calls = 0;
+        auto start = std::chrono::steady_clock::now();
+        u64 startCycles = __rdtsc();
+        f64 seconds;
+        do
+        {
+            for (u32 index = 0; index < sampleCount; ++index)
+            {
+                sink += call(index);
+            }
+            calls += callsPerPass;
+            seconds = GetBenchSeconds(start);
+        } while (seconds < context->RoundSeconds);
+        u64 cycles = __rdtsc() - startCycles;
+
+        f64 ns = seconds * 1.0e9 / (f64)calls;
+        if ((round == 0) || (ns < bestNs))
+        {
+            bestNs = ns;
+            bestCycles = (f64)cycles / (f64)calls;
+        }
+        result->Calls += calls;
+    }
+
+    GlobalBenchSink = GlobalBenchSink + sink;
+
+    result->NsPerCall = bestNs;
+    result->CyclesPerCall = bestCycles;
+    result->CallsPerSecond = 1.0e9 / bestNs;
+}
+
+internal void
+RunFormulaBenches(BenchContext *context)
+{
+    BenchSamples *s = context->Samples;
+    BoilerBatchOutput *o = &s->Output;
+
+    RunBench(context, "GetBh", [=](u32 i) { return GetBh(s->Chamber[i]); });
+    RunBench(context, "GetBhFact", [=](u32 i) { return GetBhFact(s->Chamber[i], s->q22[i], s->Fuels[i]); });
+    RunBench(context, "CalculateFireChamber", [=](u32 i) {
+        FireChamber chamber = s->Chamber[i];
+        CalculateFireChamber(chamber);
+        return chamber.Ht;
+    });
+    RunBench(context, "GetBeta0", [=](u32 i) {
+        GetBeta0(s->Fuels[i]);
+        return s->Fuels[i].beta0;
+    });
+    RunBench(context, "GetM", [=](u32 i) { return GetM(o->Bh[i], s->Fuels[i]); });
+    RunBench(context, "GetN", [=](u32 i) { return GetN(o->Bh[i], s->Fuels[i]); });
+    RunBench(context, "GetT0", [=](u32 i) { return GetT0(s->Fuels[i].alpha); });
+    RunBench(context, "GetQ0", [=](u32 i) { return GetQ0(o->Bh[i], s->t[i], s->Fuels[i], s->Heat[i]); });
+    RunBench(context, "GetQ21", [=](u32 i) { return GetQ21(o->BhFact[i], s->Fuels[i]); });
+    RunBench(context, "GetQ22", [=](u32 i) { return GetQ22(o->Q0[i], s->q22[i]); });
+    RunBench(context, "GetQ3(Q0)", [=](u32 i) { return GetQ3(o->Q0[i], o->T3[i], s->Fuels[i], s->Heat[i]); });
+    RunBench(context, "GetQ3", [=](u32 i) { return GetQ3(o->T3[i], s->Heat[i]); });
+    RunBench(context, "GetQ4(phi)", [=](u32 i) { return GetQ4(s->Phi[i], s->H0[i], s->V[i], s->t[i], s->tk[i]); });
+    RunBench(context, "GetQ4", [=](u32 i) { return GetQ4(o->Q0[i], s->LossK[i]); });
+    RunBench(context, "GetT1", [=](u32 i) { return GetT1(o->Q0[i], o->Q21[i], o->Q22[i], s->Heat[i]); });
+    RunBench(context, "SolveQuadratic", [=](u32 i) {
+        return SolveQuadratic(s->Heat[i].N, s->Heat[i].M, -(o->Q0[i] - (o->Q21[i] + o->Q22[i])) / 0.84);
+    });
+    RunBench(context, "GetT2", [=](u32 i) { return GetT2(o->BhFact[i], o->Ht[i], s->Fuels[i]); });
+    RunBench(context, "GetHPipes", [=](u32 i) { return GetHPipes(s->Dd[i], s->Nd[i], s->Ld[i]); });
+    RunBench(context, "GetHydraulicRadius", [=](u32 i) { return GetHydraulicRadius(s->Dd[i]); });
+    RunBench(context, "GetT3", [=](u32 i) {
+        return GetT3(s->Dd[i], s->Nd[i], s->Ld[i], o->BhFact[i], o->Ht[i], s->Fuels[i]);
+    });
+    RunBench(context, "GetTOfWallOnWaterSide", [=](u32 i) {
+        return GetTOfWallOnWaterSide(o->T2[i], s->tk[i], s->BetaN[i], s->BetaS[i]);
+    });
+    RunBench(context, "GetTOfWallOnGasSide", [=](u32 i) {
+        return GetTOfWallOnGasSide(o->T2[i], s->tk[i], s->BetaN[i], s->BetaS[i]);
+    });
+    RunBench(context, "GetKdHd", [=](u32 i) {
+        return GetKdHd(s->BetaGas[i], s->Heat[i].M, s->Heat[i].N, o->T2[i], s->tk[i], s->tk[i], o->T3[i]);
+    });
+    RunBench(context, "GetKd", [=](u32 i) { return GetKd(s->OmegaZ[i], GetHydraulicRadius(s->Dd[i])); });
+    RunBench(context, "GetWd", [=](u32 i) {
+        return GetWd(o->L0[i], s->Fuels[i].alpha, o->Bh[i], s->Fuels[i].u, s->OmegaZ[i], o->T2[i], o->T3[i],
+                     s->BetaGas[i]);
+    });
+    RunBench(context, "GetQt", [=](u32 i) { return GetQt(o->Q0[i], o->Q21[i], o->Q22[i], o->T2[i], s->Heat[i]); });
+    RunBench(context, "GetBeta", [=](u32 i) {
+        f64 rd = s->DIn[i] / 4.0;
+        f64 sqrD = PI * s->DIn[i] * s->DIn[i] / 4.0;
+        f64 rg = s->Dg[i] / 4.0;
+        f64 sqrG = PI * s->Dg[i] * s->Dg[i] / 4.0;
+        return GetBeta(s->Ld[i], rd, sqrD, s->Lg[i], rg, sqrG, 0.5 * s->Lg[i], rg, sqrG);
+    });
+    RunBench(context, "GetL0", [=](u32 i) { return GetL0(s->Fuels[i]); });
+    RunBench(context, "GetLv", [=](u32 i) { return GetLv(o->L0[i], s->Fuels[i]); });
+    RunBench(context, "GetKi", [=](u32 i) {
+        return GetKi(s->BetaGas[i], o->Bh[i], s->Dg[i] / 4.0, s->OmegaZ[i], s->Fuels[i]);
+    });
+    RunBench(context, "GetTabs", [=](u32 i) { return GetTabs(o->T2[i], o->T3[i]); });
+    RunBench(context, "GetPipeSquare", [=](u32 i) { return GetPipeSquare(s->Dd[i]); });
+    RunBench(context, "GetV", [=](u32 i) { return GetV(o->Tabs[i]); });
+    RunBench(context, "GetOmega", [=](u32 i) {
+        return GetOmega(s->Fuels[i], s->Dd[i], o->Tabs[i], o->L0[i], o->BhFact[i]);
+    });
+    RunBench(context, "GetK(omega)", [=](u32 i) { return GetK(s->Dd[i], o->Omega[i]); });
+    RunBench(context, "GetK(Hd)", [=](u32 i) { return GetK(s->Heat[i], o->Hd[i], s->tk[i], o->T2[i], o->T3[i]); });
+    RunBench(context, "Root", [=](u32 i) { return Root(o->T3[i] / o->T2[i], 1.6); });
+    RunBench(context, "pow", [=](u32 i) { return pow(o->Omega[i], 0.7); });
+    RunBench(context, "FastPow", [=](u32 i) { return FastPow(o->Omega[i], 0.7); });
+    RunBench(context, "pow(x, 0.625)", [=](u32 i) { return pow(o->T3[i] / o->T2[i], 0.625); });
+    RunBench(context, "FastPowFiveEighths", [=](u32 i) { return FastPowFiveEighths(o->T3[i] / o->T2[i]); });
+    RunBench(context, "log", [=](u32 i) { return log(o->T2[i] / o->T3[i]); });
+    RunBench(context, "FastLog", [=](u32 i) { return FastLog(o->T2[i] / o->T3[i]); });
+    RunBench(context, "GetF", [=](u32 i) { return GetF(s->CylinderD[i], s->Stroke[i], s->Pk[i], s->WheelD[i]); });
+}
+
+internal void
+RunChainBenches(BenchContext *context, MemoryArena *arena)
+{
+    BenchSamples *s = context->Samples;
+    BoilerBatchInput *input = &s->Input;
+    BoilerBatchOutput output = PushBoilerBatchOutput(arena, BENCH_SAMPLE_COUNT);
+
+    // одиночный расчет, как в Calculate(): пакет из одного варианта
+    RunBench(context, "Chain/Single", [&](u32 i) {
+        CalculateBoilerBatch(input, &output, i, i + 1);
+        return output.T3[i];
+    });
+
+    // тот же вариант вместе с производными по всем boiler_input
+    RunBench(context, "Chain/Sensitivity", [&](u32 i) {
+        BoilerSensitivity sensitivity;
+        CalculateBoilerSensitivity(input, i, &sensitivity);
+        return sensitivity.T3.D[BoilerInput_Ld];
+    });
+
+    // NOTE: One call computes a whole block, so calls are counted in variants.
+    u32 blockCount = BENCH_SAMPLE_COUNT / BOILER_BATCH_BLOCK;
+    const char *batchNames[] = {"Chain/Batch/Scalar", "Chain/Batch/AVX2", "Chain/Batch/AVX512"};
+    const char *batchF32Names[] = {"Chain/BatchF32/Scalar", "Chain/BatchF32/AVX2", "Chain/BatchF32/AVX512"};
+    const char *fireTubeNames[] = {"FireTubeChain/Scalar", "FireTubeChain/AVX2", "FireTubeChain/AVX512"};
+    f64 *K = PushArray(arena, BOILER_BATCH_BLOCK, f64);
+    f64 *alpha = PushArray(arena, BOILER_BATCH_BLOCK, f64);
+    auto f32Block = PushStruct(arena, BoilerBatchF32Block);
+    for (u32 level = SimdLevel_Scalar; level <= (u32)GetSimdLevel(); ++level)
+    {
+        SetSimdLevel((simd_level)level);
+
+        RunBench(context, batchNames[level], [&](u32 block) {
+            u32 first = block * BOILER_BATCH_BLOCK;
+            CalculateBoilerBatch(input, &output, first, first + BOILER_BATCH_BLOCK);
+            return output.T3[first];
+        }, blockCount, BENCH_SAMPLE_COUNT);
+
+        // NOTE: Without a wide level the f32 batch is the f64 one.
+        if (level != SimdLevel_Scalar)
+        {
+            RunBench(context, batchF32Names[level], [&](u32 block) {
+                u32 first = block * BOILER_BATCH_BLOCK;
+                CalculateBoilerBatchF32(f32Block, input, &output, first, first + BOILER_BATCH_BLOCK);
+                return output.T3[first];
+            }, blockCount, BENCH_SAMPLE_COUNT);
+        }
+
+        RunBench(context, fireTubeNames[level], [&](u32 block) {
+            u32 first = block * BOILER_BATCH_BLOCK;
+            for (u32 index = 0; index < BOILER_BATCH_BLOCK; ++index)
+            {
+                K[index] = s->Fuels[first + index].K;
+                alpha[index] = s->Fuels[first + index].alpha;
+            }
+
+            FireTubeChain chain = {};
+            chain.BhFact = s->Output.BhFact + first;
+            chain.Ht = s->Output.Ht + first;
+            chain.K = K;
+            chain.Alpha = alpha;
+            chain.L0 = s->Output.L0 + first;
+            chain.DOut = s->DOut + first;
+            chain.DIn = s->DIn + first;
+            chain.Ld = s->Ld + first;
+            chain.Nd = s->Nd + first;
+            chain.T2 = output.T2 + first;
+            chain.T3 = output.T3 + first;
+            chain.Tabs = output.Tabs + first;
+            chain.Omega = output.Omega + first;
+            chain.K1 = output.K1 + first;
+            CalculateFireTubeChain(&chain, BOILER_BATCH_BLOCK);
+            return output.T3[first];
+        }, blockCount, BENCH_SAMPLE_COUNT);
+    }
+
+    // дымогарные трубы по участкам, число участков - по FIRE_TUBE_SEGMENT_NTU
+    const char *profileNames[] = {"FireTubeProfile/Scalar", "FireTubeProfile/AVX2", "FireTubeProfile/AVX512"};
+    auto profile = PushFireTubeProfile(arena, input, &s->Output, 190.0, false);
+    for (u32 level = SimdLevel_Scalar; profile.T3 && (level <= (u32)GetSimdLevel()); ++level)
+    {
+        SetSimdLevel((simd_level)level);
+
+        RunBench(context, profileNames[level], [&](u32 block) {
+            u32 first = block * BOILER_BATCH_BLOCK;
+            FireTubeProfile blockProfile = profile;
+            blockProfile.T2 += first;
+            blockProfile.M += first;
+            blockProfile.N += first;
+            blockProfile.L0 += first;
+            blockProfile.Alpha += first;
+            blockProfile.BhFact += first;
+            blockProfile.DOut += first;
+            blockProfile.DIn += first;
+            blockProfile.Ld += first;
+            blockProfile.Nd += first;
+            blockProfile.SegmentCount += first;
+            blockProfile.T3 += first;
+            blockProfile.Q += first;
+            blockProfile.K += first;
+            CalculateFireTubeProfile(&blockProfile, BOILER_BATCH_BLOCK);
+            return blockProfile.T3[0];
+        }, blockCount, BENCH_SAMPLE_COUNT);
+    }
+    SetSimdLevel(GetSimdLevel());
+}
+
+internal const char *
+GetSimdLevelName(simd_level level)
+{
+    const char *names[] = {"Scalar", "AVX2", "AVX512"};
+    return names[level];
+}
+
+//
+// NOTE: Accuracy
+//
+
+enum wide_kernel
+{
+    WideKernel_Log,
+    WideKernel_Exp,
+    WideKernel_Pow,
+    WideKernel_Root,
+};
+
+#define WIDE f64x1
+#define WIDE_FUNCTION(name) name##X1
+#include "ss_bench_wide.inl"
+#undef WIDE_FUNCTION
+#undef WIDE
+
+#define WIDE f64x2
+#define WIDE_FUNCTION(name) name##X2
+#include "ss_bench_wide.inl"
+#undef WIDE_FUNCTION
+#undef WIDE
+
+BEGIN_TARGET_AVX2
+#define WIDE f64x4
+#define WIDE_FUNCTION(name) name##AVX2
+#include "ss_bench_wide.inl"
+#undef WIDE_FUNCTION
+#undef WIDE
+END_TARGET
+
+BEGIN_TARGET_AVX512
+#define WIDE f64x8
+#define WIDE_FUNCTION(name) name##AVX512
+#include "ss_bench_wide.inl"
+#undef WIDE_FUNCTION
+#undef WIDE
+END_TARGET
+
+typedef void wide_kernel_evaluator(wide_kernel kernel, f64 e, f64 *x, f64 *result, u32 count);
+
+struct WideKernelType
+{
+    const char *Name;
+    simd_level Level; // наименьший уровень, на котором тип есть
+    wide_kernel_evaluator *Evaluate;
+};
+
+global WideKernelType GlobalWideKernelTypes[] = {
+    {"f64x1", SimdLevel_Scalar, EvaluateWideKernelX1},
+    {"f64x2", SimdLevel_Scalar, EvaluateWideKernelX2},
+    {"f64x4", SimdLevel_AVX2, EvaluateWideKernelAVX2},
+    {"f64x8", SimdLevel_AVX512, EvaluateWideKernelAVX512},
+};
+
+// Ядра ss_math_wide.inl против libm. Pow и Root - на диапазонах аргументов
+// каждого вызова в ss_boiler.cpp, на областях |e * ln(x)| <= 4 и <= 9 из
+// оценки в ss_math_wide.inl и около точки с наибольшей найденной ошибкой.
+#define ACCURACY_BLOCK_SIZE 4096 // NOTE: Must be a multiple of the widest WIDE
+#define ACCURACY_BLOCK_COUNT 256
+#define ACCURACY_LOG_ULP 1.0
+#define ACCURACY_EXP_ULP 1.0
+#define ACCURACY_POW_ULP 8.0      // |e * ln(x)| <= 4 и все вызовы
+#define ACCURACY_POW_WIDE_ULP 12.0 // |e * ln(x)| <= 9
+
+struct AccuracyCase
+{
+    const char *Name;
+    wide_kernel Kernel;
+    f64 Min; // x берется равномерно по логарифму из [Min, Max] (Exp - равномерно)
+    f64 Max;
+    f64 Exponent; // Pow: показатель, 0 - случайный, |e * ln(x)| <= Envelope; Root: n
+    f64 Envelope;
+    f64 BoundUlp;
+    f64 Point; // не 0 - x, который проверяется всегда
+};
+
+inline f64
+GetUlpError(f64 value, f64 reference)
+{
+    f64 ulp = nextafter(fabs(reference), HUGE_VAL) - fabs(reference);
+    return fabs(value - reference) / ulp;
+}
+
+inline f64
+GetKernelReference(wide_kernel kernel, f64 x, f64 e)
+{
+    switch (kernel)
+    {
+        case WideKernel_Log: return log(x);
+        case WideKernel_Exp: return exp(x);
+        case WideKernel_Pow: return pow(x, e);
+        case WideKernel_Root: return pow(x, 1.0 / e);
+    }
+    return 0.0;
+}
+
+// Наибольшая ошибка в ULP для всех типов, которые есть на этой машине
+internal u32
+CheckWideKernel(AccuracyCase *check, BenchRandom *random, f64 *x, f64 *result)
+{
+    u32 failureCount = 0;
+
+    printf("%-28s %10.4g %10.4g", check->Name, check->Min, check->Max);
+    for (u32 typeIndex = 0; typeIndex < ArrayCount(GlobalWideKernelTypes); ++typeIndex)
+    {
+        WideKernelType *type = GlobalWideKernelTypes + typeIndex;
+        if (type->Level > GetSimdLevel())
+        {
+            printf(" %8s", "-");
+            continue;
+        }
+
+        // NOTE: Every type sees the same arguments.
+        BenchRandom typeRandom = *random;
+        f64 worst = 0.0;
+        for (u32 block = 0; block < ACCURACY_BLOCK_COUNT; ++block)
+        {
+            f64 e = check->Exponent;
+            f64 logMin = log(check->Min);
+            f64 logMax = log(check->Max);
+            if ((check->Kernel == WideKernel_Pow) && (e == 0.0))
+            {
+                e = RandomBetween(&typeRandom, -4.0, 4.0);
+                logMin = Maximum(logMin, -check->Envelope / fabs(e));
+                logMax = Minimum(logMax, check->Envelope / fabs(e));
+            }
+
+            for (u32 index = 0; index < ACCURACY_BLOCK_SIZE; ++index)
+            {
+                x[index] = (check->Kernel == WideKernel_Exp) ? RandomBetween(&typeRandom, check->Min, check->Max)
+                                                              : exp(RandomBetween(&typeRandom, logMin, logMax));
+            }
+            if ((block == 0) && check->Point)
+            {
+                x[0] = check->Point;
+            }
+
+            type->Evaluate(check->Kernel, e, x, result, ACCURACY_BLOCK_SIZE);
+            for (u32 index = 0; index < ACCURACY_BLOCK_SIZE; ++index)
+            {
+                worst = Maximum(worst, GetUlpError(result[index], GetKernelReference(check->Kernel, x[index], e)));
+            }
+        }
+
+        b32 failed = !(worst <= check->BoundUlp);
+        failureCount += failed;
+        printf(" %7.2f%s", worst, failed ? "!" : " ");
+    }
+    printf(" %6.1f%s\n", check->BoundUlp, failureCount ? "  FAIL" : "");
+
+    // следующий случай - с новыми аргументами
+    for (u32 index = 0; index < ACCURACY_BLOCK_COUNT * (ACCURACY_BLOCK_SIZE + 1); ++index)
+    {
+        RandomBetween(random, 0.0, 1.0);
+    }
+
+    return failureCount;
+}
+
+// Быстрая математика (MathMode_Fast) против эталонной: скалярные ядра на
+// диапазонах аргументов каждого вызова pow/log/Root в ss_boiler.cpp и на
+// общем диапазоне, ядро x^(5/8) всех ширин в ULP, затем вся цепочка на
+// образцах бенчмарка на всех SimdLevel. Пороги - те, что указаны в ss_math.h.
+#define ACCURACY_FAST_SAMPLE_COUNT (1 << 20)
+#define ACCURACY_FAST_POW_BOUND 1e-10
+#define ACCURACY_FAST_LOG_BOUND 5e-12
+#define ACCURACY_FAST_FIVE_EIGHTHS_ULP 1.0
+#define ACCURACY_FAST_CHAIN_BOUND 5e-10
+
+enum fast_kernel
+{
+    FastKernel_Log2,
+    FastKernel_Pow,
+    FastKernel_Exp,
+    FastKernel_PowFiveEighths,
+};
+
+struct FastMathCase
+{
+    const char *Name;
+    fast_kernel Kernel;
+    f64 Min; // x берется равномерно по логарифму из [Min, Max] (Exp - равномерно)
+    f64 Max;
+    f64 Exponent; // Pow: показатель, 0 - случайный из [-4, 4]
+    f64 Bound;    // x^(5/8) - в ULP, остальные - относительная ошибка
+};
+
+internal u32
+CheckFastMath(BenchContext *context, MemoryArena *arena)
+{
+    u32 failureCount = 0;
+
+    FastMathCase cases[] = {
+        {"Root(T3 / T2, 1.6)", FastKernel_PowFiveEighths, 0.0197, 1.0, 0.625, ACCURACY_FAST_FIVE_EIGHTHS_ULP},
+        {"Pow(r / 0.0105, 0.15)", FastKernel_Pow, 0.1, 10.0, 0.15, ACCURACY_FAST_POW_BOUND},
+        {"Pow(omega, 0.7)", FastKernel_Pow, 0.1, 1.0e5, 0.7, ACCURACY_FAST_POW_BOUND},
+        {"Pow(0.0115 / r, 0.214)", FastKernel_Pow, 0.1, 10.0, 0.214, ACCURACY_FAST_POW_BOUND},
+        {"Pow(tk - tb, 4/3)", FastKernel_Pow, 1.0, 500.0, 4.0 / 3.0, ACCURACY_FAST_POW_BOUND},
+        {"Pow(V, 0.7)", FastKernel_Pow, 0.01, 200.0, 0.7, ACCURACY_FAST_POW_BOUND},
+        {"Pow(Ki, 0.7)", FastKernel_Pow, 1.0, 1.0e6, 0.7, ACCURACY_FAST_POW_BOUND},
+        {"Pow general, |e| <= 4", FastKernel_Pow, 1.0e-6, 1.0e6, 0.0, ACCURACY_FAST_POW_BOUND},
+        {"Log(T2 / T3)", FastKernel_Log2, 1.0, 50.0, 0.0, ACCURACY_FAST_LOG_BOUND},
+        {"Log2 general", FastKernel_Log2, 1.0e-6, 1.0e6, 0.0, ACCURACY_FAST_LOG_BOUND},
+        {"Exp, fire tube segments", FastKernel_Exp, -50.0, 0.0, 0.0, ACCURACY_FAST_POW_BOUND},
+    };
+
+    printf("%-28s %12s %12s %14s %10s\n", "fast kernel", "x min", "x max", "max error", "bound");
+    BenchRandom random = {0x9E3779B97F4A7C15ULL};
+    for (u32 caseIndex = 0; caseIndex < ArrayCount(cases); ++caseIndex)
+    {
+        FastMathCase *check = cases + caseIndex;
+        f64 logMin = log(check->Min);
+        f64 logMax = log(check->Max);
+        f64 worst = 0.0;
+        for (u32 sample = 0; sample < ACCURACY_FAST_SAMPLE_COUNT; ++sample)
+        {
+            f64 x = (check->Kernel == FastKernel_Exp) ? RandomBetween(&random, check->Min, check->Max)
+                                                      : exp(RandomBetween(&random, logMin, logMax));
+            f64 e = (check->Exponent == 0.0) ? RandomBetween(&random, -4.0, 4.0) : check->Exponent;
+            switch (check->Kernel)
+            {
+                case FastKernel_Log2:
+                {
+                    // NOTE: Absolute error, log2 crosses zero at x = 1.
+                    worst = Maximum(worst, fabs(FastLog2(x) - log2(x)));
+                } break;
+
+                case FastKernel_Pow:
+                {
+                    f64 reference = pow(x, e);
+                    worst = Maximum(worst, fabs(FastPow(x, e) - reference) / reference);
+                } break;
+
+                case FastKernel_Exp:
+                {
+                    f64 reference = exp(x);
+                    worst = Maximum(worst, fabs(FastExp(x) - reference) / reference);
+                } break;
+
+                case FastKernel_PowFiveEighths:
+                {
+                    worst = Maximum(worst, GetUlpError(FastPowFiveEighths(x), pow(x, e)));
+                } break;
+            }
+        }
+
+        b32 failed = !(worst <= check->Bound);
+        failureCount += failed;
+        if (check->Kernel == FastKernel_PowFiveEighths)
+        {
+            printf("%-28s %12.4g %12.4g %10.2f ULP %6.1f ULP%s\n", check->Name, check->Min, check->Max, worst,
+                   check->Bound, failed ? "  FAIL" : "");
+        }
+        else
+        {
+            printf("%-28s %12.4g %12.4g %14.3e %10.0e%s\n", check->Name, check->Min, check->Max, worst, check->Bound,
+                   failed ? "  FAIL" : "");
+        }
+    }
+
+    // ядро x^(5/8) в векторных типах - тот же разбор, что у эталонных ядер
+    {
+        f64 *x = PushArray(arena, ACCURACY_BLOCK_SIZE, f64);
+        f64 *result = PushArray(arena, ACCURACY_BLOCK_SIZE, f64);
+        AccuracyCase rootCase = {"Root(T3 / T2, 1.6), fast", WideKernel_Root, 0.0197, 1.0, 1.6, 0.0,
+                                 ACCURACY_FAST_FIVE_EIGHTHS_ULP, 0.0};
+        SetMathMode(MathMode_Fast);
+        failureCount += CheckWideKernel(&rootCase, &random, x, result);
+        SetMathMode(MathMode_Reference);
+    }
+
+    // вся цепочка: быстрая математика против эталонной на том же наборе инструкций
+    BenchSamples *s = context->Samples;
+    BoilerBatchInput *input = &s->Input;
+    BoilerBatchOutput reference = PushBoilerBatchOutput(arena, BENCH_SAMPLE_COUNT);
+    BoilerBatchOutput fast = PushBoilerBatchOutput(arena, BENCH_SAMPLE_COUNT);
+    const char *columnNames[] = {"T1", "T2", "T3", "Tabs", "Omega", "K1", "Q3", "Qt"};
+    printf("\n%-12s", "fast chain");
+    for (u32 column = 0; column < ArrayCount(columnNames); ++column)
+    {
+        printf(" %10s", columnNames[column]);
+    }
+    printf(" %10s\n", "bound");
+    for (u32 level = SimdLevel_Scalar; level <= (u32)GetSimdLevel(); ++level)
+    {
+        SetSimdLevel((simd_level)level);
+        SetMathMode(MathMode_Reference);
+        CalculateBoilerBatch(input, &reference, 0, BENCH_SAMPLE_COUNT);
+        SetMathMode(MathMode_Fast);
+        CalculateBoilerBatch(input, &fast, 0, BENCH_SAMPLE_COUNT);
+
+        f64 *referenceColumns[] = {reference.T1, reference.T2, reference.T3, reference.Tabs,
+                                   reference.Omega, reference.K1, reference.Q3, reference.Qt};
+        f64 *fastColumns[] = {fast.T1, fast.T2, fast.T3, fast.Tabs, fast.Omega, fast.K1, fast.Q3, fast.Qt};
+        b32 failed = false;
+        printf("%-12s", GetSimdLevelName((simd_level)level));
+        for (u32 column = 0; column < ArrayCount(columnNames); ++column)
+        {
+            f64 worst = 0.0;
+            for (u32 index = 0; index < BENCH_SAMPLE_COUNT; ++index)
+            {
+                f64 value = referenceColumns[column][index];
+                worst = Maximum(worst, fabs(fastColumns[column][index] - value) / fabs(value));
+            }
+            failed |= !(worst <= ACCURACY_FAST_CHAIN_BOUND);
+            printf(" %10.2e", worst);
+        }
+        failureCount += failed;
+        printf(" %10.0e%s\n", ACCURACY_FAST_CHAIN_BOUND, failed ? "  FAIL" : "");
+    }
+    SetMathMode(MathMode_Reference);
+
+    return failureCount;
+}
+
+// Обратная задача с известным ответом: цели - выходы образцов при их
+// геометрии, поиск начинается с Start. Все строки должны сойтись, невязка -
+// не больше допуска решателя, решение - совпасть с геометрией образца.
+#define ACCURACY_INVERSE_ROWS 1024
+#define ACCURACY_INVERSE_SOLUTION 1.0e-6 // допустимая относительная ошибка решения
+
+struct InverseCheck
+{
+    const char *Name;
+    u32 UnknownCount;
+    u32 Unknowns[INVERSE_MAX_UNKNOWNS];
+    u32 Targets[INVERSE_MAX_UNKNOWNS];
+    f64 Min[INVERSE_MAX_UNKNOWNS];
+    f64 Max[INVERSE_MAX_UNKNOWNS];
+    f64 Start[INVERSE_MAX_UNKNOWNS];
+};
+
+internal u32
+CheckInverseConvergence(InverseCheck *check, BoilerBatchInput *samples, MemoryArena *arena)
+{
+    auto tempMem = BeginTemporaryMemory(arena);
+
+    u32 rowCount = ACCURACY_INVERSE_ROWS;
+    auto base = PushBoilerBatchInput(arena, rowCount);
+    auto output = PushBoilerBatchOutput(arena, rowCount);
+    auto status = PushArray(arena, rowCount, u8);
+    f64 *truth[INVERSE_MAX_UNKNOWNS] = {};
+    f64 *targets[INVERSE_MAX_UNKNOWNS] = {};
+    f64 *solution[INVERSE_MAX_UNKNOWNS] = {};
+    f64 *achieved[INVERSE_MAX_UNKNOWNS] = {};
+    for (u32 unknown = 0; unknown < check->UnknownCount; ++unknown)
+    {
+        truth[unknown] = PushArray(arena, rowCount, f64);
+        targets[unknown] = PushArray(arena, rowCount, f64);
+        solution[unknown] = PushArray(arena, rowCount, f64);
+        achieved[unknown] = PushArray(arena, rowCount, f64);
+    }
+    if (!base.Ld || !output.T3 || !status || !achieved[check->UnknownCount - 1])
+    {
+        EndTemporaryMemory(tempMem);
+        printf("%-28s - не хватает памяти  FAIL\n", check->Name);
+        return 1;
+    }
+
+    base.Fuels = samples->Fuels;
+    base.FuelRecords = samples->FuelRecords;
+    base.t = samples->t;
+    for (u32 row = 0; row < rowCount; ++row)
+    {
+        CopyBoilerBatchVariant(&base, row, samples, row);
+    }
+    CalculateBoilerBatch(&base, &output);
+
+    InverseSpec spec = {};
+    spec.UnknownCount = check->UnknownCount;
+    InverseBatch batch = {};
+    batch.Base = &base;
+    batch.Status = status;
+    for (u32 unknown = 0; unknown < check->UnknownCount; ++unknown)
+    {
+        spec.Unknowns[unknown] = check->Unknowns[unknown];
+        spec.Targets[unknown] = check->Targets[unknown];
+        spec.Min[unknown] = check->Min[unknown];
+        spec.Max[unknown] = check->Max[unknown];
+        batch.TargetValues[unknown] = targets[unknown];
+        batch.Solution[unknown] = solution[unknown];
+        batch.Achieved[unknown] = achieved[unknown];
+    }
+
+    for (u32 row = 0; row < rowCount; ++row)
+    {
+        f64 wall = base.DOut[row] - base.DIn[row];
+        for (u32 unknown = 0; unknown < check->UnknownCount; ++unknown)
+        {
+            truth[unknown][row] = GetInverseUnknown(&base, row, check->Unknowns[unknown]);
+            targets[unknown][row] = GetInverseTarget(&base, &output, row, check->Targets[unknown]);
+        }
+        for (u32 unknown = 0; unknown < check->UnknownCount; ++unknown)
+        {
+            SetInverseUnknown(&base, row, check->Unknowns[unknown], check->Start[unknown], wall);
+        }
+    }
+
+    auto stats = SolveInverseBatch(arena, &spec, &batch);
+
+    f64 worstResidual = 0.0;
+    f64 worstSolution = 0.0;
+    for (u32 row = 0; row < rowCount; ++row)
+    {
+        for (u32 unknown = 0; unknown < check->UnknownCount; ++unknown)
+        {
+            f64 residual = fabs(GetInverseResidual(achieved[unknown][row], targets[unknown][row]));
+            f64 error = fabs(solution[unknown][row] - truth[unknown][row]) / fabs(truth[unknown][row]);
+            worstResidual = (residual <= worstResidual) ? worstResidual : residual;
+            worstSolution = (error <= worstSolution) ? worstSolution : error;
+        }
+    }
+
+    b32 failed = (stats.Converged != rowCount) || !(worstResidual <= INVERSE_DEFAULT_TOLERANCE) ||
+                 !(worstSolution <= ACCURACY_INVERSE_SOLUTION);
+    printf("%-28s %10u %10u %10.2e %10.2e%s\n", check->Name, stats.Converged, stats.Iterations, worstResidual,
+           worstSolution, failed ? "  FAIL" : "");
+
+    EndTemporaryMemory(tempMem);
+    return failed;
+}
+
+// Кэш перебора: после каждого шага кэш должен совпасть бит в бит с
+// перебором без кэша, а PrepareSweepCache - вернуть ровно испорченные стадии.
+internal b32
+IsSweepCacheFresh(SweepCache *cache, BoilerBatchOutput *reference)
+{
+    b32 result = true;
+    f64 **cacheColumns = (f64 **)&cache->Output;
+    f64 **referenceColumns = (f64 **)reference;
+    for (u32 column = 0; column < BOILER_BATCH_OUTPUT_COLUMNS; ++column)
+    {
+        result &= (memcmp(cacheColumns[column], referenceColumns[column], cache->VariantCount * sizeof(f64)) == 0);
+    }
+    return result;
+}
+
+internal b32
+CheckSweepCacheStep(AppState *state, SweepSpec *spec, u64 codeIdentity, u32 expectedStale,
+                    BoilerBatchOutput *reference, const char *name)
+{
+    u32 stale = PrepareSweepCache(state, spec, codeIdentity);
+    auto cache = &state->Sweep;
+    b32 failed = !cache->ChunkStages || (stale != expectedStale);
+    if (!failed)
+    {
+        RunSweep(&state->TransientArena, spec, &cache->Output, cache->ChunkStages, 0);
+        failed = !IsSweepCacheFresh(cache, reference);
+    }
+
+    printf("%-40s %#6x %#10x%s\n", name, expectedStale, stale, failed ? "  FAIL" : "");
+    return failed;
+}
+
+internal u32
+CheckSweepCacheInvalidation(void)
+{
+    u32 failureCount = 0;
+
+    u64 permanentSize = Megabytes(16);
+    u64 transientSize = Megabytes(32);
+    auto state = (AppState *)calloc(1, sizeof(AppState));
+    u8 *permanent = (u8 *)malloc(permanentSize);
+    u8 *transient = (u8 *)malloc(transientSize);
+    InitializeArena(&state->PermanentArena, permanentSize, permanent);
+    InitializeArena(&state->TransientArena, transientSize, transient);
+
+    // перебор по умолчанию, укороченный до 16 кусков
+    SetDefaultInput(&state->Input, 0);
+    SweepSpec spec = state->Input.Sweep;
+    spec.Ranges[SweepParameter_Ld].Steps = 16;
+
+    BoilerBatchOutput reference = PushBoilerBatchOutput(&state->TransientArena, GetSweepVariantCount(&spec));
+    if (!reference.T3)
+    {
+        printf("кэш перебора - не хватает памяти  FAIL\n");
+        return 1;
+    }
+    RunSweep(&state->TransientArena, &spec, &reference, 0, 0);
+
+    printf("%-40s %6s %10s\n", "sweep cache", "stale", "got");
+    failureCount += CheckSweepCacheStep(state, &spec, 1, BoilerStage_All, &reference, "empty cache");
+    failureCount += CheckSweepCacheStep(state, &spec, 1, 0, &reference, "same code");
+    failureCount += CheckSweepCacheStep(state, &spec, 2, 0, &reference, "new code, same results");
+
+    // NOTE: A changed formula shows up as changed outputs of its stage.
+    auto cache = &state->Sweep;
+    for (u64 index = 0; index < cache->VariantCount; ++index)
+    {
+        cache->Output.T3[index] += 1.0;
+    }
+    failureCount += CheckSweepCacheStep(state, &spec, 3, BoilerStage_FireTubes, &reference, "new code, T3 changed");
+
+    for (u64 index = 0; index < cache->VariantCount; ++index)
+    {
+        cache->Output.Qt[index] *= 2.0;
+        cache->Output.Q0[index] *= 2.0;
+    }
+    failureCount += CheckSweepCacheStep(state, &spec, 4, BoilerStage_Front | BoilerStage_Losses, &reference,
+                                        "new code, Q0 and Qt changed");
+
+    // другой перебор: кэш сбрасывается целиком
+    SweepSpec changed = spec;
+    changed.Ranges[SweepParameter_Nd].Steps = 32;
+    BoilerBatchOutput changedReference =
+        PushBoilerBatchOutput(&state->TransientArena, GetSweepVariantCount(&changed));
+    if (changedReference.T3)
+    {
+        RunSweep(&state->TransientArena, &changed, &changedReference, 0, 0);
+        failureCount += CheckSweepCacheStep(state, &changed, 4, BoilerStage_All, &changedReference,
+                                            "new sweep input");
+    }
+    else
+    {
+        ++failureCount;
+    }
+
+    free(transient);
+    free(permanent);
+    free(state);
+
+    return failureCount;
+}
+
+// Библиотека топлив в памяти: ids и имена в разном порядке. Каждая запись
+// должна находиться по Id и по имени, отсутствующие - не находиться, а
+// файл с испорченным порядком ids или индекса имен - не открываться.
+#define ACCURACY_FUEL_RECORDS 64
+
+internal b32
+CheckFuelLibraryOpen(u8 *image, u64 size, b32 expected, const char *name)
+{
+    FuelLibrary library;
+    b32 opened = OpenFuelLibrary(image, size, &library);
+    b32 failed = (opened != expected);
+    printf("%-40s %6s %10s%s\n", name, expected ? "yes" : "no", opened ? "yes" : "no", failed ? "  FAIL" : "");
+    return failed;
+}
+
+internal u32
+CheckFuelLibraryLookup(MemoryArena *arena)
+{
+    u32 failureCount = 0;
+
+    auto tempMem = BeginTemporaryMemory(arena);
+
+    u32 recordCount = ACCURACY_FUEL_RECORDS;
+    u64 recordOffset = sizeof(FuelLibraryHeader);
+    u64 nameIndexOffset = recordOffset + recordCount * sizeof(FuelRecord);
+    u64 size = nameIndexOffset + recordCount * sizeof(u32);
+    auto image = (u8 *)PushSize(arena, size, 64);
+    if (!image)
+    {
+        EndTemporaryMemory(tempMem);
+        printf("библиотека топлив - не хватает памяти  FAIL\n");
+        return 1;
+    }
+    ZeroSize(size, image);
+
+    auto header = (FuelLibraryHeader *)image;
+    header->Magic = FUEL_LIBRARY_MAGIC;
+    header->HeaderSize = sizeof(FuelLibraryHeader);
+    header->RecordSize = sizeof(FuelRecord);
+    header->RecordCount = recordCount;
+    header->RecordOffset = recordOffset;
+    header->NameIndexOffset = nameIndexOffset;
+    header->FileSize = size;
+
+    auto records = (FuelRecord *)(image + recordOffset);
+    auto nameIndex = (u32 *)(image + nameIndexOffset);
+    for (u32 index = 0; index < recordCount; ++index)
+    {
+        FuelRecord *record = records + index;
+        record->Composition = BenchFuelTable[index % BENCH_FUEL_COUNT];
+        record->Id = 10 + 7 * index;
+        snprintf(record->Name, sizeof(record->Name), "Уголь %02u", (index * 37) % recordCount);
+
+        // индекс имен вставками
+        u32 dest = index;
+        while (dest && (strcmp(records[nameIndex[dest - 1]].Name, record->Name) > 0))
+        {
+            nameIndex[dest] = nameIndex[dest - 1];
+            --dest;
+        }
+        nameIndex[dest] = index;
+    }
+
+    printf("%-40s %6s %10s\n", "fuel library", "open", "got");
+    failureCount += CheckFuelLibraryOpen(image, size, true, "sorted ids and names");
+
+    FuelLibrary library;
+    if (OpenFuelLibrary(image, size, &library))
+    {
+        u32 lookupFailures = 0;
+        for (u32 index = 0; index < recordCount; ++index)
+        {
+            FuelRecord *record = records + index;
+            lookupFailures += (FindFuelById(&library, record->Id) != record);
+            lookupFailures += (FindFuelByName(&library, record->Name) != record);
+            lookupFailures += (FindFuel(&library, 0, record->Name) != record);
+        }
+        lookupFailures += (FindFuelById(&library, 11) != 0);
+        lookupFailures += (FindFuelById(&library, 10 + 7 * recordCount) != 0);
+        lookupFailures += (FindFuelByName(&library, "Уголь") != 0);
+        lookupFailures += (FindFuelByName(&library, "Уголь 99") != 0);
+        lookupFailures += (FindFuelByName(&library, "") != 0);
+        printf("%-40s %6u %10u%s\n", "lookups by id and name, failures", 0, lookupFailures,
+               lookupFailures ? "  FAIL" : "");
+        failureCount += (lookupFailures != 0);
+    }
+
+    // порча по одной, с восстановлением
+    u32 savedName = nameIndex[3];
+    nameIndex[3] = nameIndex[4];
+    nameIndex[4] = savedName;
+    failureCount += CheckFuelLibraryOpen(image, size, false, "name index out of order");
+    nameIndex[4] = nameIndex[3];
+    nameIndex[3] = savedName;
+
+    u32 savedDuplicate = nameIndex[4];
+    nameIndex[4] = nameIndex[3];
+    failureCount += CheckFuelLibraryOpen(image, size, false, "name index with a duplicate");
+    nameIndex[4] = savedDuplicate;
+
+    u32 savedId = records[5].Id;
+    records[5].Id = records[6].Id;
+    failureCount += CheckFuelLibraryOpen(image, size, false, "duplicate id");
+    records[5].Id = records[6].Id + 1;
+    failureCount += CheckFuelLibraryOpen(image, size, false, "ids out of order");
+    records[5].Id = savedId;
+
+    failureCount += CheckFuelLibraryOpen(image, size, true, "restored");
+
+    EndTemporaryMemory(tempMem);
+
+    return failureCount;
+}
+
+// Граф в расчетной точке: после сдвига каждого входа по очереди (и после
+// возврата) пересчет только помеченных узлов должен дать бит в бит то же,
+// что пересчет всех узлов с нуля.
+internal void
+UpdateBoilerGraphFull(BoilerGraph *full, BoilerGraph *graph)
+{
+    *full = *graph;
+    for (u32 node = BoilerNode_InputCount; node < BoilerNode_Count; ++node)
+    {
+        full->Values[node] = NAN;
+        full->Dirty |= (1ULL << node);
+    }
+    UpdateBoilerGraph(full);
+}
+
+internal b32
+CheckBoilerGraphStep(BoilerGraph *graph, u32 input, const char *step)
+{
+    BoilerGraph full;
+    u32 nodeCount = UpdateBoilerGraph(graph);
+    UpdateBoilerGraphFull(&full, graph);
+
+    b32 failed = (memcmp(graph->Values, full.Values, sizeof(graph->Values)) != 0);
+    if (failed)
+    {
+        printf("%-28s %10u %10u  FAIL\n", step, input, nodeCount);
+    }
+    return failed;
+}
+
+internal u32
+CheckBoilerGraphIncremental(void)
+{
+    CalculationInput input;
+    SetDefaultInput(&input, 0);
+
+    BoilerGraph graph;
+    InitializeBoilerGraph(&graph, input.Chamber, input.Dd, input.Ld, input.Nd, input.q22, input.t, input.BaseFuel);
+    UpdateBoilerGraph(&graph);
+
+    printf("%-28s %10s %10s\n", "graph", "input", "nodes");
+    u32 failureCount = 0;
+    for (u32 node = 0; node < BoilerNode_InputCount; ++node)
+    {
+        f64 original = graph.Values[node];
+        f64 delta = (node == BoilerNode_Nd) ? 1.0 : (original != 0.0) ? 0.01 * original : 0.01;
+
+        SetBoilerGraphInput(&graph, (boiler_node)node, original + delta);
+        failureCount += CheckBoilerGraphStep(&graph, node, "incremental != full");
+        SetBoilerGraphInput(&graph, (boiler_node)node, original);
+        failureCount += CheckBoilerGraphStep(&graph, node, "restored != full");
+    }
+
+    // NOTE: Several inputs at once, the dirty sets overlap.
+    SetBoilerGraphInput(&graph, BoilerNode_Ld, input.Ld + MillimeterToMeter(100));
+    SetBoilerGraphInput(&graph, BoilerNode_alpha, input.BaseFuel.alpha + 0.05);
+    SetBoilerGraphInput(&graph, BoilerNode_U, input.Chamber.U * 1.1);
+    failureCount += CheckBoilerGraphStep(&graph, BoilerNode_InputCount, "several != full");
+
+    printf("%-28s %10u %10u%s\n", "inputs checked, failures", (u32)BoilerNode_InputCount, failureCount,
+           failureCount ? "  FAIL" : "");
+    return failureCount;
+}
+
+// Производные CalculateBoilerSensitivity в расчетной точке против
+// центральных разностей пакетного расчета f64 с шагом h = 1e-5 * |x|
+// (ошибка разности порядка h^2, округление порядка eps / h). Ошибка
+// нормирована как эластичность: |d - fd| * |x| / max(|y|, |d * x|).
+#define ACCURACY_DUAL_STEP 1.0e-5
+#define ACCURACY_DUAL_TOLERANCE 1.0e-6
+
+struct DualCheckGroup
+{
+    const char *Name;
+    u32 First;
+    u32 OnePastLast;
+};
+
+internal u32
+CheckBoilerSensitivity(MemoryArena *arena)
+{
+    CalculationInput design;
+    SetDefaultInput(&design, 0);
+
+    FireChamber fireChamber = design.Chamber;
+    PipeDiameter dd = design.Dd;
+    f64 Ld = design.Ld;
+    u16 nd = design.Nd;
+    f64 q22 = design.q22;
+    Fuel fuel = design.BaseFuel;
+
+    BoilerBatchInput input = {};
+    input.Count = 1;
+    input.TopLengh = &fireChamber.TopLengh;
+    input.TopWidth = &fireChamber.TopWidth;
+    input.BottomLength = &fireChamber.BottomLength;
+    input.BottomWidth = &fireChamber.BottomWidth;
+    input.FrontHeight = &fireChamber.FrontHeight;
+    input.RearHeight = &fireChamber.RearHeight;
+    input.DOut = &dd.DOut;
+    input.DIn = &dd.DIn;
+    input.Ld = &Ld;
+    input.Nd = &nd;
+    input.U = &fireChamber.U;
+    input.q22 = &q22;
+    input.Fuels = &fuel;
+    input.t = design.t;
+
+    auto tempMem = BeginTemporaryMemory(arena);
+    BoilerBatchOutput plus = PushBoilerBatchOutput(arena, 1);
+    BoilerBatchOutput minus = PushBoilerBatchOutput(arena, 1);
+    if (!plus.N || !minus.N)
+    {
+        EndTemporaryMemory(tempMem);
+        printf("чувствительность - не хватает памяти  FAIL\n");
+        return 1;
+    }
+
+    // NOTE: In boiler_input order.
+    f64 *inputValues[] = {
+        input.TopLengh, input.TopWidth, input.BottomLength, input.BottomWidth, input.FrontHeight, input.RearHeight,
+        input.U, input.DOut, input.DIn, input.Ld, input.q22, &input.t, &fuel.C, &fuel.H, &fuel.S, &fuel.O, &fuel.N,
+        &fuel.W, &fuel.A, &fuel.CO, &fuel.CO2, &fuel.O2, &fuel.N2, &fuel.K, &fuel.beta0, &fuel.alpha,
+    };
+    static_assert(ArrayCount(inputValues) == BoilerInput_Count, "inputValues must follow boiler_input");
+
+    BoilerSensitivity sensitivity;
+    CalculateBoilerSensitivity(&input, 0, &sensitivity);
+
+    // NOTE: BoilerSensitivity has the BoilerBatchOutput columns in the same order.
+    static_assert(sizeof(BoilerSensitivity) == BOILER_BATCH_OUTPUT_COLUMNS * sizeof(dual),
+                  "BoilerSensitivity must mirror BoilerBatchOutput");
+    dual *derivatives = (dual *)&sensitivity;
+    f64 **plusColumns = (f64 **)&plus;
+    f64 **minusColumns = (f64 **)&minus;
+
+    DualCheckGroup groups[] = {
+        {"chamber", BoilerInput_TopLengh, BoilerInput_U + 1},
+        {"pipes", BoilerInput_DOut, BoilerInput_Ld + 1},
+        {"q22, t", BoilerInput_q22, BoilerInput_t + 1},
+        {"fuel", BoilerInput_C, BoilerInput_alpha + 1},
+    };
+
+    u32 failureCount = 0;
+    printf("%-28s %10s %10s %10s\n", "dual vs central difference", "inputs", "max error", "bound");
+    for (u32 groupIndex = 0; groupIndex < ArrayCount(groups); ++groupIndex)
+    {
+        DualCheckGroup *group = groups + groupIndex;
+        f64 worst = 0.0;
+        for (u32 boilerInput = group->First; boilerInput < group->OnePastLast; ++boilerInput)
+        {
+            f64 *value = inputValues[boilerInput];
+            f64 original = *value;
+            f64 scale = (original != 0.0) ? fabs(original) : 1.0;
+            f64 h = ACCURACY_DUAL_STEP * scale;
+
+            *value = original + h;
+            CalculateBoilerBatch(&input, &plus);
+            *value = original - h;
+            CalculateBoilerBatch(&input, &minus);
+            *value = original;
+
+            for (u32 column = 0; column < BOILER_BATCH_OUTPUT_COLUMNS; ++column)
+            {
+                f64 y = derivatives[column].Value;
+                f64 d = derivatives[column].D[boilerInput];
+                f64 fd = (plusColumns[column][0] - minusColumns[column][0]) / (2.0 * h);
+                f64 difference = fabs(d - fd);
+                f64 norm = Max(fabs(y), fabs(d) * scale);
+                f64 error = (difference == 0.0) ? 0.0 : difference * scale / norm;
+                worst = (error <= worst) ? worst : error;
+            }
+        }
+
+        b32 failed = !(worst <= ACCURACY_DUAL_TOLERANCE);
+        failureCount += failed;
+        printf("%-28s %10u %10.2e %10.0e%s\n", group->Name, group->OnePastLast - group->First, worst,
+               ACCURACY_DUAL_TOLERANCE, failed ? "  FAIL" : "");
+    }
+
+    EndTemporaryMemory(tempMem);
+    return failureCount;
+}
+
+// Кэш стадий на стадии графа (отчет из одной записи и таблица перебора Ld),
+// вывод в двоичном формате, то есть f64 как есть: повтор с тем же ключом
+// должен вывести из кэша бит в бит то же, что пересчет, а смена любой части
+// ключа - пересчитать стадию.
+#define ACCURACY_STAGE_STEPS 64
+
+struct StageCacheRun
+{
+    b32 Computed;
+    u64 Offset; // вывод этого прогона в файле writer
+    u64 Size;
+};
+
+internal StageCacheRun
+RunGraphStage(StageCache *cache, AppMemory *memory, ReportWriter *writer, FILE *log, CalculationInput *input)
+{
+    StageCacheRun result = {};
+    result.Offset = writer->BytesWritten;
+
+    PrepareStageCache(cache, GetStageCacheKey(input, memory));
+    if (BeginStage(cache, CalculationStage_Graph, memory, writer, log))
+    {
+        result.Computed = true;
+
+        BoilerGraph graph;
+        InitializeBoilerGraph(&graph, input->Chamber, input->Dd, input->Ld, input->Nd, input->q22, input->t,
+                              input->BaseFuel);
+        UpdateBoilerGraph(&graph);
+
+        Report report;
+        BeginReport(&report, "graph");
+        AddReportValue(&report, "T3", 0, "°C", graph.Values[BoilerNode_T3]);
+        AddReportValue(&report, "Omega", 0, 0, graph.Values[BoilerNode_Omega]);
+        AddReportValue(&report, "Qt", 0, 0, graph.Values[BoilerNode_Qt]);
+        WriteStageReport(cache, memory, writer, &report);
+
+        f64 T3[ACCURACY_STAGE_STEPS];
+        SweepBoilerGraph(&graph, BoilerNode_Ld, MillimeterToMeter(3500), MillimeterToMeter(5500),
+                         ACCURACY_STAGE_STEPS, BoilerNode_T3, T3);
+        BeginReport(&report, "graph_sweep", ACCURACY_STAGE_STEPS);
+        AddReportField(&report, "T3", 0, "°C", T3);
+        WriteStageReport(cache, memory, writer, &report, true);
+
+        EndStage(cache);
+    }
+
+    result.Size = writer->BytesWritten - result.Offset;
+    return result;
+}
+
+internal b32
+IsStageOutputSame(FILE *file, StageCacheRun *a, StageCacheRun *b)
+{
+    if (!a->Size || (a->Size != b->Size))
+    {
+        return false;
+    }
+
+    b32 result = true;
+    u8 bytesA[4096];
+    u8 bytesB[4096];
+    for (u64 offset = 0; result && (offset < a->Size); offset += sizeof(bytesA))
+    {
+        u64 size = Minimum(sizeof(bytesA), a->Size - offset);
+        fseek(file, (long)(a->Offset + offset), SEEK_SET);
+        result = (fread(bytesA, 1, size, file) == size);
+        fseek(file, (long)(b->Offset + offset), SEEK_SET);
+        result = result && (fread(bytesB, 1, size, file) == size) && (memcmp(bytesA, bytesB, size) == 0);
+    }
+    fseek(file, 0, SEEK_END);
+    return result;
+}
+
+internal b32
+CheckStageCacheRun(StageCacheRun *run, b32 expectComputed, const char *name)
+{
+    b32 failed = (run->Computed != expectComputed) || !run->Size;
+    printf("%-40s %6s %10s%s\n", name, expectComputed ? "miss" : "hit", run->Computed ? "miss" : "hit",
+           failed ? "  FAIL" : "");
+    return failed;
+}
+
+internal u32
+CheckStageCache(MemoryArena *arena)
+{
+    u32 failureCount = 0;
+
+    FILE *output = tmpfile();
+    FILE *log = tmpfile();
+    auto cache = (StageCache *)calloc(1, sizeof(StageCache));
+    u8 *cacheMemory = (u8 *)malloc(STAGE_CACHE_SIZE);
+    if (!output || !log || !cache || !cacheMemory)
+    {
+        printf("кэш стадий - нет временного файла или памяти  FAIL\n");
+        return 1;
+    }
+    InitializeArena(&cache->Arena, STAGE_CACHE_SIZE, cacheMemory);
+
+    auto tempMem = BeginTemporaryMemory(arena);
+    ReportWriter writer = BeginReportWriter(arena, output, Kilobytes(64));
+
+    CalculationInput input;
+    SetDefaultInput(&input, 0);
+    AppMemory memory = {};
+    memory.ReportFormat = ReportFormat_Binary;
+    memory.CodeIdentity = 1;
+
+    printf("%-40s %6s %10s\n", "stage cache", "expect", "got");
+    StageCacheRun first = RunGraphStage(cache, &memory, &writer, log, &input);
+    failureCount += CheckStageCacheRun(&first, true, "empty cache");
+
+    StageCacheRun replay = RunGraphStage(cache, &memory, &writer, log, &input);
+    failureCount += CheckStageCacheRun(&replay, false, "same key");
+
+    // без кэша стадия считается каждый раз
+    memory.CodeIdentity = 0;
+    StageCacheRun uncached = RunGraphStage(cache, &memory, &writer, log, &input);
+    failureCount += CheckStageCacheRun(&uncached, true, "unknown code, cache off");
+    memory.CodeIdentity = 1;
+
+    b32 same = IsStageOutputSame(output, &first, &replay) && IsStageOutputSame(output, &uncached, &replay);
+    failureCount += !same;
+    printf("%-40s %6s %10s%s\n", "replay == recomputation", "yes", same ? "yes" : "no", same ? "" : "  FAIL");
+
+    RunGraphStage(cache, &memory, &writer, log, &input);
+    input.Ld += MillimeterToMeter(1);
+    StageCacheRun run = RunGraphStage(cache, &memory, &writer, log, &input);
+    failureCount += CheckStageCacheRun(&run, true, "input changed");
+    input.Ld -= MillimeterToMeter(1);
+
+    RunGraphStage(cache, &memory, &writer, log, &input);
+    u8 fuelLibrary[64] = {1};
+    memory.FuelLibrary = fuelLibrary;
+    memory.FuelLibrarySize = sizeof(fuelLibrary);
+    run = RunGraphStage(cache, &memory, &writer, log, &input);
+    failureCount += CheckStageCacheRun(&run, true, "fuel library added");
+    fuelLibrary[0] = 2;
+    run = RunGraphStage(cache, &memory, &writer, log, &input);
+    failureCount += CheckStageCacheRun(&run, true, "fuel library changed");
+    memory.FuelLibrary = 0;
+    memory.FuelLibrarySize = 0;
+
+    RunGraphStage(cache, &memory, &writer, log, &input);
+    memory.ReportFormat = ReportFormat_CSV;
+    run = RunGraphStage(cache, &memory, &writer, log, &input);
+    failureCount += CheckStageCacheRun(&run, true, "format changed");
+    memory.ReportFormat = ReportFormat_Binary;
+
+    RunGraphStage(cache, &memory, &writer, log, &input);
+    memory.MathMode = MathMode_Fast;
+    run = RunGraphStage(cache, &memory, &writer, log, &input);
+    failureCount += CheckStageCacheRun(&run, true, "math mode changed");
+    memory.MathMode = MathMode_Reference;
+
+    RunGraphStage(cache, &memory, &writer, log, &input);
+    memory.CodeIdentity = 2;
+    run = RunGraphStage(cache, &memory, &writer, log, &input);
+    failureCount += CheckStageCacheRun(&run, true, "code identity changed");
+
+    run = RunGraphStage(cache, &memory, &writer, log, &input);
+    failureCount += CheckStageCacheRun(&run, false, "same key again");
+
+    EndTemporaryMemory(tempMem);
+    free(cacheMemory);
+    free(cache);
+    fclose(log);
+    fclose(output);
+
+    return failureCount;
+}
+
+// Парк на каждом SimdLevel против скалярного пути: статусы поездок должны
+// совпасть, время, топливо и вода - с относительной ошибкой не больше порога.
+#define ACCURACY_FLEET_ROUTES 8
+#define ACCURACY_FLEET_SECTIONS 20
+#define ACCURACY_FLEET_LOCOMOTIVES 8
+#define ACCURACY_FLEET_MASSES 8
+#define ACCURACY_FLEET_TOLERANCE 1.0e-12
+
+internal b32
+PushBenchFleet(MemoryArena *arena, CalculationInput *design, FleetBatch *fleet)
+{
+    const u32 dutyCount = ACCURACY_FLEET_ROUTES * ACCURACY_FLEET_MASSES;
+    const u32 tripCount = ACCURACY_FLEET_LOCOMOTIVES * dutyCount;
+
+    auto routes = PushArray(arena, ACCURACY_FLEET_ROUTES, TractionRoute);
+    auto sections = PushArray(arena, ACCURACY_FLEET_ROUTES * ACCURACY_FLEET_SECTIONS, RouteSection);
+    auto locomotives = PushArray(arena, ACCURACY_FLEET_LOCOMOTIVES, Locomotive);
+    auto boilers = PushStruct(arena, BoilerBatchInput);
+    auto duties = PushArray(arena, dutyCount, DutyCycle);
+    if (!routes || !sections || !locomotives || !boilers || !duties)
+    {
+        return false;
+    }
+    *boilers = PushBoilerBatchInput(arena, ACCURACY_FLEET_LOCOMOTIVES);
+    ZeroStruct(*fleet);
+    fleet->Time = PushArray(arena, tripCount, f64);
+    fleet->Coal = PushArray(arena, tripCount, f64);
+    fleet->Water = PushArray(arena, tripCount, f64);
+    fleet->Status = PushArray(arena, tripCount, u8);
+    if (!boilers->Ld || !fleet->Status)
+    {
+        return false;
+    }
+
+    // NOTE: The same random profile as the fleet stage of Calculate.
+    const f64 speedLimits[] = {40.0, 60.0, 80.0, 100.0};
+    for (u32 route = 0; route < ACCURACY_FLEET_ROUTES; ++route)
+    {
+        routes[route].Sections = sections + route * ACCURACY_FLEET_SECTIONS;
+        routes[route].SectionCount = ACCURACY_FLEET_SECTIONS;
+        for (u32 index = 0; index < ACCURACY_FLEET_SECTIONS; ++index)
+        {
+            auto bits = Philox4x32(route, index, 0, 0, 0x7AC7, 0);
+            RouteSection *section = routes[route].Sections + index;
+            section->Length = 300.0 + 1700.0 * UnitF64FromBits(bits.V[0], bits.V[1]);
+            section->Grade = -8.0 + 16.0 * UnitF64FromBits(bits.V[2], bits.V[3]);
+            section->CurveRadius = ((bits.V[0] & 3) == 0) ? (400.0 + (bits.V[1] & 0x3FF)) : 0.0;
+            section->SpeedLimit = speedLimits[bits.V[2] & 3];
+        }
+    }
+
+    boilers->Fuels = &design->BaseFuel;
+    boilers->t = design->t;
+    for (u32 locomotive = 0; locomotive < ACCURACY_FLEET_LOCOMOTIVES; ++locomotive)
+    {
+        u32 cylinder = locomotive & 3;
+        u32 size = locomotive >> 2;
+
+        Locomotive *engine = locomotives + locomotive;
+        *engine = design->Engine;
+        engine->CylinderD *= 1.0 - 0.04 * cylinder;
+        engine->WheelD *= 1.0 + 0.06 * size;
+        engine->Pressure *= 1.0 - 0.05 * size;
+
+        boilers->TopLengh[locomotive] = design->Chamber.TopLengh;
+        boilers->TopWidth[locomotive] = design->Chamber.TopWidth;
+        boilers->BottomLength[locomotive] = design->Chamber.BottomLength;
+        boilers->BottomWidth[locomotive] = design->Chamber.BottomWidth;
+        boilers->FrontHeight[locomotive] = design->Chamber.FrontHeight;
+        boilers->RearHeight[locomotive] = design->Chamber.RearHeight;
+        boilers->DOut[locomotive] = design->Dd.DOut;
+        boilers->DIn[locomotive] = design->Dd.DIn;
+        boilers->Ld[locomotive] = design->Ld * (1.0 - 0.05 * size);
+        boilers->Nd[locomotive] = (u16)(design->Nd - 10 * cylinder);
+        boilers->U[locomotive] = design->Chamber.U;
+        boilers->q22[locomotive] = design->q22;
+        boilers->FuelIndex[locomotive] = 0;
+    }
+
+    for (u32 duty = 0; duty < dutyCount; ++duty)
+    {
+        duties[duty].RouteIndex = duty % ACCURACY_FLEET_ROUTES;
+        duties[duty].TrainMass = 800.0 + 100.0 * (duty / ACCURACY_FLEET_ROUTES);
+    }
+
+    fleet->LocomotiveCount = ACCURACY_FLEET_LOCOMOTIVES;
+    fleet->Locomotives = locomotives;
+    fleet->Boilers = boilers;
+    fleet->DutyCount = dutyCount;
+    fleet->Duties = duties;
+    fleet->Routes = routes;
+    return true;
+}
+
+internal u32
+CheckFleetSimdAgreement(MemoryArena *arena)
+{
+    auto tempMem = BeginTemporaryMemory(arena);
+
+    CalculationInput design;
+    SetDefaultInput(&design, 0);
+
+    FleetBatch fleet;
+    FleetBatch reference;
+    b32 haveMemory = PushBenchFleet(arena, &design, &fleet) && PushBenchFleet(arena, &design, &reference);
+    if (!haveMemory)
+    {
+        EndTemporaryMemory(tempMem);
+        printf("парк - не хватает памяти  FAIL\n");
+        return 1;
+    }
+
+    u32 failureCount = 0;
+    u64 tripCount = (u64)fleet.LocomotiveCount * fleet.DutyCount;
+    FleetStats stats;
+
+    printf("%-12s %10s %10s %10s %10s\n", "fleet", "arrived", "status", "max error", "bound");
+    SetSimdLevel(SimdLevel_Scalar);
+    b32 failed = !RunFleet(arena, &design.Traction, &reference, 0, &stats) || !stats.Arrived;
+    failureCount += failed;
+    printf("%-12s %10llu %10s %10s %10s%s\n", GetSimdLevelName(SimdLevel_Scalar), (unsigned long long)stats.Arrived,
+           "-", "-", "-", failed ? "  FAIL" : "");
+
+    for (u32 level = SimdLevel_AVX2; level <= (u32)GetSimdLevel(); ++level)
+    {
+        SetSimdLevel((simd_level)level);
+        failed = !RunFleet(arena, &design.Traction, &fleet, 0, &stats);
+
+        u32 statusMismatches = 0;
+        f64 worst = 0.0;
+        for (u64 trip = 0; !failed && (trip < tripCount); ++trip)
+        {
+            statusMismatches += (fleet.Status[trip] != reference.Status[trip]);
+            // NOTE: A trip stalled at the start burns nothing, hence the floor.
+            f64 errors[] = {
+                fabs(fleet.Time[trip] - reference.Time[trip]) / Max(fabs(reference.Time[trip]), 1e-300),
+                fabs(fleet.Coal[trip] - reference.Coal[trip]) / Max(fabs(reference.Coal[trip]), 1e-300),
+                fabs(fleet.Water[trip] - reference.Water[trip]) / Max(fabs(reference.Water[trip]), 1e-300),
+            };
+            for (u32 index = 0; index < ArrayCount(errors); ++index)
+            {
+                worst = (errors[index] <= worst) ? worst : errors[index];
+            }
+        }
+
+        failed = failed || statusMismatches || !(worst <= ACCURACY_FLEET_TOLERANCE);
+        failureCount += failed;
+        printf("%-12s %10llu %10u %10.2e %10.0e%s\n", GetSimdLevelName((simd_level)level),
+               (unsigned long long)stats.Arrived, statusMismatches, worst, ACCURACY_FLEET_TOLERANCE,
+               failed ? "  FAIL" : "");
+    }
+    SetSimdLevel(GetSimdLevel());
+
+    EndTemporaryMemory(tempMem);
+    return failureCount;
+}
+
+// Дымогарные трубы по участкам на котлах выборки (рабочий диапазон): с ростом
+// числа участков T3 сходится (ошибка против FIRE_TUBE_MAX_SEGMENTS участков
+// убывает), а предел близок к T3 цепочки GetT3. Это две эмпирические модели
+// одних труб (k по скорости газов GetWd против формулы GetT3), поэтому
+// расхождение ограничено порогами, а не нулем: сейчас в среднем около 0.10,
+// наибольшее около 0.27 от GetT3.
+#define ACCURACY_FIRE_TUBE_MEAN_GAP 0.12
+#define ACCURACY_FIRE_TUBE_MAX_GAP 0.30
+#define ACCURACY_FIRE_TUBE_SEGMENT_ERROR 0.01 // °C при SegmentCount по FIRE_TUBE_SEGMENT_NTU
+
+internal u32
+CheckFireTubeConvergence(BenchContext *context, MemoryArena *arena)
+{
+    BenchSamples *s = context->Samples;
+    u32 count = BENCH_SAMPLE_COUNT;
+
+    auto tempMem = BeginTemporaryMemory(arena);
+    auto profile = PushFireTubeProfile(arena, &s->Input, &s->Output, 190.0, false);
+    auto chosen = PushArray(arena, count, u16);
+    auto converged = PushArray(arena, count, f64);
+    if (!profile.T3 || !chosen || !converged)
+    {
+        EndTemporaryMemory(tempMem);
+        printf("дымогарные трубы - не хватает памяти  FAIL\n");
+        return 1;
+    }
+    memcpy(chosen, profile.SegmentCount, count * sizeof(u16));
+
+    for (u32 index = 0; index < count; ++index)
+    {
+        profile.SegmentCount[index] = FIRE_TUBE_MAX_SEGMENTS;
+    }
+    CalculateFireTubeProfile(&profile, count);
+    memcpy(converged, profile.T3, count * sizeof(f64));
+
+    u32 failureCount = 0;
+    printf("%-20s %10s %10s %10s\n", "fire tube segments", "T3 error", "mean gap", "max gap");
+    f64 previousError = HUGE_VAL;
+    for (u32 segmentCount = 1; segmentCount <= 2 * FIRE_TUBE_MAX_SEGMENTS; segmentCount *= 2)
+    {
+        // NOTE: The last pass runs the counts ChooseFireTubeSegmentCounts picked.
+        b32 chosenCounts = (segmentCount > FIRE_TUBE_MAX_SEGMENTS);
+        for (u32 index = 0; index < count; ++index)
+        {
+            profile.SegmentCount[index] = chosenCounts ? chosen[index] : (u16)segmentCount;
+        }
+        CalculateFireTubeProfile(&profile, count);
+
+        f64 worstError = 0.0;
+        f64 worstGap = 0.0;
+        f64 gapSum = 0.0;
+        for (u32 index = 0; index < count; ++index)
+        {
+            f64 error = fabs(profile.T3[index] - converged[index]);
+            f64 gap = fabs(profile.T3[index] - s->Output.T3[index]) / s->Output.T3[index];
+            worstError = (error <= worstError) ? worstError : error;
+            worstGap = (gap <= worstGap) ? worstGap : gap;
+            gapSum += gap;
+        }
+        f64 meanGap = gapSum / count;
+
+        b32 gapFailed = !(meanGap <= ACCURACY_FIRE_TUBE_MEAN_GAP) || !(worstGap <= ACCURACY_FIRE_TUBE_MAX_GAP);
+        b32 failed;
+        char name[32];
+        if (chosenCounts)
+        {
+            snprintf(name, sizeof(name), "by NTU %.2f", FIRE_TUBE_SEGMENT_NTU);
+            failed = !(worstError <= ACCURACY_FIRE_TUBE_SEGMENT_ERROR) || gapFailed;
+        }
+        else
+        {
+            snprintf(name, sizeof(name), "%u", segmentCount);
+            failed = !(worstError <= previousError) || ((segmentCount == FIRE_TUBE_MAX_SEGMENTS) && gapFailed);
+            previousError = worstError;
+        }
+        failureCount += failed;
+        printf("%-20s %10.2e %10.4f %10.4f%s\n", name, worstError, meanGap, worstGap, failed ? "  FAIL" : "");
+    }
+    printf("%-20s %10.2e %10.4f %10.4f\n", "bound", ACCURACY_FIRE_TUBE_SEGMENT_ERROR, ACCURACY_FIRE_TUBE_MEAN_GAP,
+           ACCURACY_FIRE_TUBE_MAX_GAP);
+
+    EndTemporaryMemory(tempMem);
+    return failureCount;
+}
+
+// Проверки точности: ядра ss_math_wide.inl в ULP против libm с порогами из
+// ss_math_wide.inl, быстрая математика против эталонной с порогами из
+// ss_math.h, пакет в f32 против f64 с порогом из ss_batch_f32.cpp,
+// сходимость обратной задачи, сброс кэша перебора, поиск в библиотеке топлив,
+// пересчет графа зависимостей, производные по дуальным числам, кэш стадий,
+// парк на всех SimdLevel и сходимость дымогарных труб по участкам.
+internal u32
+RunAccuracyChecks(BenchContext *context, MemoryArena *arena)
+{
+    u32 failureCount = 0;
+
+    AccuracyCase cases[] = {
+        {"Log", WideKernel_Log, 1.0e-6, 1.0e6, 0.0, 0.0, ACCURACY_LOG_ULP, 0.0},
+        {"Exp", WideKernel_Exp, -708.0, 708.0, 0.0, 0.0, ACCURACY_EXP_ULP, 0.0},
+        {"Root(T3 / T2, 1.6)", WideKernel_Root, 0.0197, 1.0, 1.6, 0.0, ACCURACY_POW_ULP, 0.0},
+        {"Pow(r / 0.0105, 0.15)", WideKernel_Pow, 0.1, 10.0, 0.15, 0.0, ACCURACY_POW_ULP, 0.0},
+        {"Pow(omega, 0.7)", WideKernel_Pow, 0.1, 1.0e5, 0.7, 0.0, ACCURACY_POW_ULP, 0.0},
+        {"Pow(0.0115 / r, 0.214)", WideKernel_Pow, 0.1, 10.0, 0.214, 0.0, ACCURACY_POW_ULP, 0.0},
+        {"Pow(tk - tb, 4/3)", WideKernel_Pow, 1.0, 500.0, 4.0 / 3.0, 0.0, ACCURACY_POW_ULP, 0.0},
+        {"Pow(V, 0.7)", WideKernel_Pow, 0.01, 200.0, 0.7, 0.0, ACCURACY_POW_ULP, 0.0},
+        {"Pow, |e * ln(x)| <= 4", WideKernel_Pow, 1.0e-6, 1.0e6, 0.0, 4.0, ACCURACY_POW_ULP, 0.0},
+        {"Pow, |e * ln(x)| <= 9", WideKernel_Pow, 1.0e-6, 1.0e6, 0.0, 9.0, ACCURACY_POW_WIDE_ULP, 0.0},
+        {"Pow(x, 3.137777806354392)", WideKernel_Pow, 0.2, 0.5, 3.137777806354392, 0.0, ACCURACY_POW_ULP,
+         0.32965535252501543},
+    };
+
+    f64 *x = PushArray(arena, ACCURACY_BLOCK_SIZE, f64);
+    f64 *result = PushArray(arena, ACCURACY_BLOCK_SIZE, f64);
+
+    printf("%-28s %10s %10s", "kernel, max ULP", "x min", "x max");
+    for (u32 typeIndex = 0; typeIndex < ArrayCount(GlobalWideKernelTypes); ++typeIndex)
+    {
+        printf(" %8s", GlobalWideKernelTypes[typeIndex].Name);
+    }
+    printf(" %6s\n", "bound");
+
+    BenchRandom random = {0x2545F4914F6CDD1DULL};
+    for (u32 caseIndex = 0; caseIndex < ArrayCount(cases); ++caseIndex)
+    {
+        failureCount += CheckWideKernel(cases + caseIndex, &random, x, result);
+    }
+    printf("\n");
+
+    failureCount += CheckFastMath(context, arena);
+    printf("\n");
+
+    BenchSamples *s = context->Samples;
+    BoilerBatchInput *input = &s->Input;
+    BoilerBatchOutput reference = PushBoilerBatchOutput(arena, BENCH_SAMPLE_COUNT);
+    BoilerBatchOutput fast = PushBoilerBatchOutput(arena, BENCH_SAMPLE_COUNT);
+    auto f32Block = PushStruct(arena, BoilerBatchF32Block);
+
+    // пакет в f32 против пакета в f64: ошибка всех выходов (варианты с
+    // большой оценкой ошибки пересчитаны в f64) не больше допуска
+    printf("%-12s %10s %10s %10s\n", "batch f32", "fallback", "max error", "bound");
+    for (u32 level = SimdLevel_AVX2; level <= (u32)GetSimdLevel(); ++level)
+    {
+        SetSimdLevel((simd_level)level);
+        CalculateBoilerBatch(input, &reference, 0, BENCH_SAMPLE_COUNT);
+        u32 fallbackCount = CalculateBoilerBatchF32(f32Block, input, &fast, 0, BENCH_SAMPLE_COUNT);
+
+        f64 worst = GetBoilerBatchDeviation(&fast, &reference, BENCH_SAMPLE_COUNT);
+
+        b32 failed = !(worst <= BOILER_BATCH_F32_TOLERANCE);
+        failureCount += failed;
+        printf("%-12s %10u %10.2e %10.0e%s\n", GetSimdLevelName((simd_level)level), fallbackCount, worst,
+               BOILER_BATCH_F32_TOLERANCE, failed ? "  FAIL" : "");
+    }
+    SetSimdLevel(GetSimdLevel());
+    printf("\n");
+
+    InverseCheck inverseChecks[] = {
+        {"Ld(T3)", 1, {InverseUnknown_Ld}, {InverseTarget_T3}, {2.0}, {7.0}, {4.5}},
+        {"Nd(T3)", 1, {InverseUnknown_Nd}, {InverseTarget_T3}, {100.0}, {300.0}, {200.0}},
+        {"DOut(Omega)", 1, {InverseUnknown_DOut}, {InverseTarget_Omega}, {0.040}, {0.060}, {0.050}},
+        {"Ld, DOut(T3, Omega)", 2, {InverseUnknown_Ld, InverseUnknown_DOut}, {InverseTarget_T3, InverseTarget_Omega},
+         {2.0, 0.040}, {7.0, 0.060}, {4.5, 0.050}},
+    };
+
+    printf("%-28s %10s %10s %10s %10s\n", "inverse", "converged", "passes", "residual", "solution");
+    for (u32 checkIndex = 0; checkIndex < ArrayCount(inverseChecks); ++checkIndex)
+    {
+        failureCount += CheckInverseConvergence(inverseChecks + checkIndex, input, arena);
+    }
+    printf("\n");
+
+    failureCount += CheckSweepCacheInvalidation();
+    printf("\n");
+
+    failureCount += CheckFuelLibraryLookup(arena);
+    printf("\n");
+
+    failureCount += CheckBoilerGraphIncremental();
+    printf("\n");
+
+    failureCount += CheckBoilerSensitivity(arena);
+    printf("\n");
+
+    failureCount += CheckStageCache(arena);
+    printf("\n");
+
+    failureCount += CheckFleetSimdAgreement(arena);
+    printf("\n");
+
+    failureCount += CheckFireTubeConvergence(context, arena);
+
+    return failureCount;
+}
+
+internal b32
+WriteBenchJSON(BenchContext *context, const char *fileName)
+{
+    FILE *file = fopen(fileName, "wb");
+    if (!file)
+    {
+        return false;
+    }
+
+    fprintf(file, "{\n  \"simd\": \"%s\",\n  \"samples\": %u,\n  \"benchmarks\": [\n",
+            GetSimdLevelName(GetSimdLevel()), BENCH_SAMPLE_COUNT);
+    for (u32 index = 0; index < context->ResultCount; ++index)
+    {
+        BenchResult *result = context->Results + index;
+        fprintf(file,
+                "    {\"name\": \"%s\", \"calls\": %llu, \"ns_per_call\": %.4f, "
+                "\"cycles_per_call\": %.4f, \"calls_per_second\": %.1f}%s\n",
+                result->Name, (unsigned long long)result->Calls, result->NsPerCall, result->CyclesPerCall,
+                result->CallsPerSecond, (index + 1 < context->ResultCount) ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    b32 result = (fclose(file) == 0);
+    return result;
+}
+
+// NOTE: Reads back only what WriteBenchJSON writes: one benchmark per line.
+internal b32
+ReadBenchBaseline(BenchContext *context, const char *fileName)
+{
+    FILE *file = fopen(fileName, "rb");
+    if (!file)
+    {
+        return false;
+    }
+
+    char line[1024];
+    while (fgets(line, sizeof(line), file))
+    {
+        char *name = strstr(line, "\"name\": \"");
+        char *ns = strstr(line, "\"ns_per_call\": ");
+        if (name && ns)
+        {
+            name += 9;
+            char *nameEnd = strchr(name, '"');
+            if (nameEnd)
+            {
+                *nameEnd = 0;
+                for (u32 index = 0; index < context->ResultCount; ++index)
+                {
+                    BenchResult *result = context->Results + index;
+                    if (strcmp(result->Name, name) == 0)
+                    {
+                        result->HasBaseline = true;
+                        result->BaselineNsPerCall = atof(ns + 15);
+                    }
+                }
+            }
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const char *outFileName = 0;
+    const char *baselineFileName = 0;
+    f64 threshold = BENCH_DEFAULT_THRESHOLD;
+    math_mode mathMode = MathMode_Reference;
+    b32 accuracy = false;
+
+    BenchContext context = {};
+    context.RoundSeconds = 0.05;
+    for (int argIndex = 1; argIndex < argc; ++argIndex)
+    {
+        b32 hasValue = (argIndex + 1 < argc);
+        if (hasValue && (strcmp(argv[argIndex], "-out") == 0))
+        {
+            outFileName = argv[++argIndex];
+        }
+        else if (hasValue && (strcmp(argv[argIndex], "-baseline") == 0))
+        {
+            baselineFileName = argv[++argIndex];
+        }
+        else if (hasValue && (strcmp(argv[argIndex], "-threshold") == 0))
+        {
+            threshold = atof(argv[++argIndex]);
+        }
+        else if (hasValue && (strcmp(argv[argIndex], "-filter") == 0))
+        {
+            context.Filter = argv[++argIndex];
+        }
+        else if (hasValue && (strcmp(argv[argIndex], "-seconds") == 0))
+        {
+            context.RoundSeconds = atof(argv[++argIndex]);
+        }
+        else if (hasValue && (strcmp(argv[argIndex], "-math") == 0))
+        {
+            ++argIndex;
+            if (strcmp(argv[argIndex], "fast") == 0)
+            {
+                mathMode = MathMode_Fast;
+            }
+            else if (strcmp(argv[argIndex], "reference") != 0)
+            {
+                fprintf(stderr, "Unknown math mode %s\n", argv[argIndex]);
+                return 2;
+            }
+        }
+        else if (strcmp(argv[argIndex], "-accuracy") == 0)
+        {
+            accuracy = true;
+        }
+        else
+        {
+            fprintf(stderr, "usage: ss_bench [-out file.json] [-baseline file.json] [-threshold percent] "
+                            "[-filter name] [-seconds round] [-math fast|reference] [-accuracy]\n");
+            return 2;
+        }
+    }
+
+    u64 memorySize = Megabytes(64);
+    MemoryArena arena = {};
+    InitializeArena(&arena, memorySize, malloc(memorySize));
+
+    context.Samples = PushStruct(&arena, BenchSamples);
+    InitializeBenchSamples(context.Samples, &arena);
+
+    if (accuracy)
+    {
+        u32 failureCount = RunAccuracyChecks(&context, &arena);
+        if (failureCount)
+        {
+            printf("%u check(s) failed\n", failureCount);
+        }
+        return failureCount ? 1 : 0;
+    }
+
+    SetMathMode(mathMode);
+    RunFormulaBenches(&context);
+    RunChainBenches(&context, &arena);
+
+    b32 hasBaseline = false;
+    if (baselineFileName)
+    {
+        hasBaseline = ReadBenchBaseline(&context, baselineFileName);
+        if (!hasBaseline)
+        {
+            fprintf(stderr, "Unable to read baseline %s\n", baselineFileName);
+        }
+    }
+
+    u32 regressionCount = 0;
+    printf("%-24s %12s %12s %14s%s\n", "benchmark", "ns/call", "cycles/call", "Mcalls/s",
+           hasBaseline ? "   baseline ns    change" : "");
+    for (u32 index = 0; index < context.ResultCount; ++index)
+    {
+        BenchResult *result = context.Results + index;
+        printf("%-24s %12.3f %12.2f %14.2f", result->Name, result->NsPerCall, result->CyclesPerCall,
+               result->CallsPerSecond / 1.0e6);
+        if (result->HasBaseline && (result->BaselineNsPerCall > 0.0))
+        {
+            f64 change = (result->NsPerCall / result->BaselineNsPerCall - 1.0) * 100.0;
+            b32 regression = (change > threshold);
+            regressionCount += regression;
+            printf(" %13.3f %+8.1f%%%s", result->BaselineNsPerCall, change, regression ? "  REGRESSION" : "");
+        }
+        printf("\n");
+    }
+
+    if (outFileName && !WriteBenchJSON(&context, outFileName))
+    {
+        fprintf(stderr, "Unable to write %s\n", outFileName);
+        return 2;
+    }
+
+    if (regressionCount)
+    {
+        printf("%u regression(s) slower than the baseline by more than %.1f%%\n", regressionCount, threshold);
+    }
+
+    return regressionCount ? 1 : 0;
+}
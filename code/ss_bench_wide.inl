@@ -0,0 +1,21 @@
+// NOTE: The kernels of ss_math_wide.inl over arrays, for the accuracy checks.
+// ss_bench.cpp includes this once per wide type with WIDE and WIDE_FUNCTION
+// defined, inside the matching target region. count must be a multiple of
+// the widest type's width.
+
+internal void
+WIDE_FUNCTION(EvaluateWideKernel)(wide_kernel kernel, f64 e, f64 *x, f64 *result, u32 count)
+{
+    for (u32 index = 0; index < count; index += WIDE::Width)
+    {
+        WIDE value = WIDE::Load(x + index);
+        switch (kernel)
+        {
+            case WideKernel_Log: value = Log(value); break;
+            case WideKernel_Exp: value = Exp(value); break;
+            case WideKernel_Pow: value = Pow(value, e); break;
+            case WideKernel_Root: value = Root(value, e); break;
+        }
+        WIDE::Store(result + index, value);
+    }
+}
@@ -1,3 +1,8 @@
+// формулы, общие с векторными путями
+#define WIDE f64
+#include "ss_boiler_formulas.inl"
+#undef WIDE
+
 // форсировка решетки в кг/м2 час
 // масса подаваемого угля в час, площадь колосниковой решетки
 internal inline f64
@@ -178,12 +183,26 @@ GetN2(Fuel &fuel)
     fuel.N2 = 100.0 - (fuel.CO2 + fuel.O2);
 }
 
+// Gbc - множитель при Bh в M, зависит только от топлива
+internal inline f64
+GetGbc(Fuel fuel)
+{
+    return 0.55 * (fuel.C / (fuel.CO2 + fuel.CO)) + 0.0021 * fuel.C + 0.0406 * fuel.H + 0.0045 * fuel.W;
+}
+
+// Gbb - множитель при Bh в N, зависит только от топлива
+internal inline f64
+GetGbb(Fuel fuel)
+{
+    return 0.0000445 * (fuel.C / (fuel.CO2 + fuel.CO)) + 0.0000012 * fuel.C + 0.0000044 * fuel.H + 0.0000005 * fuel.W;
+}
+
 // a - коэффициент избытка топлива
 // Bh - количество топлива сгораемого за час в кг
 internal inline f64
 GetM(f64 Bh, Fuel fuel)
 {
-    auto Gbc = 0.55 * (fuel.C / (fuel.CO2 + fuel.CO)) + 0.0021 * fuel.C + 0.0406 * fuel.H + 0.0045 * fuel.W;
+    auto Gbc = GetGbc(fuel);
 
     return Gbc * Bh;
 }
@@ -193,7 +212,7 @@ GetM(f64 Bh, Fuel fuel)
 internal inline f64
 GetN(f64 Bh, Fuel fuel)
 {
-    auto Gbb = 0.0000445 * (fuel.C / (fuel.CO2 + fuel.CO)) + 0.0000012 * fuel.C + 0.0000044 * fuel.H + 0.0000005 * fuel.W;
+    auto Gbb = GetGbb(fuel);
 
     return Gbb * Bh;
 }
@@ -243,10 +262,16 @@ GetQ1(f64 Bt, f64 Bk, f64 lY, f64 lK, f64 phi)
 // a - коэффициент избытка топлива
 // b0 - химическая характеристика топлива
 // Bh - количество топлива сгораемого за час в кг
+internal inline f64
+GetQ21Rate(Fuel fuel)
+{
+    return (56.9 * fuel.C * (fuel.CO / (fuel.CO2 + fuel.CO)));
+}
+
 internal inline f64
 GetQ21(f64 BhFact, Fuel fuel)
 {
-    return (56.9 * fuel.C * (fuel.CO / (fuel.CO2 + fuel.CO)) * BhFact);
+    return (GetQ21Rate(fuel) * BhFact);
 }
 
 // Q2'' - механические потери тепла
@@ -259,12 +284,10 @@ GetQ22(f64 Q0, f64 q22)
 }
 
 // Q3 - потеря тепла с уходящими газами
-// a - коэффициент избытка топлива
-// Bh - количество топлива сгораемого за час в кг
 // Q0 - распологаемое тепло
 // T3 - температура газов по выходе из трубчатой части котла
 internal inline f64
-GetQ3(f64 Bh, f64 Q0, f64 T3, Fuel fuel, HeatCoefficient heatCoefficient)
+GetQ3(f64 Q0, f64 T3, Fuel fuel, HeatCoefficient heatCoefficient)
 {
     auto q3 = heatCoefficient.M / fuel.K * (heatCoefficient.M * T3 + heatCoefficient.N * T3 * T3) * 100.0;
     return Q0 * q3;
@@ -285,7 +308,7 @@ internal inline f64
 GetQ4(f64 phi, f64 H0, f64 V, f64 tb, f64 tk)
 {
     // Q4 = 2.2 * phi * H0 * (tk - tb)^(4/3)
-    return phi * H0 * (2.2 + 0.21 * pow(V, 0.7)) * pow(tk - tb, 4.0 / 3.0);
+    return GetQ4(phi * H0, Pow(V, 0.7), Pow(tk - tb, 4.0 / 3.0));
 }
 
 // Q4 - потери на внешнее охлаждение
@@ -308,10 +331,8 @@ GetQ5(f64 Q0)
 // Q0   - распологаемое тепло
 // Q2'  - химические потери тепла
 // Q2'' - механические потери тепла
-// a    - коэффициент избытка топлива
-// Bh   - количество топлива сгораемого за час в кг
 internal inline f64
-GetT1(f64 Q0, f64 Q21, f64 Q22, f64 Bh, Fuel fuel, HeatCoefficient heatCoefficient)
+GetT1(f64 Q0, f64 Q21, f64 Q22, HeatCoefficient heatCoefficient)
 {
     //N * T^2 + M * T - Q / 0.84 = 0
     auto Q = (Q0 - (Q21 + Q22)) / 0.84;
@@ -324,14 +345,7 @@ GetT1(f64 Q0, f64 Q21, f64 Q22, f64 Bh, Fuel fuel, HeatCoefficient heatCoefficie
 internal inline f64
 GetT2(f64 Bh, f64 Ht, Fuel fuel)
 {
-    const f64 A = 1350.0;
-
-    auto top = (Bh * fuel.K) / Ht + 4400.0;
-    auto bottom = (Bh * fuel.K) / Ht + 223000.0;
-
-    auto result = A * Root(top / bottom, 1.6);
-
-    return result;
+    return GetT2(Bh, Ht, fuel.K);
 }
 
 // H - поверхность нагрева труб
@@ -340,13 +354,38 @@ GetT2(f64 Bh, f64 Ht, Fuel fuel)
 internal inline f64
 GetHPipes(PipeDiameter d, u16 n, f64 l)
 {
-    return PI * d.DOut * n * l;
+    return GetHPipes(d.DOut, n, l);
 }
 
 internal inline f64
 GetHydraulicRadius(PipeDiameter d)
 {
-    return (d.DIn / 4.0);
+    return GetHydraulicRadius(d.DIn);
+}
+
+// Кольцевое сечение жаровой трубы dz вокруг элемента перегревателя di
+internal inline f64
+GetAnnulusSquare(PipeDiameter dz, PipeDiameter di)
+{
+    return GetAnnulusSquare(dz.DIn, di.DOut);
+}
+
+internal inline f64
+GetAnnulusHydraulicRadius(PipeDiameter dz, PipeDiameter di)
+{
+    return GetAnnulusHydraulicRadius(dz.DIn, di.DOut);
+}
+
+// поверхности нагрева котла с жаровыми трубами по их размерам
+// Ht - поверхность нагрева огневой коробки
+internal inline void
+CalculateBoiler(Boiler &boiler, f64 Ht)
+{
+    TIMED_FUNCTION();
+    boiler.Hdg = GetHPipes(boiler.Dd, boiler.Nd, boiler.Ld);
+    boiler.Hz1 = GetHPipes(boiler.Dz1, boiler.Nz, boiler.Lz1);
+    boiler.Hz2 = GetHPipes(boiler.Dz2, boiler.Nz, boiler.Lz2);
+    boiler.Hk = Ht + boiler.Hdg + boiler.Hz1 + boiler.Hz2;
 }
 
 // T3 - температура газов по выходе из трубчатой части котла
@@ -358,14 +397,7 @@ GetHydraulicRadius(PipeDiameter d)
 internal inline f64
 GetT3(PipeDiameter d, u16 n, f64 L, f64 Bh, f64 Hk, Fuel fuel)
 {
-    auto Hi = GetHPipes(d, n, L);
-    auto H = Hk + Hi;               // полная поверхность нагрева
-    auto r = GetHydraulicRadius(d); // гидравлический радиус
-    auto A = pow(r / 0.0105, 0.15) * (710.0 + 332000.0 / (L / r + 105.0));
-    auto top = (Bh * fuel.K) / H + 4400.0;
-    auto bottom = (Bh * fuel.K) / H + 223000.0;
-
-    return (A * Root(top / bottom, 1.6));
+    return GetT3(d.DOut, d.DIn, n, L, Bh, Hk, fuel.K);
 }
 
 internal inline f64
@@ -445,19 +477,7 @@ GetH(f64 Dc)
 internal inline f64
 GetKdHd(f64 b, f64 M, f64 N, f64 T2, f64 Tk, f64 tk, f64 T3d)
 {
-    return ((1.0 - b) * ((M + 2.0 * N * tk) * log((T2 - Tk) / (T3d - tk)) + 2.0 * N * (T2 - T3d)));
-}
-
-internal inline f64
-GetKd(f64 Wd, f64 rd)
-{
-    return (6.0 + 2.45 * pow(Wd, 0.7) * (pow(0.0115 / rd, 0.214)));
-}
-
-internal inline f64
-GetWd(f64 L0, f64 a, f64 Bh, f64 u, f64 omegaD, f64 T2, f64 T3d, f64 b)
-{
-    return (0.8425 * ((L0 * a * Bh * u) / (10000000.0 * omegaD)) * ((T2 + T3d) / 2.0 + 273) * (1.0 - b));
+    return ((1.0 - b) * ((M + 2.0 * N * tk) * Log((T2 - Tk) / (T3d - tk)) + 2.0 * N * (T2 - T3d)));
 }
 
 // Qt  - тепло проходящее в котел через топочную
@@ -489,25 +509,34 @@ CalculateFuel(Fuel &fuel)
     GetBeta0(fuel);
 }
 
+// beta - доля газов, идущая через жаровые трубы, из равенства потерь напора
+// в дымогарных и жаровых трубах
 // L   - длина трубы
 // r   - гидравлический радиус
 // sqr - площадь живого сечения трубы
+// theta1, theta2 - отношение средней абсолютной температуры газов в жаровых
+//                  трубах до перегревателя и в области перегревателя к ней
+//                  же в дымогарных трубах (удельный объем газов)
 internal inline f64
-GetBeta(f64 Ld, f64 rd, f64 sqrD, f64 Lg1, f64 rg1, f64 sqrG1, f64 Lg2, f64 rg2, f64 sqrG2)
+GetBeta(f64 Ld, f64 rd, f64 sqrD, f64 Lg1, f64 rg1, f64 sqrG1, f64 Lg2, f64 rg2, f64 sqrG2, f64 theta1, f64 theta2)
 {
     auto a = Ld / (rd * sqrD * sqrD);
     auto b = Lg1 / (rg1 * sqrG1 * sqrG1);
     auto c = Lg2 / (rg2 * sqrG2 * sqrG2);
 
-    auto top = a - sqrt((1.33 * b + 0.96 * c) * a);
-    auto bottom = (a - 1.33 * b - 0.96 * c);
-
-    printf("top \t\t\t\t\t\t%.2lf\n", top);
-    printf("bottom \t\t\t\t\t\t%.2lf\n", bottom);
+    auto top = a - sqrt((theta1 * b + theta2 * c) * a);
+    auto bottom = (a - theta1 * b - theta2 * c);
 
     return (top / bottom);
 }
 
+// beta с принятыми отношениями температур 1.33 и 0.96
+internal inline f64
+GetBeta(f64 Ld, f64 rd, f64 sqrD, f64 Lg1, f64 rg1, f64 sqrG1, f64 Lg2, f64 rg2, f64 sqrG2)
+{
+    return GetBeta(Ld, rd, sqrD, Lg1, rg1, sqrG1, Lg2, rg2, sqrG2, 1.33, 0.96);
+}
+
 // L0 - теоретический расход воздуха для сжигания 1 кг топлива
 internal inline f64
 GetL0(Fuel fuel)
@@ -526,50 +555,30 @@ GetLv(f64 L0, Fuel fuel)
 internal inline f64
 GetKi(f64 beta, f64 Bh, f64 rz2, f64 omegaZ2, Fuel fuel)
 {
-    auto x = pow((beta * Bh * fuel.u * fuel.K) / (10000.0 * omegaZ2), 0.7);
-    auto y = pow(0.0115 / rz2, 0.214);
+    auto x = Pow((beta * Bh * fuel.u * fuel.K) / (10000.0 * omegaZ2), 0.7);
+    auto y = Pow(0.0115 / rz2, 0.214);
     return (6.0 + 0.24 * x * y);
 }
 
-// Tabs - средняя абсолютная температура газов в дымогарных трубах
-internal inline f64
-GetTabs(f64 T2, f64 T3)
-{
-    return ((T2 + T3) / 2.0 + 273.0);
-}
-
 // O - площадь живого сечения трубы
 internal inline f64
 GetPipeSquare(PipeDiameter d)
 {
-    auto dSq = d.DIn * d.DIn;
-    return ((PI * dSq) / 4.0);
-}
-
-//v - удельный объем протекающих по трубкам продуктов сгорания
-internal inline f64
-GetV(f64 Tabs)
-{
-    return ((29.27 * Tabs) / 10330.0);
+    return GetPipeSquare(d.DIn);
 }
 
 // omega - скорость протекания газов по дымогарным трубам
 internal inline f64
 GetOmega(Fuel fuel, PipeDiameter d, f64 Tabs, f64 L0, f64 Bh)
 {
-    auto Od = GetPipeSquare(d);
-    auto v = GetV(Tabs);
-    auto top = (L0 * fuel.alpha + 1.0) * Bh * v;
-    auto bottom = 3600.0 * Od;
-    return (top / bottom);
+    return GetOmega(fuel.alpha, d.DIn, Tabs, L0, Bh);
 }
 
 // k - коэффициент теплопередачи
 internal inline f64
 GetK(PipeDiameter d, f64 omega)
 {
-    auto r = GetHydraulicRadius(d);
-    return ((6.0 + 2.45 * pow(omega, 0.7)) * pow(0.0115 / r, 0.214));
+    return GetK(d.DIn, omega);
 }
 
 // k - коэффициент теплопередачи
@@ -577,7 +586,7 @@ internal inline f64
 GetK(HeatCoefficient heatCoefficient, f64 Hd, f64 tk, f64 T2, f64 T3)
 {
     auto a = (heatCoefficient.M + 2.0 * heatCoefficient.N * tk);
-    auto b = log((T2 - tk) / (T3 - tk));
+    auto b = Log((T2 - tk) / (T3 - tk));
     auto c = 2.0 * heatCoefficient.N * (T2 - T3);
     return (a * b + c) / Hd;
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+// Формулы ss_boiler.cpp над дуальными числами: в пространстве имен
+// boiler_dual тип f64 - это dual, поэтому тот же текст формул за один проход
+// дает и значение, и производные по всем входам boiler_input.
+// NOTE: The structs and formulas are compiled a second time from the very
+// same files, so the AD path can never drift from the scalar one.
+namespace boiler_dual
+{
+typedef dual f64;
+
+#undef TIMED_BLOCK_PREFIX
+#define TIMED_BLOCK_PREFIX "boiler_dual::"
+#include "ss_boiler.h"
+#include "ss_boiler.cpp"
+#undef TIMED_BLOCK_PREFIX
+#define TIMED_BLOCK_PREFIX 0
+}
+
+// Выходы варианта index и их производные по всем входам. Порядок вызовов тот
+// же, что в CalculateBoilerBatch (стадии Front, FireTubes, Losses), поэтому
+// значения (dual.Value) совпадают с пакетным расчетом бит в бит.
+internal void
+CalculateBoilerSensitivity(BoilerBatchInput *input, u32 index, BoilerSensitivity *result)
+{
+    using namespace boiler_dual;
+
+    Assert(index < input->Count);
+
+    boiler_dual::FireChamber fireChamber = {};
+    fireChamber.TopLengh = MakeDual(input->TopLengh[index], BoilerInput_TopLengh);
+    fireChamber.TopWidth = MakeDual(input->TopWidth[index], BoilerInput_TopWidth);
+    fireChamber.BottomLength = MakeDual(input->BottomLength[index], BoilerInput_BottomLength);
+    fireChamber.BottomWidth = MakeDual(input->BottomWidth[index], BoilerInput_BottomWidth);
+    fireChamber.FrontHeight = MakeDual(input->FrontHeight[index], BoilerInput_FrontHeight);
+    fireChamber.RearHeight = MakeDual(input->RearHeight[index], BoilerInput_RearHeight);
+    fireChamber.U = MakeDual(input->U[index], BoilerInput_U);
+    CalculateFireChamber(fireChamber);
+
+    boiler_dual::PipeDiameter dd = {};
+    dd.DOut = MakeDual(input->DOut[index], BoilerInput_DOut);
+    dd.DIn = MakeDual(input->DIn[index], BoilerInput_DIn);
+
+    auto Ld = MakeDual(input->Ld[index], BoilerInput_Ld);
+    auto Nd = input->Nd[index];
+    auto q22 = MakeDual(input->q22[index], BoilerInput_q22);
+    auto t = MakeDual(input->t, BoilerInput_t);
+
+    ::Fuel *source = GetBatchFuel(input, index);
+    boiler_dual::Fuel fuel = {};
+    fuel.C = MakeDual(source->C, BoilerInput_C);
+    fuel.H = MakeDual(source->H, BoilerInput_H);
+    fuel.S = MakeDual(source->S, BoilerInput_S);
+    fuel.O = MakeDual(source->O, BoilerInput_O);
+    fuel.N = MakeDual(source->N, BoilerInput_N);
+    fuel.W = MakeDual(source->W, BoilerInput_W);
+    fuel.A = MakeDual(source->A, BoilerInput_A);
+    fuel.CO = MakeDual(source->CO, BoilerInput_CO);
+    fuel.CO2 = MakeDual(source->CO2, BoilerInput_CO2);
+    fuel.O2 = MakeDual(source->O2, BoilerInput_O2);
+    fuel.N2 = MakeDual(source->N2, BoilerInput_N2);
+    fuel.K = MakeDual(source->K, BoilerInput_K);
+    fuel.beta0 = MakeDual(source->beta0, BoilerInput_beta0);
+    fuel.alpha = MakeDual(source->alpha, BoilerInput_alpha);
+    fuel.u = source->u;
+
+    // топка
+    auto Hd = GetHPipes(dd, Nd, Ld);
+
+    auto Bh = GetBh(fireChamber);
+    auto BhFact = GetBhFact(fireChamber, q22, fuel);
+
+    boiler_dual::HeatCoefficient heatCoefficient = {};
+    GetHeatCoefficient(heatCoefficient, fuel, BhFact);
+
+    auto Q0 = GetQ0(Bh, t, fuel, heatCoefficient);
+    auto Q21 = GetQ21(BhFact, fuel);
+    auto Q22 = GetQ22(Q0, q22);
+
+    auto T1 = GetT1(Q0, Q21, Q22, heatCoefficient);
+
+    auto Q4 = GetQ4(Q0, 1.0); // 1% потерь от Q0
+
+    auto L0 = GetL0(fuel);
+
+    // дымогарные трубы
+    auto T2 = GetT2(BhFact, fireChamber.Ht, fuel);
+    auto T3 = GetT3(dd, Nd, Ld, BhFact, fireChamber.Ht, fuel);
+    auto Tabs = GetTabs(T2, T3);
+    auto omega = GetOmega(fuel, dd, Tabs, L0, BhFact);
+    auto k1 = GetK(dd, omega);
+
+    // потери
+    auto Q3 = GetQ3(T3, heatCoefficient);
+    auto Qt = GetQt(Q0, Q21, Q22, T2, heatCoefficient);
+
+    result->R = fireChamber.R;
+    result->Ht = fireChamber.Ht;
+    result->Hd = Hd;
+    result->L0 = L0;
+    result->Bh = Bh;
+    result->BhFact = BhFact;
+    result->T1 = T1;
+    result->T2 = T2;
+    result->T3 = T3;
+    result->Tabs = Tabs;
+    result->Q0 = Q0;
+    result->Q21 = Q21;
+    result->Q22 = Q22;
+    result->Q3 = Q3;
+    result->Q4 = Q4;
+    result->Qt = Qt;
+    result->Omega = omega;
+    result->K1 = k1;
+    result->M = heatCoefficient.M;
+    result->N = heatCoefficient.N;
+}
@@ -0,0 +1,165 @@
+// NOTE: The formulas of ss_boiler.cpp that the wide paths need, written once
+// over WIDE. ss_boiler.cpp includes this with WIDE defined to f64 (and so, in
+// ss_boiler_dual.cpp, to dual); ss_boiler_wide.cpp includes it once per wide
+// type, inside the matching target region, for ss_boiler_wide.inl,
+// ss_firetube_wide.inl and ss_fleet_wide.inl; ss_fleet.cpp adds the f64x1
+// build for its one-lane path. Only operators, Pow, Root and Exp are used,
+// which every one of these types has, so each lane goes through the same
+// operations as the scalar formula.
+
+// Q4 - потери на внешнее охлаждение
+// phiH0     - phi * H0
+// speedTerm - V^0.7, V - скорость в км/ч
+// heatTerm  - (tk - tb)^(4/3)
+internal inline WIDE
+GetQ4(WIDE phiH0, WIDE speedTerm, WIDE heatTerm)
+{
+    return phiH0 * (2.2 + 0.21 * speedTerm) * heatTerm;
+}
+
+// T2 - температура при входе газов в отверстия огневой решетки (43)
+// Bh - количество топлива сгораемого за час в кг
+// Ht - поверхность нагрева огневой коробки
+// K  - теплопроизводительность 1 кг топлива
+internal inline WIDE
+GetT2(WIDE Bh, WIDE Ht, WIDE K)
+{
+    WIDE heat = (Bh * K) / Ht;
+    return 1350.0 * Root((heat + 4400.0) / (heat + 223000.0), 1.6);
+}
+
+// H - поверхность нагрева n труб длины l
+internal inline WIDE
+GetHPipes(WIDE DOut, WIDE n, WIDE l)
+{
+    return PI * DOut * n * l;
+}
+
+internal inline WIDE
+GetHydraulicRadius(WIDE DIn)
+{
+    return (DIn / 4.0);
+}
+
+// Кольцевое сечение трубы DIn вокруг элемента перегревателя DElement
+internal inline WIDE
+GetAnnulusSquare(WIDE DIn, WIDE DElement)
+{
+    return ((PI * (DIn * DIn - DElement * DElement)) / 4.0);
+}
+
+internal inline WIDE
+GetAnnulusHydraulicRadius(WIDE DIn, WIDE DElement)
+{
+    return ((DIn * DIn - DElement * DElement) / (4.0 * (DIn + DElement)));
+}
+
+// T3 - температура газов по выходе из трубчатой части котла
+// n, L - число и длина дымогарных труб
+// Hk   - поверхность нагрева котла без этих труб
+internal inline WIDE
+GetT3(WIDE DOut, WIDE DIn, WIDE n, WIDE L, WIDE Bh, WIDE Hk, WIDE K)
+{
+    WIDE H = Hk + GetHPipes(DOut, n, L); // полная поверхность нагрева
+    WIDE r = GetHydraulicRadius(DIn);     // гидравлический радиус
+    WIDE A = Pow(r / 0.0105, 0.15) * (710.0 + 332000.0 / (L / r + 105.0));
+    WIDE heat = (Bh * K) / H;
+    return (A * Root((heat + 4400.0) / (heat + 223000.0), 1.6));
+}
+
+// kr = (0.0115 / rd)^0.214 - множитель GetKd от гидравлического радиуса; вдоль
+// труб он не меняется, поэтому участки считают его один раз
+internal inline WIDE
+GetKr(WIDE rd)
+{
+    return Pow(0.0115 / rd, 0.214);
+}
+
+internal inline WIDE
+GetKdByKr(WIDE Wd, WIDE kr)
+{
+    return (6.0 + 2.45 * Pow(Wd, 0.7) * kr);
+}
+
+internal inline WIDE
+GetKd(WIDE Wd, WIDE rd)
+{
+    return GetKdByKr(Wd, GetKr(rd));
+}
+
+// T на выходе участка дымогарных труб: (M + 2N T) dT = -k (T - tk) dH / (1 - b)
+// при постоянных на участке k и теплоемкости, взятой при температуре Tm
+// T   - температура газов на входе участка
+// kdH - коэффициент теплопередачи, умноженный на поверхность участка
+// b   - доля газов, идущая мимо этих труб
+internal inline WIDE
+GetSegmentT(WIDE T, WIDE Tm, WIDE tk, WIDE kdH, WIDE b, WIDE M, WIDE N)
+{
+    WIDE c = (1.0 - b) * (M + 2.0 * N * Tm);
+    return (tk + (T - tk) * Exp(-kdH / c));
+}
+
+// Вода (kdH при tk) и перегреватель (sink при ts) на участке как один сток:
+// суммарный kdH и средневзвешенная температура стока T
+internal inline WIDE
+GetSegmentSink(WIDE kdH, WIDE tk, WIDE sink, WIDE ts, WIDE *T)
+{
+    *T = (kdH * tk + sink * ts) / (kdH + sink);
+    return (kdH + sink);
+}
+
+// Тепло, отданное в трубах газами, остывшими от T2 до T3
+internal inline WIDE
+GetTubeQ(WIDE b, WIDE M, WIDE N, WIDE T2, WIDE T3)
+{
+    return (1.0 - b) * (M * (T2 - T3) + N * (T2 * T2 - T3 * T3));
+}
+
+// Wd - скорость газов в дымогарных трубах, м/с
+// omegaD - живое сечение всех труб, T2 и T3d - температуры газов на входе и
+// выходе, b - доля газов, идущая мимо труб
+internal inline WIDE
+GetWd(WIDE L0, WIDE a, WIDE Bh, WIDE u, WIDE omegaD, WIDE T2, WIDE T3d, WIDE b)
+{
+    return (0.8425 * ((L0 * a * Bh * u) / (1000000.0 * omegaD)) * ((T2 + T3d) / 2.0 + 273) * (1.0 - b));
+}
+
+// Tabs - средняя абсолютная температура газов в дымогарных трубах
+internal inline WIDE
+GetTabs(WIDE T2, WIDE T3)
+{
+    return ((T2 + T3) / 2.0 + 273.0);
+}
+
+// O - площадь живого сечения трубы
+internal inline WIDE
+GetPipeSquare(WIDE DIn)
+{
+    return ((PI * (DIn * DIn)) / 4.0);
+}
+
+//v - удельный объем протекающих по трубкам продуктов сгорания
+internal inline WIDE
+GetV(WIDE Tabs)
+{
+    return ((29.27 * Tabs) / 10330.0);
+}
+
+// omega - скорость протекания газов по дымогарным трубам
+internal inline WIDE
+GetOmega(WIDE alpha, WIDE DIn, WIDE Tabs, WIDE L0, WIDE Bh)
+{
+    WIDE Od = GetPipeSquare(DIn);
+    WIDE v = GetV(Tabs);
+    WIDE top = (L0 * alpha + 1.0) * Bh * v;
+    WIDE bottom = 3600.0 * Od;
+    return (top / bottom);
+}
+
+// k - коэффициент теплопередачи
+internal inline WIDE
+GetK(WIDE DIn, WIDE omega)
+{
+    WIDE r = GetHydraulicRadius(DIn);
+    return ((6.0 + 2.45 * Pow(omega, 0.7)) * GetKr(r));
+}
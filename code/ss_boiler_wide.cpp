@@ -0,0 +1,104 @@
+// Цепочка расчета дымогарных труб для массива вариантов:
+// скалярный путь вызывает формулы ss_boiler.cpp, векторные пути (AVX2, AVX-512)
+// считают 4 или 8 вариантов за инструкцию. Путь выбирается по процессору.
+//
+// Отклонение векторных путей от скалярного (1M случайных вариантов в рабочем
+// диапазоне, pow из ss_math_wide.inl):
+//   T2, Tabs    <= 2 ULP
+//   T3, omega   <= 8 ULP
+//   k1          <= 16 ULP
+// Q3 и Qt в CalculateBoilerBatch наследуют ошибку T2/T3 (<= 8 ULP).
+// SetSimdLevel(SimdLevel_Scalar) дает результат бит в бит как у Calculate().
+
+internal void
+CalculateFireTubeChainScalar(FireTubeChain *chain, u32 count)
+{
+    for (u32 index = 0; index < count; ++index)
+    {
+        Fuel fuel = {};
+        fuel.K = chain->K[index];
+        fuel.alpha = chain->Alpha[index];
+
+        PipeDiameter dd = {};
+        dd.DOut = chain->DOut[index];
+        dd.DIn = chain->DIn[index];
+
+        auto BhFact = chain->BhFact[index];
+        auto Ht = chain->Ht[index];
+
+        auto T2 = GetT2(BhFact, Ht, fuel);
+        auto T3 = GetT3(dd, chain->Nd[index], chain->Ld[index], BhFact, Ht, fuel);
+        auto Tabs = GetTabs(T2, T3);
+        auto omega = GetOmega(fuel, dd, Tabs, chain->L0[index], BhFact);
+        auto k1 = GetK(dd, omega);
+
+        chain->T2[index] = T2;
+        chain->T3[index] = T3;
+        chain->Tabs[index] = Tabs;
+        chain->Omega[index] = omega;
+        chain->K1[index] = k1;
+    }
+}
+
+BEGIN_TARGET_AVX2
+#define WIDE f64x4
+#define WIDE_FUNCTION(name) name##AVX2
+#include "ss_boiler_formulas.inl"
+#include "ss_boiler_wide.inl"
+#undef WIDE_FUNCTION
+#undef WIDE
+END_TARGET
+
+BEGIN_TARGET_AVX512
+#define WIDE f64x8
+#define WIDE_FUNCTION(name) name##AVX512
+#include "ss_boiler_formulas.inl"
+#include "ss_boiler_wide.inl"
+#undef WIDE_FUNCTION
+#undef WIDE
+END_TARGET
+
+global b32 GlobalSimdLevelInitialized;
+global simd_level GlobalSimdLevel;
+
+// Ограничивает используемый набор инструкций (например SimdLevel_Scalar для
+// эталонного расчета); выше поддерживаемого процессором не поднимается.
+internal void
+SetSimdLevel(simd_level level)
+{
+    auto supported = GetSimdLevel();
+    GlobalSimdLevel = (level < supported) ? level : supported;
+    GlobalSimdLevelInitialized = true;
+}
+
+internal void
+CalculateFireTubeChain(FireTubeChain *chain, u32 count)
+{
+    TIMED_FUNCTION();
+
+    if (!GlobalSimdLevelInitialized)
+    {
+        SetSimdLevel(SimdLevel_AVX512);
+    }
+
+    switch (GlobalSimdLevel)
+    {
+        case SimdLevel_AVX512:
+        {
+            CalculateFireTubeChainAVX512(chain, count);
+        }
+        break;
+
+        case SimdLevel_AVX2:
+        {
+            CalculateFireTubeChainAVX2(chain, count);
+        }
+        break;
+
+        default:
+        {
+            CalculateFireTubeChainScalar(chain, count);
+        }
+        break;
+    }
+}
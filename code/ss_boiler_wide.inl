@@ -0,0 +1,78 @@
+// NOTE: Wide version of the fire-tube chain. ss_boiler_wide.cpp includes this
+// once per wide type with WIDE and WIDE_FUNCTION defined, inside the matching
+// target region, right after ss_boiler_formulas.inl. The formulas are the
+// ones the scalar path calls, so the only difference from it is the pow in
+// ss_math_wide.inl.
+
+inline void
+WIDE_FUNCTION(FireTubeChainLanes)(FireTubeChain *chain, u32 index)
+{
+    WIDE BhFact = WIDE::Load(chain->BhFact + index);
+    WIDE Ht = WIDE::Load(chain->Ht + index);
+    WIDE K = WIDE::Load(chain->K + index);
+    WIDE alpha = WIDE::Load(chain->Alpha + index);
+    WIDE L0 = WIDE::Load(chain->L0 + index);
+    WIDE DOut = WIDE::Load(chain->DOut + index);
+    WIDE DIn = WIDE::Load(chain->DIn + index);
+    WIDE Ld = WIDE::Load(chain->Ld + index);
+    WIDE nd = WIDE::Load(chain->Nd + index);
+
+    WIDE T2 = GetT2(BhFact, Ht, K);
+    WIDE T3 = GetT3(DOut, DIn, nd, Ld, BhFact, Ht, K);
+    WIDE Tabs = GetTabs(T2, T3);
+    WIDE omega = GetOmega(alpha, DIn, Tabs, L0, BhFact);
+    WIDE k1 = GetK(DIn, omega);
+
+    WIDE::Store(chain->T2 + index, T2);
+    WIDE::Store(chain->T3 + index, T3);
+    WIDE::Store(chain->Tabs + index, Tabs);
+    WIDE::Store(chain->Omega + index, omega);
+    WIDE::Store(chain->K1 + index, k1);
+}
+
+internal void
+WIDE_FUNCTION(CalculateFireTubeChain)(FireTubeChain *chain, u32 count)
+{
+    u32 index = 0;
+    for (; index + WIDE::Width <= count; index += WIDE::Width)
+    {
+        WIDE_FUNCTION(FireTubeChainLanes)(chain, index);
+    }
+
+    if (index < count)
+    {
+        // NOTE: The tail goes through the same lanes (padded with the first
+        // tail element) so that results do not depend on where a variant
+        // falls inside the batch.
+        f64 BhFact[WIDE::Width], Ht[WIDE::Width], K[WIDE::Width], alpha[WIDE::Width], L0[WIDE::Width];
+        f64 DOut[WIDE::Width], DIn[WIDE::Width], Ld[WIDE::Width];
+        u16 nd[WIDE::Width];
+        f64 T2[WIDE::Width], T3[WIDE::Width], Tabs[WIDE::Width], omega[WIDE::Width], k1[WIDE::Width];
+
+        for (u32 lane = 0; lane < WIDE::Width; ++lane)
+        {
+            u32 source = (index + lane < count) ? (index + lane) : index;
+            BhFact[lane] = chain->BhFact[source];
+            Ht[lane] = chain->Ht[source];
+            K[lane] = chain->K[source];
+            alpha[lane] = chain->Alpha[source];
+            L0[lane] = chain->L0[source];
+            DOut[lane] = chain->DOut[source];
+            DIn[lane] = chain->DIn[source];
+            Ld[lane] = chain->Ld[source];
+            nd[lane] = chain->Nd[source];
+        }
+
+        FireTubeChain tail = {BhFact, Ht, K, alpha, L0, DOut, DIn, Ld, nd, T2, T3, Tabs, omega, k1};
+        WIDE_FUNCTION(FireTubeChainLanes)(&tail, 0);
+
+        for (u32 lane = 0; index + lane < count; ++lane)
+        {
+            chain->T2[index + lane] = T2[lane];
+            chain->T3[index + lane] = T3[lane];
+            chain->Tabs[index + lane] = Tabs[lane];
+            chain->Omega[index + lane] = omega[lane];
+            chain->K1[index + lane] = k1[lane];
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+// Счетчики тактов (rdtsc) по функциям и стадиям расчета: TIMED_FUNCTION() в
+// начале функции, TIMED_BLOCK(Name) до конца блока, BEGIN_TIMED_BLOCK(Name) и
+// END_TIMED_BLOCK(Name) - для участка без своего блока. Счетчик считает
+// такты вместе с вложенными блоками и число входов. Таблицу дает платформа
+// (AppMemory::DebugTable), она же печатает самые горячие счетчики после
+// каждого Calculate. Счетчики включает EDITOR_PROFILE=1, иначе макросы пустые.
+// NOTE: A timed block costs a few dozen cycles (two rdtsc), more than most of
+// the ss_boiler.cpp formulas themselves, so blocks go only at stage, batch
+// and solver-loop granularity (CalculateBoiler, CalculateBoilerBatch, sweep
+// chunks, Solve*Batch), never on a single formula.
+
+#if EDITOR_PROFILE
+
+// NOTE: Set by Calculate from AppMemory; tools that link the calculation
+// code directly (ss_bench, ss_fuelc) leave it 0 and timed blocks do nothing.
+global DebugCounterTable *GlobalDebugTable;
+
+struct DebugThreadSlot
+{
+    u32 Generation;
+    u32 Index;
+};
+
+global thread_local DebugThreadSlot GlobalDebugThreadSlot;
+
+// Счетчик блока counterIndex в строке текущего потока, 0 - если не считаем
+inline DebugCounter *
+GetDebugCounter(u32 counterIndex, char const *fileName, u32 lineNumber, char const *prefix,
+                char const *blockName)
+{
+    DebugCounterTable *table = GlobalDebugTable;
+    if (!table)
+    {
+        return 0;
+    }
+
+    DebugThreadSlot *slot = &GlobalDebugThreadSlot;
+    if (slot->Generation != table->Generation)
+    {
+        slot->Generation = table->Generation;
+        slot->Index = table->ThreadCount++;
+    }
+    if (slot->Index >= DEBUG_MAX_THREADS)
+    {
+        return 0;
+    }
+
+    // NOTE: Written once per reset; threads that race here write the same values.
+    DebugCounterRecord *record = table->Records + counterIndex;
+    if (!record->BlockName)
+    {
+        record->FileName = fileName;
+        record->Prefix = prefix;
+        record->LineNumber = lineNumber;
+        record->BlockName = blockName;
+    }
+
+    return table->Counters[slot->Index] + counterIndex;
+}
+
+struct TimedBlock
+{
+    DebugCounter *Counter;
+    u64 StartCycles;
+
+    TimedBlock(u32 counterIndex, char const *fileName, u32 lineNumber, char const *prefix, char const *blockName)
+    {
+        Counter = GetDebugCounter(counterIndex, fileName, lineNumber, prefix, blockName);
+        StartCycles = Counter ? __rdtsc() : 0;
+    }
+
+    void End()
+    {
+        if (Counter)
+        {
+            Counter->CycleCount += __rdtsc() - StartCycles;
+            ++Counter->HitCount;
+            Counter = 0;
+        }
+    }
+
+    ~TimedBlock()
+    {
+        End();
+    }
+};
+
+// NOTE: ss_boiler_dual.cpp redefines the prefix around its second copy of
+// CalculateBoiler, so both copies show up separately in the report.
+#define TIMED_BLOCK_PREFIX 0
+
+#define TIMED_BLOCK_(name, variable) \
+    TimedBlock variable(__COUNTER__, __FILE__, __LINE__, TIMED_BLOCK_PREFIX, name)
+#define TIMED_BLOCK(Name) TIMED_BLOCK_(#Name, timedBlock_##Name)
+#define TIMED_FUNCTION() TIMED_BLOCK_(__FUNCTION__, timedFunction)
+#define BEGIN_TIMED_BLOCK(Name) TIMED_BLOCK_(#Name, timedBlock_##Name)
+#define END_TIMED_BLOCK(Name) timedBlock_##Name.End()
+
+#else
+
+#define TIMED_BLOCK(Name)
+#define TIMED_FUNCTION()
+#define BEGIN_TIMED_BLOCK(Name)
+#define END_TIMED_BLOCK(Name)
+
+#endif
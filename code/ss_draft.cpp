@@ -0,0 +1,319 @@
+// Тяга и напряжение решетки. Напряжение решетки U не задается, а находится
+// из равенства разрежения в дымовой коробке и сопротивления газового тракта:
+// решетки со слоем топлива (растет как квадрат расхода воздуха) и дымогарных
+// труб (как квадрат скорости газов при их средней температуре). Разрежение
+// дает дымовая труба и конус, разрежение конуса растет с расходом мятого пара,
+// то есть с испарением котла при этом U. Получается установившийся режим:
+// наибольшее U, Bh и испарение, которые котел держит на своей тяге.
+//
+// Невязка (сопротивление - разрежение) / разрежение растет с U, поэтому
+// корень один. Как в SolveInverseBatch: сначала оба конца [UMin, UMax],
+// затем Ньютон с производной по конечной разности внутри отрезка с переменой
+// знака, шаг за его пределы заменяется делением пополам. Точки всех строк
+// считаются одним CalculateBoilerBatch (векторная цепочка дымогарных труб);
+// от U зависит и топка, поэтому каждый раз считаются все стадии.
+
+#define DRAFT_STEP_FRACTION 1e-7 // шаг конечной разности, доля ширины границ
+
+// Сопротивление колосниковой решетки со слоем топлива, мм вод. ст.
+// U    - напряжение колосниковой решетки
+// L0   - теоретический расход воздуха
+// tb   - температура наружного воздуха
+// zeta - коэффициент сопротивления решетки со слоем топлива
+internal inline f64
+GetGrateDraftLoss(f64 U, f64 L0, f64 tb, Fuel fuel, f64 zeta)
+{
+    auto v = GetV(tb + 273.0);
+    auto w = (L0 * fuel.alpha * U * v) / 3600.0; // скорость воздуха на 1 м2 решетки
+    return (zeta * w * w / (2.0 * 9.81 * v));
+}
+
+// Сопротивление дымогарных труб, мм вод. ст.
+// omega  - скорость газов (GetOmega, на сечение одной трубы)
+// n      - число труб
+// L      - длина труб
+// lambda - коэффициент трения
+// zeta   - сопротивление входа в трубы и выхода из них
+internal inline f64
+GetTubeDraftLoss(PipeDiameter d, u16 n, f64 L, f64 omega, f64 Tabs, f64 lambda, f64 zeta)
+{
+    auto w = omega / n;
+    auto r = GetHydraulicRadius(d);
+    auto v = GetV(Tabs);
+    return ((lambda * L / (4.0 * r) + zeta) * w * w / (2.0 * 9.81 * v));
+}
+
+// Разрежение в дымовой коробке, мм вод. ст.
+// D        - испарение котла кг/час (мятый пар через конус)
+// chimney  - тяга дымовой трубы
+// blast    - разрежение от конуса при 1 т/час пара
+// exponent - показатель степени по расходу пара
+internal inline f64
+GetDraft(f64 D, f64 chimney, f64 blast, f64 exponent)
+{
+    return (chimney + blast * Pow(D / 1000.0, exponent));
+}
+
+// D   - испарение котла кг/час
+// Q1  - полезное тепло
+// lK  - теплосодержание пара в котле в кал/кг
+// phi - температура питательной воды
+internal inline f64
+GetEvaporation(f64 Q1, f64 lK, f64 phi)
+{
+    return (Q1 / (lK - phi));
+}
+
+struct DraftRow
+{
+    f64 U;
+    f64 H; // сдвиг для производной, со знаком
+
+    // отрезок с переменой знака невязки
+    f64 Lo;
+    f64 Hi;
+    f64 FLo;
+    f64 FHi;
+
+    u32 Iterations;
+    u8 Status;
+    b32 Active;
+};
+
+// Испарение котла кг/час в точке slot по полезному теплу
+inline f64
+GetDraftEvaporation(DraftSpec *spec, BoilerBatchOutput *output, u32 slot)
+{
+    auto Q1 = output->Q0[slot] - output->Q21[slot] - output->Q22[slot] - output->Q3[slot] - output->Q4[slot];
+    return GetEvaporation(Maximum(Q1, 0.0), spec->SteamEnthalpy, spec->FeedT);
+}
+
+// Относительная невязка (сопротивление - разрежение) / разрежение в точке slot
+inline f64
+GetDraftResidual(DraftSpec *spec, BoilerBatchInput *input, BoilerBatchOutput *output, u32 slot, f64 *draft)
+{
+    Fuel *fuel = GetBatchFuel(input, slot);
+
+    PipeDiameter dd = {};
+    dd.DOut = input->DOut[slot];
+    dd.DIn = input->DIn[slot];
+
+    auto D = GetDraftEvaporation(spec, output, slot);
+    auto h = GetDraft(D, spec->ChimneyDraft, spec->BlastCoefficient, spec->BlastExponent);
+    auto loss = GetGrateDraftLoss(input->U[slot], output->L0[slot], input->t, *fuel, spec->GrateResistance) +
+                GetTubeDraftLoss(dd, input->Nd[slot], input->Ld[slot], output->Omega[slot], output->Tabs[slot],
+                                 spec->TubeFriction, spec->TubeEntryExit);
+
+    *draft = h;
+    f64 scale = (h > 0.0) ? h : 1.0;
+    return (loss - h) / scale;
+}
+
+internal DraftStats
+SolveDraftBatch(MemoryArena *arena, DraftSpec *spec, DraftBatch *batch)
+{
+    TIMED_FUNCTION();
+
+    DraftStats stats = {};
+
+    BoilerBatchInput *base = batch->Base;
+    u32 rowCount = base->Count;
+    Assert((spec->UMin > 0.0) && (spec->UMin < spec->UMax));
+
+    f64 tolerance = (spec->Tolerance > 0.0) ? spec->Tolerance : DRAFT_DEFAULT_TOLERANCE;
+    u32 maxIterations = spec->MaxIterations ? spec->MaxIterations : DRAFT_DEFAULT_MAX_ITERATIONS;
+
+    stats.RowCount = rowCount;
+
+    auto tempMem = BeginTemporaryMemory(arena);
+
+    // у каждой строки точка и ее сдвиг; в первой итерации - оба конца отрезка
+    const u32 slotsPerRow = 2;
+    u64 slotCount = (u64)rowCount * slotsPerRow;
+    Assert(slotCount <= 0xFFFFFFFF);
+
+    auto rows = PushArray(arena, rowCount, DraftRow);
+    auto eval = PushBoilerBatchInput(arena, (u32)slotCount);
+    auto evalOutput = PushBoilerBatchOutput(arena, slotCount);
+    if (!rows || !eval.Ld || !evalOutput.T3)
+    {
+        EndTemporaryMemory(tempMem);
+        return stats;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    eval.Fuels = base->Fuels;
+    eval.FuelRecords = base->FuelRecords;
+    eval.t = base->t;
+    for (u32 rowIndex = 0; rowIndex < rowCount; ++rowIndex)
+    {
+        DraftRow *row = rows + rowIndex;
+        ZeroStruct(*row);
+        row->Active = true;
+
+        u32 firstSlot = rowIndex * slotsPerRow;
+        for (u32 slot = 0; slot < slotsPerRow; ++slot)
+        {
+            CopyBoilerBatchVariant(&eval, firstSlot + slot, base, rowIndex);
+        }
+        eval.U[firstSlot] = spec->UMin;
+        eval.U[firstSlot + 1] = spec->UMax;
+    }
+
+    f64 h = DRAFT_STEP_FRACTION * (spec->UMax - spec->UMin);
+
+    u32 activeCount = rowCount;
+    u32 iteration = 0;
+    for (; (iteration < maxIterations) && activeCount; ++iteration)
+    {
+        CalculateBoilerBatch(&eval, &evalOutput);
+        stats.Evaluations += (u64)activeCount * slotsPerRow;
+
+        for (u32 rowIndex = 0; rowIndex < rowCount; ++rowIndex)
+        {
+            DraftRow *row = rows + rowIndex;
+            if (!row->Active)
+            {
+                continue;
+            }
+            ++row->Iterations;
+
+            u32 firstSlot = rowIndex * slotsPerRow;
+
+            f64 draft;
+            f64 f = GetDraftResidual(spec, &eval, &evalOutput, firstSlot, &draft);
+            f64 fShifted = GetDraftResidual(spec, &eval, &evalOutput, firstSlot + 1, &draft);
+
+            if (iteration == 0)
+            {
+                f64 fMax = fShifted;
+                if (fabs(f) <= tolerance)
+                {
+                    row->U = spec->UMin;
+                    row->Status = DraftStatus_Converged;
+                    row->Active = false;
+                }
+                else if (fabs(fMax) <= tolerance)
+                {
+                    row->U = spec->UMax;
+                    row->Status = DraftStatus_Converged;
+                    row->Active = false;
+                }
+                else if (IsSameSign(f, fMax))
+                {
+                    // NOTE: Draft to spare even at UMax means the grate, not
+                    // the draft, limits the firing rate.
+                    row->U = (f < 0.0) ? spec->UMax : spec->UMin;
+                    row->Status = DraftStatus_OutOfBounds;
+                    row->Active = false;
+                }
+                else
+                {
+                    row->Lo = spec->UMin;
+                    row->Hi = spec->UMax;
+                    row->FLo = f;
+                    row->FHi = fMax;
+
+                    // первое приближение - по хорде
+                    row->U = row->Lo - row->FLo * (row->Hi - row->Lo) / (row->FHi - row->FLo);
+                }
+            }
+            else if (fabs(f) <= tolerance)
+            {
+                row->Status = DraftStatus_Converged;
+                row->Active = false;
+            }
+            else
+            {
+                if (IsSameSign(f, row->FLo))
+                {
+                    row->Lo = row->U;
+                    row->FLo = f;
+                }
+                else
+                {
+                    row->Hi = row->U;
+                    row->FHi = f;
+                }
+
+                if (row->Hi - row->Lo <= 1e-12 * (spec->UMax - spec->UMin))
+                {
+                    row->Status = DraftStatus_Converged;
+                    row->Active = false;
+                }
+                else
+                {
+                    f64 df = (fShifted - f) / row->H;
+                    f64 next = row->U - f / df;
+                    if (!(next > row->Lo && next < row->Hi))
+                    {
+                        next = 0.5 * (row->Lo + row->Hi);
+                    }
+                    row->U = next;
+                }
+            }
+
+            if (row->Active)
+            {
+                // NOTE: Step inward so the shifted point stays within the bounds.
+                row->H = (row->U + h > spec->UMax) ? -h : h;
+                eval.U[firstSlot] = row->U;
+                eval.U[firstSlot + 1] = row->U + row->H;
+            }
+            else
+            {
+                --activeCount;
+            }
+        }
+    }
+
+    // итоговая точка каждой строки
+    for (u32 rowIndex = 0; rowIndex < rowCount; ++rowIndex)
+    {
+        DraftRow *row = rows + rowIndex;
+        if (row->Active)
+        {
+            row->Status = DraftStatus_NoConvergence;
+        }
+
+        u32 slot = rowIndex * slotsPerRow;
+        eval.U[slot] = eval.U[slot + 1] = row->U;
+    }
+    CalculateBoilerBatch(&eval, &evalOutput);
+    stats.Evaluations += (u64)rowCount * slotsPerRow;
+
+    for (u32 rowIndex = 0; rowIndex < rowCount; ++rowIndex)
+    {
+        DraftRow *row = rows + rowIndex;
+        u32 slot = rowIndex * slotsPerRow;
+
+        f64 draft;
+        GetDraftResidual(spec, &eval, &evalOutput, slot, &draft);
+
+        batch->U[rowIndex] = row->U;
+        batch->Bh[rowIndex] = evalOutput.Bh[slot];
+        batch->T3[rowIndex] = evalOutput.T3[slot];
+        batch->Draft[rowIndex] = draft;
+        batch->Evaporation[rowIndex] = GetDraftEvaporation(spec, &evalOutput, slot);
+        if (batch->Status)
+        {
+            batch->Status[rowIndex] = row->Status;
+        }
+        if (batch->Iterations)
+        {
+            batch->Iterations[rowIndex] = (u8)LimitI(row->Iterations, 0, 0xFF);
+        }
+
+        stats.Converged += (row->Status == DraftStatus_Converged);
+        stats.OutOfBounds += (row->Status == DraftStatus_OutOfBounds);
+        stats.NoConvergence += (row->Status == DraftStatus_NoConvergence);
+    }
+
+    auto endTime = std::chrono::steady_clock::now();
+    stats.Iterations = iteration;
+    stats.Seconds = std::chrono::duration<f64>(endTime - startTime).count();
+
+    EndTemporaryMemory(tempMem);
+    return stats;
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+// Forward-mode automatic differentiation. A dual number carries a value and
+// its partial derivatives with respect to up to DUAL_WIDTH seeded inputs, so
+// evaluating a formula once over duals yields the value and the whole
+// gradient. The value part goes through exactly the same f64 operations as
+// the plain formula, so it matches the scalar result bit for bit.
+//
+// Every operation updates all DUAL_WIDTH derivatives in a fixed-length loop
+// the compiler can vectorize; the cost over plain f64 is therefore a
+// constant factor (roughly DUAL_WIDTH / SIMD lanes), independent of how many
+// inputs are seeded.
+
+#define DUAL_WIDTH 28
+
+struct dual
+{
+    f64 Value;
+    f64 D[DUAL_WIDTH];
+
+    dual() = default;
+    constexpr dual(f64 value) : Value(value), D{} {}
+};
+
+inline dual
+MakeDual(f64 value, u32 seed)
+{
+    Assert(seed < DUAL_WIDTH);
+    dual result(value);
+    result.D[seed] = 1.0;
+    return result;
+}
+
+// NOTE: Chain rule helper: result = f(a) with f'(a) = derivative.
+inline dual
+ApplyDerivative(dual a, f64 value, f64 derivative)
+{
+    dual result;
+    result.Value = value;
+    for (u32 index = 0; index < DUAL_WIDTH; ++index)
+    {
+        result.D[index] = derivative * a.D[index];
+    }
+    return result;
+}
+
+inline dual
+operator+(dual a, dual b)
+{
+    dual result;
+    result.Value = a.Value + b.Value;
+    for (u32 index = 0; index < DUAL_WIDTH; ++index)
+    {
+        result.D[index] = a.D[index] + b.D[index];
+    }
+    return result;
+}
+
+inline dual
+operator-(dual a, dual b)
+{
+    dual result;
+    result.Value = a.Value - b.Value;
+    for (u32 index = 0; index < DUAL_WIDTH; ++index)
+    {
+        result.D[index] = a.D[index] - b.D[index];
+    }
+    return result;
+}
+
+inline dual
+operator*(dual a, dual b)
+{
+    dual result;
+    result.Value = a.Value * b.Value;
+    for (u32 index = 0; index < DUAL_WIDTH; ++index)
+    {
+        result.D[index] = a.D[index] * b.Value + a.Value * b.D[index];
+    }
+    return result;
+}
+
+inline dual
+operator/(dual a, dual b)
+{
+    dual result;
+    result.Value = a.Value / b.Value;
+    f64 inverse = 1.0 / b.Value;
+    for (u32 index = 0; index < DUAL_WIDTH; ++index)
+    {
+        result.D[index] = (a.D[index] - result.Value * b.D[index]) * inverse;
+    }
+    return result;
+}
+
+inline dual
+operator-(dual a)
+{
+    return ApplyDerivative(a, -a.Value, -1.0);
+}
+
+inline dual operator+(dual a, f64 b) { dual result = a; result.Value = a.Value + b; return result; }
+inline dual operator-(dual a, f64 b) { dual result = a; result.Value = a.Value - b; return result; }
+inline dual operator*(dual a, f64 b) { return ApplyDerivative(a, a.Value * b, b); }
+inline dual operator/(dual a, f64 b) { return ApplyDerivative(a, a.Value / b, 1.0 / b); }
+inline dual operator+(f64 a, dual b) { dual result = b; result.Value = a + b.Value; return result; }
+inline dual operator-(f64 a, dual b) { return ApplyDerivative(b, a - b.Value, -1.0); }
+inline dual operator*(f64 a, dual b) { return ApplyDerivative(b, a * b.Value, a); }
+inline dual operator/(f64 a, dual b) { return ApplyDerivative(b, a / b.Value, -(a / b.Value) / b.Value); }
+
+inline dual &operator+=(dual &a, dual b) { a = a + b; return a; }
+inline dual &operator-=(dual &a, dual b) { a = a - b; return a; }
+inline dual &operator*=(dual &a, dual b) { a = a * b; return a; }
+inline dual &operator/=(dual &a, dual b) { a = a / b; return a; }
+
+// NOTE: Comparisons look at the value only, so branches follow the f64 path.
+inline bool operator<(dual a, dual b) { return a.Value < b.Value; }
+inline bool operator>(dual a, dual b) { return a.Value > b.Value; }
+inline bool operator<=(dual a, dual b) { return a.Value <= b.Value; }
+inline bool operator>=(dual a, dual b) { return a.Value >= b.Value; }
+inline bool operator==(dual a, dual b) { return a.Value == b.Value; }
+inline bool operator!=(dual a, dual b) { return a.Value != b.Value; }
+inline bool operator<(dual a, f64 b) { return a.Value < b; }
+inline bool operator>(dual a, f64 b) { return a.Value > b; }
+inline bool operator==(dual a, f64 b) { return a.Value == b; }
+
+inline dual
+sqrt(dual a)
+{
+    f64 value = sqrt(a.Value);
+    return ApplyDerivative(a, value, 0.5 / value);
+}
+
+inline dual
+log(dual a)
+{
+    return ApplyDerivative(a, log(a.Value), 1.0 / a.Value);
+}
+
+inline dual
+exp(dual a)
+{
+    f64 value = exp(a.Value);
+    return ApplyDerivative(a, value, value);
+}
+
+inline dual
+fabs(dual a)
+{
+    return (a.Value < 0.0) ? -a : a;
+}
+
+inline dual
+pow(dual a, f64 e)
+{
+    // NOTE: e * a^(e-1) written as e * a^e / a saves a second pow call.
+    f64 value = pow(a.Value, e);
+    return ApplyDerivative(a, value, e * value / a.Value);
+}
+
+inline dual
+pow(dual a, dual e)
+{
+    // d(a^e) = a^e * (e' * ln a + e * a' / a)
+    f64 value = pow(a.Value, e.Value);
+    f64 logA = log(a.Value);
+    dual result;
+    result.Value = value;
+    for (u32 index = 0; index < DUAL_WIDTH; ++index)
+    {
+        result.D[index] = value * (e.D[index] * logA + e.Value * a.D[index] / a.Value);
+    }
+    return result;
+}
+
+// Dual versions of the ss_math.h helpers the boiler formulas use; same
+// operation order as the f64 versions.
+
+inline dual
+Map(dual x, f64 inMin, f64 inMax, f64 outMin, f64 outMax)
+{
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+inline dual
+Pow(dual a, f64 e)
+{
+    f64 value = Pow(a.Value, e);
+    return ApplyDerivative(a, value, e * value / a.Value);
+}
+
+inline dual
+Log(dual a)
+{
+    return ApplyDerivative(a, Log(a.Value), 1.0 / a.Value);
+}
+
+inline dual
+Exp(dual a)
+{
+    f64 value = Exp(a.Value);
+    return ApplyDerivative(a, value, value);
+}
+
+inline dual
+Root(dual input, f64 n)
+{
+    return Pow(input, 1.0 / n);
+}
+
+inline dual
+SolveQuadratic(dual a, dual b, dual c)
+{
+    auto D = (b * b) - (4.0 * a * c);
+
+    if (D < 0)
+    {
+        return -1;
+    }
+    if (D == 0)
+    {
+        return -b / (2.0 * a);
+    }
+
+    auto x1 = (-b + sqrt(D)) / (2.0 * a);
+    auto x2 = (-b - sqrt(D)) / (2.0 * a);
+
+    return x1 > x2 ? x1 : x2;
+}
@@ -0,0 +1,236 @@
+// Дымогарные трубы по участкам. Газ входит в трубы с температурой T2 и
+// отдает тепло воде (tk) на каждом из SegmentCount участков длины
+// Ld / SegmentCount. На участке скорость газов (GetWd) и коэффициент
+// теплопередачи (GetKd) берутся при средней температуре участка, которую
+// дает предиктор с температурой на входе (схема второго порядка), а
+// температура на выходе - точное решение GetSegmentT при этих k и
+// теплоемкости.
+// Группа может нести элементы пароперегревателя (жаровые трубы): газ идет по
+// кольцевому сечению, а тепло уходит и воде, и пару (SinkKH при SinkT).
+//
+// GetWd - скорость газов в трубе, та же, что GetOmega / Nd (с точностью до
+// L0 alpha + 1 против L0 alpha). С ростом числа участков T3 сходится к
+// значению в среднем на 10% ниже эмпирической GetT3 (проверка в ss_bench
+// -accuracy).
+// Ошибка от числа участков (против 4096 участков, случайные котлы рабочего
+// диапазона): при FIRE_TUBE_SEGMENT_NTU 0.05 T3 <= 0.01 °C.
+// Векторные пути считают по тем же формулам (ss_boiler_formulas.inl) и
+// отличаются от скалярного на <= 16 ULP (T3, Q, K).
+
+// Живое сечение и гидравлический радиус группы: труба или кольцо вокруг
+// элемента перегревателя
+internal inline void
+GetFireTubeSection(FireTubeProfile *profile, u32 index, f64 *omega, f64 *r)
+{
+    PipeDiameter dd = {};
+    dd.DOut = profile->DOut[index];
+    dd.DIn = profile->DIn[index];
+
+    if (profile->DElement)
+    {
+        PipeDiameter di = {};
+        di.DOut = profile->DElement[index];
+        *omega = GetAnnulusSquare(dd, di) * profile->Nd[index];
+        *r = GetAnnulusHydraulicRadius(dd, di);
+    }
+    else
+    {
+        *omega = GetPipeSquare(dd) * profile->Nd[index];
+        *r = GetHydraulicRadius(dd);
+    }
+}
+
+// Число участков для каждой группы: не больше maxNtu единиц переноса
+// (k dH / теплоемкость) на участок при входной температуре, где k
+// наибольший. Ошибка участка растет как куб его числа единиц переноса.
+internal void
+ChooseFireTubeSegmentCounts(FireTubeProfile *profile, u32 count, f64 maxNtu)
+{
+    for (u32 index = 0; index < count; ++index)
+    {
+        PipeDiameter dd = {};
+        dd.DOut = profile->DOut[index];
+        dd.DIn = profile->DIn[index];
+
+        f64 omegaD, rd;
+        GetFireTubeSection(profile, index, &omegaD, &rd);
+
+        auto T2 = profile->T2[index];
+        auto b = profile->Beta ? profile->Beta[index] : 0.0;
+        auto Wd = GetWd(profile->L0[index], profile->Alpha[index], profile->BhFact[index], 1.0, omegaD, T2, T2, b);
+        auto kH = GetKd(Wd, rd) * GetHPipes(dd, profile->Nd[index], profile->Ld[index]);
+        if (profile->SinkKH)
+        {
+            kH += profile->SinkKH[index];
+        }
+        auto c = (1.0 - b) * (profile->M[index] + 2.0 * profile->N[index] * T2);
+
+        auto segmentCount = ceil((kH / c) / maxNtu);
+        profile->SegmentCount[index] = (u16)LimitF(segmentCount, 1.0, FIRE_TUBE_MAX_SEGMENTS);
+    }
+}
+
+internal void
+CalculateFireTubeProfileScalar(FireTubeProfile *profile, u32 count)
+{
+    for (u32 index = 0; index < count; ++index)
+    {
+        PipeDiameter dd = {};
+        dd.DOut = profile->DOut[index];
+        dd.DIn = profile->DIn[index];
+
+        auto T2 = profile->T2[index];
+        auto M = profile->M[index];
+        auto N = profile->N[index];
+        auto L0 = profile->L0[index];
+        auto alpha = profile->Alpha[index];
+        auto BhFact = profile->BhFact[index];
+        auto b = profile->Beta ? profile->Beta[index] : 0.0;
+        auto tk = profile->tk;
+        auto ts = profile->SinkT;
+        u32 segmentCount = profile->SegmentCount[index];
+        Assert((segmentCount >= 1) && (segmentCount <= FIRE_TUBE_MAX_SEGMENTS));
+
+        f64 omegaD, rd; // живое сечение группы и гидравлический радиус
+        GetFireTubeSection(profile, index, &omegaD, &rd);
+        auto dH = GetHPipes(dd, profile->Nd[index], profile->Ld[index] / segmentCount);
+        auto sink = profile->SinkKH ? (profile->SinkKH[index] / segmentCount) : 0.0;
+
+        // NOTE: BhFact already includes u, so GetWd gets u = 1.
+        auto kr = GetKr(rd);
+        auto T = T2;
+        f64 kdH = 0.0;
+        f64 sinkQ = 0.0;
+        if (profile->Profile)
+        {
+            profile->Profile[index] = T;
+        }
+        for (u32 segment = 0; segment < segmentCount; ++segment)
+        {
+            auto kIn = GetKdByKr(GetWd(L0, alpha, BhFact, 1.0, omegaD, T, T, b), kr);
+            auto sinkIn = tk;
+            auto kdHIn = (sink > 0.0) ? GetSegmentSink(kIn * dH, tk, sink, ts, &sinkIn) : kIn * dH;
+            auto Tp = GetSegmentT(T, T, sinkIn, kdHIn, b, M, N);
+
+            auto Tm = (T + Tp) / 2.0;
+            auto km = GetKdByKr(GetWd(L0, alpha, BhFact, 1.0, omegaD, Tm, Tm, b), kr);
+            auto sinkM = tk;
+            auto kdHM = (sink > 0.0) ? GetSegmentSink(km * dH, tk, sink, ts, &sinkM) : km * dH;
+            auto next = GetSegmentT(T, Tm, sinkM, kdHM, b, M, N);
+
+            kdH += km * dH;
+            sinkQ += sink * ((T + next) / 2.0 - ts);
+            T = next;
+
+            if (profile->Profile)
+            {
+                profile->Profile[(segment + 1) * profile->ProfileStride + index] = T;
+            }
+        }
+
+        profile->T3[index] = T;
+        profile->Q[index] = GetTubeQ(b, M, N, T2, T);
+        profile->K[index] = kdH / (dH * segmentCount);
+        if (profile->QSink)
+        {
+            profile->QSink[index] = sinkQ;
+        }
+    }
+}
+
+BEGIN_TARGET_AVX2
+#define WIDE f64x4
+#define WIDE_FUNCTION(name) name##AVX2
+#include "ss_firetube_wide.inl"
+#undef WIDE_FUNCTION
+#undef WIDE
+END_TARGET
+
+BEGIN_TARGET_AVX512
+#define WIDE f64x8
+#define WIDE_FUNCTION(name) name##AVX512
+#include "ss_firetube_wide.inl"
+#undef WIDE_FUNCTION
+#undef WIDE
+END_TARGET
+
+internal void
+CalculateFireTubeProfile(FireTubeProfile *profile, u32 count)
+{
+    TIMED_FUNCTION();
+
+    if (!GlobalSimdLevelInitialized)
+    {
+        SetSimdLevel(SimdLevel_AVX512);
+    }
+
+    switch (GlobalSimdLevel)
+    {
+        case SimdLevel_AVX512:
+        {
+            CalculateFireTubeProfileAVX512(profile, count);
+        }
+        break;
+
+        case SimdLevel_AVX2:
+        {
+            CalculateFireTubeProfileAVX2(profile, count);
+        }
+        break;
+
+        default:
+        {
+            CalculateFireTubeProfileScalar(profile, count);
+        }
+        break;
+    }
+}
+
+// Профиль дымогарных труб для вариантов пакетного расчета: входы берутся из
+// input и из output после CalculateBoilerBatch, Alpha, SegmentCount (по
+// FIRE_TUBE_SEGMENT_NTU) и выходы - в arena. withRows - с температурами на
+// границах участков. Если памяти не хватает, T3 результата нулевой.
+internal FireTubeProfile
+PushFireTubeProfile(MemoryArena *arena, BoilerBatchInput *input, BoilerBatchOutput *output, f64 tk, b32 withRows)
+{
+    FireTubeProfile result = {};
+
+    u32 count = input->Count;
+    u32 rowCount = withRows ? (FIRE_TUBE_MAX_SEGMENTS + 1) : 0;
+    u64 size = (4 + rowCount) * (count * sizeof(f64) + ARENA_DEFAULT_ALIGNMENT) + count * sizeof(u16) +
+               ARENA_DEFAULT_ALIGNMENT;
+    if (size > GetArenaSizeRemaining(arena))
+    {
+        return result;
+    }
+
+    result.T2 = output->T2;
+    result.M = output->M;
+    result.N = output->N;
+    result.L0 = output->L0;
+    result.BhFact = output->BhFact;
+    result.DOut = input->DOut;
+    result.DIn = input->DIn;
+    result.Ld = input->Ld;
+    result.Nd = input->Nd;
+    result.tk = tk;
+
+    result.Alpha = PushArray(arena, count, f64);
+    result.SegmentCount = PushArray(arena, count, u16);
+    result.T3 = PushArray(arena, count, f64);
+    result.Q = PushArray(arena, count, f64);
+    result.K = PushArray(arena, count, f64);
+    if (withRows)
+    {
+        result.Profile = PushArray(arena, rowCount * count, f64);
+        result.ProfileStride = count;
+    }
+
+    for (u32 index = 0; index < count; ++index)
+    {
+        result.Alpha[index] = GetBatchFuel(input, index)->alpha;
+    }
+    ChooseFireTubeSegmentCounts(&result, count, FIRE_TUBE_SEGMENT_NTU);
+
+    return result;
+}
@@ -0,0 +1,176 @@
+// NOTE: Wide version of the segmented fire-tube solver. ss_firetube.cpp
+// includes this once per wide type with WIDE and WIDE_FUNCTION defined,
+// inside the matching target region. Each lane is one tube group; lanes with
+// fewer segments than the longest one in the block stop updating (masked)
+// once they are done. The formulas are those of ss_boiler_formulas.inl that
+// the scalar path calls, so the only difference from it is the pow/exp in
+// ss_math_wide.inl.
+
+inline void
+WIDE_FUNCTION(FireTubeProfileLanes)(FireTubeProfile *profile, u32 index, u32 segmentCount)
+{
+    WIDE T2 = WIDE::Load(profile->T2 + index);
+    WIDE M = WIDE::Load(profile->M + index);
+    WIDE N = WIDE::Load(profile->N + index);
+    WIDE L0 = WIDE::Load(profile->L0 + index);
+    WIDE alpha = WIDE::Load(profile->Alpha + index);
+    WIDE BhFact = WIDE::Load(profile->BhFact + index);
+    WIDE DOut = WIDE::Load(profile->DOut + index);
+    WIDE DIn = WIDE::Load(profile->DIn + index);
+    WIDE Ld = WIDE::Load(profile->Ld + index);
+    WIDE nd = WIDE::Load(profile->Nd + index);
+    WIDE b = profile->Beta ? WIDE::Load(profile->Beta + index) : WIDE::Set(0.0);
+    WIDE segments = WIDE::Load(profile->SegmentCount + index);
+    WIDE tk = WIDE::Set(profile->tk);
+
+    WIDE rd, omegaD;
+    if (profile->DElement)
+    {
+        // кольцевое сечение вокруг элемента перегревателя
+        WIDE De = WIDE::Load(profile->DElement + index);
+        omegaD = GetAnnulusSquare(DIn, De) * nd;
+        rd = GetAnnulusHydraulicRadius(DIn, De);
+    }
+    else
+    {
+        omegaD = GetPipeSquare(DIn) * nd;
+        rd = GetHydraulicRadius(DIn);
+    }
+    WIDE dH = GetHPipes(DOut, nd, Ld / segments);
+
+    b32 hasSink = (profile->SinkKH != 0);
+    WIDE sink = hasSink ? WIDE::Load(profile->SinkKH + index) / segments : WIDE::Set(0.0);
+    WIDE ts = WIDE::Set(profile->SinkT);
+
+    // NOTE: BhFact already includes u, so GetWd gets u = 1.
+    WIDE u = WIDE::Set(1.0);
+    WIDE kr = GetKr(rd);
+
+    WIDE T = T2;
+    WIDE kdH = WIDE::Set(0.0);
+    WIDE sinkQ = WIDE::Set(0.0);
+    if (profile->Profile)
+    {
+        WIDE::Store(profile->Profile + index, T);
+    }
+    for (u32 segment = 0; segment < segmentCount; ++segment)
+    {
+        auto active = GreaterThan(segments - (f64)segment, 0.5);
+
+        // предиктор по входной температуре; перегреватель складывается с
+        // водой в один сток
+        WIDE kIn = GetKdByKr(GetWd(L0, alpha, BhFact, u, omegaD, T, T, b), kr);
+        WIDE kdHIn = kIn * dH;
+        WIDE sinkIn = tk;
+        if (hasSink)
+        {
+            kdHIn = GetSegmentSink(kdHIn, tk, sink, ts, &sinkIn);
+        }
+        WIDE Tp = GetSegmentT(T, T, sinkIn, kdHIn, b, M, N);
+
+        WIDE Tm = (T + Tp) / 2.0;
+        WIDE km = GetKdByKr(GetWd(L0, alpha, BhFact, u, omegaD, Tm, Tm, b), kr);
+        WIDE kdHM = km * dH;
+        WIDE sinkM = tk;
+        if (hasSink)
+        {
+            kdHM = GetSegmentSink(kdHM, tk, sink, ts, &sinkM);
+        }
+        WIDE next = GetSegmentT(T, Tm, sinkM, kdHM, b, M, N);
+
+        kdH = Select(active, kdH + km * dH, kdH);
+        sinkQ = Select(active, sinkQ + sink * ((T + next) / 2.0 - ts), sinkQ);
+        T = Select(active, next, T);
+
+        if (profile->Profile)
+        {
+            WIDE::Store(profile->Profile + (segment + 1) * profile->ProfileStride + index, T);
+        }
+    }
+
+    WIDE Q = GetTubeQ(b, M, N, T2, T);
+    WIDE K = kdH / (dH * segments);
+
+    WIDE::Store(profile->T3 + index, T);
+    WIDE::Store(profile->Q + index, Q);
+    WIDE::Store(profile->K + index, K);
+    if (profile->QSink)
+    {
+        WIDE::Store(profile->QSink + index, sinkQ);
+    }
+}
+
+internal void
+WIDE_FUNCTION(CalculateFireTubeProfile)(FireTubeProfile *profile, u32 count)
+{
+    u32 index = 0;
+    for (; index + WIDE::Width <= count; index += WIDE::Width)
+    {
+        u32 segmentCount = 0;
+        for (u32 lane = 0; lane < WIDE::Width; ++lane)
+        {
+            segmentCount = Maximum(segmentCount, (u32)profile->SegmentCount[index + lane]);
+        }
+        Assert((segmentCount >= 1) && (segmentCount <= FIRE_TUBE_MAX_SEGMENTS));
+
+        WIDE_FUNCTION(FireTubeProfileLanes)(profile, index, segmentCount);
+    }
+
+    if (index < count)
+    {
+        // NOTE: The tail goes through the same lanes (padded with the first
+        // tail element) so that results do not depend on where a group
+        // falls inside the batch.
+        f64 T2[WIDE::Width], M[WIDE::Width], N[WIDE::Width], L0[WIDE::Width], alpha[WIDE::Width];
+        f64 BhFact[WIDE::Width], DOut[WIDE::Width], DIn[WIDE::Width], Ld[WIDE::Width], beta[WIDE::Width];
+        f64 element[WIDE::Width], sinkKH[WIDE::Width];
+        u16 nd[WIDE::Width], segments[WIDE::Width];
+        f64 T3[WIDE::Width], Q[WIDE::Width], K[WIDE::Width], sinkQ[WIDE::Width];
+        f64 rows[(FIRE_TUBE_MAX_SEGMENTS + 1) * WIDE::Width];
+
+        u32 segmentCount = 0;
+        for (u32 lane = 0; lane < WIDE::Width; ++lane)
+        {
+            u32 source = (index + lane < count) ? (index + lane) : index;
+            T2[lane] = profile->T2[source];
+            M[lane] = profile->M[source];
+            N[lane] = profile->N[source];
+            L0[lane] = profile->L0[source];
+            alpha[lane] = profile->Alpha[source];
+            BhFact[lane] = profile->BhFact[source];
+            DOut[lane] = profile->DOut[source];
+            DIn[lane] = profile->DIn[source];
+            Ld[lane] = profile->Ld[source];
+            beta[lane] = profile->Beta ? profile->Beta[source] : 0.0;
+            element[lane] = profile->DElement ? profile->DElement[source] : 0.0;
+            sinkKH[lane] = profile->SinkKH ? profile->SinkKH[source] : 0.0;
+            nd[lane] = profile->Nd[source];
+            segments[lane] = profile->SegmentCount[source];
+            segmentCount = Maximum(segmentCount, (u32)segments[lane]);
+        }
+        Assert((segmentCount >= 1) && (segmentCount <= FIRE_TUBE_MAX_SEGMENTS));
+
+        FireTubeProfile tail = {T2, M, N, L0, alpha, BhFact, DOut, DIn, Ld, nd, beta, segments, profile->tk,
+                                profile->DElement ? element : 0, profile->SinkKH ? sinkKH : 0, profile->SinkT,
+                                T3, Q, K, sinkQ, profile->Profile ? rows : 0, WIDE::Width};
+        WIDE_FUNCTION(FireTubeProfileLanes)(&tail, 0, segmentCount);
+
+        for (u32 lane = 0; index + lane < count; ++lane)
+        {
+            profile->T3[index + lane] = T3[lane];
+            profile->Q[index + lane] = Q[lane];
+            profile->K[index + lane] = K[lane];
+            if (profile->QSink)
+            {
+                profile->QSink[index + lane] = sinkQ[lane];
+            }
+            if (profile->Profile)
+            {
+                for (u32 row = 0; row <= segments[lane]; ++row)
+                {
+                    profile->Profile[row * profile->ProfileStride + index + lane] = rows[row * WIDE::Width + lane];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,389 @@
+// Парк: поездки всех пар (паровоз, рейс) по всем ядрам. Поездки режутся на
+// куски по FLEET_CHUNK_SIZE, потоки берут куски по очереди. Внутри куска
+// векторный путь ведет WIDE::Width поездок сразу: состояние хранится
+// столбцами (FleetLanes), шаг по времени считается для всех дорожек одними
+// инструкциями, а доехавшая (вставшая, опоздавшая) дорожка тут же получает
+// следующую поездку куска. Скалярные только редкие события: переход на
+// следующий участок, начало и конец поездки. Без AVX2 тот же код идет по
+// одной дорожке (f64x1), так что результат парка не зависит от SimdLevel.
+//
+// Модель та же, что в SimulateTractionTrip, кроме ограничения скорости перед
+// участками с меньшим ограничением: вместо просмотра участков по тормозному
+// пути берется огибающая тормозных кривых всех следующих участков, заранее
+// посчитанная для маршрута. Таблица котла интерполируется "шляпками" по всем
+// точкам сразу, чтобы обойтись без выборки по индексу.
+
+#define FLEET_CHUNK_SIZE 64
+#define FLEET_MAX_WIDTH 8
+
+struct FleetRoute
+{
+    TractionRoute *Route;
+    f64 Length;
+    f64 *Envelope; // min по следующим участкам (ограничение^2 + 2 Brake начало участка), м2/с2
+};
+
+// Состояние поездок на дорожках: по элементу на дорожку
+struct alignas(64) FleetLanes
+{
+    f64 V[FLEET_MAX_WIDTH];
+    f64 Position[FLEET_MAX_WIDTH];
+    f64 U[FLEET_MAX_WIDTH];
+    f64 Time[FLEET_MAX_WIDTH];
+    f64 Fuel[FLEET_MAX_WIDTH];
+    f64 Steam[FLEET_MAX_WIDTH];
+    f64 MaxSpeed[FLEET_MAX_WIDTH];
+    f64 Q4[FLEET_MAX_WIDTH];
+    f64 Q4Speed[FLEET_MAX_WIDTH];
+
+    // поездка
+    f64 Length[FLEET_MAX_WIDTH];
+    f64 Mass[FLEET_MAX_WIDTH];
+    f64 AccelerationPerForce[FLEET_MAX_WIDTH];
+    f64 StartForce[FLEET_MAX_WIDTH];
+    f64 SteamRate[FLEET_MAX_WIDTH];
+    f64 PhiH0[FLEET_MAX_WIDTH];
+    f64 Q[TRACTION_FIRING_LEVELS][FLEET_MAX_WIDTH];
+    f64 Bh[TRACTION_FIRING_LEVELS][FLEET_MAX_WIDTH];
+
+    // текущий участок
+    f64 SectionEnd[FLEET_MAX_WIDTH];
+    f64 Wi[FLEET_MAX_WIDTH];
+    f64 Limit2[FLEET_MAX_WIDTH];
+    f64 Envelope[FLEET_MAX_WIDTH];
+
+    u32 Trip[FLEET_MAX_WIDTH];
+    u32 Section[FLEET_MAX_WIDTH];
+    FleetRoute *Route[FLEET_MAX_WIDTH];
+
+    u32 Active; // бит на дорожку
+    u32 NextTrip;
+    u32 OnePastLastTrip;
+
+    u64 Steps;
+    u64 Arrived;
+    u64 Stalled;
+    u64 TimedOut;
+};
+
+struct FleetWork
+{
+    TractionSpec *Spec;
+    FleetBatch *Batch;
+    FleetRoute *Routes;
+    TractionFiring *Firings;
+    FleetLanes *Workspaces; // по одному на поток
+    f64 tb;
+    f64 Q4T; // множитель GetQ4 от температур, Pow(tk - tb, 4 / 3)
+    u64 TripCount;
+    u32 ChunkCount;
+    std::atomic<u32> NextChunk;
+};
+
+// Огибающая тормозных кривых маршрута, с конца к началу
+internal b32
+PushFleetRoute(MemoryArena *arena, TractionSpec *spec, TractionRoute *route, FleetRoute *result)
+{
+    result->Route = route;
+    result->Envelope = PushArray(arena, route->SectionCount, f64);
+    if (!result->Envelope)
+    {
+        return false;
+    }
+
+    f64 length = 0.0;
+    for (u32 index = 0; index < route->SectionCount; ++index)
+    {
+        length += route->Sections[index].Length;
+    }
+    result->Length = length;
+
+    f64 envelope = HUGE_VAL;
+    f64 sectionStart = length;
+    for (u32 index = route->SectionCount; index-- > 0;)
+    {
+        result->Envelope[index] = envelope;
+
+        sectionStart -= route->Sections[index].Length;
+        f64 limit = route->Sections[index].SpeedLimit / 3.6;
+        envelope = Minimum(envelope, limit * limit + 2.0 * spec->Brake * sectionStart);
+    }
+
+    return true;
+}
+
+inline void
+SetFleetLaneSection(FleetLanes *lanes, u32 lane)
+{
+    FleetRoute *route = lanes->Route[lane];
+    RouteSection *section = route->Route->Sections + lanes->Section[lane];
+
+    f64 limit = section->SpeedLimit / 3.6;
+    lanes->Wi[lane] = GetTractionSectionResistance(section);
+    lanes->Limit2[lane] = limit * limit;
+    lanes->Envelope[lane] = route->Envelope[lanes->Section[lane]];
+}
+
+// Переход дорожки на участок, в котором она сейчас находится
+inline void
+AdvanceFleetLane(FleetLanes *lanes, u32 lane)
+{
+    TractionRoute *route = lanes->Route[lane]->Route;
+    while ((lanes->Position[lane] >= lanes->SectionEnd[lane]) && (lanes->Section[lane] + 1 < route->SectionCount))
+    {
+        ++lanes->Section[lane];
+        lanes->SectionEnd[lane] += route->Sections[lanes->Section[lane]].Length;
+    }
+    SetFleetLaneSection(lanes, lane);
+}
+
+// Следующая поездка куска на дорожку lane; если их больше нет - дорожка гаснет
+internal void
+StartFleetLane(FleetWork *work, FleetLanes *lanes, u32 lane)
+{
+    if (lanes->NextTrip >= lanes->OnePastLastTrip)
+    {
+        lanes->Active &= ~(1u << lane);
+        return;
+    }
+
+    TractionSpec *spec = work->Spec;
+    FleetBatch *batch = work->Batch;
+
+    u32 trip = lanes->NextTrip++;
+    u32 locomotiveIndex = trip / batch->DutyCount;
+    DutyCycle *duty = batch->Duties + (trip % batch->DutyCount);
+    Locomotive *locomotive = batch->Locomotives + locomotiveIndex;
+    TractionFiring *firing = work->Firings + locomotiveIndex;
+
+    f64 mass = locomotive->Mass + duty->TrainMass;
+    lanes->Trip[lane] = trip;
+    lanes->Route[lane] = work->Routes + duty->RouteIndex;
+    lanes->Length[lane] = lanes->Route[lane]->Length;
+    lanes->Mass[lane] = mass;
+    lanes->AccelerationPerForce[lane] = GetTractionAccelerationPerForce(spec, mass);
+    lanes->StartForce[lane] = GetTractionStartForce(spec, locomotive);
+    lanes->SteamRate[lane] = locomotive->SteamRate;
+    lanes->PhiH0[lane] = locomotive->Phi * locomotive->H0;
+    for (u32 level = 0; level < TRACTION_FIRING_LEVELS; ++level)
+    {
+        lanes->Q[level][lane] = firing->Q[level];
+        lanes->Bh[level][lane] = firing->Bh[level];
+    }
+
+    // NOTE: The fire is built up before departure.
+    lanes->V[lane] = 0.0;
+    lanes->Position[lane] = 0.0;
+    lanes->U[lane] = spec->UMax;
+    lanes->Time[lane] = 0.0;
+    lanes->Fuel[lane] = 0.0;
+    lanes->Steam[lane] = 0.0;
+    lanes->MaxSpeed[lane] = 0.0;
+    lanes->Q4[lane] = GetQ4(locomotive->Phi, locomotive->H0, 0.0, work->tb, spec->tk);
+    lanes->Q4Speed[lane] = 0.0;
+
+    lanes->Section[lane] = 0;
+    lanes->SectionEnd[lane] = lanes->Route[lane]->Route->Sections[0].Length;
+    SetFleetLaneSection(lanes, lane);
+
+    lanes->Active |= (1u << lane);
+}
+
+// Результат поездки дорожки lane и следующая поездка на ее место
+internal void
+FinishFleetLane(FleetWork *work, FleetLanes *lanes, u32 lane, traction_status status)
+{
+    FleetBatch *batch = work->Batch;
+    u32 trip = lanes->Trip[lane];
+
+    f64 time = lanes->Time[lane];
+    if ((status == TractionStatus_Arrived) && (lanes->V[lane] > 0.0))
+    {
+        // последний шаг заканчивается за концом пути
+        time -= (lanes->Position[lane] - lanes->Length[lane]) / lanes->V[lane];
+    }
+
+    batch->Time[trip] = time;
+    batch->Coal[trip] = lanes->Fuel[lane];
+    batch->Water[trip] = lanes->Steam[lane];
+    batch->Status[trip] = (u8)status;
+
+    lanes->Arrived += (status == TractionStatus_Arrived);
+    lanes->Stalled += (status == TractionStatus_Stalled);
+    lanes->TimedOut += (status == TractionStatus_TimeOut);
+
+    StartFleetLane(work, lanes, lane);
+}
+
+// NOTE: ss_boiler_wide.cpp has no f64x1 build of the boiler formulas, so
+// the one-lane fleet brings its own.
+#define WIDE f64x1
+#define WIDE_FUNCTION(name) name##X1
+#include "ss_boiler_formulas.inl"
+#include "ss_traction_formulas.inl"
+#include "ss_fleet_wide.inl"
+#undef WIDE_FUNCTION
+#undef WIDE
+
+BEGIN_TARGET_AVX2
+#define WIDE f64x4
+#define WIDE_FUNCTION(name) name##AVX2
+#include "ss_traction_formulas.inl"
+#include "ss_fleet_wide.inl"
+#undef WIDE_FUNCTION
+#undef WIDE
+END_TARGET
+
+BEGIN_TARGET_AVX512
+#define WIDE f64x8
+#define WIDE_FUNCTION(name) name##AVX512
+#include "ss_traction_formulas.inl"
+#include "ss_fleet_wide.inl"
+#undef WIDE_FUNCTION
+#undef WIDE
+END_TARGET
+
+internal void
+RunFleetChunk(FleetWork *work, FleetLanes *lanes, u32 first, u32 onePastLast)
+{
+    TIMED_FUNCTION();
+
+    switch (GlobalSimdLevel)
+    {
+        case SimdLevel_AVX512:
+        {
+            RunFleetChunkAVX512(work, lanes, first, onePastLast);
+        }
+        break;
+
+        case SimdLevel_AVX2:
+        {
+            RunFleetChunkAVX2(work, lanes, first, onePastLast);
+        }
+        break;
+
+        default:
+        {
+            RunFleetChunkX1(work, lanes, first, onePastLast);
+        }
+        break;
+    }
+}
+
+internal PARALLEL_PROC(FleetWorkerProc)
+{
+    auto work = (FleetWork *)data;
+    auto lanes = work->Workspaces + threadIndex;
+    for (;;)
+    {
+        u32 chunk = work->NextChunk++;
+        if (chunk >= work->ChunkCount)
+        {
+            break;
+        }
+
+        u64 first = (u64)chunk * FLEET_CHUNK_SIZE;
+        u64 onePastLast = Minimum(first + FLEET_CHUNK_SIZE, work->TripCount);
+        RunFleetChunk(work, lanes, (u32)first, (u32)onePastLast);
+    }
+}
+
+// Рабочая память берется из arena и возвращается по окончании.
+// threadCount = 0 - по числу ядер. Возвращает false, если не хватило памяти.
+internal b32
+RunFleet(MemoryArena *arena, TractionSpec *spec, FleetBatch *batch, u32 threadCount, FleetStats *stats)
+{
+    ZeroStruct(*stats);
+
+    u64 tripCount = (u64)batch->LocomotiveCount * batch->DutyCount;
+    if (tripCount == 0)
+    {
+        return true;
+    }
+    Assert(tripCount <= 0xFFFFFFFF);
+    Assert(batch->Boilers->Count == batch->LocomotiveCount);
+    Assert((spec->Dt > 0.0) && (spec->UIdle < spec->UMax) && (spec->Brake > 0.0));
+
+    if (!GlobalSimdLevelInitialized)
+    {
+        SetSimdLevel(SimdLevel_AVX512);
+    }
+
+    if (threadCount == 0)
+    {
+        threadCount = GetDefaultThreadCount();
+    }
+    threadCount = (u32)LimitI(threadCount, 1, SWEEP_MAX_THREADS);
+
+    u64 chunkCount = (tripCount + FLEET_CHUNK_SIZE - 1) / FLEET_CHUNK_SIZE;
+    threadCount = (u32)Minimum((u64)threadCount, chunkCount);
+
+    auto tempMem = BeginTemporaryMemory(arena);
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    u32 routeCount = 0;
+    for (u32 duty = 0; duty < batch->DutyCount; ++duty)
+    {
+        routeCount = Maximum(routeCount, batch->Duties[duty].RouteIndex + 1);
+    }
+
+    auto work = PushStruct(arena, FleetWork);
+    auto routes = PushArray(arena, routeCount, FleetRoute);
+    auto workspaces = PushArray(arena, threadCount, FleetLanes);
+    auto firings = PushTractionFirings(arena, spec, batch->Boilers);
+    b32 haveMemory = work && routes && workspaces && firings;
+    for (u32 route = 0; haveMemory && (route < routeCount); ++route)
+    {
+        haveMemory = PushFleetRoute(arena, spec, batch->Routes + route, routes + route);
+    }
+    if (!haveMemory)
+    {
+        EndTemporaryMemory(tempMem);
+        return false;
+    }
+    ZeroSize(sizeof(*work), work);
+    ZeroSize(threadCount * sizeof(FleetLanes), workspaces);
+
+    work->Spec = spec;
+    work->Batch = batch;
+    work->Routes = routes;
+    work->Firings = firings;
+    work->Workspaces = workspaces;
+    work->tb = batch->Boilers->t;
+    work->Q4T = Pow(spec->tk - work->tb, 4.0 / 3.0);
+    work->TripCount = tripCount;
+    work->ChunkCount = (u32)chunkCount;
+    work->NextChunk = 0;
+
+    RunParallel(FleetWorkerProc, work, threadCount);
+
+    auto endTime = std::chrono::steady_clock::now();
+
+    stats->TripCount = tripCount;
+    stats->ThreadCount = threadCount;
+    for (u32 threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+    {
+        FleetLanes *lanes = workspaces + threadIndex;
+        stats->Steps += lanes->Steps;
+        stats->Arrived += lanes->Arrived;
+        stats->Stalled += lanes->Stalled;
+        stats->TimedOut += lanes->TimedOut;
+    }
+
+    // NOTE: Totals are summed in trip order so they do not depend on the thread count.
+    for (u64 trip = 0; trip < tripCount; ++trip)
+    {
+        if (batch->Status[trip] == TractionStatus_Arrived)
+        {
+            stats->Coal += batch->Coal[trip];
+            stats->Water += batch->Water[trip];
+        }
+    }
+
+    stats->Seconds = std::chrono::duration<f64>(endTime - startTime).count();
+    stats->TripsPerSecond = (stats->Seconds > 0.0) ? (tripCount / stats->Seconds) : 0.0;
+
+    EndTemporaryMemory(tempMem);
+    return true;
+}
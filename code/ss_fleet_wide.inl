@@ -0,0 +1,163 @@
+// NOTE: Wide version of the trip step. ss_fleet.cpp includes this once per
+// wide type with WIDE and WIDE_FUNCTION defined, inside the matching target
+// region, and once with f64x1 for the scalar path. Each lane is one trip; its state lives in FleetLanes columns and is
+// loaded, stepped and stored back every Dt. Lanes whose trip ends are refilled
+// with the next trip of the chunk right away, so the block stays full until
+// the chunk runs dry. Driver modes are computed for all lanes and blended
+// with Select; the formulas are those of ss_traction_formulas.inl and
+// ss_boiler_formulas.inl that the scalar trip calls.
+
+internal void
+WIDE_FUNCTION(RunFleetChunk)(FleetWork *work, FleetLanes *lanes, u32 first, u32 onePastLast)
+{
+    TractionSpec *spec = work->Spec;
+    const u32 width = WIDE::Width;
+    Assert(width <= FLEET_MAX_WIDTH);
+
+    lanes->NextTrip = first;
+    lanes->OnePastLastTrip = onePastLast;
+    lanes->Active = 0;
+    for (u32 lane = 0; lane < width; ++lane)
+    {
+        StartFleetLane(work, lanes, lane);
+    }
+
+    f64 dt = spec->Dt;
+    f64 steamHeat = spec->SteamEnthalpy - spec->FeedT;
+    f64 firingScale = (TRACTION_FIRING_LEVELS - 1) / (spec->UMax - spec->UIdle);
+    f64 lag = Minimum(dt / spec->FiringLag, 1.0);
+
+    WIDE zero = WIDE::Set(0.0);
+    WIDE one = WIDE::Set(1.0);
+    WIDE UMax = WIDE::Set(spec->UMax);
+    WIDE UIdle = WIDE::Set(spec->UIdle);
+    WIDE maxTime = WIDE::Set(spec->MaxTime);
+
+    while (lanes->Active)
+    {
+        // редкие события по дорожкам: переход на следующий участок, опоздание
+        WIDE position = WIDE::Load(lanes->Position);
+        u32 crossed = lanes->Active & ~GetMaskBits(GreaterThan(WIDE::Load(lanes->SectionEnd), position));
+        while (crossed)
+        {
+            u32 lane = FindLeastSignificantSetBit(crossed);
+            crossed &= crossed - 1;
+            AdvanceFleetLane(lanes, lane);
+        }
+
+        u32 late = lanes->Active & ~GetMaskBits(GreaterThan(maxTime, WIDE::Load(lanes->Time)));
+        while (late)
+        {
+            u32 lane = FindLeastSignificantSetBit(late);
+            late &= late - 1;
+            FinishFleetLane(work, lanes, lane, TractionStatus_TimeOut);
+        }
+        if (!lanes->Active)
+        {
+            break;
+        }
+
+        WIDE V = WIDE::Load(lanes->V);
+        WIDE U = WIDE::Load(lanes->U);
+        position = WIDE::Load(lanes->Position);
+        WIDE apf = WIDE::Load(lanes->AccelerationPerForce);
+
+        // сопротивление поезда, кг
+        WIDE speed = V * 3.6;
+        WIDE W = GetTractionResistance(spec, WIDE::Load(lanes->Mass), speed, WIDE::Load(lanes->Wi));
+
+        // пар при текущей форсировке и скорости, кг/час
+        // NOTE: Hat weights max(0, 1 - |x - level|) give the same linear
+        // interpolation as the scalar table lookup without a per-lane gather.
+        WIDE x = LimitF((U - spec->UIdle) * firingScale, 0.0, TRACTION_FIRING_LEVELS - 1);
+        WIDE Q = zero;
+        WIDE Bh = zero;
+        for (u32 level = 0; level < TRACTION_FIRING_LEVELS; ++level)
+        {
+            WIDE d = x - (f64)level;
+            WIDE weight = Max(one - Max(d, -d), zero);
+            Q = Q + weight * WIDE::Load(lanes->Q[level]);
+            Bh = Bh + weight * WIDE::Load(lanes->Bh[level]);
+        }
+
+        WIDE Q4 = WIDE::Load(lanes->Q4);
+        WIDE Q4Speed = WIDE::Load(lanes->Q4Speed);
+        WIDE dSpeed = speed - Q4Speed;
+        auto refresh = GreaterThan(Max(dSpeed, -dSpeed), TRACTION_Q4_SPEED_STEP);
+        if (GetMaskBits(refresh) & lanes->Active)
+        {
+            WIDE speedTerm = Select(GreaterThan(speed, 0.0), Pow(Max(speed, WIDE::Set(1e-6)), 0.7), zero);
+            WIDE fresh = GetQ4(WIDE::Load(lanes->PhiH0), speedTerm, WIDE::Set(work->Q4T));
+            Q4 = Select(refresh, fresh, Q4);
+            Q4Speed = Select(refresh, speed, Q4Speed);
+        }
+        WIDE steamRate = WIDE::Load(lanes->SteamRate);
+        WIDE D = GetTractionSteamFlow(Q, Q4, steamHeat);
+
+        WIDE steamForce = GetTractionSteamForce(D, steamRate, speed);
+        WIDE maxForce = Min(WIDE::Load(lanes->StartForce), steamForce);
+
+        // ограничение участка и тормозные кривые следующих участков
+        WIDE allowed2 = Min(WIDE::Load(lanes->Limit2), WIDE::Load(lanes->Envelope) - (2.0 * spec->Brake) * position);
+        WIDE allowed = SquareRoot(Max(allowed2, zero));
+
+        auto over = GreaterThan(V, allowed);
+        auto under = GreaterThan(allowed - TRACTION_HOLD_BAND, V);
+
+        WIDE aBrake = GetTractionBrakeAcceleration(spec, W, apf);
+        WIDE aPower = GetTractionAcceleration(maxForce, W, apf);
+        WIDE FHold = GetTractionHoldForce(W, maxForce);
+        WIDE aHold = GetTractionHoldAcceleration(FHold, W, apf);
+
+        WIDE F = Select(over, zero, Select(under, maxForce, FHold));
+        WIDE a = Select(over, aBrake, Select(under, aPower, aHold));
+
+        // NOTE: A stalled lane keeps its accumulators from before the step.
+        auto stall = AndNot(under, GreaterThan(V, 0.0) | GreaterThan(aPower, 0.0));
+        u32 stalled = lanes->Active & GetMaskBits(stall);
+
+        WIDE steam = WIDE::Load(lanes->Steam);
+        WIDE fuel = WIDE::Load(lanes->Fuel);
+        WIDE time = WIDE::Load(lanes->Time);
+        WIDE maxSpeed = WIDE::Load(lanes->MaxSpeed);
+        steam = Select(stall, steam, steam + GetTractionStepSteam(F, speed, steamRate, dt));
+        fuel = Select(stall, fuel, fuel + GetTractionStepFuel(Bh, dt));
+
+        WIDE targetU = Select(GreaterThan(F, 0.0), UMax, UIdle);
+        U = GetTractionFiringStep(U, targetU, lag);
+
+        V = Max(V + a * dt, zero);
+        position = position + V * dt;
+        time = Select(stall, time, time + dt);
+        maxSpeed = Select(stall, maxSpeed, Max(maxSpeed, V * 3.6));
+
+        WIDE::Store(lanes->V, V);
+        WIDE::Store(lanes->U, U);
+        WIDE::Store(lanes->Position, position);
+        WIDE::Store(lanes->Steam, steam);
+        WIDE::Store(lanes->Fuel, fuel);
+        WIDE::Store(lanes->Time, time);
+        WIDE::Store(lanes->MaxSpeed, maxSpeed);
+        WIDE::Store(lanes->Q4, Q4);
+        WIDE::Store(lanes->Q4Speed, Q4Speed);
+
+        u32 arrived = lanes->Active & ~stalled & ~GetMaskBits(GreaterThan(WIDE::Load(lanes->Length), position));
+        for (u32 stepped = lanes->Active & ~stalled; stepped; stepped &= stepped - 1)
+        {
+            ++lanes->Steps;
+        }
+
+        while (stalled)
+        {
+            u32 lane = FindLeastSignificantSetBit(stalled);
+            stalled &= stalled - 1;
+            FinishFleetLane(work, lanes, lane, TractionStatus_Stalled);
+        }
+        while (arrived)
+        {
+            u32 lane = FindLeastSignificantSetBit(arrived);
+            arrived &= arrived - 1;
+            FinishFleetLane(work, lanes, lane, TractionStatus_Arrived);
+        }
+    }
+}
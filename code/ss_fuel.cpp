@@ -0,0 +1,146 @@
+// Библиотека топлив: проверка и поиск по отображенному файлу; сам файл
+// собирает из текстового каталога ss_fuelc. Все, что зависит только от
+// топлива (beta0, состав газов, L0, Gbc, Gbb), считается при сборке, так что
+// расчет по каталогу берет записи из файла как есть.
+
+#define FUEL_REPORT_MAX_ROWS 32 // топлив в отчете Calculate, остальные только считаются
+
+struct FuelLibrary
+{
+    FuelLibraryHeader *Header;
+    FuelRecord *Records; // по возрастанию Id
+    u32 *NameIndex;      // номера записей по возрастанию Name
+    u32 RecordCount;
+};
+
+inline b32
+IsFuelNameTerminated(FuelRecord *record)
+{
+    b32 result = (memchr(record->Name, 0, sizeof(record->Name)) != 0);
+    return result;
+}
+
+// NOTE: The file comes from disk, so everything used by lookups is checked
+// here once: sizes, offsets, ordering of ids and the name index. Both
+// orders must be strict, since the lookups binary-search them.
+internal b32
+OpenFuelLibrary(void *memory, u64 size, FuelLibrary *library)
+{
+    ZeroStruct(*library);
+
+    auto header = (FuelLibraryHeader *)memory;
+    if (!memory || (size < sizeof(FuelLibraryHeader)) ||
+        (header->Magic != FUEL_LIBRARY_MAGIC) ||
+        (header->HeaderSize != sizeof(FuelLibraryHeader)) ||
+        (header->RecordSize != sizeof(FuelRecord)) ||
+        (header->FileSize > size) ||
+        (header->RecordOffset % alignof(FuelRecord)) ||
+        (header->RecordOffset < sizeof(FuelLibraryHeader)) ||
+        (header->RecordOffset + (u64)header->RecordCount * sizeof(FuelRecord) > header->NameIndexOffset) ||
+        (header->NameIndexOffset % sizeof(u32)) ||
+        (header->NameIndexOffset + (u64)header->RecordCount * sizeof(u32) > header->FileSize))
+    {
+        return false;
+    }
+
+    auto records = (FuelRecord *)((u8 *)memory + header->RecordOffset);
+    auto nameIndex = (u32 *)((u8 *)memory + header->NameIndexOffset);
+    for (u32 index = 0; index < header->RecordCount; ++index)
+    {
+        if (!IsFuelNameTerminated(records + index) ||
+            ((index > 0) && (records[index - 1].Id >= records[index].Id)) ||
+            (nameIndex[index] >= header->RecordCount))
+        {
+            return false;
+        }
+    }
+
+    // NOTE: Only after every name is known to be terminated.
+    for (u32 index = 1; index < header->RecordCount; ++index)
+    {
+        if (strcmp(records[nameIndex[index - 1]].Name, records[nameIndex[index]].Name) >= 0)
+        {
+            return false;
+        }
+    }
+
+    library->Header = header;
+    library->Records = records;
+    library->NameIndex = nameIndex;
+    library->RecordCount = header->RecordCount;
+    return true;
+}
+
+internal FuelRecord *
+FindFuelById(FuelLibrary *library, u32 id)
+{
+    u32 first = 0;
+    u32 onePastLast = library->RecordCount;
+    while (first < onePastLast)
+    {
+        u32 middle = first + (onePastLast - first) / 2;
+        FuelRecord *record = library->Records + middle;
+        if (record->Id == id)
+        {
+            return record;
+        }
+
+        if (record->Id < id)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            onePastLast = middle;
+        }
+    }
+    return 0;
+}
+
+// Имена сравниваются побайтово (strcmp), без учета языка
+internal FuelRecord *
+FindFuelByName(FuelLibrary *library, const char *name)
+{
+    u32 first = 0;
+    u32 onePastLast = library->RecordCount;
+    while (first < onePastLast)
+    {
+        u32 middle = first + (onePastLast - first) / 2;
+        FuelRecord *record = library->Records + library->NameIndex[middle];
+        int order = strcmp(record->Name, name);
+        if (order == 0)
+        {
+            return record;
+        }
+
+        if (order < 0)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            onePastLast = middle;
+        }
+    }
+    return 0;
+}
+
+// Топливо расчета: по имени, если оно не пустое, иначе по Id (0 - не задано).
+// 0 - нет библиотеки или такой записи.
+internal FuelRecord *
+FindFuel(FuelLibrary *library, u32 id, const char *name)
+{
+    FuelRecord *result = 0;
+    if (library)
+    {
+        if (name && name[0])
+        {
+            result = FindFuelByName(library, name);
+        }
+        else if (id)
+        {
+            result = FindFuelById(library, id);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,452 @@
+// Сборка библиотеки топлив: текстовый каталог в двоичный файл, который
+// платформа отображает в память (-fuels). Отдельная программа: включает код
+// расчета целиком (unity build).
+//
+//   ss_fuelc fuels.txt fuels.ssf
+//
+// Текстовый каталог: одна секция на топливо.
+//
+//   # комментарий
+//   [12] Каменный уголь Д
+//   C 58.7
+//   H 4.2
+//   ...
+//
+// Обязательны C, H и K (теплопроизводительность, кал/кг) и alpha; S, O, N, W,
+// A (состав на рабочую массу, %) и CO - 0, если не заданы. CO2, O2 и N2 -
+// анализ газов; если его нет, состав газов считается по alpha, как в
+// GetCO2/GetO2/GetN2.
+//
+// После сборки файл открывается так же, как его откроет расчет, и каждое
+// топливо ищется по Id и по имени.
+
+#include "ss.cpp"
+
+#include <stdlib.h>
+
+internal FuelConstants
+GetFuelConstants(Fuel fuel)
+{
+    FuelConstants result = {};
+    result.L0 = GetL0(fuel);
+    result.Gbc = GetGbc(fuel);
+    result.Gbb = GetGbb(fuel);
+    return result;
+}
+
+enum fuel_source_field
+{
+    FuelSourceField_C,
+    FuelSourceField_H,
+    FuelSourceField_S,
+    FuelSourceField_O,
+    FuelSourceField_N,
+    FuelSourceField_W,
+    FuelSourceField_A,
+    FuelSourceField_CO,
+    FuelSourceField_CO2,
+    FuelSourceField_O2,
+    FuelSourceField_N2,
+    FuelSourceField_K,
+    FuelSourceField_alpha,
+
+    FuelSourceField_Count,
+};
+
+struct FuelCompileResult
+{
+    void *Image; // готовый файл библиотеки
+    u64 Size;
+    u32 RecordCount;
+
+    // первая ошибка в каталоге, если Image == 0
+    u32 ErrorLine;
+    const char *Error;
+};
+
+struct FuelSourceEntry
+{
+    u32 Line; // строка заголовка секции
+    b32 Has[FuelSourceField_Count];
+    f64 Values[FuelSourceField_Count];
+};
+
+inline char *
+SkipFuelSourceSpaces(char *at)
+{
+    while ((*at == ' ') || (*at == '\t') || (*at == '\r'))
+    {
+        ++at;
+    }
+    return at;
+}
+
+// Переводит разобранную секцию в запись; 0 - все в порядке, иначе текст ошибки
+internal const char *
+FinishFuelRecord(FuelSourceEntry *entry, FuelRecord *record)
+{
+    auto has = entry->Has;
+    auto values = entry->Values;
+    if (!has[FuelSourceField_C] || !has[FuelSourceField_H] || !has[FuelSourceField_K] || !has[FuelSourceField_alpha])
+    {
+        return "C, H, K and alpha are required";
+    }
+
+    Fuel fuel = {};
+    fuel.C = values[FuelSourceField_C];
+    fuel.H = values[FuelSourceField_H];
+    fuel.S = values[FuelSourceField_S];
+    fuel.O = values[FuelSourceField_O];
+    fuel.N = values[FuelSourceField_N];
+    fuel.W = values[FuelSourceField_W];
+    fuel.A = values[FuelSourceField_A];
+    fuel.CO = values[FuelSourceField_CO];
+    fuel.K = values[FuelSourceField_K];
+    fuel.alpha = values[FuelSourceField_alpha];
+
+    f64 total = fuel.C + fuel.H + fuel.S + fuel.O + fuel.N + fuel.W + fuel.A;
+    if ((fuel.C <= 0.0) || (fabs(total - 100.0) > 0.5))
+    {
+        return "C + H + S + O + N + W + A must be 100%";
+    }
+    if (fuel.alpha <= 1.0)
+    {
+        return "alpha must be above 1";
+    }
+
+    GetBeta0(fuel);
+    if (has[FuelSourceField_CO2])
+    {
+        fuel.CO2 = values[FuelSourceField_CO2];
+    }
+    else
+    {
+        GetCO2(fuel);
+    }
+    if (has[FuelSourceField_O2])
+    {
+        fuel.O2 = values[FuelSourceField_O2];
+    }
+    else
+    {
+        GetO2(fuel);
+    }
+    if (has[FuelSourceField_N2])
+    {
+        fuel.N2 = values[FuelSourceField_N2];
+    }
+    else
+    {
+        GetN2(fuel);
+    }
+    if (fuel.CO2 + fuel.CO <= 0.0)
+    {
+        return "CO2 + CO must be positive";
+    }
+
+    record->Composition = fuel;
+    record->Constants = GetFuelConstants(fuel);
+    return 0;
+}
+
+// Собирает библиотеку из текста source (с нулем в конце; текст меняется при
+// разборе). Образ файла кладется в arena.
+internal FuelCompileResult
+CompileFuelLibrary(MemoryArena *arena, char *source)
+{
+    FuelCompileResult result = {};
+
+    // число секций определяет размер файла
+    u32 recordCount = 0;
+    for (char *at = source; *at; ++at)
+    {
+        if ((*at == '[') && ((at == source) || (at[-1] == '\n')))
+        {
+            ++recordCount;
+        }
+    }
+
+    u64 recordOffset = sizeof(FuelLibraryHeader);
+    u64 nameIndexOffset = recordOffset + (u64)recordCount * sizeof(FuelRecord);
+    u64 size = nameIndexOffset + (u64)recordCount * sizeof(u32);
+    auto image = (u8 *)PushSize(arena, size, alignof(FuelRecord));
+    if (!image)
+    {
+        result.Error = "out of memory";
+        return result;
+    }
+    ZeroSize(size, image);
+
+    auto records = (FuelRecord *)(image + recordOffset);
+    auto nameIndex = (u32 *)(image + nameIndexOffset);
+
+    const char *fieldNames[FuelSourceField_Count] = {"C", "H", "S", "O", "N", "W", "A",
+                                                     "CO", "CO2", "O2", "N2", "K", "alpha"};
+
+    FuelSourceEntry entry = {};
+    u32 recordIndex = 0;
+    u32 lineNumber = 0;
+    const char *error = 0;
+    char *line = source;
+    while (line && !error)
+    {
+        ++lineNumber;
+        char *nextLine = strchr(line, '\n');
+        if (nextLine)
+        {
+            *nextLine++ = 0;
+        }
+
+        char *at = SkipFuelSourceSpaces(line);
+        if ((*at == 0) || (*at == '#'))
+        {
+            // пустая строка или комментарий
+        }
+        else if ((*at == '[') && (at == line))
+        {
+            if (recordIndex && (error = FinishFuelRecord(&entry, records + recordIndex - 1)))
+            {
+                lineNumber = entry.Line;
+                break;
+            }
+
+            FuelRecord *record = records + recordIndex++;
+            ZeroStruct(entry);
+            entry.Line = lineNumber;
+
+            char *end;
+            unsigned long id = strtoul(at + 1, &end, 10);
+            if ((end == at + 1) || (*end != ']') || (id > 0xFFFFFFFF))
+            {
+                error = "expected [id] name";
+                break;
+            }
+            record->Id = (u32)id;
+
+            char *name = SkipFuelSourceSpaces(end + 1);
+            size_t nameLength = strlen(name);
+            while (nameLength && ((name[nameLength - 1] == ' ') || (name[nameLength - 1] == '\t') ||
+                                  (name[nameLength - 1] == '\r')))
+            {
+                --nameLength;
+            }
+            if ((nameLength == 0) || (nameLength >= sizeof(record->Name)))
+            {
+                error = "fuel name is empty or too long";
+                break;
+            }
+            memcpy(record->Name, name, nameLength);
+        }
+        else if (recordIndex == 0)
+        {
+            error = "value outside of a [id] name section";
+        }
+        else
+        {
+            char *key = at;
+            while (*at && (*at != ' ') && (*at != '\t'))
+            {
+                ++at;
+            }
+            char *keyEnd = at;
+
+            char *end;
+            f64 value = strtod(at, &end);
+            if ((end == at) || (*SkipFuelSourceSpaces(end) != 0))
+            {
+                error = "expected key value";
+                break;
+            }
+            *keyEnd = 0;
+
+            u32 field = 0;
+            while ((field < FuelSourceField_Count) && (strcmp(key, fieldNames[field]) != 0))
+            {
+                ++field;
+            }
+            if (field == FuelSourceField_Count)
+            {
+                error = "unknown key";
+            }
+            else if (entry.Has[field])
+            {
+                error = "duplicate key";
+            }
+            else
+            {
+                entry.Has[field] = true;
+                entry.Values[field] = value;
+            }
+        }
+
+        line = nextLine;
+    }
+
+    if (!error && recordIndex && (error = FinishFuelRecord(&entry, records + recordIndex - 1)))
+    {
+        lineNumber = entry.Line;
+    }
+
+    if (!error)
+    {
+        // NOTE: Insertion sorts, a catalogue is hundreds of fuels.
+        for (u32 index = 1; index < recordCount; ++index)
+        {
+            FuelRecord record = records[index];
+            u32 dest = index;
+            while (dest && (records[dest - 1].Id > record.Id))
+            {
+                records[dest] = records[dest - 1];
+                --dest;
+            }
+            records[dest] = record;
+        }
+
+        for (u32 index = 0; index < recordCount; ++index)
+        {
+            u32 dest = index;
+            while (dest && (strcmp(records[nameIndex[dest - 1]].Name, records[index].Name) > 0))
+            {
+                nameIndex[dest] = nameIndex[dest - 1];
+                --dest;
+            }
+            nameIndex[dest] = index;
+        }
+
+        for (u32 index = 1; !error && (index < recordCount); ++index)
+        {
+            if (records[index - 1].Id == records[index].Id)
+            {
+                error = "duplicate id";
+            }
+            else if (strcmp(records[nameIndex[index - 1]].Name, records[nameIndex[index]].Name) == 0)
+            {
+                error = "duplicate name";
+            }
+        }
+        lineNumber = 0;
+    }
+
+    if (error)
+    {
+        PopTo(arena, image);
+        result.ErrorLine = lineNumber;
+        result.Error = error;
+        return result;
+    }
+
+    auto header = (FuelLibraryHeader *)image;
+    header->Magic = FUEL_LIBRARY_MAGIC;
+    header->HeaderSize = sizeof(FuelLibraryHeader);
+    header->RecordSize = sizeof(FuelRecord);
+    header->RecordCount = recordCount;
+    header->RecordOffset = recordOffset;
+    header->NameIndexOffset = nameIndexOffset;
+    header->FileSize = size;
+
+    result.Image = image;
+    result.Size = size;
+    result.RecordCount = recordCount;
+    return result;
+}
+
+// Читает файл целиком в arena, с нулем в конце
+internal char *
+ReadFuelSource(MemoryArena *arena, const char *fileName)
+{
+    char *result = 0;
+
+    FILE *file = fopen(fileName, "rb");
+    if (file)
+    {
+        if (fseek(file, 0, SEEK_END) == 0)
+        {
+            long size = ftell(file);
+            if ((size >= 0) && (fseek(file, 0, SEEK_SET) == 0))
+            {
+                result = (char *)PushSize(arena, (u64)size + 1);
+                if (result && (fread(result, 1, (size_t)size, file) == (size_t)size))
+                {
+                    result[size] = 0;
+                }
+                else
+                {
+                    result = 0;
+                }
+            }
+        }
+        fclose(file);
+    }
+
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: ss_fuelc fuels.txt fuels.ssf\n");
+        return 2;
+    }
+
+    const char *sourceFileName = argv[1];
+    const char *libraryFileName = argv[2];
+
+    u64 memorySize = Megabytes(64);
+    MemoryArena arena = {};
+    InitializeArena(&arena, memorySize, malloc(memorySize));
+
+    char *source = ReadFuelSource(&arena, sourceFileName);
+    if (!source)
+    {
+        fprintf(stderr, "Unable to read %s\n", sourceFileName);
+        return 1;
+    }
+
+    auto compiled = CompileFuelLibrary(&arena, source);
+    if (!compiled.Image)
+    {
+        if (compiled.ErrorLine)
+        {
+            fprintf(stderr, "%s:%u: %s\n", sourceFileName, compiled.ErrorLine, compiled.Error);
+        }
+        else
+        {
+            fprintf(stderr, "%s: %s\n", sourceFileName, compiled.Error);
+        }
+        return 1;
+    }
+
+    FuelLibrary library;
+    b32 valid = OpenFuelLibrary(compiled.Image, compiled.Size, &library);
+    for (u32 index = 0; valid && (index < library.RecordCount); ++index)
+    {
+        FuelRecord *record = library.Records + index;
+        valid = (FindFuelById(&library, record->Id) == record) && (FindFuelByName(&library, record->Name) == record);
+    }
+    if (!valid)
+    {
+        fprintf(stderr, "%s: the compiled library does not read back\n", sourceFileName);
+        return 1;
+    }
+
+    FILE *file = fopen(libraryFileName, "wb");
+    if (!file || (fwrite(compiled.Image, 1, (size_t)compiled.Size, file) != (size_t)compiled.Size) ||
+        (fclose(file) != 0))
+    {
+        fprintf(stderr, "Unable to write %s\n", libraryFileName);
+        return 1;
+    }
+
+    printf("%5s %8s %8s %8s %8s %8s %8s  %s\n", "id", "beta0", "CO2", "O2", "L0", "Gbc", "Gbb", "name");
+    for (u32 index = 0; index < library.RecordCount; ++index)
+    {
+        FuelRecord *record = library.Records + index;
+        printf("%5u %8.4lf %8.3lf %8.3lf %8.4lf %8.4lf %8.2e  %s\n", record->Id, record->Composition.beta0,
+               record->Composition.CO2, record->Composition.O2, record->Constants.L0, record->Constants.Gbc,
+               record->Constants.Gbb, record->Name);
+    }
+    printf("%u fuels, %llu bytes -> %s\n", library.RecordCount, (unsigned long long)compiled.Size, libraryFileName);
+
+    return 0;
+}
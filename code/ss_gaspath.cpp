@@ -0,0 +1,329 @@
+// Газовый тракт котла с пароперегревателем. Газы из топки (T2) идут
+// параллельно по дымогарным трубам (доля 1 - beta) и по жаровым трубам
+// (доля beta); в жаровых трубах за участком Lz1 газ обтекает элементы
+// перегревателя и отдает тепло и воде, и пару (GetKi). На выходе потоки
+// смешиваются в дымовой коробке.
+//
+// Доля beta - из равенства потерь напора (GetBeta), а они зависят от
+// удельного объема газов, то есть от температур в трубах, которые в свою
+// очередь зависят от beta. Неподвижная точка beta = G(beta) ищется
+// итерацией с ускорением секущими (Андерсон с глубиной 1): первый шаг -
+// простая подстановка с beta из GetBeta с принятыми отношениями температур,
+// дальше - секущая по невязке G(beta) - beta. Обычно 3-5 итераций.
+//
+// Все строки решаются вместе: на каждой итерации три группы труб всех
+// строк считаются векторным CalculateFireTubeProfile. Сошедшиеся строки
+// больше не меняют beta, так что их результат от итераций других строк не
+// зависит. Рабочие массивы - во временной памяти arena, куча не трогается.
+
+#include <chrono>
+
+#define GAS_PATH_MIN_BETA 1e-3
+
+// Три группы труб, через которые идет газ
+struct GasPathTubes
+{
+    FireTubeProfile Smoke; // дымогарные трубы
+    FireTubeProfile Flue1; // жаровые трубы до перегревателя
+    FireTubeProfile Flue2; // жаровые трубы в области перегревателя
+};
+
+struct GasPathRow
+{
+    f64 Beta;
+    f64 PrevBeta;
+    f64 PrevResidual;
+    u32 Iterations;
+    u8 Status;
+    b32 Active;
+};
+
+// Столбцы одной группы труб на count строк; геометрия заполняется отдельно
+internal b32
+PushGasPathGroup(MemoryArena *arena, FireTubeProfile *group, GasPathBatch *batch, f64 *beta)
+{
+    u32 count = batch->Count;
+    BoilerBatchOutput *front = batch->Output;
+
+    group->T2 = front->T2;
+    group->M = front->M;
+    group->N = front->N;
+    group->L0 = front->L0;
+    group->BhFact = front->BhFact;
+    group->Beta = beta;
+    group->tk = batch->tk;
+
+    group->DOut = PushArray(arena, count, f64);
+    group->DIn = PushArray(arena, count, f64);
+    group->Ld = PushArray(arena, count, f64);
+    group->Nd = PushArray(arena, count, u16);
+    group->SegmentCount = PushArray(arena, count, u16);
+    group->T3 = PushArray(arena, count, f64);
+    group->Q = PushArray(arena, count, f64);
+    group->K = PushArray(arena, count, f64);
+
+    b32 result = (group->K != 0);
+    return result;
+}
+
+// Ki перегревателя при доле газов beta через жаровые трубы
+internal inline f64
+GetGasPathKi(Boiler *boiler, f64 beta, f64 BhFact, f64 K)
+{
+    // NOTE: BhFact already includes u.
+    Fuel fuel = {};
+    fuel.K = K;
+    fuel.u = 1.0;
+    auto rz2 = GetAnnulusHydraulicRadius(boiler->Dz2, boiler->Di);
+    auto omegaZ2 = GetAnnulusSquare(boiler->Dz2, boiler->Di) * boiler->Nz;
+    return GetKi(beta, BhFact, rz2, omegaZ2, fuel);
+}
+
+// G(beta): beta из равенства потерь напора при температурах, которые дал
+// расчет групп труб строки index
+internal inline f64
+GetGasPathBeta(Boiler *boiler, GasPathTubes *tubes, u32 index)
+{
+    auto T2 = tubes->Smoke.T2[index];
+    auto TabsD = GetTabs(T2, tubes->Smoke.T3[index]);
+    auto TabsZ1 = GetTabs(T2, tubes->Flue1.T3[index]);
+    auto TabsZ2 = GetTabs(tubes->Flue1.T3[index], tubes->Flue2.T3[index]);
+
+    auto rd = GetHydraulicRadius(boiler->Dd);
+    auto sqrD = GetPipeSquare(boiler->Dd) * boiler->Nd;
+    auto rz1 = GetHydraulicRadius(boiler->Dz1);
+    auto sqrZ1 = GetPipeSquare(boiler->Dz1) * boiler->Nz;
+    auto rz2 = GetAnnulusHydraulicRadius(boiler->Dz2, boiler->Di);
+    auto sqrZ2 = GetAnnulusSquare(boiler->Dz2, boiler->Di) * boiler->Nz;
+
+    return GetBeta(boiler->Ld, rd, sqrD, boiler->Lz1, rz1, sqrZ1, boiler->Lz2, rz2, sqrZ2, TabsZ1 / TabsD,
+                   TabsZ2 / TabsD);
+}
+
+// Пересчитывает три группы труб всех строк при текущих beta
+internal void
+EvaluateGasPath(GasPathBatch *batch, GasPathTubes *tubes, GasPathRow *rows, f64 *flueBypass)
+{
+    u32 count = batch->Count;
+    for (u32 index = 0; index < count; ++index)
+    {
+        Boiler *boiler = batch->Boilers + index;
+        Fuel *fuel = GetBatchFuel(batch->Input, index);
+        f64 beta = rows[index].Beta;
+
+        tubes->Smoke.Beta[index] = beta;
+        flueBypass[index] = 1.0 - beta;
+        tubes->Flue2.SinkKH[index] = GetGasPathKi(boiler, beta, batch->Output->BhFact[index], fuel->K) * boiler->Hi;
+    }
+
+    CalculateFireTubeProfile(&tubes->Smoke, count);
+    CalculateFireTubeProfile(&tubes->Flue1, count);
+    CalculateFireTubeProfile(&tubes->Flue2, count);
+}
+
+internal GasPathStats
+SolveGasPathBatch(MemoryArena *arena, GasPathBatch *batch)
+{
+    TIMED_FUNCTION();
+
+    GasPathStats stats = {};
+    u32 count = batch->Count;
+    stats.RowCount = count;
+
+    auto startTime = std::chrono::steady_clock::now();
+    auto tempMem = BeginTemporaryMemory(arena);
+
+    f64 tolerance = (batch->Tolerance > 0.0) ? batch->Tolerance : GAS_PATH_DEFAULT_TOLERANCE;
+    u32 maxIterations = batch->MaxIterations ? batch->MaxIterations : GAS_PATH_DEFAULT_MAX_ITERATIONS;
+
+    GasPathTubes tubes = {};
+    auto rows = PushArray(arena, count, GasPathRow);
+    auto smokeBypass = PushArray(arena, count, f64);
+    auto flueBypass = PushArray(arena, count, f64);
+    auto alpha = PushArray(arena, count, f64);
+    b32 haveMemory = rows && smokeBypass && flueBypass && alpha &&
+                     PushGasPathGroup(arena, &tubes.Smoke, batch, smokeBypass) &&
+                     PushGasPathGroup(arena, &tubes.Flue1, batch, flueBypass) &&
+                     PushGasPathGroup(arena, &tubes.Flue2, batch, flueBypass);
+    if (haveMemory)
+    {
+        tubes.Flue2.DElement = PushArray(arena, count, f64);
+        tubes.Flue2.SinkKH = PushArray(arena, count, f64);
+        tubes.Flue2.QSink = PushArray(arena, count, f64);
+        haveMemory = (tubes.Flue2.QSink != 0);
+    }
+    if (!haveMemory)
+    {
+        EndTemporaryMemory(tempMem);
+        stats.NoConvergence = count;
+        return stats;
+    }
+
+    // газ во второй части жаровых труб приходит из первой
+    tubes.Smoke.Alpha = tubes.Flue1.Alpha = tubes.Flue2.Alpha = alpha;
+    tubes.Flue2.T2 = tubes.Flue1.T3;
+    tubes.Flue2.SinkT = batch->ti;
+
+    for (u32 index = 0; index < count; ++index)
+    {
+        Boiler *boiler = batch->Boilers + index;
+        alpha[index] = GetBatchFuel(batch->Input, index)->alpha;
+
+        tubes.Smoke.DOut[index] = boiler->Dd.DOut;
+        tubes.Smoke.DIn[index] = boiler->Dd.DIn;
+        tubes.Smoke.Ld[index] = boiler->Ld;
+        tubes.Smoke.Nd[index] = boiler->Nd;
+
+        tubes.Flue1.DOut[index] = boiler->Dz1.DOut;
+        tubes.Flue1.DIn[index] = boiler->Dz1.DIn;
+        tubes.Flue1.Ld[index] = boiler->Lz1;
+        tubes.Flue1.Nd[index] = boiler->Nz;
+
+        tubes.Flue2.DOut[index] = boiler->Dz2.DOut;
+        tubes.Flue2.DIn[index] = boiler->Dz2.DIn;
+        tubes.Flue2.Ld[index] = boiler->Lz2;
+        tubes.Flue2.Nd[index] = boiler->Nz;
+        tubes.Flue2.DElement[index] = boiler->Di.DOut;
+
+        // начальная точка - принятые в GetBeta отношения температур
+        GasPathRow *row = rows + index;
+        ZeroStruct(*row);
+        auto rd = GetHydraulicRadius(boiler->Dd);
+        auto rz1 = GetHydraulicRadius(boiler->Dz1);
+        auto rz2 = GetAnnulusHydraulicRadius(boiler->Dz2, boiler->Di);
+        row->Beta = GetBeta(boiler->Ld, rd, GetPipeSquare(boiler->Dd) * boiler->Nd, boiler->Lz1, rz1,
+                            GetPipeSquare(boiler->Dz1) * boiler->Nz, boiler->Lz2, rz2,
+                            GetAnnulusSquare(boiler->Dz2, boiler->Di) * boiler->Nz);
+        row->Active = (row->Beta > GAS_PATH_MIN_BETA) && (row->Beta < 1.0 - GAS_PATH_MIN_BETA);
+        row->Status = GasPathStatus_NoConvergence;
+        if (!row->Active)
+        {
+            row->Beta = LimitF(row->Beta, GAS_PATH_MIN_BETA, 1.0 - GAS_PATH_MIN_BETA);
+        }
+
+        smokeBypass[index] = row->Beta;
+        flueBypass[index] = 1.0 - row->Beta;
+        Fuel *fuel = GetBatchFuel(batch->Input, index);
+        tubes.Flue2.SinkKH[index] = GetGasPathKi(boiler, row->Beta, batch->Output->BhFact[index], fuel->K) * boiler->Hi;
+    }
+
+    // NOTE: Segment counts are fixed at the starting split so that G(beta)
+    // stays smooth for the secant steps.
+    ChooseFireTubeSegmentCounts(&tubes.Smoke, count, FIRE_TUBE_SEGMENT_NTU);
+    ChooseFireTubeSegmentCounts(&tubes.Flue1, count, FIRE_TUBE_SEGMENT_NTU);
+    CalculateFireTubeProfile(&tubes.Flue1, count);
+    ChooseFireTubeSegmentCounts(&tubes.Flue2, count, FIRE_TUBE_SEGMENT_NTU);
+
+    u32 activeCount = 0;
+    for (u32 index = 0; index < count; ++index)
+    {
+        activeCount += rows[index].Active;
+    }
+
+    EvaluateGasPath(batch, &tubes, rows, flueBypass);
+    stats.Evaluations += count;
+
+    u32 iteration = 0;
+    while (activeCount && (iteration < maxIterations))
+    {
+        ++iteration;
+
+        b32 moved = false;
+        for (u32 index = 0; index < count; ++index)
+        {
+            GasPathRow *row = rows + index;
+            if (!row->Active)
+            {
+                continue;
+            }
+
+            f64 G = GetGasPathBeta(batch->Boilers + index, &tubes, index);
+            f64 residual = G - row->Beta;
+            ++row->Iterations;
+
+            f64 next = G;
+            if (!((G > GAS_PATH_MIN_BETA) && (G < 1.0 - GAS_PATH_MIN_BETA)))
+            {
+                row->Active = false;
+            }
+            else if (fabs(residual) <= tolerance)
+            {
+                row->Status = GasPathStatus_Converged;
+                row->Active = false;
+            }
+            else if (row->Iterations > 1)
+            {
+                // секущая по невязке; если она вырождена или уводит из
+                // (0, 1) - простая подстановка
+                f64 slope = residual - row->PrevResidual;
+                if (slope != 0.0)
+                {
+                    f64 secant = row->Beta - residual * (row->Beta - row->PrevBeta) / slope;
+                    if ((secant > GAS_PATH_MIN_BETA) && (secant < 1.0 - GAS_PATH_MIN_BETA))
+                    {
+                        next = secant;
+                    }
+                }
+            }
+
+            if (!row->Active)
+            {
+                --activeCount;
+                continue;
+            }
+
+            row->PrevBeta = row->Beta;
+            row->PrevResidual = residual;
+            row->Beta = next;
+            moved = true;
+        }
+
+        // результат каждой строки - при ее последнем beta
+        if (moved)
+        {
+            EvaluateGasPath(batch, &tubes, rows, flueBypass);
+            stats.Evaluations += count;
+        }
+    }
+
+    for (u32 index = 0; index < count; ++index)
+    {
+        GasPathRow *row = rows + index;
+        BoilerBatchOutput *front = batch->Output;
+        auto M = front->M[index];
+        auto N = front->N[index];
+        auto beta = row->Beta;
+        auto T3d = tubes.Smoke.T3[index];
+        auto T3z = tubes.Flue2.T3[index];
+
+        // смешение потоков в дымовой коробке: M T + N T^2 сохраняется
+        auto Q = (1.0 - beta) * (M * T3d + N * T3d * T3d) + beta * (M * T3z + N * T3z * T3z);
+
+        batch->Beta[index] = beta;
+        batch->T3[index] = SolveQuadratic(N, M, -Q);
+        batch->T3d[index] = T3d;
+        batch->T3z[index] = T3z;
+        batch->Qi[index] = tubes.Flue2.QSink[index];
+        batch->Qw[index] = tubes.Smoke.Q[index] + tubes.Flue1.Q[index] + tubes.Flue2.Q[index] - tubes.Flue2.QSink[index];
+        batch->Ki[index] = GetGasPathKi(batch->Boilers + index, beta, front->BhFact[index],
+                                        GetBatchFuel(batch->Input, index)->K);
+        if (batch->Status)
+        {
+            batch->Status[index] = row->Status;
+        }
+        if (batch->Iterations)
+        {
+            batch->Iterations[index] = (u8)LimitI(row->Iterations, 0, 0xFF);
+        }
+
+        stats.Converged += (row->Status == GasPathStatus_Converged);
+        stats.NoConvergence += (row->Status == GasPathStatus_NoConvergence);
+    }
+
+    EndTemporaryMemory(tempMem);
+
+    auto endTime = std::chrono::steady_clock::now();
+    stats.Iterations = iteration;
+    stats.Seconds = std::chrono::duration<f64>(endTime - startTime).count();
+    return stats;
+}
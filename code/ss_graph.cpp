@@ -0,0 +1,302 @@
+// Граф зависимостей величин котла: та же цепочка, что в CalculateBoilerBatch
+// (скалярные формулы ss_boiler.cpp, результат бит в бит как при
+// SetSimdLevel(SimdLevel_Scalar)), но каждый узел пересчитывается, только
+// если изменился один из его входов. Если пересчитанный узел получил прежнее
+// значение, зависящие от него узлы не трогаются.
+
+#define BoilerNodeBit(node) (1ULL << BoilerNode_##node)
+
+// Прямые входы каждого узла
+global const u64 GlobalBoilerNodeInputs[BoilerNode_Count] = {
+    // входы графа
+    0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0,
+    0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+
+    // R
+    BoilerNodeBit(BottomLength) | BoilerNodeBit(BottomWidth),
+    // Ht
+    BoilerNodeBit(TopLengh) | BoilerNodeBit(TopWidth) | BoilerNodeBit(FrontHeight) | BoilerNodeBit(RearHeight),
+    // Hd
+    BoilerNodeBit(DOut) | BoilerNodeBit(Nd) | BoilerNodeBit(Ld),
+    // Bh
+    BoilerNodeBit(R) | BoilerNodeBit(U),
+    // BhFact
+    BoilerNodeBit(R) | BoilerNodeBit(U) | BoilerNodeBit(q22),
+    // L0
+    BoilerNodeBit(C) | BoilerNodeBit(H) | BoilerNodeBit(S) | BoilerNodeBit(O),
+    // HeatM
+    BoilerNodeBit(BhFact) | BoilerNodeBit(C) | BoilerNodeBit(H) | BoilerNodeBit(W) | BoilerNodeBit(CO) |
+        BoilerNodeBit(CO2),
+    // HeatN
+    BoilerNodeBit(BhFact) | BoilerNodeBit(C) | BoilerNodeBit(H) | BoilerNodeBit(W) | BoilerNodeBit(CO) |
+        BoilerNodeBit(CO2),
+    // Q0
+    BoilerNodeBit(Bh) | BoilerNodeBit(t) | BoilerNodeBit(K) | BoilerNodeBit(HeatM) | BoilerNodeBit(HeatN),
+    // Q21
+    BoilerNodeBit(BhFact) | BoilerNodeBit(C) | BoilerNodeBit(CO) | BoilerNodeBit(CO2),
+    // Q22
+    BoilerNodeBit(Q0) | BoilerNodeBit(q22),
+    // T1
+    BoilerNodeBit(Q0) | BoilerNodeBit(Q21) | BoilerNodeBit(Q22) | BoilerNodeBit(HeatM) | BoilerNodeBit(HeatN),
+    // Q4
+    BoilerNodeBit(Q0),
+    // T2
+    BoilerNodeBit(BhFact) | BoilerNodeBit(Ht) | BoilerNodeBit(K),
+    // T3
+    BoilerNodeBit(DOut) | BoilerNodeBit(DIn) | BoilerNodeBit(Nd) | BoilerNodeBit(Ld) | BoilerNodeBit(BhFact) |
+        BoilerNodeBit(Ht) | BoilerNodeBit(K),
+    // Tabs
+    BoilerNodeBit(T2) | BoilerNodeBit(T3),
+    // Omega
+    BoilerNodeBit(DIn) | BoilerNodeBit(alpha) | BoilerNodeBit(Tabs) | BoilerNodeBit(L0) | BoilerNodeBit(BhFact),
+    // K1
+    BoilerNodeBit(DIn) | BoilerNodeBit(Omega),
+    // Q3
+    BoilerNodeBit(T3) | BoilerNodeBit(HeatM) | BoilerNodeBit(HeatN),
+    // Qt
+    BoilerNodeBit(Q0) | BoilerNodeBit(Q21) | BoilerNodeBit(Q22) | BoilerNodeBit(T2) | BoilerNodeBit(HeatM) |
+        BoilerNodeBit(HeatN),
+};
+
+inline Fuel
+GetBoilerGraphFuel(f64 *values)
+{
+    Fuel result = {};
+    result.C = values[BoilerNode_C];
+    result.H = values[BoilerNode_H];
+    result.S = values[BoilerNode_S];
+    result.O = values[BoilerNode_O];
+    result.N = values[BoilerNode_N];
+    result.W = values[BoilerNode_W];
+    result.A = values[BoilerNode_A];
+    result.CO = values[BoilerNode_CO];
+    result.CO2 = values[BoilerNode_CO2];
+    result.O2 = values[BoilerNode_O2];
+    result.N2 = values[BoilerNode_N2];
+    result.K = values[BoilerNode_K];
+    result.alpha = values[BoilerNode_alpha];
+    return result;
+}
+
+inline PipeDiameter
+GetBoilerGraphPipeDiameter(f64 *values)
+{
+    PipeDiameter result = {};
+    result.DOut = values[BoilerNode_DOut];
+    result.DIn = values[BoilerNode_DIn];
+    return result;
+}
+
+inline HeatCoefficient
+GetBoilerGraphHeatCoefficient(f64 *values)
+{
+    HeatCoefficient result = {};
+    result.M = values[BoilerNode_HeatM];
+    result.N = values[BoilerNode_HeatN];
+    return result;
+}
+
+// Значение рассчитываемого узла по уже посчитанным входам
+internal f64
+CalculateBoilerNode(f64 *values, boiler_node node)
+{
+    f64 result = 0.0;
+
+    auto fuel = GetBoilerGraphFuel(values);
+    auto dd = GetBoilerGraphPipeDiameter(values);
+    auto heatCoefficient = GetBoilerGraphHeatCoefficient(values);
+    auto Nd = (u16)values[BoilerNode_Nd];
+
+    FireChamber fireChamber = {};
+    fireChamber.TopLengh = values[BoilerNode_TopLengh];
+    fireChamber.TopWidth = values[BoilerNode_TopWidth];
+    fireChamber.BottomLength = values[BoilerNode_BottomLength];
+    fireChamber.BottomWidth = values[BoilerNode_BottomWidth];
+    fireChamber.FrontHeight = values[BoilerNode_FrontHeight];
+    fireChamber.RearHeight = values[BoilerNode_RearHeight];
+    fireChamber.U = values[BoilerNode_U];
+    fireChamber.R = values[BoilerNode_R];
+
+    switch (node)
+    {
+        case BoilerNode_R:
+        {
+            CalculateFireChamber(fireChamber);
+            result = fireChamber.R;
+        }
+        break;
+
+        case BoilerNode_Ht:
+        {
+            CalculateFireChamber(fireChamber);
+            result = fireChamber.Ht;
+        }
+        break;
+
+        case BoilerNode_Hd: result = GetHPipes(dd, Nd, values[BoilerNode_Ld]); break;
+        case BoilerNode_Bh: result = GetBh(fireChamber); break;
+        case BoilerNode_BhFact: result = GetBhFact(fireChamber, values[BoilerNode_q22], fuel); break;
+        case BoilerNode_L0: result = GetL0(fuel); break;
+        case BoilerNode_HeatM: result = GetM(values[BoilerNode_BhFact], fuel); break;
+        case BoilerNode_HeatN: result = GetN(values[BoilerNode_BhFact], fuel); break;
+        case BoilerNode_Q0: result = GetQ0(values[BoilerNode_Bh], values[BoilerNode_t], fuel, heatCoefficient); break;
+        case BoilerNode_Q21: result = GetQ21(values[BoilerNode_BhFact], fuel); break;
+        case BoilerNode_Q22: result = GetQ22(values[BoilerNode_Q0], values[BoilerNode_q22]); break;
+
+        case BoilerNode_T1:
+        {
+            result = GetT1(values[BoilerNode_Q0], values[BoilerNode_Q21], values[BoilerNode_Q22], heatCoefficient);
+        }
+        break;
+
+        case BoilerNode_Q4: result = GetQ4(values[BoilerNode_Q0], 1); break; // 1% потерь от Q0
+        case BoilerNode_T2: result = GetT2(values[BoilerNode_BhFact], values[BoilerNode_Ht], fuel); break;
+
+        case BoilerNode_T3:
+        {
+            result = GetT3(dd, Nd, values[BoilerNode_Ld], values[BoilerNode_BhFact], values[BoilerNode_Ht], fuel);
+        }
+        break;
+
+        case BoilerNode_Tabs: result = GetTabs(values[BoilerNode_T2], values[BoilerNode_T3]); break;
+
+        case BoilerNode_Omega:
+        {
+            result = GetOmega(fuel, dd, values[BoilerNode_Tabs], values[BoilerNode_L0], values[BoilerNode_BhFact]);
+        }
+        break;
+
+        case BoilerNode_K1: result = GetK(dd, values[BoilerNode_Omega]); break;
+        case BoilerNode_Q3: result = GetQ3(values[BoilerNode_T3], heatCoefficient); break;
+
+        case BoilerNode_Qt:
+        {
+            result = GetQt(values[BoilerNode_Q0], values[BoilerNode_Q21], values[BoilerNode_Q22],
+                           values[BoilerNode_T2], heatCoefficient);
+        }
+        break;
+
+        InvalidDefaultCase;
+    }
+
+    return result;
+}
+
+// Заполняет входы; все рассчитываемые узлы помечаются для пересчета
+internal void
+InitializeBoilerGraph(BoilerGraph *graph, FireChamber fireChamber, PipeDiameter dd, f64 Ld, u16 Nd, f64 q22, f64 t,
+                      Fuel fuel)
+{
+    ZeroStruct(*graph);
+
+    for (u32 node = 0; node < BoilerNode_Count; ++node)
+    {
+        // NOTE: Inputs must come earlier in the enum, UpdateBoilerGraph walks it once.
+        Assert((GlobalBoilerNodeInputs[node] >> node) == 0);
+        for (u32 input = 0; input < node; ++input)
+        {
+            if (GlobalBoilerNodeInputs[node] & (1ULL << input))
+            {
+                graph->Dependents[input] |= (1ULL << node);
+            }
+        }
+    }
+
+    auto values = graph->Values;
+    values[BoilerNode_TopLengh] = fireChamber.TopLengh;
+    values[BoilerNode_TopWidth] = fireChamber.TopWidth;
+    values[BoilerNode_BottomLength] = fireChamber.BottomLength;
+    values[BoilerNode_BottomWidth] = fireChamber.BottomWidth;
+    values[BoilerNode_FrontHeight] = fireChamber.FrontHeight;
+    values[BoilerNode_RearHeight] = fireChamber.RearHeight;
+    values[BoilerNode_U] = fireChamber.U;
+    values[BoilerNode_DOut] = dd.DOut;
+    values[BoilerNode_DIn] = dd.DIn;
+    values[BoilerNode_Ld] = Ld;
+    values[BoilerNode_Nd] = Nd;
+    values[BoilerNode_q22] = q22;
+    values[BoilerNode_t] = t;
+    values[BoilerNode_C] = fuel.C;
+    values[BoilerNode_H] = fuel.H;
+    values[BoilerNode_S] = fuel.S;
+    values[BoilerNode_O] = fuel.O;
+    values[BoilerNode_N] = fuel.N;
+    values[BoilerNode_W] = fuel.W;
+    values[BoilerNode_A] = fuel.A;
+    values[BoilerNode_CO] = fuel.CO;
+    values[BoilerNode_CO2] = fuel.CO2;
+    values[BoilerNode_O2] = fuel.O2;
+    values[BoilerNode_N2] = fuel.N2;
+    values[BoilerNode_K] = fuel.K;
+    values[BoilerNode_alpha] = fuel.alpha;
+
+    u64 allNodes = (BoilerNode_Count == 64) ? ~0ULL : ((1ULL << BoilerNode_Count) - 1);
+    graph->Dirty = allNodes & (~0ULL << BoilerNode_InputCount);
+}
+
+internal void
+SetBoilerGraphInput(BoilerGraph *graph, boiler_node input, f64 value)
+{
+    Assert(input < BoilerNode_InputCount);
+    if (graph->Values[input] != value)
+    {
+        graph->Values[input] = value;
+        graph->Dirty |= graph->Dependents[input];
+    }
+}
+
+// Пересчитывает помеченные узлы; возвращает, сколько узлов пересчитано
+internal u32
+UpdateBoilerGraph(BoilerGraph *graph)
+{
+    u32 result = 0;
+
+    u64 dirty = graph->Dirty;
+    while (dirty)
+    {
+        // NOTE: The lowest dirty node has all its inputs up to date, and
+        // dependents only ever set higher bits.
+        u32 node = FindLeastSignificantSetBit(dirty);
+        dirty &= dirty - 1;
+
+        f64 value = CalculateBoilerNode(graph->Values, (boiler_node)node);
+        ++result;
+
+        // NOTE: Not ==, a NaN has to keep propagating.
+        if (!(value == graph->Values[node]))
+        {
+            graph->Values[node] = value;
+            dirty |= graph->Dependents[node];
+        }
+    }
+
+    graph->Dirty = 0;
+    graph->Evaluations += result;
+    return result;
+}
+
+// Сдвиг одного входа по шагам от min до max: на каждом шаге пересчитываются
+// только узлы, зависящие от этого входа. values[step] - значение узла output.
+// Вход возвращается к исходному значению.
+internal u32
+SweepBoilerGraph(BoilerGraph *graph, boiler_node input, f64 min, f64 max, u32 stepCount, boiler_node output,
+                 f64 *values)
+{
+    u32 result = UpdateBoilerGraph(graph);
+
+    f64 original = graph->Values[input];
+    for (u32 step = 0; step < stepCount; ++step)
+    {
+        f64 value = (stepCount > 1) ? Map((f64)step, 0.0, (f64)(stepCount - 1), min, max) : min;
+        SetBoilerGraphInput(graph, input, value);
+        result += UpdateBoilerGraph(graph);
+        values[step] = graph->Values[output];
+    }
+
+    SetBoilerGraphInput(graph, input, original);
+    result += UpdateBoilerGraph(graph);
+
+    return result;
+}
@@ -0,0 +1,516 @@
+// Обратная задача: подбор геометрии дымогарных труб под заданные выходы.
+//
+// Все строки пакета решаются одновременно: на каждой итерации точки всех
+// строк (и их сдвиги для производных) собираются в один пакет и считаются
+// CalculateBoilerBatch, то есть векторной цепочкой дымогарных труб. Стадия
+// топки от неизвестных не зависит и считается один раз.
+//
+// Одна неизвестная: Ньютон с производной по конечной разности внутри
+// отрезка [Lo, Hi], на концах которого невязка разных знаков; шаг за
+// пределы отрезка заменяется делением пополам (как rtsafe). Для Nd - деление
+// пополам по целым и выбор ближайшего из двух соседних значений.
+// Несколько неизвестных: Ньютон с матрицей Якоби по конечным разностям,
+// проекцией на границы и дроблением шага, если невязка не уменьшилась.
+
+#include <chrono>
+
+#define INVERSE_DEFAULT_TOLERANCE 1e-9
+#define INVERSE_DEFAULT_MAX_ITERATIONS 60
+#define INVERSE_STEP_FRACTION 1e-7 // шаг конечной разности, доля ширины границ
+#define INVERSE_MIN_LAMBDA (1.0 / 64.0)
+
+struct InverseRow
+{
+    f64 X[INVERSE_MAX_UNKNOWNS];
+    f64 BestX[INVERSE_MAX_UNKNOWNS];
+    f64 Step[INVERSE_MAX_UNKNOWNS];
+    f64 H[INVERSE_MAX_UNKNOWNS]; // сдвиг для производной, со знаком
+    f64 BestNorm;
+    f64 Lambda;
+
+    // отрезок с переменой знака невязки (одна неизвестная)
+    f64 Lo;
+    f64 Hi;
+    f64 FLo;
+    f64 FHi;
+
+    f64 Wall; // толщина стенки трубы
+    u32 Iterations;
+    u8 Status;
+    b32 Active;
+};
+
+inline void
+SetInverseUnknown(BoilerBatchInput *input, u32 slot, u32 unknown, f64 value, f64 wall)
+{
+    switch (unknown)
+    {
+        case InverseUnknown_Ld:
+        {
+            input->Ld[slot] = value;
+        }
+        break;
+
+        case InverseUnknown_DOut:
+        {
+            input->DOut[slot] = value;
+            input->DIn[slot] = value - wall;
+        }
+        break;
+
+        case InverseUnknown_Nd:
+        {
+            input->Nd[slot] = (u16)LimitI((i64)(value + 0.5), 0, 0xFFFF);
+        }
+        break;
+
+        InvalidDefaultCase;
+    }
+}
+
+inline f64
+GetInverseUnknown(BoilerBatchInput *input, u32 index, u32 unknown)
+{
+    f64 result = 0.0;
+    switch (unknown)
+    {
+        case InverseUnknown_Ld:
+        {
+            result = input->Ld[index];
+        }
+        break;
+
+        case InverseUnknown_DOut:
+        {
+            result = input->DOut[index];
+        }
+        break;
+
+        case InverseUnknown_Nd:
+        {
+            result = input->Nd[index];
+        }
+        break;
+
+        InvalidDefaultCase;
+    }
+    return result;
+}
+
+inline f64
+GetInverseTarget(BoilerBatchInput *input, BoilerBatchOutput *output, u32 slot, u32 target)
+{
+    f64 result = 0.0;
+    switch (target)
+    {
+        case InverseTarget_T3:
+        {
+            result = output->T3[slot];
+        }
+        break;
+
+        case InverseTarget_Q3:
+        {
+            result = output->Q3[slot];
+        }
+        break;
+
+        case InverseTarget_Omega:
+        {
+            result = output->Omega[slot];
+        }
+        break;
+
+        case InverseTarget_Hd:
+        {
+            // NOTE: Hd belongs to the front stage, which is not rerun per iteration.
+            PipeDiameter dd = {input->DOut[slot], input->DIn[slot]};
+            result = GetHPipes(dd, input->Nd[slot], input->Ld[slot]);
+        }
+        break;
+
+        InvalidDefaultCase;
+    }
+    return result;
+}
+
+// Относительная невязка цели
+inline f64
+GetInverseResidual(f64 value, f64 target)
+{
+    f64 scale = (target != 0.0) ? fabs(target) : 1.0;
+    return (value - target) / scale;
+}
+
+inline b32
+IsSameSign(f64 a, f64 b)
+{
+    return (a < 0.0) == (b < 0.0);
+}
+
+internal InverseStats
+SolveInverseBatch(MemoryArena *arena, InverseSpec *spec, InverseBatch *batch)
+{
+    TIMED_FUNCTION();
+
+    InverseStats stats = {};
+
+    BoilerBatchInput *base = batch->Base;
+    u32 rowCount = base->Count;
+    u32 unknownCount = spec->UnknownCount;
+    Assert((unknownCount > 0) && (unknownCount <= INVERSE_MAX_UNKNOWNS));
+
+    f64 tolerance = (spec->Tolerance > 0.0) ? spec->Tolerance : INVERSE_DEFAULT_TOLERANCE;
+    u32 maxIterations = spec->MaxIterations ? spec->MaxIterations : INVERSE_DEFAULT_MAX_ITERATIONS;
+
+    b32 oneUnknown = (unknownCount == 1);
+    b32 integerUnknown = oneUnknown && (spec->Unknowns[0] == InverseUnknown_Nd);
+    for (u32 unknown = 0; unknown < unknownCount; ++unknown)
+    {
+        // NOTE: Nd only moves in whole tubes, so there is no Jacobian column for it.
+        Assert(oneUnknown || (spec->Unknowns[unknown] != InverseUnknown_Nd));
+        Assert(spec->Min[unknown] < spec->Max[unknown]);
+    }
+
+    stats.RowCount = rowCount;
+
+    auto tempMem = BeginTemporaryMemory(arena);
+
+    // у каждой строки есть точка и сдвиги по каждой неизвестной;
+    // в первой итерации одной неизвестной - оба конца отрезка
+    u32 slotsPerRow = oneUnknown ? 2 : (unknownCount + 1);
+    u64 slotCount = (u64)rowCount * slotsPerRow;
+    Assert(slotCount <= 0xFFFFFFFF);
+
+    auto rows = PushArray(arena, rowCount, InverseRow);
+    auto eval = PushBoilerBatchInput(arena, (u32)slotCount);
+    auto evalOutput = PushBoilerBatchOutput(arena, slotCount);
+    if (!rows || !eval.Ld || !evalOutput.T3)
+    {
+        EndTemporaryMemory(tempMem);
+        return stats;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    eval.Fuels = base->Fuels;
+    eval.FuelRecords = base->FuelRecords;
+    eval.t = base->t;
+    for (u32 rowIndex = 0; rowIndex < rowCount; ++rowIndex)
+    {
+        InverseRow *row = rows + rowIndex;
+        ZeroStruct(*row);
+        row->Wall = base->DOut[rowIndex] - base->DIn[rowIndex];
+        row->BestNorm = INFINITY;
+        row->Lambda = 1.0;
+        row->Active = true;
+
+        for (u32 unknown = 0; unknown < unknownCount; ++unknown)
+        {
+            f64 start = GetInverseUnknown(base, rowIndex, spec->Unknowns[unknown]);
+            row->X[unknown] = LimitF(start, spec->Min[unknown], spec->Max[unknown]);
+            row->BestX[unknown] = row->X[unknown];
+        }
+
+        for (u32 slot = 0; slot < slotsPerRow; ++slot)
+        {
+            CopyBoilerBatchVariant(&eval, rowIndex * slotsPerRow + slot, base, rowIndex);
+        }
+    }
+
+    CalculateBoilerBatch(&eval, &evalOutput, BoilerStage_Front);
+
+    u32 activeCount = rowCount;
+    u32 iteration = 0;
+    for (; (iteration < maxIterations) && activeCount; ++iteration)
+    {
+        for (u32 rowIndex = 0; rowIndex < rowCount; ++rowIndex)
+        {
+            InverseRow *row = rows + rowIndex;
+            if (!row->Active)
+            {
+                continue;
+            }
+
+            u32 firstSlot = rowIndex * slotsPerRow;
+            if (oneUnknown && (iteration == 0))
+            {
+                SetInverseUnknown(&eval, firstSlot, spec->Unknowns[0], spec->Min[0], row->Wall);
+                SetInverseUnknown(&eval, firstSlot + 1, spec->Unknowns[0], spec->Max[0], row->Wall);
+                continue;
+            }
+
+            for (u32 unknown = 0; unknown < unknownCount; ++unknown)
+            {
+                SetInverseUnknown(&eval, firstSlot, spec->Unknowns[unknown], row->X[unknown], row->Wall);
+            }
+
+            if (!integerUnknown)
+            {
+                for (u32 unknown = 0; unknown < unknownCount; ++unknown)
+                {
+                    u32 slot = firstSlot + 1 + (oneUnknown ? 0 : unknown);
+                    if (!oneUnknown)
+                    {
+                        for (u32 other = 0; other < unknownCount; ++other)
+                        {
+                            SetInverseUnknown(&eval, slot, spec->Unknowns[other], row->X[other], row->Wall);
+                        }
+                    }
+
+                    // NOTE: Step inward so the shifted point stays within the bounds.
+                    f64 h = INVERSE_STEP_FRACTION * (spec->Max[unknown] - spec->Min[unknown]);
+                    if (row->X[unknown] + h > spec->Max[unknown])
+                    {
+                        h = -h;
+                    }
+                    row->H[unknown] = h;
+                    SetInverseUnknown(&eval, slot, spec->Unknowns[unknown], row->X[unknown] + h, row->Wall);
+                }
+            }
+        }
+
+        CalculateBoilerBatch(&eval, &evalOutput, BoilerStage_FireTubes | BoilerStage_Losses);
+        stats.Evaluations += (u64)activeCount * ((integerUnknown && iteration) ? 1 : slotsPerRow);
+
+        for (u32 rowIndex = 0; rowIndex < rowCount; ++rowIndex)
+        {
+            InverseRow *row = rows + rowIndex;
+            if (!row->Active)
+            {
+                continue;
+            }
+            ++row->Iterations;
+
+            u32 firstSlot = rowIndex * slotsPerRow;
+
+            f64 f[INVERSE_MAX_UNKNOWNS];
+            f64 norm = 0.0;
+            for (u32 target = 0; target < unknownCount; ++target)
+            {
+                f64 value = GetInverseTarget(&eval, &evalOutput, firstSlot, spec->Targets[target]);
+                f[target] = GetInverseResidual(value, batch->TargetValues[target][rowIndex]);
+                norm = Maximum(norm, fabs(f[target]));
+            }
+
+            if (oneUnknown && (iteration == 0))
+            {
+                f64 fMax = GetInverseResidual(GetInverseTarget(&eval, &evalOutput, firstSlot + 1, spec->Targets[0]),
+                                              batch->TargetValues[0][rowIndex]);
+                if (fabs(f[0]) <= tolerance)
+                {
+                    row->X[0] = spec->Min[0];
+                    row->Status = InverseStatus_Converged;
+                    row->Active = false;
+                }
+                else if (fabs(fMax) <= tolerance)
+                {
+                    row->X[0] = spec->Max[0];
+                    row->Status = InverseStatus_Converged;
+                    row->Active = false;
+                }
+                else if (IsSameSign(f[0], fMax))
+                {
+                    row->X[0] = (fabs(f[0]) < fabs(fMax)) ? spec->Min[0] : spec->Max[0];
+                    row->Status = InverseStatus_OutOfBounds;
+                    row->Active = false;
+                }
+                else
+                {
+                    row->Lo = spec->Min[0];
+                    row->Hi = spec->Max[0];
+                    row->FLo = f[0];
+                    row->FHi = fMax;
+                    if (integerUnknown)
+                    {
+                        row->X[0] = floor(0.5 * (row->Lo + row->Hi));
+                    }
+                    else
+                    {
+                        // первое приближение - по хорде
+                        row->X[0] = row->Lo - row->FLo * (row->Hi - row->Lo) / (row->FHi - row->FLo);
+                    }
+                }
+            }
+            else if (oneUnknown)
+            {
+                f64 x = row->X[0];
+                if (fabs(f[0]) <= tolerance)
+                {
+                    row->Status = InverseStatus_Converged;
+                    row->Active = false;
+                }
+                else
+                {
+                    if (IsSameSign(f[0], row->FLo))
+                    {
+                        row->Lo = x;
+                        row->FLo = f[0];
+                    }
+                    else
+                    {
+                        row->Hi = x;
+                        row->FHi = f[0];
+                    }
+
+                    if (integerUnknown)
+                    {
+                        if (row->Hi - row->Lo <= 1.0)
+                        {
+                            // NOTE: The nearest whole number of tubes is the best we can do.
+                            row->X[0] = (fabs(row->FLo) < fabs(row->FHi)) ? row->Lo : row->Hi;
+                            row->Status = InverseStatus_Converged;
+                            row->Active = false;
+                        }
+                        else
+                        {
+                            row->X[0] = floor(0.5 * (row->Lo + row->Hi));
+                        }
+                    }
+                    else if (row->Hi - row->Lo <= 1e-12 * (spec->Max[0] - spec->Min[0]))
+                    {
+                        row->Status = InverseStatus_Converged;
+                        row->Active = false;
+                    }
+                    else
+                    {
+                        f64 fh = GetInverseResidual(GetInverseTarget(&eval, &evalOutput, firstSlot + 1, spec->Targets[0]),
+                                                    batch->TargetValues[0][rowIndex]);
+                        f64 df = (fh - f[0]) / row->H[0];
+                        f64 next = x - f[0] / df;
+                        if (!(next > row->Lo && next < row->Hi))
+                        {
+                            next = 0.5 * (row->Lo + row->Hi);
+                        }
+                        row->X[0] = next;
+                    }
+                }
+            }
+            else if (norm <= tolerance)
+            {
+                row->Status = InverseStatus_Converged;
+                row->Active = false;
+            }
+            else if (norm >= row->BestNorm)
+            {
+                // невязка не уменьшилась - дробим шаг от лучшей точки
+                row->Lambda *= 0.5;
+                if (row->Lambda < INVERSE_MIN_LAMBDA)
+                {
+                    row->Status = InverseStatus_NoConvergence;
+                    row->Active = false;
+                }
+                for (u32 unknown = 0; unknown < unknownCount; ++unknown)
+                {
+                    row->X[unknown] = row->Active ? LimitF(row->BestX[unknown] + row->Lambda * row->Step[unknown],
+                                                           spec->Min[unknown], spec->Max[unknown])
+                                                  : row->BestX[unknown];
+                }
+            }
+            else
+            {
+                row->BestNorm = norm;
+                for (u32 unknown = 0; unknown < unknownCount; ++unknown)
+                {
+                    row->BestX[unknown] = row->X[unknown];
+                }
+
+                f64 jacobian[LINEAR_SYSTEM_MAX][LINEAR_SYSTEM_MAX];
+                f64 minusF[LINEAR_SYSTEM_MAX];
+                for (u32 target = 0; target < unknownCount; ++target)
+                {
+                    minusF[target] = -f[target];
+                    for (u32 unknown = 0; unknown < unknownCount; ++unknown)
+                    {
+                        f64 shifted = GetInverseTarget(&eval, &evalOutput, firstSlot + 1 + unknown, spec->Targets[target]);
+                        f64 fShifted = GetInverseResidual(shifted, batch->TargetValues[target][rowIndex]);
+                        jacobian[target][unknown] = (fShifted - f[target]) / row->H[unknown];
+                    }
+                }
+
+                if (SolveLinearSystem(unknownCount, jacobian, minusF, row->Step))
+                {
+                    b32 moved = false;
+                    row->Lambda = 1.0;
+                    for (u32 unknown = 0; unknown < unknownCount; ++unknown)
+                    {
+                        f64 next = LimitF(row->X[unknown] + row->Step[unknown], spec->Min[unknown], spec->Max[unknown]);
+                        moved |= (next != row->X[unknown]);
+                        row->X[unknown] = next;
+                    }
+
+                    if (!moved)
+                    {
+                        // шаг целиком уперся в границы
+                        row->Status = InverseStatus_OutOfBounds;
+                        row->Active = false;
+                    }
+                }
+                else
+                {
+                    row->Status = InverseStatus_NoConvergence;
+                    row->Active = false;
+                }
+            }
+
+            if (!row->Active)
+            {
+                --activeCount;
+            }
+        }
+    }
+
+    // итоговая точка каждой строки и значения целей в ней
+    for (u32 rowIndex = 0; rowIndex < rowCount; ++rowIndex)
+    {
+        InverseRow *row = rows + rowIndex;
+        if (row->Active)
+        {
+            row->Status = InverseStatus_NoConvergence;
+            if (!oneUnknown)
+            {
+                for (u32 unknown = 0; unknown < unknownCount; ++unknown)
+                {
+                    row->X[unknown] = row->BestX[unknown];
+                }
+            }
+        }
+
+        for (u32 unknown = 0; unknown < unknownCount; ++unknown)
+        {
+            SetInverseUnknown(&eval, rowIndex * slotsPerRow, spec->Unknowns[unknown], row->X[unknown], row->Wall);
+        }
+    }
+    CalculateBoilerBatch(&eval, &evalOutput, BoilerStage_FireTubes | BoilerStage_Losses);
+    stats.Evaluations += (u64)rowCount * slotsPerRow;
+
+    for (u32 rowIndex = 0; rowIndex < rowCount; ++rowIndex)
+    {
+        InverseRow *row = rows + rowIndex;
+        u32 slot = rowIndex * slotsPerRow;
+        for (u32 unknown = 0; unknown < unknownCount; ++unknown)
+        {
+            batch->Solution[unknown][rowIndex] = GetInverseUnknown(&eval, slot, spec->Unknowns[unknown]);
+            batch->Achieved[unknown][rowIndex] = GetInverseTarget(&eval, &evalOutput, slot, spec->Targets[unknown]);
+        }
+        if (batch->Status)
+        {
+            batch->Status[rowIndex] = row->Status;
+        }
+        if (batch->Iterations)
+        {
+            batch->Iterations[rowIndex] = (u8)LimitI(row->Iterations, 0, 0xFF);
+        }
+
+        stats.Converged += (row->Status == InverseStatus_Converged);
+        stats.OutOfBounds += (row->Status == InverseStatus_OutOfBounds);
+        stats.NoConvergence += (row->Status == InverseStatus_NoConvergence);
+    }
+
+    auto endTime = std::chrono::steady_clock::now();
+    stats.Iterations = iteration;
+    stats.Seconds = std::chrono::duration<f64>(endTime - startTime).count();
+
+    EndTemporaryMemory(tempMem);
+    return stats;
+}
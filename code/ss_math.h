@@ -16,10 +16,177 @@ Map(f64 x, f64 inMin, f64 inMax, f64 outMin, f64 outMax)
     return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
 }
 
+// NOTE: Accuracy tier of Pow, Log, Exp and Root (scalar and wide). Reference is
+// libm (the wide kernels stay within a few ULP of it), Fast uses the short
+// polynomial kernels below. The default is chosen at build time with
+// EDITOR_FAST_MATH and can be changed at run time with SetMathMode.
+//
+// Fast accuracy (ss_bench -accuracy, over the operating envelope of every
+// call site in ss_boiler.cpp and over x in [1e-6, 1e6], |e| <= 4):
+//   FastLog2   absolute error <= 5e-12 (measured 2.1e-12)
+//   FastPow    relative error <= 1e-10 (measured 4.6e-11)
+//   FastExp    relative error <= 1e-10 for x in [-50, 0]
+//   FastPowFiveEighths  <= 1 ULP, Pow uses it for the exponent 5/8
+// The boiler outputs stay within 5e-10 relative (measured 8.6e-11, K1).
+// Inputs must be positive normal numbers; there is no NaN/Inf handling.
+#if !defined(EDITOR_FAST_MATH)
+#define EDITOR_FAST_MATH 0
+#endif
+
+enum math_mode
+{
+    MathMode_Reference,
+    MathMode_Fast,
+};
+
+global math_mode GlobalMathMode = EDITOR_FAST_MATH ? MathMode_Fast : MathMode_Reference;
+
+inline void
+SetMathMode(math_mode mode)
+{
+    GlobalMathMode = mode;
+}
+
+// log2(m) = s * P(s^2), s = (m - 1) / (m + 1), m in [sqrt(2)/2, sqrt(2)):
+// minimax fit of 2 atanh(s) / (s ln 2), relative error 4.2e-12.
+global const f64 FastLog2P0 = 2.8853900817901503;
+global const f64 FastLog2P1 = 0.9617966732769966;
+global const f64 FastLog2P2 = 0.5770835953846003;
+global const f64 FastLog2P3 = 0.41167217310193743;
+global const f64 FastLog2P4 = 0.34073911087309966;
+
+// 2^f for f in [-0.5, 0.5]: minimax fit, relative error 4.0e-11.
+global const f64 FastExp2P0 = 0.9999999999616878;
+global const f64 FastExp2P1 = 0.6931471807283558;
+global const f64 FastExp2P2 = 0.24022651198153042;
+global const f64 FastExp2P3 = 0.05550410353652539;
+global const f64 FastExp2P4 = 0.009618027251260626;
+global const f64 FastExp2P5 = 0.0013333922412687726;
+global const f64 FastExp2P6 = 0.00015469292355748288;
+global const f64 FastExp2P7 = 1.5201956774474527e-05;
+
+// NOTE: The fast kernels take positive normal x and return garbage for 0,
+// negatives, inf, NaN and denormals, the same domain as the wide kernels.
+inline f64
+FastLog2(f64 x)
+{
+    u64 bits;
+    memcpy(&bits, &x, sizeof(bits));
+    f64 exponent = (f64)((i64)(bits >> 52) - 1023);
+    bits = (bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;
+    f64 m;
+    memcpy(&m, &bits, sizeof(m));
+
+    b32 isLarge = (m > 1.41421356237309504880);
+    m = isLarge ? (m * 0.5) : m;
+    exponent = isLarge ? (exponent + 1.0) : exponent;
+
+    f64 s = (m - 1.0) / (m + 1.0);
+    f64 z = s * s;
+    f64 p = FastLog2P0 + z * (FastLog2P1 + z * (FastLog2P2 + z * (FastLog2P3 + z * FastLog2P4)));
+    return exponent + s * p;
+}
+
+// NOTE: x must be in (-1022, 1023), no overflow or underflow handling.
+inline f64
+FastExp2(f64 x)
+{
+    // round to nearest by the 1.5 * 2^52 trick
+    f64 k = (x + 6755399441055744.0) - 6755399441055744.0;
+    f64 f = x - k;
+    f64 p = FastExp2P0 + f * (FastExp2P1 + f * (FastExp2P2 + f * (FastExp2P3 + f * (FastExp2P4 +
+            f * (FastExp2P5 + f * (FastExp2P6 + f * FastExp2P7))))));
+
+    u64 bits = (u64)((i64)k + 1023) << 52;
+    f64 scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+inline f64
+FastPow(f64 x, f64 e)
+{
+    return FastExp2(e * FastLog2(x));
+}
+
+inline f64
+FastLog(f64 x)
+{
+    return FastLog2(x) * 0.69314718055994530942;
+}
+
+inline f64
+FastExp(f64 x)
+{
+    return FastExp2(x * 1.44269504088896340736);
+}
+
+// Fixed-exponent kernel for Root(x, 1.6) = x^(5/8): x^5 and three square
+// roots, <= 1 ULP (the square roots divide the rounding of x^5 by 8) and
+// faster than FastPow. Needs x^5 normal, x in [1e-61, 1e61]. The other
+// exponents (0.7, 0.214, 0.15, 4/3) have no such form and use FastPow;
+// x * cbrt(x) for 4/3 is no faster than libm pow.
+inline f64
+FastPowFiveEighths(f64 x)
+{
+    f64 x2 = x * x;
+    return sqrt(sqrt(sqrt(x2 * x2 * x)));
+}
+
+// x^e for x > 0 in the current math_mode. The exponent is a constant at every
+// call site, so after inlining the fast branch folds to a single kernel.
+inline f64
+Pow(f64 x, f64 e)
+{
+    if (GlobalMathMode == MathMode_Fast)
+    {
+        if (e == 0.625)
+        {
+            return FastPowFiveEighths(x);
+        }
+        return FastPow(x, e);
+    }
+    return pow(x, e);
+}
+
+inline f64
+Log(f64 x)
+{
+    if (GlobalMathMode == MathMode_Fast)
+    {
+        return FastLog(x);
+    }
+    return log(x);
+}
+
+inline f64
+Exp(f64 x)
+{
+    if (GlobalMathMode == MathMode_Fast)
+    {
+        return FastExp(x);
+    }
+    return exp(x);
+}
+
 inline f64
 Root(f64 input, f64 n)
 {
-    return pow(input, 1.0 / n);
+    return Pow(input, 1.0 / n);
+}
+
+// NOTE: Function forms of Minimum/Maximum, for the same reason: a formula
+// written over WIDE then also compiles with WIDE defined to f64.
+inline f64
+Min(f64 a, f64 b)
+{
+    return (a < b) ? a : b;
+}
+
+inline f64
+Max(f64 a, f64 b)
+{
+    return (a > b) ? a : b;
 }
 
 inline f64
@@ -42,6 +209,182 @@ SolveQuadratic(f64 a, f64 b, f64 c)
     return x1 > x2 ? x1 : x2;
 }
 
+// Solves the n x n system a * x = b by Gaussian elimination with partial
+// pivoting; a and b are destroyed. Returns false if a is singular.
+#define LINEAR_SYSTEM_MAX 4
+
+inline b32
+SolveLinearSystem(u32 n, f64 a[][LINEAR_SYSTEM_MAX], f64 *b, f64 *x)
+{
+    for (u32 column = 0; column < n; ++column)
+    {
+        u32 pivot = column;
+        for (u32 row = column + 1; row < n; ++row)
+        {
+            if (fabs(a[row][column]) > fabs(a[pivot][column]))
+            {
+                pivot = row;
+            }
+        }
+        if (a[pivot][column] == 0.0)
+        {
+            return false;
+        }
+
+        if (pivot != column)
+        {
+            for (u32 index = 0; index < n; ++index)
+            {
+                f64 temp = a[column][index];
+                a[column][index] = a[pivot][index];
+                a[pivot][index] = temp;
+            }
+            f64 temp = b[column];
+            b[column] = b[pivot];
+            b[pivot] = temp;
+        }
+
+        for (u32 row = column + 1; row < n; ++row)
+        {
+            f64 factor = a[row][column] / a[column][column];
+            for (u32 index = column; index < n; ++index)
+            {
+                a[row][index] -= factor * a[column][index];
+            }
+            b[row] -= factor * b[column];
+        }
+    }
+
+    for (u32 row = n; row-- > 0;)
+    {
+        f64 sum = b[row];
+        for (u32 index = row + 1; index < n; ++index)
+        {
+            sum -= a[row][index] * x[index];
+        }
+        x[row] = sum / a[row][row];
+    }
+
+    return true;
+}
+
+// Eigen decomposition of the symmetric n x n matrix a by cyclic Jacobi
+// rotations: a = vectors * diag(values) * vectors^T, eigenvectors are the
+// columns of vectors. a is destroyed.
+#define SYMMETRIC_EIGEN_MAX 16
+
+inline void
+SymmetricEigen(u32 n, f64 a[][SYMMETRIC_EIGEN_MAX], f64 *values, f64 vectors[][SYMMETRIC_EIGEN_MAX])
+{
+    for (u32 row = 0; row < n; ++row)
+    {
+        for (u32 column = 0; column < n; ++column)
+        {
+            vectors[row][column] = (row == column) ? 1.0 : 0.0;
+        }
+    }
+
+    for (u32 sweep = 0; sweep < 50; ++sweep)
+    {
+        f64 offDiagonal = 0.0;
+        f64 diagonal = 0.0;
+        for (u32 row = 0; row < n; ++row)
+        {
+            diagonal += a[row][row] * a[row][row];
+            for (u32 column = row + 1; column < n; ++column)
+            {
+                offDiagonal += a[row][column] * a[row][column];
+            }
+        }
+        // NOTE: Converged once the off-diagonal part is below rounding noise.
+        if (offDiagonal <= 1e-30 * diagonal)
+        {
+            break;
+        }
+
+        for (u32 p = 0; p < n; ++p)
+        {
+            for (u32 q = p + 1; q < n; ++q)
+            {
+                if (a[p][q] == 0.0)
+                {
+                    continue;
+                }
+
+                f64 theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                f64 t = ((theta >= 0.0) ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                f64 c = 1.0 / sqrt(t * t + 1.0);
+                f64 s = t * c;
+
+                for (u32 k = 0; k < n; ++k)
+                {
+                    f64 akp = a[k][p];
+                    f64 akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (u32 k = 0; k < n; ++k)
+                {
+                    f64 apk = a[p][k];
+                    f64 aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (u32 k = 0; k < n; ++k)
+                {
+                    f64 vkp = vectors[k][p];
+                    f64 vkq = vectors[k][q];
+                    vectors[k][p] = c * vkp - s * vkq;
+                    vectors[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    for (u32 index = 0; index < n; ++index)
+    {
+        values[index] = a[index][index];
+    }
+}
+
+// Philox4x32-10 counter-based random number generator (Salmon et al.,
+// "Parallel Random Numbers: As Easy as 1, 2, 3"). The output is a pure
+// function of (counter, key), so any thread can generate the numbers of any
+// sample without sharing or advancing state.
+struct philox_result
+{
+    u32 V[4];
+};
+
+inline philox_result
+Philox4x32(u32 counter0, u32 counter1, u32 counter2, u32 counter3, u32 key0, u32 key1)
+{
+    u32 c[4] = {counter0, counter1, counter2, counter3};
+    for (u32 round = 0; round < 10; ++round)
+    {
+        u64 product0 = (u64)0xD2511F53 * c[0];
+        u64 product1 = (u64)0xCD9E8D57 * c[2];
+        u32 next0 = (u32)(product1 >> 32) ^ c[1] ^ key0;
+        u32 next2 = (u32)(product0 >> 32) ^ c[3] ^ key1;
+        c[0] = next0;
+        c[1] = (u32)product1;
+        c[2] = next2;
+        c[3] = (u32)product0;
+        key0 += 0x9E3779B9;
+        key1 += 0xBB67AE85;
+    }
+
+    philox_result result = {{c[0], c[1], c[2], c[3]}};
+    return result;
+}
+
+// NOTE: 53 random bits into [0, 1).
+inline f64
+UnitF64FromBits(u32 high, u32 low)
+{
+    return (f64)((((u64)high << 32) | low) >> 11) * (1.0 / 9007199254740992.0);
+}
+
 inline i32
 RoundF32ToI32(f32 value)
 {
@@ -84,6 +427,19 @@ TruncateU64(u64 value)
     return result;
 }
 
+// NOTE: value must not be zero.
+inline u32
+FindLeastSignificantSetBit(u64 value)
+{
+#if COMPILER_MSVC
+    unsigned long result;
+    _BitScanForward64(&result, value);
+    return (u32)result;
+#else
+    return (u32)__builtin_ctzll(value);
+#endif
+}
+
 inline f64
 LimitF(f64 value, f64 minValue, f64 maxValue)
 {
@@ -279,3 +635,952 @@ operator-(vector2 A, vector2 B)
 
     return result;
 }
+
+//
+// NOTE: Wide (SIMD) math.
+//
+// f64x4 (AVX2) and f64x8 (AVX-512F) pack 4 or 8 doubles. Every function that
+// touches them is compiled for its instruction set only (see BEGIN_TARGET_*),
+// so the rest of the code stays baseline x64 and the right path is picked at
+// run time by GetSimdLevel().
+//
+// f64x1, f64x2, f64x4 and f64x8 share one interface (operators, GreaterThan,
+// Select, Min/Max, the kernels of ss_math_wide.inl), so a formula written
+// over WIDE compiles to 1, 2, 4 or 8 lanes.
+//
+// f32x8 (AVX2) and f32x16 (AVX-512F) are the single-precision counterparts
+// with twice the lanes; their kernels are in ss_math_wide_f32.inl.
+//
+
+#if COMPILER_GCC
+#define BEGIN_TARGET_AVX2 _Pragma("GCC push_options") _Pragma("GCC target(\"avx2\")")
+#define BEGIN_TARGET_AVX512 _Pragma("GCC push_options") _Pragma("GCC target(\"avx512f\")")
+#define END_TARGET _Pragma("GCC pop_options")
+#elif COMPILER_LLVM
+#define BEGIN_TARGET_AVX2 _Pragma("clang attribute push (__attribute__((target(\"avx2\"))), apply_to = function)")
+#define BEGIN_TARGET_AVX512 _Pragma("clang attribute push (__attribute__((target(\"avx512f\"))), apply_to = function)")
+#define END_TARGET _Pragma("clang attribute pop")
+#else
+#define BEGIN_TARGET_AVX2
+#define BEGIN_TARGET_AVX512
+#define END_TARGET
+#endif
+
+enum simd_level
+{
+    SimdLevel_Scalar,
+    SimdLevel_AVX2,
+    SimdLevel_AVX512,
+};
+
+inline simd_level
+GetSimdLevel()
+{
+    simd_level result = SimdLevel_Scalar;
+
+#if COMPILER_MSVC
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    b32 osxsave = (info[2] & (1 << 27)) != 0;
+    b32 avx = (info[2] & (1 << 28)) != 0;
+    if (osxsave && avx && (maxLeaf >= 7))
+    {
+        // NOTE: The OS has to save the YMM (and ZMM) state, not just the CPU support it.
+        u64 xcr0 = _xgetbv(0);
+        __cpuidex(info, 7, 0);
+        if (((xcr0 & 0x06) == 0x06) && (info[1] & (1 << 5)))
+        {
+            result = SimdLevel_AVX2;
+        }
+        if (((xcr0 & 0xe6) == 0xe6) && (info[1] & (1 << 16)))
+        {
+            result = SimdLevel_AVX512;
+        }
+    }
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        result = SimdLevel_AVX2;
+    }
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        result = SimdLevel_AVX512;
+    }
+#endif
+
+    return result;
+}
+
+// NOTE: f64x1 and f64x2 (SSE2, baseline x64) have the same interface as the
+// AVX types below and need no target region. They let a formula written once
+// over WIDE also build for one and two lanes; f64x1 is plain
+// scalar code. SSE2 has no blend or round instructions, so Select is and/or
+// and Round uses the 1.5 * 2^52 trick (exact for |a| < 2^51).
+
+struct f64x1
+{
+    f64 V;
+
+    enum
+    {
+        Width = 1
+    };
+
+    static inline f64x1 Set(f64 a)
+    {
+        f64x1 result = {a};
+        return result;
+    }
+    static inline f64x1 Load(const f64 *p)
+    {
+        f64x1 result = {*p};
+        return result;
+    }
+    static inline f64x1 Load(const u16 *p)
+    {
+        f64x1 result = {(f64)*p};
+        return result;
+    }
+    static inline void Store(f64 *p, f64x1 a)
+    {
+        *p = a.V;
+    }
+};
+
+struct f64x1_mask
+{
+    b32 V;
+};
+
+inline f64x1 operator+(f64x1 a, f64x1 b) { return {a.V + b.V}; }
+inline f64x1 operator-(f64x1 a, f64x1 b) { return {a.V - b.V}; }
+inline f64x1 operator*(f64x1 a, f64x1 b) { return {a.V * b.V}; }
+inline f64x1 operator/(f64x1 a, f64x1 b) { return {a.V / b.V}; }
+inline f64x1 operator-(f64x1 a) { return {-a.V}; }
+
+inline f64x1 operator+(f64x1 a, f64 b) { return {a.V + b}; }
+inline f64x1 operator-(f64x1 a, f64 b) { return {a.V - b}; }
+inline f64x1 operator*(f64x1 a, f64 b) { return {a.V * b}; }
+inline f64x1 operator/(f64x1 a, f64 b) { return {a.V / b}; }
+inline f64x1 operator+(f64 a, f64x1 b) { return {a + b.V}; }
+inline f64x1 operator-(f64 a, f64x1 b) { return {a - b.V}; }
+inline f64x1 operator*(f64 a, f64x1 b) { return {a * b.V}; }
+inline f64x1 operator/(f64 a, f64x1 b) { return {a / b.V}; }
+
+inline f64x1_mask
+GreaterThan(f64x1 a, f64 b)
+{
+    return {a.V > b};
+}
+
+inline f64x1
+Select(f64x1_mask mask, f64x1 a, f64x1 b)
+{
+    return mask.V ? a : b;
+}
+
+inline f64x1_mask
+GreaterThan(f64x1 a, f64x1 b)
+{
+    return {a.V > b.V};
+}
+
+inline f64x1_mask operator&(f64x1_mask a, f64x1_mask b) { return {a.V && b.V}; }
+inline f64x1_mask operator|(f64x1_mask a, f64x1_mask b) { return {a.V || b.V}; }
+
+inline f64x1_mask
+AndNot(f64x1_mask a, f64x1_mask b)
+{
+    return {a.V && !b.V};
+}
+
+inline u32
+GetMaskBits(f64x1_mask mask)
+{
+    return mask.V ? 1 : 0;
+}
+
+inline f64x1
+Min(f64x1 a, f64x1 b)
+{
+    return {(a.V < b.V) ? a.V : b.V};
+}
+
+inline f64x1
+Max(f64x1 a, f64x1 b)
+{
+    return {(a.V > b.V) ? a.V : b.V};
+}
+
+inline f64x1
+SquareRoot(f64x1 a)
+{
+    return {sqrt(a.V)};
+}
+
+inline f64x1
+Round(f64x1 a)
+{
+    return {(a.V + 6755399441055744.0) - 6755399441055744.0};
+}
+
+inline f64x1
+ExtractExponent(f64x1 a)
+{
+    u64 bits;
+    memcpy(&bits, &a.V, sizeof(bits));
+    return {(f64)((i64)(bits >> 52) - 1023)};
+}
+
+inline f64x1
+ExtractMantissa(f64x1 a)
+{
+    u64 bits;
+    memcpy(&bits, &a.V, sizeof(bits));
+    bits = (bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;
+    f64x1 result;
+    memcpy(&result.V, &bits, sizeof(bits));
+    return result;
+}
+
+inline f64x1
+ScaleByPowerOf2(f64x1 a, f64x1 k)
+{
+    u64 bits = (u64)((i64)k.V + 1023) << 52;
+    f64 scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return {a.V * scale};
+}
+
+
+#define WIDE f64x1
+#include "ss_math_wide.inl"
+#undef WIDE
+
+struct f64x2
+{
+    __m128d V;
+
+    enum
+    {
+        Width = 2
+    };
+
+    static inline f64x2 Set(f64 a)
+    {
+        f64x2 result = {_mm_set1_pd(a)};
+        return result;
+    }
+    static inline f64x2 Load(const f64 *p)
+    {
+        f64x2 result = {_mm_loadu_pd(p)};
+        return result;
+    }
+    static inline f64x2 Load(const u16 *p)
+    {
+        f64x2 result = {_mm_set_pd(p[1], p[0])};
+        return result;
+    }
+    static inline void Store(f64 *p, f64x2 a)
+    {
+        _mm_storeu_pd(p, a.V);
+    }
+};
+
+struct f64x2_mask
+{
+    __m128d V;
+};
+
+inline f64x2 operator+(f64x2 a, f64x2 b) { return {_mm_add_pd(a.V, b.V)}; }
+inline f64x2 operator-(f64x2 a, f64x2 b) { return {_mm_sub_pd(a.V, b.V)}; }
+inline f64x2 operator*(f64x2 a, f64x2 b) { return {_mm_mul_pd(a.V, b.V)}; }
+inline f64x2 operator/(f64x2 a, f64x2 b) { return {_mm_div_pd(a.V, b.V)}; }
+inline f64x2 operator-(f64x2 a) { return {_mm_sub_pd(_mm_setzero_pd(), a.V)}; }
+
+inline f64x2 operator+(f64x2 a, f64 b) { return a + f64x2::Set(b); }
+inline f64x2 operator-(f64x2 a, f64 b) { return a - f64x2::Set(b); }
+inline f64x2 operator*(f64x2 a, f64 b) { return a * f64x2::Set(b); }
+inline f64x2 operator/(f64x2 a, f64 b) { return a / f64x2::Set(b); }
+inline f64x2 operator+(f64 a, f64x2 b) { return f64x2::Set(a) + b; }
+inline f64x2 operator-(f64 a, f64x2 b) { return f64x2::Set(a) - b; }
+inline f64x2 operator*(f64 a, f64x2 b) { return f64x2::Set(a) * b; }
+inline f64x2 operator/(f64 a, f64x2 b) { return f64x2::Set(a) / b; }
+
+inline f64x2_mask
+GreaterThan(f64x2 a, f64 b)
+{
+    return {_mm_cmpgt_pd(a.V, _mm_set1_pd(b))};
+}
+
+inline f64x2
+Select(f64x2_mask mask, f64x2 a, f64x2 b)
+{
+    return {_mm_or_pd(_mm_and_pd(mask.V, a.V), _mm_andnot_pd(mask.V, b.V))};
+}
+
+inline f64x2_mask
+GreaterThan(f64x2 a, f64x2 b)
+{
+    return {_mm_cmpgt_pd(a.V, b.V)};
+}
+
+inline f64x2_mask operator&(f64x2_mask a, f64x2_mask b) { return {_mm_and_pd(a.V, b.V)}; }
+inline f64x2_mask operator|(f64x2_mask a, f64x2_mask b) { return {_mm_or_pd(a.V, b.V)}; }
+
+inline f64x2_mask
+AndNot(f64x2_mask a, f64x2_mask b)
+{
+    return {_mm_andnot_pd(b.V, a.V)};
+}
+
+inline u32
+GetMaskBits(f64x2_mask mask)
+{
+    return (u32)_mm_movemask_pd(mask.V);
+}
+
+inline f64x2
+Min(f64x2 a, f64x2 b)
+{
+    return {_mm_min_pd(a.V, b.V)};
+}
+
+inline f64x2
+Max(f64x2 a, f64x2 b)
+{
+    return {_mm_max_pd(a.V, b.V)};
+}
+
+inline f64x2
+SquareRoot(f64x2 a)
+{
+    return {_mm_sqrt_pd(a.V)};
+}
+
+inline f64x2
+Round(f64x2 a)
+{
+    __m128d magic = _mm_set1_pd(6755399441055744.0); // 1.5 * 2^52
+    return {_mm_sub_pd(_mm_add_pd(a.V, magic), magic)};
+}
+
+inline f64x2
+ExtractExponent(f64x2 a)
+{
+    __m128i magic = _mm_castpd_si128(_mm_set1_pd(4503599627370496.0)); // 2^52
+    __m128i bits = _mm_srli_epi64(_mm_castpd_si128(a.V), 52);
+    __m128d biased = _mm_castsi128_pd(_mm_or_si128(bits, magic));
+    return {_mm_sub_pd(biased, _mm_set1_pd(4503599627370496.0 + 1023.0))};
+}
+
+inline f64x2
+ExtractMantissa(f64x2 a)
+{
+    __m128i bits = _mm_and_si128(_mm_castpd_si128(a.V), _mm_set1_epi64x(0x000FFFFFFFFFFFFFLL));
+    bits = _mm_or_si128(bits, _mm_set1_epi64x(0x3FF0000000000000LL));
+    return {_mm_castsi128_pd(bits)};
+}
+
+inline f64x2
+ScaleByPowerOf2(f64x2 a, f64x2 k)
+{
+    __m128d biased = _mm_add_pd(k.V, _mm_set1_pd(4503599627370496.0 + 1023.0));
+    __m128i bits = _mm_slli_epi64(_mm_castpd_si128(biased), 52);
+    return {_mm_mul_pd(a.V, _mm_castsi128_pd(bits))};
+}
+
+
+#define WIDE f64x2
+#include "ss_math_wide.inl"
+#undef WIDE
+
+BEGIN_TARGET_AVX2
+
+struct f64x4
+{
+    __m256d V;
+
+    enum
+    {
+        Width = 4
+    };
+
+    static inline f64x4 Set(f64 a)
+    {
+        f64x4 result = {_mm256_set1_pd(a)};
+        return result;
+    }
+    static inline f64x4 Load(const f64 *p)
+    {
+        f64x4 result = {_mm256_loadu_pd(p)};
+        return result;
+    }
+    static inline f64x4 Load(const u16 *p)
+    {
+        __m128i packed = _mm_loadl_epi64((const __m128i *)p);
+        f64x4 result = {_mm256_cvtepi32_pd(_mm_cvtepu16_epi32(packed))};
+        return result;
+    }
+    static inline void Store(f64 *p, f64x4 a)
+    {
+        _mm256_storeu_pd(p, a.V);
+    }
+};
+
+struct f64x4_mask
+{
+    __m256d V;
+};
+
+inline f64x4 operator+(f64x4 a, f64x4 b) { return {_mm256_add_pd(a.V, b.V)}; }
+inline f64x4 operator-(f64x4 a, f64x4 b) { return {_mm256_sub_pd(a.V, b.V)}; }
+inline f64x4 operator*(f64x4 a, f64x4 b) { return {_mm256_mul_pd(a.V, b.V)}; }
+inline f64x4 operator/(f64x4 a, f64x4 b) { return {_mm256_div_pd(a.V, b.V)}; }
+inline f64x4 operator-(f64x4 a) { return {_mm256_sub_pd(_mm256_setzero_pd(), a.V)}; }
+
+inline f64x4 operator+(f64x4 a, f64 b) { return a + f64x4::Set(b); }
+inline f64x4 operator-(f64x4 a, f64 b) { return a - f64x4::Set(b); }
+inline f64x4 operator*(f64x4 a, f64 b) { return a * f64x4::Set(b); }
+inline f64x4 operator/(f64x4 a, f64 b) { return a / f64x4::Set(b); }
+inline f64x4 operator+(f64 a, f64x4 b) { return f64x4::Set(a) + b; }
+inline f64x4 operator-(f64 a, f64x4 b) { return f64x4::Set(a) - b; }
+inline f64x4 operator*(f64 a, f64x4 b) { return f64x4::Set(a) * b; }
+inline f64x4 operator/(f64 a, f64x4 b) { return f64x4::Set(a) / b; }
+
+inline f64x4_mask
+GreaterThan(f64x4 a, f64 b)
+{
+    return {_mm256_cmp_pd(a.V, _mm256_set1_pd(b), _CMP_GT_OQ)};
+}
+
+inline f64x4
+Select(f64x4_mask mask, f64x4 a, f64x4 b)
+{
+    return {_mm256_blendv_pd(b.V, a.V, mask.V)};
+}
+
+inline f64x4_mask
+GreaterThan(f64x4 a, f64x4 b)
+{
+    return {_mm256_cmp_pd(a.V, b.V, _CMP_GT_OQ)};
+}
+
+inline f64x4_mask operator&(f64x4_mask a, f64x4_mask b) { return {_mm256_and_pd(a.V, b.V)}; }
+inline f64x4_mask operator|(f64x4_mask a, f64x4_mask b) { return {_mm256_or_pd(a.V, b.V)}; }
+
+// a and not b
+inline f64x4_mask
+AndNot(f64x4_mask a, f64x4_mask b)
+{
+    return {_mm256_andnot_pd(b.V, a.V)};
+}
+
+// Bit per lane, lane 0 in bit 0.
+inline u32
+GetMaskBits(f64x4_mask mask)
+{
+    return (u32)_mm256_movemask_pd(mask.V);
+}
+
+// NOTE: Same as the scalar Minimum/Maximum macros, (a < b) ? a : b.
+inline f64x4
+Min(f64x4 a, f64x4 b)
+{
+    return {_mm256_min_pd(a.V, b.V)};
+}
+
+inline f64x4
+Max(f64x4 a, f64x4 b)
+{
+    return {_mm256_max_pd(a.V, b.V)};
+}
+
+inline f64x4
+SquareRoot(f64x4 a)
+{
+    return {_mm256_sqrt_pd(a.V)};
+}
+
+inline f64x4
+Round(f64x4 a)
+{
+    return {_mm256_round_pd(a.V, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)};
+}
+
+// Unbiased binary exponent of a positive normal value, as a double.
+inline f64x4
+ExtractExponent(f64x4 a)
+{
+    __m256i magic = _mm256_castpd_si256(_mm256_set1_pd(4503599627370496.0)); // 2^52
+    __m256i bits = _mm256_srli_epi64(_mm256_castpd_si256(a.V), 52);
+    __m256d biased = _mm256_castsi256_pd(_mm256_or_si256(bits, magic));
+    return {_mm256_sub_pd(biased, _mm256_set1_pd(4503599627370496.0 + 1023.0))};
+}
+
+// Mantissa of a positive normal value, scaled to [1, 2).
+inline f64x4
+ExtractMantissa(f64x4 a)
+{
+    __m256i bits = _mm256_and_si256(_mm256_castpd_si256(a.V), _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL));
+    bits = _mm256_or_si256(bits, _mm256_set1_epi64x(0x3FF0000000000000LL));
+    return {_mm256_castsi256_pd(bits)};
+}
+
+// a * 2^k for integral k in [-1022, 1023].
+inline f64x4
+ScaleByPowerOf2(f64x4 a, f64x4 k)
+{
+    __m256d biased = _mm256_add_pd(k.V, _mm256_set1_pd(4503599627370496.0 + 1023.0));
+    __m256i bits = _mm256_slli_epi64(_mm256_castpd_si256(biased), 52);
+    return {_mm256_mul_pd(a.V, _mm256_castsi256_pd(bits))};
+}
+
+
+#define WIDE f64x4
+#include "ss_math_wide.inl"
+#undef WIDE
+
+// NOTE: Eight floats, for the single-precision batch (ss_batch_f32.cpp).
+// Load and Store also take f64 columns and convert on the way.
+struct f32x8
+{
+    __m256 V;
+
+    enum
+    {
+        Width = 8
+    };
+
+    static inline f32x8 Set(f32 a)
+    {
+        f32x8 result = {_mm256_set1_ps(a)};
+        return result;
+    }
+    static inline f32x8 Load(const f32 *p)
+    {
+        f32x8 result = {_mm256_loadu_ps(p)};
+        return result;
+    }
+    static inline f32x8 Load(const f64 *p)
+    {
+        __m128 low = _mm256_cvtpd_ps(_mm256_loadu_pd(p));
+        __m128 high = _mm256_cvtpd_ps(_mm256_loadu_pd(p + 4));
+        f32x8 result = {_mm256_set_m128(high, low)};
+        return result;
+    }
+    static inline f32x8 Load(const u16 *p)
+    {
+        __m128i packed = _mm_loadu_si128((const __m128i *)p);
+        f32x8 result = {_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(packed))};
+        return result;
+    }
+    static inline void Store(f32 *p, f32x8 a)
+    {
+        _mm256_storeu_ps(p, a.V);
+    }
+    static inline void Store(f64 *p, f32x8 a)
+    {
+        _mm256_storeu_pd(p, _mm256_cvtps_pd(_mm256_castps256_ps128(a.V)));
+        _mm256_storeu_pd(p + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(a.V, 1)));
+    }
+};
+
+struct f32x8_mask
+{
+    __m256 V;
+};
+
+inline f32x8 operator+(f32x8 a, f32x8 b) { return {_mm256_add_ps(a.V, b.V)}; }
+inline f32x8 operator-(f32x8 a, f32x8 b) { return {_mm256_sub_ps(a.V, b.V)}; }
+inline f32x8 operator*(f32x8 a, f32x8 b) { return {_mm256_mul_ps(a.V, b.V)}; }
+inline f32x8 operator/(f32x8 a, f32x8 b) { return {_mm256_div_ps(a.V, b.V)}; }
+inline f32x8 operator-(f32x8 a) { return {_mm256_sub_ps(_mm256_setzero_ps(), a.V)}; }
+
+inline f32x8 operator+(f32x8 a, f32 b) { return a + f32x8::Set(b); }
+inline f32x8 operator-(f32x8 a, f32 b) { return a - f32x8::Set(b); }
+inline f32x8 operator*(f32x8 a, f32 b) { return a * f32x8::Set(b); }
+inline f32x8 operator/(f32x8 a, f32 b) { return a / f32x8::Set(b); }
+inline f32x8 operator+(f32 a, f32x8 b) { return f32x8::Set(a) + b; }
+inline f32x8 operator-(f32 a, f32x8 b) { return f32x8::Set(a) - b; }
+inline f32x8 operator*(f32 a, f32x8 b) { return f32x8::Set(a) * b; }
+inline f32x8 operator/(f32 a, f32x8 b) { return f32x8::Set(a) / b; }
+
+inline f32x8_mask
+GreaterThan(f32x8 a, f32 b)
+{
+    return {_mm256_cmp_ps(a.V, _mm256_set1_ps(b), _CMP_GT_OQ)};
+}
+
+inline f32x8
+Select(f32x8_mask mask, f32x8 a, f32x8 b)
+{
+    return {_mm256_blendv_ps(b.V, a.V, mask.V)};
+}
+
+inline f32x8_mask
+GreaterThan(f32x8 a, f32x8 b)
+{
+    return {_mm256_cmp_ps(a.V, b.V, _CMP_GT_OQ)};
+}
+
+inline f32x8_mask operator&(f32x8_mask a, f32x8_mask b) { return {_mm256_and_ps(a.V, b.V)}; }
+inline f32x8_mask operator|(f32x8_mask a, f32x8_mask b) { return {_mm256_or_ps(a.V, b.V)}; }
+
+inline f32x8_mask
+AndNot(f32x8_mask a, f32x8_mask b)
+{
+    return {_mm256_andnot_ps(b.V, a.V)};
+}
+
+inline u32
+GetMaskBits(f32x8_mask mask)
+{
+    return (u32)_mm256_movemask_ps(mask.V);
+}
+
+inline f32x8
+Min(f32x8 a, f32x8 b)
+{
+    return {_mm256_min_ps(a.V, b.V)};
+}
+
+inline f32x8
+Max(f32x8 a, f32x8 b)
+{
+    return {_mm256_max_ps(a.V, b.V)};
+}
+
+inline f32x8
+SquareRoot(f32x8 a)
+{
+    return {_mm256_sqrt_ps(a.V)};
+}
+
+inline f32x8
+Round(f32x8 a)
+{
+    return {_mm256_round_ps(a.V, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)};
+}
+
+inline f32x8
+ExtractExponent(f32x8 a)
+{
+    __m256i bits = _mm256_srli_epi32(_mm256_castps_si256(a.V), 23);
+    return {_mm256_cvtepi32_ps(_mm256_sub_epi32(bits, _mm256_set1_epi32(127)))};
+}
+
+inline f32x8
+ExtractMantissa(f32x8 a)
+{
+    __m256i bits = _mm256_and_si256(_mm256_castps_si256(a.V), _mm256_set1_epi32(0x007FFFFF));
+    bits = _mm256_or_si256(bits, _mm256_set1_epi32(0x3F800000));
+    return {_mm256_castsi256_ps(bits)};
+}
+
+// a * 2^k for integral k in [-126, 127].
+inline f32x8
+ScaleByPowerOf2(f32x8 a, f32x8 k)
+{
+    __m256i biased = _mm256_add_epi32(_mm256_cvtps_epi32(k.V), _mm256_set1_epi32(127));
+    return {_mm256_mul_ps(a.V, _mm256_castsi256_ps(_mm256_slli_epi32(biased, 23)))};
+}
+
+#define WIDE f32x8
+#include "ss_math_wide_f32.inl"
+#undef WIDE
+
+END_TARGET
+
+BEGIN_TARGET_AVX512
+
+struct f64x8
+{
+    __m512d V;
+
+    enum
+    {
+        Width = 8
+    };
+
+    static inline f64x8 Set(f64 a)
+    {
+        f64x8 result = {_mm512_set1_pd(a)};
+        return result;
+    }
+    static inline f64x8 Load(const f64 *p)
+    {
+        f64x8 result = {_mm512_loadu_pd(p)};
+        return result;
+    }
+    static inline f64x8 Load(const u16 *p)
+    {
+        __m128i packed = _mm_loadu_si128((const __m128i *)p);
+        f64x8 result = {_mm512_cvtepi32_pd(_mm256_cvtepu16_epi32(packed))};
+        return result;
+    }
+    static inline void Store(f64 *p, f64x8 a)
+    {
+        _mm512_storeu_pd(p, a.V);
+    }
+};
+
+struct f64x8_mask
+{
+    __mmask8 V;
+};
+
+inline f64x8 operator+(f64x8 a, f64x8 b) { return {_mm512_add_pd(a.V, b.V)}; }
+inline f64x8 operator-(f64x8 a, f64x8 b) { return {_mm512_sub_pd(a.V, b.V)}; }
+inline f64x8 operator*(f64x8 a, f64x8 b) { return {_mm512_mul_pd(a.V, b.V)}; }
+inline f64x8 operator/(f64x8 a, f64x8 b) { return {_mm512_div_pd(a.V, b.V)}; }
+inline f64x8 operator-(f64x8 a) { return {_mm512_sub_pd(_mm512_setzero_pd(), a.V)}; }
+
+inline f64x8 operator+(f64x8 a, f64 b) { return a + f64x8::Set(b); }
+inline f64x8 operator-(f64x8 a, f64 b) { return a - f64x8::Set(b); }
+inline f64x8 operator*(f64x8 a, f64 b) { return a * f64x8::Set(b); }
+inline f64x8 operator/(f64x8 a, f64 b) { return a / f64x8::Set(b); }
+inline f64x8 operator+(f64 a, f64x8 b) { return f64x8::Set(a) + b; }
+inline f64x8 operator-(f64 a, f64x8 b) { return f64x8::Set(a) - b; }
+inline f64x8 operator*(f64 a, f64x8 b) { return f64x8::Set(a) * b; }
+inline f64x8 operator/(f64 a, f64x8 b) { return f64x8::Set(a) / b; }
+
+inline f64x8_mask
+GreaterThan(f64x8 a, f64 b)
+{
+    return {_mm512_cmp_pd_mask(a.V, _mm512_set1_pd(b), _CMP_GT_OQ)};
+}
+
+inline f64x8
+Select(f64x8_mask mask, f64x8 a, f64x8 b)
+{
+    return {_mm512_mask_blend_pd(mask.V, b.V, a.V)};
+}
+
+inline f64x8_mask
+GreaterThan(f64x8 a, f64x8 b)
+{
+    return {_mm512_cmp_pd_mask(a.V, b.V, _CMP_GT_OQ)};
+}
+
+inline f64x8_mask operator&(f64x8_mask a, f64x8_mask b) { return {(__mmask8)(a.V & b.V)}; }
+inline f64x8_mask operator|(f64x8_mask a, f64x8_mask b) { return {(__mmask8)(a.V | b.V)}; }
+
+inline f64x8_mask
+AndNot(f64x8_mask a, f64x8_mask b)
+{
+    return {(__mmask8)(a.V & ~b.V)};
+}
+
+inline u32
+GetMaskBits(f64x8_mask mask)
+{
+    return (u32)mask.V;
+}
+
+inline f64x8
+Min(f64x8 a, f64x8 b)
+{
+    return {_mm512_min_pd(a.V, b.V)};
+}
+
+inline f64x8
+Max(f64x8 a, f64x8 b)
+{
+    return {_mm512_max_pd(a.V, b.V)};
+}
+
+inline f64x8
+SquareRoot(f64x8 a)
+{
+    return {_mm512_sqrt_pd(a.V)};
+}
+
+inline f64x8
+Round(f64x8 a)
+{
+    return {_mm512_roundscale_pd(a.V, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)};
+}
+
+inline f64x8
+ExtractExponent(f64x8 a)
+{
+    __m512i magic = _mm512_castpd_si512(_mm512_set1_pd(4503599627370496.0)); // 2^52
+    __m512i bits = _mm512_srli_epi64(_mm512_castpd_si512(a.V), 52);
+    __m512d biased = _mm512_castsi512_pd(_mm512_or_si512(bits, magic));
+    return {_mm512_sub_pd(biased, _mm512_set1_pd(4503599627370496.0 + 1023.0))};
+}
+
+inline f64x8
+ExtractMantissa(f64x8 a)
+{
+    __m512i bits = _mm512_and_si512(_mm512_castpd_si512(a.V), _mm512_set1_epi64(0x000FFFFFFFFFFFFFLL));
+    bits = _mm512_or_si512(bits, _mm512_set1_epi64(0x3FF0000000000000LL));
+    return {_mm512_castsi512_pd(bits)};
+}
+
+inline f64x8
+ScaleByPowerOf2(f64x8 a, f64x8 k)
+{
+    __m512d biased = _mm512_add_pd(k.V, _mm512_set1_pd(4503599627370496.0 + 1023.0));
+    __m512i bits = _mm512_slli_epi64(_mm512_castpd_si512(biased), 52);
+    return {_mm512_mul_pd(a.V, _mm512_castsi512_pd(bits))};
+}
+
+
+#define WIDE f64x8
+#include "ss_math_wide.inl"
+#undef WIDE
+
+struct f32x16
+{
+    __m512 V;
+
+    enum
+    {
+        Width = 16
+    };
+
+    static inline f32x16 Set(f32 a)
+    {
+        f32x16 result = {_mm512_set1_ps(a)};
+        return result;
+    }
+    static inline f32x16 Load(const f32 *p)
+    {
+        f32x16 result = {_mm512_loadu_ps(p)};
+        return result;
+    }
+    static inline f32x16 Load(const f64 *p)
+    {
+        __m256d low = _mm256_castps_pd(_mm512_cvtpd_ps(_mm512_loadu_pd(p)));
+        __m256d high = _mm256_castps_pd(_mm512_cvtpd_ps(_mm512_loadu_pd(p + 8)));
+        f32x16 result = {_mm512_castpd_ps(_mm512_insertf64x4(_mm512_castpd256_pd512(low), high, 1))};
+        return result;
+    }
+    static inline f32x16 Load(const u16 *p)
+    {
+        __m256i packed = _mm256_loadu_si256((const __m256i *)p);
+        f32x16 result = {_mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(packed))};
+        return result;
+    }
+    static inline void Store(f32 *p, f32x16 a)
+    {
+        _mm512_storeu_ps(p, a.V);
+    }
+    static inline void Store(f64 *p, f32x16 a)
+    {
+        __m256 high = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a.V), 1));
+        _mm512_storeu_pd(p, _mm512_cvtps_pd(_mm512_castps512_ps256(a.V)));
+        _mm512_storeu_pd(p + 8, _mm512_cvtps_pd(high));
+    }
+};
+
+struct f32x16_mask
+{
+    __mmask16 V;
+};
+
+inline f32x16 operator+(f32x16 a, f32x16 b) { return {_mm512_add_ps(a.V, b.V)}; }
+inline f32x16 operator-(f32x16 a, f32x16 b) { return {_mm512_sub_ps(a.V, b.V)}; }
+inline f32x16 operator*(f32x16 a, f32x16 b) { return {_mm512_mul_ps(a.V, b.V)}; }
+inline f32x16 operator/(f32x16 a, f32x16 b) { return {_mm512_div_ps(a.V, b.V)}; }
+inline f32x16 operator-(f32x16 a) { return {_mm512_sub_ps(_mm512_setzero_ps(), a.V)}; }
+
+inline f32x16 operator+(f32x16 a, f32 b) { return a + f32x16::Set(b); }
+inline f32x16 operator-(f32x16 a, f32 b) { return a - f32x16::Set(b); }
+inline f32x16 operator*(f32x16 a, f32 b) { return a * f32x16::Set(b); }
+inline f32x16 operator/(f32x16 a, f32 b) { return a / f32x16::Set(b); }
+inline f32x16 operator+(f32 a, f32x16 b) { return f32x16::Set(a) + b; }
+inline f32x16 operator-(f32 a, f32x16 b) { return f32x16::Set(a) - b; }
+inline f32x16 operator*(f32 a, f32x16 b) { return f32x16::Set(a) * b; }
+inline f32x16 operator/(f32 a, f32x16 b) { return f32x16::Set(a) / b; }
+
+inline f32x16_mask
+GreaterThan(f32x16 a, f32 b)
+{
+    return {_mm512_cmp_ps_mask(a.V, _mm512_set1_ps(b), _CMP_GT_OQ)};
+}
+
+inline f32x16
+Select(f32x16_mask mask, f32x16 a, f32x16 b)
+{
+    return {_mm512_mask_blend_ps(mask.V, b.V, a.V)};
+}
+
+inline f32x16_mask
+GreaterThan(f32x16 a, f32x16 b)
+{
+    return {_mm512_cmp_ps_mask(a.V, b.V, _CMP_GT_OQ)};
+}
+
+inline f32x16_mask operator&(f32x16_mask a, f32x16_mask b) { return {(__mmask16)(a.V & b.V)}; }
+inline f32x16_mask operator|(f32x16_mask a, f32x16_mask b) { return {(__mmask16)(a.V | b.V)}; }
+
+inline f32x16_mask
+AndNot(f32x16_mask a, f32x16_mask b)
+{
+    return {(__mmask16)(a.V & ~b.V)};
+}
+
+inline u32
+GetMaskBits(f32x16_mask mask)
+{
+    return (u32)mask.V;
+}
+
+inline f32x16
+Min(f32x16 a, f32x16 b)
+{
+    return {_mm512_min_ps(a.V, b.V)};
+}
+
+inline f32x16
+Max(f32x16 a, f32x16 b)
+{
+    return {_mm512_max_ps(a.V, b.V)};
+}
+
+inline f32x16
+SquareRoot(f32x16 a)
+{
+    return {_mm512_sqrt_ps(a.V)};
+}
+
+inline f32x16
+Round(f32x16 a)
+{
+    return {_mm512_roundscale_ps(a.V, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)};
+}
+
+inline f32x16
+ExtractExponent(f32x16 a)
+{
+    __m512i bits = _mm512_srli_epi32(_mm512_castps_si512(a.V), 23);
+    return {_mm512_cvtepi32_ps(_mm512_sub_epi32(bits, _mm512_set1_epi32(127)))};
+}
+
+inline f32x16
+ExtractMantissa(f32x16 a)
+{
+    __m512i bits = _mm512_and_si512(_mm512_castps_si512(a.V), _mm512_set1_epi32(0x007FFFFF));
+    bits = _mm512_or_si512(bits, _mm512_set1_epi32(0x3F800000));
+    return {_mm512_castsi512_ps(bits)};
+}
+
+inline f32x16
+ScaleByPowerOf2(f32x16 a, f32x16 k)
+{
+    __m512i biased = _mm512_add_epi32(_mm512_cvtps_epi32(k.V), _mm512_set1_epi32(127));
+    return {_mm512_mul_ps(a.V, _mm512_castsi512_ps(_mm512_slli_epi32(biased, 23)))};
+}
+
+#define WIDE f32x16
+#include "ss_math_wide_f32.inl"
+#undef WIDE
+
+END_TARGET
@@ -0,0 +1,176 @@
+// NOTE: Lane-width independent transcendental kernels. ss_math.h includes this
+// once per wide type (f64x1, f64x2, f64x4, f64x8) with WIDE defined to that
+// type, inside the matching target region. Inputs are assumed finite and in
+// the domains the boiler formulas use; there is no special-case handling of
+// 0, inf, NaN or denormals.
+//
+// Accuracy against libm, x in [1e-6, 1e6] (ss_bench -accuracy enforces these
+// bounds for every wide type):
+//   Log        <= 1 ULP
+//   Exp        <= 1 ULP for |x| < 708
+//   Pow, Root  <= 8 ULP while |e * ln(x)| <= 4 (measured 7 over 64M
+//              arguments), <= 12 ULP while |e * ln(x)| <= 9 (measured 11).
+//              The rounding of Log(x) is scaled by e, so the error grows
+//              about linearly with |e * ln(x)|. The call sites in ss_boiler.cpp
+//              stay within 8 ULP (measured 7, omega^0.7 and (tk - tb)^(4/3)).
+//   SquareRoot  exact (IEEE sqrt)
+// In MathMode_Fast Pow, Root and Exp use FastLog2/FastExp2 below and x^(5/8)
+// the square root kernel, with the error of the scalar fast tier (ss_math.h).
+
+// Natural logarithm, after fdlibm's __ieee754_log.
+inline WIDE
+Log(WIDE x)
+{
+    const f64 Ln2Hi = 6.93147180369123816490e-01;
+    const f64 Ln2Lo = 1.90821492927058770002e-10;
+    const f64 Lg1 = 6.666666666666735130e-01;
+    const f64 Lg2 = 3.999999999940941908e-01;
+    const f64 Lg3 = 2.857142874366239149e-01;
+    const f64 Lg4 = 2.222219843214978396e-01;
+    const f64 Lg5 = 1.818357216161805012e-01;
+    const f64 Lg6 = 1.531383769920937332e-01;
+    const f64 Lg7 = 1.479819860511658591e-01;
+
+    // x = 2^e * m, m in [sqrt(2)/2, sqrt(2))
+    WIDE e = ExtractExponent(x);
+    WIDE m = ExtractMantissa(x);
+    auto isLarge = GreaterThan(m, 1.41421356237309504880);
+    m = Select(isLarge, m * 0.5, m);
+    e = Select(isLarge, e + 1.0, e);
+
+    WIDE f = m - 1.0;
+    WIDE s = f / (2.0 + f);
+    WIDE z = s * s;
+    WIDE w = z * z;
+    WIDE t1 = w * (Lg2 + w * (Lg4 + w * Lg6));
+    WIDE t2 = z * (Lg1 + w * (Lg3 + w * (Lg5 + w * Lg7)));
+    WIDE R = t2 + t1;
+    WIDE hfsq = 0.5 * f * f;
+
+    return e * Ln2Hi - ((hfsq - (s * (hfsq + R) + e * Ln2Lo)) - f);
+}
+
+inline WIDE FastExp2(WIDE x);
+
+// e^x in the current math_mode; the reference kernel is after fdlibm's
+// __ieee754_exp.
+inline WIDE
+Exp(WIDE x)
+{
+    if (GlobalMathMode == MathMode_Fast)
+    {
+        return FastExp2(x * 1.44269504088896340736);
+    }
+
+    const f64 InvLn2 = 1.44269504088896338700e+00;
+    const f64 Ln2Hi = 6.93147180369123816490e-01;
+    const f64 Ln2Lo = 1.90821492927058770002e-10;
+    const f64 P1 = 1.66666666666666019037e-01;
+    const f64 P2 = -2.77777777770155933842e-03;
+    const f64 P3 = 6.61375632143793436117e-05;
+    const f64 P4 = -1.65339022054652515390e-06;
+    const f64 P5 = 4.13813679705723846039e-08;
+
+    // x = k * ln2 + r, |r| <= 0.5 * ln2
+    WIDE k = Round(x * InvLn2);
+    WIDE hi = x - k * Ln2Hi;
+    WIDE lo = k * Ln2Lo;
+    WIDE r = hi - lo;
+
+    WIDE t = r * r;
+    WIDE c = r - t * (P1 + t * (P2 + t * (P3 + t * (P4 + t * P5))));
+    WIDE y = 1.0 - ((lo - (r * c) / (2.0 - c)) - hi);
+
+    return ScaleByPowerOf2(y, k);
+}
+
+// Fast tier, the same kernels as the scalar FastLog2/FastExp2 in ss_math.h
+inline WIDE
+FastLog2(WIDE x)
+{
+    WIDE e = ExtractExponent(x);
+    WIDE m = ExtractMantissa(x);
+    auto isLarge = GreaterThan(m, 1.41421356237309504880);
+    m = Select(isLarge, m * 0.5, m);
+    e = Select(isLarge, e + 1.0, e);
+
+    WIDE s = (m - 1.0) / (m + 1.0);
+    WIDE z = s * s;
+    WIDE p = FastLog2P0 + z * (FastLog2P1 + z * (FastLog2P2 + z * (FastLog2P3 + z * FastLog2P4)));
+    return e + s * p;
+}
+
+inline WIDE
+FastExp2(WIDE x)
+{
+    WIDE k = Round(x);
+    WIDE f = x - k;
+    WIDE p = FastExp2P0 + f * (FastExp2P1 + f * (FastExp2P2 + f * (FastExp2P3 + f * (FastExp2P4 +
+             f * (FastExp2P5 + f * (FastExp2P6 + f * FastExp2P7))))));
+    return ScaleByPowerOf2(p, k);
+}
+
+// x^e for x > 0 in the current math_mode; x^(5/8) has the same square root
+// kernel as the scalar FastPowFiveEighths.
+inline WIDE
+Pow(WIDE x, f64 e)
+{
+    if (GlobalMathMode == MathMode_Fast)
+    {
+        if (e == 0.625)
+        {
+            WIDE x2 = x * x;
+            return SquareRoot(SquareRoot(SquareRoot(x2 * x2 * x)));
+        }
+        return FastExp2(FastLog2(x) * e);
+    }
+    return Exp(Log(x) * e);
+}
+
+inline WIDE
+Root(WIDE input, f64 n)
+{
+    return Pow(input, 1.0 / n);
+}
+
+// NOTE: Lane versions of the scalar helpers in ss_math.h, with the same
+// operation order, so each lane matches the scalar result bit for bit unless
+// the compiler fuses a multiply-add (GCC does in the AVX-512 region).
+inline WIDE
+Map(WIDE x, f64 inMin, f64 inMax, f64 outMin, f64 outMax)
+{
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+inline WIDE
+LimitF(WIDE value, f64 minValue, f64 maxValue)
+{
+    WIDE limited = Select(GreaterThan(WIDE::Set(minValue), value), WIDE::Set(minValue), value);
+    return Select(GreaterThan(value, maxValue), WIDE::Set(maxValue), limited);
+}
+
+inline WIDE
+Min(WIDE a, f64 b)
+{
+    return Min(a, WIDE::Set(b));
+}
+
+inline WIDE
+Max(WIDE a, f64 b)
+{
+    return Max(a, WIDE::Set(b));
+}
+
+// Larger root of a x^2 + b x + c = 0, -1 for lanes without real roots
+inline WIDE
+SolveQuadratic(WIDE a, WIDE b, WIDE c)
+{
+    WIDE D = (b * b) - (4.0 * a * c);
+    WIDE sqrtD = SquareRoot(Max(D, 0.0));
+
+    WIDE x1 = (-b + sqrtD) / (2.0 * a);
+    WIDE x2 = (-b - sqrtD) / (2.0 * a);
+    WIDE result = Select(GreaterThan(x1, x2), x1, x2);
+
+    return Select(GreaterThan(WIDE::Set(0.0), D), WIDE::Set(-1.0), result);
+}
@@ -0,0 +1,47 @@
+// NOTE: Single-precision kernels. ss_math.h includes this once per f32 wide
+// type with WIDE defined to that type, inside the matching target region.
+// There is one tier only: the polynomials of the scalar FastLog2/FastExp2
+// evaluated in f32, whatever GlobalMathMode says. Inputs must be positive
+// normal floats, no special-case handling.
+//
+// Accuracy against libm pow (ss_batch_f32.cpp measures it over the boiler
+// envelope): relative error <= 4 ULP of f32 (2.4e-7) while |e * log2(x)| <= 4.
+
+inline WIDE
+FastLog2(WIDE x)
+{
+    WIDE e = ExtractExponent(x);
+    WIDE m = ExtractMantissa(x);
+    auto isLarge = GreaterThan(m, 1.41421356237309504880f);
+    m = Select(isLarge, m * 0.5f, m);
+    e = Select(isLarge, e + 1.0f, e);
+
+    WIDE s = (m - 1.0f) / (m + 1.0f);
+    WIDE z = s * s;
+    WIDE p = (f32)FastLog2P0 + z * ((f32)FastLog2P1 + z * ((f32)FastLog2P2 + z * ((f32)FastLog2P3 +
+             z * (f32)FastLog2P4)));
+    return e + s * p;
+}
+
+inline WIDE
+FastExp2(WIDE x)
+{
+    WIDE k = Round(x);
+    WIDE f = x - k;
+    WIDE p = (f32)FastExp2P0 + f * ((f32)FastExp2P1 + f * ((f32)FastExp2P2 + f * ((f32)FastExp2P3 +
+             f * ((f32)FastExp2P4 + f * ((f32)FastExp2P5 + f * ((f32)FastExp2P6 + f * (f32)FastExp2P7))))));
+    return ScaleByPowerOf2(p, k);
+}
+
+// x^e for x > 0
+inline WIDE
+Pow(WIDE x, f32 e)
+{
+    return FastExp2(FastLog2(x) * e);
+}
+
+inline WIDE
+Root(WIDE input, f32 n)
+{
+    return Pow(input, 1.0f / n);
+}
@@ -0,0 +1,432 @@
+// Метод Монте-Карло: разброс состава топлива и режима горения через всю
+// цепочку расчета.
+//
+// Выборка номер sample целиком определяется парой (sample, Seed): случайные
+// числа берутся из Philox4x32 со счетчиком sample, поэтому любой поток
+// может посчитать любую выборку и результат не зависит от числа потоков.
+// Выборки режутся на куски по MONTE_CARLO_CHUNK_SIZE, кусок считается одним
+// пакетом CalculateBoilerBatch (дымогарные трубы - векторно). Потоки копят
+// свои гистограммы, средние и разбросы хранятся по кускам и сливаются по
+// порядку кусков.
+
+#define MONTE_CARLO_CHUNK_SIZE 4096
+
+// NOTE: Salt for the Philox counter word that numbers the draws of one sample.
+enum monte_carlo_draw
+{
+    MonteCarloDraw_CH,
+    MonteCarloDraw_OAlpha,
+    MonteCarloDraw_UK,
+};
+
+// обратная функция треугольного распределения
+inline f64
+SampleTriangular(MonteCarloDistribution distribution, f64 unit)
+{
+    f64 range = distribution.Max - distribution.Min;
+    if (range <= 0.0)
+    {
+        return distribution.Mode;
+    }
+
+    f64 left = distribution.Mode - distribution.Min;
+    f64 right = distribution.Max - distribution.Mode;
+    if (unit * range < left)
+    {
+        return distribution.Min + sqrt(unit * range * left);
+    }
+    return distribution.Max - sqrt((1.0 - unit) * range * right);
+}
+
+// Топливо выборки sample. Продукты сгорания CO2, O2, N2 пересчитываются по
+// beta0 и alpha, CO (недожог) остается как в исходном топливе.
+internal void
+GetMonteCarloSample(MonteCarloSpec *spec, u64 sample, Fuel *fuel, f64 *q22)
+{
+    u32 key0 = (u32)spec->Seed;
+    u32 key1 = (u32)(spec->Seed >> 32);
+    u32 counter0 = (u32)sample;
+    u32 counter1 = (u32)(sample >> 32);
+
+    auto ch = Philox4x32(counter0, counter1, MonteCarloDraw_CH, 0, key0, key1);
+    auto oAlpha = Philox4x32(counter0, counter1, MonteCarloDraw_OAlpha, 0, key0, key1);
+    auto uK = Philox4x32(counter0, counter1, MonteCarloDraw_UK, 0, key0, key1);
+
+    auto variables = spec->Variables;
+    *fuel = spec->BaseFuel;
+    fuel->C = SampleTriangular(variables[MonteCarloVariable_C], UnitF64FromBits(ch.V[0], ch.V[1]));
+    fuel->H = SampleTriangular(variables[MonteCarloVariable_H], UnitF64FromBits(ch.V[2], ch.V[3]));
+    fuel->O = SampleTriangular(variables[MonteCarloVariable_O], UnitF64FromBits(oAlpha.V[0], oAlpha.V[1]));
+    fuel->alpha = SampleTriangular(variables[MonteCarloVariable_alpha], UnitF64FromBits(oAlpha.V[2], oAlpha.V[3]));
+    f64 u = SampleTriangular(variables[MonteCarloVariable_u], UnitF64FromBits(uK.V[0], uK.V[1]));
+    fuel->K = SampleTriangular(variables[MonteCarloVariable_K], UnitF64FromBits(uK.V[2], uK.V[3]));
+
+    GetBeta0(*fuel);
+    GetCO2(*fuel);
+    GetO2(*fuel);
+    GetN2(*fuel);
+
+    // GetBhFact берет u из q22
+    *q22 = 100.0 * (1.0 - u);
+}
+
+struct MonteCarloChunkSummary
+{
+    u32 Count;
+    f64 Mean[MonteCarloOutput_Count];
+    f64 M2[MonteCarloOutput_Count]; // сумма квадратов отклонений от Mean
+    f64 Lowest[MonteCarloOutput_Count];
+    f64 Highest[MonteCarloOutput_Count];
+};
+
+struct MonteCarloWorkspace
+{
+    // постоянная геометрия котла и переменные топливо и q22 по выборкам
+    f64 Geometry[SweepParameter_Count][MONTE_CARLO_CHUNK_SIZE];
+    u16 Nd[MONTE_CARLO_CHUNK_SIZE];
+    Fuel Fuels[MONTE_CARLO_CHUNK_SIZE];
+    u32 FuelIndex[MONTE_CARLO_CHUNK_SIZE];
+
+    f64 Output[sizeof(BoilerBatchOutput) / sizeof(f64 *)][MONTE_CARLO_CHUNK_SIZE];
+    f64 Values[MonteCarloOutput_Count][MONTE_CARLO_CHUNK_SIZE];
+
+    // NOTE: Bins only; Min/Max are shared and live in MonteCarloWork.
+    u64 Counts[MonteCarloOutput_Count][MONTE_CARLO_HISTOGRAM_BINS];
+    u64 Below[MonteCarloOutput_Count];
+    u64 Above[MonteCarloOutput_Count];
+};
+
+struct MonteCarloWork
+{
+    MonteCarloSpec *Spec;
+    u64 SampleCount;
+    u32 ChunkCount;
+    MonteCarloChunkSummary *Summaries;
+    MonteCarloWorkspace *Workspaces; // по одному на поток
+    f64 HistogramMin[MonteCarloOutput_Count];
+    f64 HistogramScale[MonteCarloOutput_Count]; // бинов на единицу величины
+    std::atomic<u32> NextChunk;
+};
+
+internal void
+InitializeMonteCarloWorkspace(MonteCarloSpec *spec, MonteCarloWorkspace *workspace)
+{
+    for (u32 index = 0; index < MONTE_CARLO_CHUNK_SIZE; ++index)
+    {
+        workspace->Geometry[SweepParameter_TopLengh][index] = spec->Chamber.TopLengh;
+        workspace->Geometry[SweepParameter_TopWidth][index] = spec->Chamber.TopWidth;
+        workspace->Geometry[SweepParameter_BottomLength][index] = spec->Chamber.BottomLength;
+        workspace->Geometry[SweepParameter_BottomWidth][index] = spec->Chamber.BottomWidth;
+        workspace->Geometry[SweepParameter_FrontHeight][index] = spec->Chamber.FrontHeight;
+        workspace->Geometry[SweepParameter_RearHeight][index] = spec->Chamber.RearHeight;
+        workspace->Geometry[SweepParameter_DOut][index] = spec->Dd.DOut;
+        workspace->Geometry[SweepParameter_DIn][index] = spec->Dd.DIn;
+        workspace->Geometry[SweepParameter_Ld][index] = spec->Ld;
+        workspace->Geometry[SweepParameter_U][index] = spec->Chamber.U;
+        workspace->Nd[index] = spec->Nd;
+        workspace->FuelIndex[index] = index;
+    }
+    ZeroSize(sizeof(workspace->Counts), workspace->Counts);
+    ZeroSize(sizeof(workspace->Below), workspace->Below);
+    ZeroSize(sizeof(workspace->Above), workspace->Above);
+}
+
+// считает кусок chunk в workspace->Values и его сводку
+internal void
+CalculateMonteCarloChunk(MonteCarloWork *work, MonteCarloWorkspace *workspace, u32 chunk)
+{
+    TIMED_FUNCTION();
+
+    auto spec = work->Spec;
+    u64 first = (u64)chunk * MONTE_CARLO_CHUNK_SIZE;
+    u32 count = (u32)Minimum(work->SampleCount - first, (u64)MONTE_CARLO_CHUNK_SIZE);
+
+    // q22 задается по выборкам, а не геометрией
+    f64 *q22 = workspace->Geometry[SweepParameter_q22];
+    for (u32 index = 0; index < count; ++index)
+    {
+        GetMonteCarloSample(spec, first + index, &workspace->Fuels[index], &q22[index]);
+    }
+
+    BoilerBatchInput input = {};
+    input.Count = count;
+    input.TopLengh = workspace->Geometry[SweepParameter_TopLengh];
+    input.TopWidth = workspace->Geometry[SweepParameter_TopWidth];
+    input.BottomLength = workspace->Geometry[SweepParameter_BottomLength];
+    input.BottomWidth = workspace->Geometry[SweepParameter_BottomWidth];
+    input.FrontHeight = workspace->Geometry[SweepParameter_FrontHeight];
+    input.RearHeight = workspace->Geometry[SweepParameter_RearHeight];
+    input.DOut = workspace->Geometry[SweepParameter_DOut];
+    input.DIn = workspace->Geometry[SweepParameter_DIn];
+    input.Ld = workspace->Geometry[SweepParameter_Ld];
+    input.Nd = workspace->Nd;
+    input.U = workspace->Geometry[SweepParameter_U];
+    input.q22 = q22;
+    input.Fuels = workspace->Fuels;
+    input.FuelIndex = workspace->FuelIndex;
+    input.t = spec->t;
+
+    BoilerBatchOutput output;
+    f64 **columns = (f64 **)&output;
+    for (u32 column = 0; column < sizeof(output) / sizeof(f64 *); ++column)
+    {
+        columns[column] = workspace->Output[column];
+    }
+
+    CalculateBoilerBatch(&input, &output);
+
+    for (u32 index = 0; index < count; ++index)
+    {
+        f64 percent = 100.0 / output.Q0[index];
+        workspace->Values[MonteCarloOutput_T1][index] = output.T1[index];
+        workspace->Values[MonteCarloOutput_T3][index] = output.T3[index];
+        workspace->Values[MonteCarloOutput_q21][index] = output.Q21[index] * percent;
+        workspace->Values[MonteCarloOutput_q22][index] = output.Q22[index] * percent;
+        workspace->Values[MonteCarloOutput_q3][index] = output.Q3[index] * percent;
+        workspace->Values[MonteCarloOutput_qt][index] = output.Qt[index] * percent;
+    }
+
+    // сводка куска в два прохода: среднее, затем отклонения от него
+    auto summary = &work->Summaries[chunk];
+    summary->Count = count;
+    for (u32 outputIndex = 0; outputIndex < MonteCarloOutput_Count; ++outputIndex)
+    {
+        f64 *values = workspace->Values[outputIndex];
+        f64 sum = 0.0;
+        f64 lowest = values[0];
+        f64 highest = values[0];
+        for (u32 index = 0; index < count; ++index)
+        {
+            sum += values[index];
+            lowest = Minimum(lowest, values[index]);
+            highest = Maximum(highest, values[index]);
+        }
+        f64 mean = sum / count;
+        f64 m2 = 0.0;
+        for (u32 index = 0; index < count; ++index)
+        {
+            f64 delta = values[index] - mean;
+            m2 += delta * delta;
+        }
+        summary->Mean[outputIndex] = mean;
+        summary->M2[outputIndex] = m2;
+        summary->Lowest[outputIndex] = lowest;
+        summary->Highest[outputIndex] = highest;
+    }
+}
+
+internal void
+AddMonteCarloHistogram(MonteCarloWork *work, MonteCarloWorkspace *workspace, u32 count)
+{
+    for (u32 outputIndex = 0; outputIndex < MonteCarloOutput_Count; ++outputIndex)
+    {
+        f64 *values = workspace->Values[outputIndex];
+        u64 *counts = workspace->Counts[outputIndex];
+        f64 min = work->HistogramMin[outputIndex];
+        f64 scale = work->HistogramScale[outputIndex];
+        for (u32 index = 0; index < count; ++index)
+        {
+            f64 bin = (values[index] - min) * scale;
+            if (bin < 0.0)
+            {
+                ++workspace->Below[outputIndex];
+            }
+            else if (!(bin < (f64)MONTE_CARLO_HISTOGRAM_BINS))
+            {
+                // NOTE: NaN lands here too.
+                ++workspace->Above[outputIndex];
+            }
+            else
+            {
+                ++counts[(u32)bin];
+            }
+        }
+    }
+}
+
+internal PARALLEL_PROC(MonteCarloWorkerProc)
+{
+    auto work = (MonteCarloWork *)data;
+    auto workspace = work->Workspaces + threadIndex;
+    for (;;)
+    {
+        u32 chunk = work->NextChunk++;
+        if (chunk >= work->ChunkCount)
+        {
+            break;
+        }
+        CalculateMonteCarloChunk(work, workspace, chunk);
+        AddMonteCarloHistogram(work, workspace, work->Summaries[chunk].Count);
+    }
+}
+
+// Рабочая память берется из arena и возвращается по окончании.
+// threadCount = 0 - по числу ядер. Возвращает false, если не хватило памяти.
+internal b32
+RunMonteCarlo(MemoryArena *arena, MonteCarloSpec *spec, u32 threadCount, MonteCarloStats *stats)
+{
+    ZeroStruct(*stats);
+    if (spec->SampleCount == 0)
+    {
+        return true;
+    }
+
+    if (threadCount == 0)
+    {
+        threadCount = GetDefaultThreadCount();
+    }
+    threadCount = (u32)LimitI(threadCount, 1, SWEEP_MAX_THREADS);
+
+    u64 chunkCount = (spec->SampleCount + MONTE_CARLO_CHUNK_SIZE - 1) / MONTE_CARLO_CHUNK_SIZE;
+    Assert(chunkCount <= 0xFFFFFFFF);
+    threadCount = (u32)Minimum((u64)threadCount, chunkCount);
+
+    auto tempMem = BeginTemporaryMemory(arena);
+
+    auto work = PushStruct(arena, MonteCarloWork);
+    auto summaries = PushArray(arena, chunkCount, MonteCarloChunkSummary);
+    auto workspaces = PushArray(arena, threadCount, MonteCarloWorkspace);
+    if (!work || !summaries || !workspaces)
+    {
+        EndTemporaryMemory(tempMem);
+        return false;
+    }
+    ZeroSize(sizeof(*work), work);
+
+    work->Spec = spec;
+    work->SampleCount = spec->SampleCount;
+    work->ChunkCount = (u32)chunkCount;
+    work->Summaries = summaries;
+    work->Workspaces = workspaces;
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    // первый кусок задает границы гистограмм: его размах с запасом в
+    // половину размаха с каждой стороны
+    InitializeMonteCarloWorkspace(spec, workspaces);
+    CalculateMonteCarloChunk(work, workspaces, 0);
+    for (u32 outputIndex = 0; outputIndex < MonteCarloOutput_Count; ++outputIndex)
+    {
+        f64 lowest = summaries[0].Lowest[outputIndex];
+        f64 highest = summaries[0].Highest[outputIndex];
+        f64 margin = (highest > lowest) ? 0.5 * (highest - lowest) : Maximum(fabs(lowest), 1.0);
+        work->HistogramMin[outputIndex] = lowest - margin;
+        work->HistogramScale[outputIndex] = MONTE_CARLO_HISTOGRAM_BINS / ((highest - lowest) + 2.0 * margin);
+
+        stats->Histograms[outputIndex].Min = lowest - margin;
+        stats->Histograms[outputIndex].Max = highest + margin;
+    }
+    AddMonteCarloHistogram(work, workspaces, summaries[0].Count);
+    work->NextChunk = 1;
+
+    for (u32 threadIndex = 1; threadIndex < threadCount; ++threadIndex)
+    {
+        InitializeMonteCarloWorkspace(spec, workspaces + threadIndex);
+    }
+    RunParallel(MonteCarloWorkerProc, work, threadCount);
+
+    auto endTime = std::chrono::steady_clock::now();
+
+    // сводки кусков по порядку (формула Чана для объединения выборок)
+    f64 total = 0.0;
+    f64 mean[MonteCarloOutput_Count] = {};
+    f64 m2[MonteCarloOutput_Count] = {};
+    for (u32 chunk = 0; chunk < work->ChunkCount; ++chunk)
+    {
+        auto summary = &summaries[chunk];
+        f64 count = summary->Count;
+        f64 combined = total + count;
+        for (u32 outputIndex = 0; outputIndex < MonteCarloOutput_Count; ++outputIndex)
+        {
+            f64 delta = summary->Mean[outputIndex] - mean[outputIndex];
+            mean[outputIndex] += delta * count / combined;
+            m2[outputIndex] += summary->M2[outputIndex] + delta * delta * total * count / combined;
+
+            if (chunk == 0)
+            {
+                stats->Lowest[outputIndex] = summary->Lowest[outputIndex];
+                stats->Highest[outputIndex] = summary->Highest[outputIndex];
+            }
+            stats->Lowest[outputIndex] = Minimum(stats->Lowest[outputIndex], summary->Lowest[outputIndex]);
+            stats->Highest[outputIndex] = Maximum(stats->Highest[outputIndex], summary->Highest[outputIndex]);
+        }
+        total = combined;
+    }
+
+    for (u32 outputIndex = 0; outputIndex < MonteCarloOutput_Count; ++outputIndex)
+    {
+        stats->Mean[outputIndex] = mean[outputIndex];
+        stats->StdDev[outputIndex] = (total > 1.0) ? sqrt(m2[outputIndex] / (total - 1.0)) : 0.0;
+
+        auto histogram = &stats->Histograms[outputIndex];
+        for (u32 threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+        {
+            auto workspace = &workspaces[threadIndex];
+            histogram->Below += workspace->Below[outputIndex];
+            histogram->Above += workspace->Above[outputIndex];
+            for (u32 bin = 0; bin < MONTE_CARLO_HISTOGRAM_BINS; ++bin)
+            {
+                histogram->Counts[bin] += workspace->Counts[outputIndex][bin];
+            }
+        }
+    }
+
+    stats->SampleCount = spec->SampleCount;
+    stats->ChunkCount = work->ChunkCount;
+    stats->ThreadCount = threadCount;
+    stats->Seconds = std::chrono::duration<f64>(endTime - startTime).count();
+    stats->SamplesPerSecond = (stats->Seconds > 0.0) ? (stats->SampleCount / stats->Seconds) : 0.0;
+
+    EndTemporaryMemory(tempMem);
+
+    return true;
+}
+
+// Процентиль по гистограмме с линейной интерполяцией внутри бина; за
+// границами гистограммы - крайние значения выборки
+internal f64
+GetMonteCarloPercentile(MonteCarloStats *stats, u32 output, f64 percent)
+{
+    auto histogram = &stats->Histograms[output];
+    f64 target = percent / 100.0 * stats->SampleCount;
+    if (target <= (f64)histogram->Below)
+    {
+        return stats->Lowest[output];
+    }
+
+    f64 width = (histogram->Max - histogram->Min) / MONTE_CARLO_HISTOGRAM_BINS;
+    f64 cumulative = (f64)histogram->Below;
+    for (u32 bin = 0; bin < MONTE_CARLO_HISTOGRAM_BINS; ++bin)
+    {
+        f64 count = (f64)histogram->Counts[bin];
+        if ((count > 0.0) && (cumulative + count >= target))
+        {
+            f64 result = histogram->Min + (bin + (target - cumulative) / count) * width;
+            return LimitF(result, stats->Lowest[output], stats->Highest[output]);
+        }
+        cumulative += count;
+    }
+
+    return stats->Highest[output];
+}
+
+// Сводит гистограмму к binCount бинам на [min, max) (по центрам бинов)
+internal void
+GetMonteCarloHistogram(MonteCarloStats *stats, u32 output, f64 min, f64 max, u32 binCount, u64 *counts)
+{
+    auto histogram = &stats->Histograms[output];
+    f64 width = (histogram->Max - histogram->Min) / MONTE_CARLO_HISTOGRAM_BINS;
+    for (u32 bin = 0; bin < binCount; ++bin)
+    {
+        counts[bin] = 0;
+    }
+    for (u32 bin = 0; bin < MONTE_CARLO_HISTOGRAM_BINS; ++bin)
+    {
+        f64 center = histogram->Min + (bin + 0.5) * width;
+        f64 target = (center - min) / (max - min) * binCount;
+        if ((target >= 0.0) && (target < binCount))
+        {
+            counts[(u32)target] += histogram->Counts[bin];
+        }
+    }
+}
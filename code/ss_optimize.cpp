@@ -0,0 +1,538 @@
+// Оптимизация геометрии котла с ограничениями: CMA-ES со многими запусками
+// на всех ядрах.
+//
+// Переменные нормируются в [0, 1] по границам спецификации, выборка за
+// границами прижимается к ним. Кандидаты сравниваются по правилам Деба:
+// допустимый лучше недопустимого, из недопустимых лучше тот, у кого меньше
+// суммарное нарушение, из допустимых - у кого меньше целевая функция.
+// Поколение считается одним пакетом CalculateBoilerBatch.
+//
+// Запуски независимы: у запуска run свое зерно и свой размер популяции
+// (IPOP - удваивается по кругу), потоки разбирают запуски по счетчику.
+// Лучший выбирается по запускам с учетом номера, поэтому результат не
+// зависит от числа потоков.
+
+#define OPTIMIZE_MAX_POPULATION 128
+#define OPTIMIZE_DEFAULT_RUNS 64
+#define OPTIMIZE_DEFAULT_EVALUATIONS 20000
+#define OPTIMIZE_POPULATION_DOUBLINGS 4
+
+struct OptimizeRandom
+{
+    u64 State;
+};
+
+// splitmix64, разводит соседние зерна
+inline u64
+MixOptimizeSeed(u64 seed)
+{
+    u64 z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// равномерно в (0, 1]
+inline f64
+RandomUnit(OptimizeRandom *random)
+{
+    // xorshift64*
+    u64 x = random->State;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    random->State = x;
+    return ((f64)((x * 0x2545F4914F6CDD1DULL) >> 11) + 1.0) * (1.0 / 9007199254740992.0);
+}
+
+// нормальное распределение N(0, 1), Бокс-Мюллер
+inline f64
+RandomGaussian(OptimizeRandom *random)
+{
+    f64 radius = sqrt(-2.0 * log(RandomUnit(random)));
+    return radius * cos(TwoPI * RandomUnit(random));
+}
+
+inline b32
+IsBetterCandidate(f64 objective, f64 violation, f64 otherObjective, f64 otherViolation)
+{
+    if (violation != otherViolation)
+    {
+        return violation < otherViolation;
+    }
+    return objective < otherObjective;
+}
+
+internal void
+GetOptimizeQuantities(BoilerBatchInput *input, BoilerBatchOutput *output, u32 index, f64 *quantities)
+{
+    quantities[OptimizeQuantity_R] = output->R[index];
+    quantities[OptimizeQuantity_Ht] = output->Ht[index];
+    quantities[OptimizeQuantity_Hd] = output->Hd[index];
+    quantities[OptimizeQuantity_Hi] = output->Ht[index] + output->Hd[index];
+    quantities[OptimizeQuantity_Wall] = (input->DOut[index] - input->DIn[index]) / 2.0;
+    quantities[OptimizeQuantity_T3] = output->T3[index];
+    quantities[OptimizeQuantity_Omega] = output->Omega[index];
+    quantities[OptimizeQuantity_K1] = output->K1[index];
+    quantities[OptimizeQuantity_Q0] = output->Q0[index];
+    quantities[OptimizeQuantity_Q21] = output->Q21[index];
+    quantities[OptimizeQuantity_Q22] = output->Q22[index];
+    quantities[OptimizeQuantity_Q3] = output->Q3[index];
+    quantities[OptimizeQuantity_Q4] = output->Q4[index];
+    quantities[OptimizeQuantity_Qt] = output->Qt[index];
+}
+
+internal f64
+GetOptimizeObjective(OptimizeSpec *spec, f64 *quantities)
+{
+    f64 result = 0.0;
+    for (u32 quantity = 0; quantity < OptimizeQuantity_Count; ++quantity)
+    {
+        if (spec->Weights[quantity] != 0.0)
+        {
+            result += spec->Weights[quantity] * quantities[quantity];
+        }
+    }
+    if (spec->PerQ0)
+    {
+        result /= quantities[OptimizeQuantity_Q0];
+    }
+    return result;
+}
+
+// нарушения считаются относительно границы, чтобы ограничения разных
+// величин были сравнимы
+internal f64
+GetOptimizeViolation(OptimizeSpec *spec, f64 *quantities)
+{
+    f64 result = 0.0;
+    for (u32 index = 0; index < spec->ConstraintCount; ++index)
+    {
+        auto constraint = &spec->Constraints[index];
+        f64 value = quantities[constraint->Quantity];
+        if (value < constraint->Min)
+        {
+            result += (constraint->Min - value) / Maximum(fabs(constraint->Min), 1e-12);
+        }
+        else if (value > constraint->Max)
+        {
+            result += (value - constraint->Max) / Maximum(fabs(constraint->Max), 1e-12);
+        }
+    }
+    return result;
+}
+
+struct OptimizeWorkspace
+{
+    SweepChunkInput Input; // NOTE: Only the first OPTIMIZE_MAX_POPULATION rows are used.
+    f64 Output[sizeof(BoilerBatchOutput) / sizeof(f64 *)][OPTIMIZE_MAX_POPULATION];
+
+    f64 Y[OPTIMIZE_MAX_POPULATION][SweepParameter_Count]; // нормированные кандидаты
+    f64 Objective[OPTIMIZE_MAX_POPULATION];
+    f64 Violation[OPTIMIZE_MAX_POPULATION];
+    u32 Order[OPTIMIZE_MAX_POPULATION];
+};
+
+struct OptimizeRun
+{
+    f64 Objective;
+    f64 Violation;
+    f64 Values[SweepParameter_Count];
+    u64 Evaluations;
+};
+
+struct OptimizeWork
+{
+    OptimizeSpec *Spec;
+    SweepSpec BatchSpec; // топливо и t для GetSweepChunkBatchInput
+    u32 FreeCount;
+    u32 Free[SweepParameter_Count]; // номера незакрепленных параметров
+    u32 RunCount;
+    u32 MaxEvaluations;
+    OptimizeRun *Runs;
+    OptimizeWorkspace *Workspaces; // по одному на поток
+    std::atomic<u32> NextRun;
+};
+
+// значения всех параметров по нормированной точке y (только свободные)
+inline void
+GetOptimizeValues(OptimizeWork *work, f64 *y, f64 *values)
+{
+    auto spec = work->Spec;
+    for (u32 parameter = 0; parameter < SweepParameter_Count; ++parameter)
+    {
+        values[parameter] = spec->Min[parameter];
+    }
+    for (u32 index = 0; index < work->FreeCount; ++index)
+    {
+        u32 parameter = work->Free[index];
+        values[parameter] = Map(y[index], 0.0, 1.0, spec->Min[parameter], spec->Max[parameter]);
+    }
+    values[SweepParameter_Nd] = (f64)(u16)(values[SweepParameter_Nd] + 0.5);
+}
+
+// считает поколение из count кандидатов workspace->Y
+internal void
+EvaluateOptimizePopulation(OptimizeWork *work, OptimizeWorkspace *workspace, u32 count)
+{
+    for (u32 index = 0; index < count; ++index)
+    {
+        f64 values[SweepParameter_Count];
+        GetOptimizeValues(work, workspace->Y[index], values);
+        SetSweepChunkVariant(&workspace->Input, index, values);
+    }
+
+    auto input = GetSweepChunkBatchInput(&work->BatchSpec, &workspace->Input, count);
+    BoilerBatchOutput output;
+    f64 **columns = (f64 **)&output;
+    for (u32 column = 0; column < sizeof(output) / sizeof(f64 *); ++column)
+    {
+        columns[column] = workspace->Output[column];
+    }
+
+    CalculateBoilerBatch(&input, &output);
+
+    for (u32 index = 0; index < count; ++index)
+    {
+        f64 quantities[OptimizeQuantity_Count];
+        GetOptimizeQuantities(&input, &output, index, quantities);
+        workspace->Objective[index] = GetOptimizeObjective(work->Spec, quantities);
+        workspace->Violation[index] = GetOptimizeViolation(work->Spec, quantities);
+    }
+}
+
+// Один запуск CMA-ES (Hansen, "The CMA Evolution Strategy: A Tutorial")
+internal void
+RunOptimizeCMAES(OptimizeWork *work, OptimizeWorkspace *workspace, u32 run)
+{
+    TIMED_FUNCTION();
+
+    auto spec = work->Spec;
+    u32 n = work->FreeCount;
+    auto result = &work->Runs[run];
+
+    OptimizeRandom random = {MixOptimizeSeed(spec->Seed + run)};
+
+    // параметры стратегии
+    u32 lambda = (4 + (u32)(3.0 * log((f64)n))) << (run % OPTIMIZE_POPULATION_DOUBLINGS);
+    lambda = Minimum(lambda, OPTIMIZE_MAX_POPULATION);
+    u32 mu = lambda / 2;
+
+    f64 weights[OPTIMIZE_MAX_POPULATION];
+    f64 weightSum = 0.0;
+    for (u32 index = 0; index < mu; ++index)
+    {
+        weights[index] = log(mu + 0.5) - log(index + 1.0);
+        weightSum += weights[index];
+    }
+    f64 weightSquareSum = 0.0;
+    for (u32 index = 0; index < mu; ++index)
+    {
+        weights[index] /= weightSum;
+        weightSquareSum += weights[index] * weights[index];
+    }
+    f64 muEff = 1.0 / weightSquareSum;
+
+    f64 cSigma = (muEff + 2.0) / (n + muEff + 5.0);
+    f64 dSigma = 1.0 + 2.0 * Maximum(0.0, sqrt((muEff - 1.0) / (n + 1.0)) - 1.0) + cSigma;
+    f64 cC = (4.0 + muEff / n) / (n + 4.0 + 2.0 * muEff / n);
+    f64 c1 = 2.0 / ((n + 1.3) * (n + 1.3) + muEff);
+    f64 cMu = Minimum(1.0 - c1, 2.0 * (muEff - 2.0 + 1.0 / muEff) / ((n + 2.0) * (n + 2.0) + muEff));
+    f64 chiN = sqrt((f64)n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+
+    // состояние: первый запуск стартует из Start, остальные - из случайных точек
+    f64 mean[SweepParameter_Count];
+    for (u32 index = 0; index < n; ++index)
+    {
+        u32 parameter = work->Free[index];
+        if (run == 0)
+        {
+            mean[index] = LimitF(Map(spec->Start[parameter], spec->Min[parameter], spec->Max[parameter], 0.0, 1.0),
+                                 0.0, 1.0);
+        }
+        else
+        {
+            mean[index] = RandomUnit(&random);
+        }
+    }
+    f64 sigma = 0.3;
+
+    f64 C[SYMMETRIC_EIGEN_MAX][SYMMETRIC_EIGEN_MAX] = {};
+    f64 B[SYMMETRIC_EIGEN_MAX][SYMMETRIC_EIGEN_MAX] = {};
+    f64 D[SYMMETRIC_EIGEN_MAX];
+    f64 pC[SweepParameter_Count] = {};
+    f64 pSigma[SweepParameter_Count] = {};
+    for (u32 index = 0; index < n; ++index)
+    {
+        C[index][index] = 1.0;
+        B[index][index] = 1.0;
+        D[index] = 1.0;
+    }
+
+    result->Objective = HUGE_VAL;
+    result->Violation = HUGE_VAL;
+    result->Evaluations = 0;
+
+    u32 maxEvaluations = work->MaxEvaluations;
+    for (u32 generation = 0; result->Evaluations + lambda <= maxEvaluations; ++generation)
+    {
+        // выборка y = mean + sigma * B * D * z
+        for (u32 k = 0; k < lambda; ++k)
+        {
+            f64 z[SweepParameter_Count];
+            for (u32 index = 0; index < n; ++index)
+            {
+                z[index] = D[index] * RandomGaussian(&random);
+            }
+            for (u32 row = 0; row < n; ++row)
+            {
+                f64 sum = 0.0;
+                for (u32 column = 0; column < n; ++column)
+                {
+                    sum += B[row][column] * z[column];
+                }
+                workspace->Y[k][row] = LimitF(mean[row] + sigma * sum, 0.0, 1.0);
+            }
+        }
+
+        EvaluateOptimizePopulation(work, workspace, lambda);
+        result->Evaluations += lambda;
+
+        // NOTE: Insertion sort; the population is at most a hundred or so.
+        for (u32 k = 0; k < lambda; ++k)
+        {
+            u32 position = k;
+            while ((position > 0) &&
+                   IsBetterCandidate(workspace->Objective[k], workspace->Violation[k],
+                                     workspace->Objective[workspace->Order[position - 1]],
+                                     workspace->Violation[workspace->Order[position - 1]]))
+            {
+                workspace->Order[position] = workspace->Order[position - 1];
+                --position;
+            }
+            workspace->Order[position] = k;
+        }
+
+        u32 best = workspace->Order[0];
+        if (IsBetterCandidate(workspace->Objective[best], workspace->Violation[best],
+                              result->Objective, result->Violation))
+        {
+            result->Objective = workspace->Objective[best];
+            result->Violation = workspace->Violation[best];
+            GetOptimizeValues(work, workspace->Y[best], result->Values);
+        }
+
+        // новое среднее и шаг среднего в единицах sigma
+        f64 step[SweepParameter_Count];
+        for (u32 index = 0; index < n; ++index)
+        {
+            f64 sum = 0.0;
+            for (u32 k = 0; k < mu; ++k)
+            {
+                sum += weights[k] * workspace->Y[workspace->Order[k]][index];
+            }
+            step[index] = (sum - mean[index]) / sigma;
+        }
+
+        // пути эволюции; C^(-1/2) = B * D^-1 * B^T
+        f64 projected[SweepParameter_Count];
+        for (u32 column = 0; column < n; ++column)
+        {
+            f64 sum = 0.0;
+            for (u32 row = 0; row < n; ++row)
+            {
+                sum += B[row][column] * step[row];
+            }
+            projected[column] = sum / D[column];
+        }
+        f64 sigmaFactor = sqrt(cSigma * (2.0 - cSigma) * muEff);
+        f64 pSigmaNorm = 0.0;
+        for (u32 row = 0; row < n; ++row)
+        {
+            f64 sum = 0.0;
+            for (u32 column = 0; column < n; ++column)
+            {
+                sum += B[row][column] * projected[column];
+            }
+            pSigma[row] = (1.0 - cSigma) * pSigma[row] + sigmaFactor * sum;
+            pSigmaNorm += pSigma[row] * pSigma[row];
+        }
+        pSigmaNorm = sqrt(pSigmaNorm);
+
+        f64 hSigmaBound = (1.4 + 2.0 / (n + 1.0)) * chiN;
+        b32 hSigma = (pSigmaNorm / sqrt(1.0 - pow(1.0 - cSigma, 2.0 * (generation + 1))) < hSigmaBound);
+        f64 cFactor = hSigma ? sqrt(cC * (2.0 - cC) * muEff) : 0.0;
+        for (u32 index = 0; index < n; ++index)
+        {
+            pC[index] = (1.0 - cC) * pC[index] + cFactor * step[index];
+        }
+
+        // ковариация: rank-one по pC и rank-mu по лучшим mu кандидатам
+        f64 oldC = 1.0 - c1 - cMu + (hSigma ? 0.0 : c1 * cC * (2.0 - cC));
+        for (u32 row = 0; row < n; ++row)
+        {
+            for (u32 column = 0; column <= row; ++column)
+            {
+                f64 rankMu = 0.0;
+                for (u32 k = 0; k < mu; ++k)
+                {
+                    f64 *y = workspace->Y[workspace->Order[k]];
+                    rankMu += weights[k] * (y[row] - mean[row]) * (y[column] - mean[column]);
+                }
+                C[row][column] = oldC * C[row][column] + c1 * pC[row] * pC[column] +
+                                 cMu * rankMu / (sigma * sigma);
+                C[column][row] = C[row][column];
+            }
+        }
+
+        for (u32 index = 0; index < n; ++index)
+        {
+            mean[index] += sigma * step[index];
+        }
+        sigma *= exp((cSigma / dSigma) * (pSigmaNorm / chiN - 1.0));
+
+        f64 eigen[SYMMETRIC_EIGEN_MAX][SYMMETRIC_EIGEN_MAX];
+        for (u32 row = 0; row < n; ++row)
+        {
+            for (u32 column = 0; column < n; ++column)
+            {
+                eigen[row][column] = C[row][column];
+            }
+        }
+        SymmetricEigen(n, eigen, D, B);
+        f64 maxD = 0.0;
+        for (u32 index = 0; index < n; ++index)
+        {
+            D[index] = sqrt(Maximum(D[index], 1e-20));
+            maxD = Maximum(maxD, D[index]);
+        }
+
+        // сошлось: шаг меньше точности, с которой имеет смысл задавать размеры
+        if (sigma * maxD < 1e-7)
+        {
+            break;
+        }
+    }
+}
+
+internal PARALLEL_PROC(OptimizeWorkerProc)
+{
+    auto work = (OptimizeWork *)data;
+    auto workspace = work->Workspaces + threadIndex;
+    for (;;)
+    {
+        u32 run = work->NextRun++;
+        if (run >= work->RunCount)
+        {
+            break;
+        }
+        RunOptimizeCMAES(work, workspace, run);
+    }
+}
+
+// Рабочая память берется из arena и возвращается по окончании.
+// threadCount = 0 - по числу ядер.
+internal OptimizeResult
+RunOptimize(MemoryArena *arena, OptimizeSpec *spec, u32 threadCount)
+{
+    OptimizeResult result = {};
+    result.Objective = HUGE_VAL;
+    result.Violation = HUGE_VAL;
+
+    if (threadCount == 0)
+    {
+        threadCount = GetDefaultThreadCount();
+    }
+    threadCount = (u32)LimitI(threadCount, 1, SWEEP_MAX_THREADS);
+
+    u32 runCount = spec->RunCount ? spec->RunCount : OPTIMIZE_DEFAULT_RUNS;
+    threadCount = Minimum(threadCount, runCount);
+
+    auto tempMem = BeginTemporaryMemory(arena);
+
+    auto work = PushStruct(arena, OptimizeWork);
+    auto runs = PushArray(arena, runCount, OptimizeRun);
+    auto workspaces = PushArray(arena, threadCount, OptimizeWorkspace);
+    if (!work || !runs || !workspaces)
+    {
+        EndTemporaryMemory(tempMem);
+        return result;
+    }
+    ZeroSize(sizeof(*work), work);
+
+    work->Spec = spec;
+    work->BatchSpec.BaseFuel = spec->BaseFuel;
+    work->BatchSpec.t = spec->t;
+    for (u32 parameter = 0; parameter < SweepParameter_Count; ++parameter)
+    {
+        if (spec->Max[parameter] > spec->Min[parameter])
+        {
+            work->Free[work->FreeCount++] = parameter;
+        }
+    }
+    work->RunCount = runCount;
+    work->MaxEvaluations = spec->MaxEvaluations ? spec->MaxEvaluations : OPTIMIZE_DEFAULT_EVALUATIONS;
+    work->Runs = runs;
+    work->Workspaces = workspaces;
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    if (work->FreeCount > 0)
+    {
+        RunParallel(OptimizeWorkerProc, work, threadCount);
+    }
+    else
+    {
+        // все закреплено - считаем единственный вариант
+        runCount = work->RunCount = 1;
+        workspaces->Y[0][0] = 0.0;
+        EvaluateOptimizePopulation(work, workspaces, 1);
+        runs[0].Objective = workspaces->Objective[0];
+        runs[0].Violation = workspaces->Violation[0];
+        runs[0].Evaluations = 1;
+        GetOptimizeValues(work, workspaces->Y[0], runs[0].Values);
+    }
+
+    auto endTime = std::chrono::steady_clock::now();
+
+    for (u32 run = 0; run < runCount; ++run)
+    {
+        auto candidate = &runs[run];
+        result.Evaluations += candidate->Evaluations;
+        if (candidate->Violation == 0.0)
+        {
+            ++result.FeasibleRuns;
+        }
+        if (IsBetterCandidate(candidate->Objective, candidate->Violation, result.Objective, result.Violation))
+        {
+            result.Objective = candidate->Objective;
+            result.Violation = candidate->Violation;
+            result.BestRun = run;
+            for (u32 parameter = 0; parameter < SweepParameter_Count; ++parameter)
+            {
+                result.Values[parameter] = candidate->Values[parameter];
+            }
+        }
+    }
+    result.Feasible = (result.Violation == 0.0);
+
+    // величины лучшего варианта - одним расчетом
+    SetSweepChunkVariant(&workspaces->Input, 0, result.Values);
+    auto input = GetSweepChunkBatchInput(&work->BatchSpec, &workspaces->Input, 1);
+    BoilerBatchOutput output;
+    f64 **columns = (f64 **)&output;
+    for (u32 column = 0; column < sizeof(output) / sizeof(f64 *); ++column)
+    {
+        columns[column] = workspaces->Output[column];
+    }
+    CalculateBoilerBatch(&input, &output);
+    GetOptimizeQuantities(&input, &output, 0, result.Quantities);
+
+    result.RunCount = runCount;
+    result.ThreadCount = threadCount;
+    result.Seconds = std::chrono::duration<f64>(endTime - startTime).count();
+
+    EndTemporaryMemory(tempMem);
+
+    return result;
+}
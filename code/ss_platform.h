@@ -1,8 +1,50 @@
 #pragma once
 
+#if !defined(COMPILER_MSVC)
+#define COMPILER_MSVC 0
+#endif
+
+#if !defined(COMPILER_GCC)
+#define COMPILER_GCC 0
+#endif
+
+#if !defined(COMPILER_LLVM)
+#define COMPILER_LLVM 0
+#endif
+
+#if !COMPILER_MSVC && !COMPILER_GCC && !COMPILER_LLVM
+#if defined(_MSC_VER)
+#undef COMPILER_MSVC
+#define COMPILER_MSVC 1
+#elif defined(__clang__)
+#undef COMPILER_LLVM
+#define COMPILER_LLVM 1
+#else
+#undef COMPILER_GCC
+#define COMPILER_GCC 1
+#endif
+#endif
+
+#if COMPILER_MSVC
+#include <intrin.h>
+#elif defined(__GNUC__) && !defined(__clang__) && (__GNUC__ == 12)
+// NOTE: GCC 12 warns about the deliberately undefined vector that
+// avx512fintrin.h passes to its masked builtins (GCC bug 105593, fixed in
+// GCC 13). Only this header and only this compiler get the suppression.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <x86intrin.h>
+#pragma GCC diagnostic pop
+#else
+#include <x86intrin.h>
+#endif
+
+#include <atomic>
 #include <cstdio>
 #include <math.h>
 #include <stdint.h>
+#include <string.h>
 
 typedef int8_t i8;
 typedef int16_t i16;
@@ -19,9 +61,45 @@ typedef uint64_t u64;
 typedef float f32;
 typedef double f64;
 
+// NOTE: For the parameters of the callback signatures below, which not every
+// callback uses.
+#if COMPILER_MSVC
+#define UNUSED_PARAMETER
+#else
+#define UNUSED_PARAMETER __attribute__((unused))
+#endif
+
 struct ThreadContext
 {
-    int Placeholder;
+    u32 ThreadIndex; // NOTE: 0 is the thread that calls Calculate, the pool workers are 1..
+};
+
+// NOTE: Work queue of the platform layer. The host starts a fixed pool of
+// worker threads once and keeps it for its whole life, so the pool survives
+// code reloads. Entries may be added from any thread (the queue is a
+// lock-free multi-producer/multi-consumer ring). CompleteAllWork runs entries
+// on the calling thread too and returns once everything added so far is
+// done. Calculate must not return with entries pending: their callbacks
+// point into code that may be unloaded.
+struct PlatformWorkQueue;
+
+#define PLATFORM_WORK_QUEUE_CALLBACK(name) \
+    void name(ThreadContext *thread UNUSED_PARAMETER, PlatformWorkQueue *queue UNUSED_PARAMETER, void *data)
+typedef PLATFORM_WORK_QUEUE_CALLBACK(PlatformWorkQueueCallback);
+
+#define PLATFORM_ADD_ENTRY(name) void name(PlatformWorkQueue *queue, PlatformWorkQueueCallback *callback, void *data)
+typedef PLATFORM_ADD_ENTRY(PlatformAddEntryType);
+
+#define PLATFORM_COMPLETE_ALL_WORK(name) void name(PlatformWorkQueue *queue)
+typedef PLATFORM_COMPLETE_ALL_WORK(PlatformCompleteAllWorkType);
+
+struct PlatformAPI
+{
+    PlatformWorkQueue *WorkQueue; // NOTE: 0 if the host has no pool, the app then starts its own threads
+    u32 ThreadCount;              // threads that run entries, the one calling CompleteAllWork included
+
+    PlatformAddEntryType *AddEntry;
+    PlatformCompleteAllWorkType *CompleteAllWork;
 };
 
 #if EDITOR_INTERNAL
@@ -32,18 +110,112 @@ struct DebugReadFileResult
     void *Contents;
 };
 
-#define DEBUG_PLATFORM_FREE_FILE_MEMORY(name) void name(ThreadContext *thread, void *memory)
+#define DEBUG_PLATFORM_FREE_FILE_MEMORY(name) void name(ThreadContext *thread UNUSED_PARAMETER, void *memory)
 typedef DEBUG_PLATFORM_FREE_FILE_MEMORY(DebugPlatformFreeFileMemoryType);
 
-#define DEBUG_PLATFORM_READ_ENTIRE_FILE(name) DebugReadFileResult name(ThreadContext *thread, char *filename)
+#define DEBUG_PLATFORM_READ_ENTIRE_FILE(name) DebugReadFileResult name(ThreadContext *thread UNUSED_PARAMETER, char *filename)
 typedef DEBUG_PLATFORM_READ_ENTIRE_FILE(DebugPlatformReadEntireFileType);
 
-#define DEBUG_PLATFORM_WRITE_ENTIRE_FILE(name) b32 name(ThreadContext *thread, char *filename, u32 memorySize, void *memory)
+#define DEBUG_PLATFORM_WRITE_ENTIRE_FILE(name) \
+    b32 name(ThreadContext *thread UNUSED_PARAMETER, char *filename, u32 memorySize, void *memory)
 typedef DEBUG_PLATFORM_WRITE_ENTIRE_FILE(DebugPlatformWriteEntireFileType);
 
 #endif
 
-#define CALCULATE(name) void name()
+#if EDITOR_PROFILE
+
+// NOTE: Cycle counters of the TIMED_BLOCK macros (see ss_debug.h). The table
+// belongs to the platform layer, so it outlives a code reload. Every thread
+// that enters a timed block takes a row of its own with one atomic increment
+// and then only writes to that row, so no locks are needed. The host reads
+// the table once Calculate has returned and all of its threads are joined,
+// then resets it. Records point at strings inside the loaded code, so the
+// host has to report before it unloads that code.
+#define DEBUG_MAX_COUNTERS 512
+#define DEBUG_MAX_THREADS 256
+
+struct DebugCounterRecord
+{
+    char const *FileName;
+    char const *Prefix; // 0, or a namespace the same source is compiled into once more
+    char const *BlockName;
+    u32 LineNumber;
+};
+
+struct DebugCounter
+{
+    u64 CycleCount;
+    u64 HitCount;
+};
+
+struct DebugCounterTable
+{
+    u32 Generation; // NOTE: Never 0; bumped on reset so threads take new rows
+    std::atomic<u32> ThreadCount;
+    DebugCounterRecord Records[DEBUG_MAX_COUNTERS];
+    DebugCounter Counters[DEBUG_MAX_THREADS][DEBUG_MAX_COUNTERS];
+};
+
+#endif
+
+enum report_format
+{
+    ReportFormat_Table,
+    ReportFormat_CSV,
+    ReportFormat_Binary,
+};
+
+struct AppMemory
+{
+    b32 IsInitialized;
+
+    u64 PermanentStorageSize;
+    void *PermanentStorage; // NOTE: REQUIRED to be cleared to zero at startup
+
+    u64 TransientStorageSize;
+    void *TransientStorage; // NOTE: Scratch, its contents are not kept between calls
+
+    b32 LargePages; // the block is backed by huge/large pages
+
+    u32 ReportFormat; // report_format, chosen on the host command line
+    b32 ReportSweep;  // write every sweep variant, not only the design point
+    u32 MathMode;     // math_mode, the build default unless chosen on the host command line
+
+    void *FuelLibrary; // NOTE: Read-only mapping of the fuel library file (see ss_fuel.cpp), 0 if there is none
+    u64 FuelLibrarySize;
+
+    PlatformAPI Platform;
+
+    u64 CodeIdentity; // NOTE: Set by the host on every code load (hash or write time of the image), 0 if unknown
+
+    b32 PlayingBack;          // NOTE: Permanent storage was restored from a snapshot, keep its input
+    u64 PermanentStorageUsed; // NOTE: Set by the app, the part of permanent storage a snapshot must keep
+
+#if EDITOR_PROFILE
+    DebugCounterTable *DebugTable; // NOTE: Owned by the host, 0 if it does not collect timings
+#endif
+};
+
+// NOTE: Snapshot file layout: this header, then the used part of permanent
+// storage at SNAPSHOT_DATA_OFFSET. The data is stored as-is (pointers
+// included), so playback maps it back at the same BaseAddress. The offset
+// and the data size are multiples of 2MB, which satisfies both the Windows
+// allocation granularity and huge page alignment.
+#define SNAPSHOT_MAGIC 0x31535353 // "SSS1"
+#define SNAPSHOT_DATA_OFFSET Megabytes(2)
+#define SNAPSHOT_DATA_ALIGNMENT Megabytes(2)
+
+struct SnapshotHeader
+{
+    u32 Magic;
+    u32 HeaderSize;
+    u64 BaseAddress;
+    u64 PermanentStorageSize;
+    u64 TransientStorageSize;
+    u64 DataSize;
+};
+
+#define CALCULATE(name) void name(ThreadContext *thread UNUSED_PARAMETER, AppMemory *memory UNUSED_PARAMETER)
 typedef CALCULATE(CalculateType);
 CALCULATE(CalculateStub)
 {
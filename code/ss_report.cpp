@@ -0,0 +1,402 @@
+// Вывод результатов: расчет складывает значения в столбцы Report, а
+// форматирование идет отдельным проходом в большой буфер ReportWriter,
+// который сбрасывается в файл одной записью по мере заполнения.
+
+// Каждая стадия расчета пишет свой отчет, отчеты идут в поток подряд. В CSV
+// блок начинается строкой "# имя стадии", блоки разделены пустой строкой.
+// Двоичный формат (little-endian), записи тоже подряд:
+//   u32 Magic, u32 FieldCount, u64 RecordCount, u8 длина + имя стадии
+//   FieldCount раз: u8 длина + имя, u8 длина + единицы (UTF-8)
+//   RecordCount записей по FieldCount значений f64
+#define REPORT_BINARY_MAGIC 0x32525353 // "SSR2"
+
+#define REPORT_BUFFER_SIZE Megabytes(4)
+#define REPORT_MAX_NUMBER_LENGTH 32
+#define REPORT_CSV_DECIMALS 6
+#define REPORT_TABLE_COLUMN_WIDTH 14
+
+global f64 ReportPowersOf10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+internal u32
+AddReportField(Report *report, const char *name, const char *label, const char *unit, f64 *values, u32 decimals = 2)
+{
+    Assert(report->FieldCount < REPORT_MAX_FIELDS);
+
+    u32 result = report->FieldCount++;
+    ReportField *field = report->Fields + result;
+    field->Name = name;
+    field->Label = label;
+    field->Unit = unit ? unit : "";
+    field->Decimals = decimals;
+    field->ShareOf = -1;
+    field->Values = values;
+
+    return result;
+}
+
+internal void
+BeginReport(Report *report, const char *name, u64 recordCount = 1)
+{
+    ZeroStruct(*report);
+    report->Name = name;
+    report->RecordCount = recordCount;
+}
+
+// Поле отчета из одной записи, значение хранится в самом отчете
+internal u32
+AddReportValue(Report *report, const char *name, const char *label, const char *unit, f64 value, u32 decimals = 2)
+{
+    Assert(report->RecordCount == 1);
+    u32 result = AddReportField(report, name, label, unit, report->Scalars + report->FieldCount, decimals);
+    report->Scalars[result] = value;
+
+    return result;
+}
+
+internal ReportWriter
+BeginReportWriter(MemoryArena *arena, FILE *file, u64 size = REPORT_BUFFER_SIZE)
+{
+    ReportWriter result = {};
+    result.File = file;
+    result.Base = PushArray(arena, size, u8);
+    result.Size = result.Base ? size : 0;
+    Assert(result.Base);
+
+    return result;
+}
+
+internal void
+FlushReportWriter(ReportWriter *writer)
+{
+    if (writer->Used)
+    {
+        fwrite(writer->Base, 1, writer->Used, writer->File);
+        writer->BytesWritten += writer->Used;
+        writer->Used = 0;
+    }
+    fflush(writer->File);
+}
+
+// NOTE: Returns room for at least size bytes; the caller advances Used.
+inline char *
+ReserveReportBytes(ReportWriter *writer, u64 size)
+{
+    Assert(size <= writer->Size);
+    if (writer->Used + size > writer->Size)
+    {
+        FlushReportWriter(writer);
+    }
+
+    return (char *)writer->Base + writer->Used;
+}
+
+inline void
+AppendReportBytes(ReportWriter *writer, const void *bytes, u64 size)
+{
+    char *dest = ReserveReportBytes(writer, size);
+    memcpy(dest, bytes, size);
+    writer->Used += size;
+}
+
+inline void
+AppendReportString(ReportWriter *writer, const char *string)
+{
+    AppendReportBytes(writer, string, strlen(string));
+}
+
+inline void
+AppendReportChar(ReportWriter *writer, char c)
+{
+    char *dest = ReserveReportBytes(writer, 1);
+    *dest = c;
+    ++writer->Used;
+}
+
+// Число с фиксированным числом знаков после точки, как "%.*f", но без printf.
+// Очень большие значения, NaN и бесконечности уходят в snprintf.
+internal char *
+FormatF64(char *dest, f64 value, u32 decimals)
+{
+    Assert(decimals < ArrayCount(ReportPowersOf10));
+
+    f64 magnitude = (value < 0) ? -value : value;
+    f64 scaled = magnitude * ReportPowersOf10[decimals] + 0.5;
+    if (!(scaled < 9.0e18))
+    {
+        int length = snprintf(dest, REPORT_MAX_NUMBER_LENGTH, "%.*e", (int)decimals, value);
+        return dest + ((length < REPORT_MAX_NUMBER_LENGTH) ? length : REPORT_MAX_NUMBER_LENGTH - 1);
+    }
+
+    if (value < 0)
+    {
+        *dest++ = '-';
+    }
+
+    u64 digits = (u64)scaled;
+    char reversed[24];
+    u32 count = 0;
+    do
+    {
+        reversed[count++] = (char)('0' + digits % 10);
+        digits /= 10;
+    } while (digits || (count <= decimals));
+
+    for (u32 index = count; index-- > 0;)
+    {
+        *dest++ = reversed[index];
+        if (decimals && (index == decimals))
+        {
+            *dest++ = '.';
+        }
+    }
+
+    return dest;
+}
+
+inline void
+AppendReportF64(ReportWriter *writer, f64 value, u32 decimals)
+{
+    char *dest = ReserveReportBytes(writer, REPORT_MAX_NUMBER_LENGTH);
+    writer->Used += FormatF64(dest, value, decimals) - dest;
+}
+
+inline void
+AppendReportPadded(ReportWriter *writer, const char *text, u64 length, u32 width)
+{
+    for (u64 pad = length; pad < width; ++pad)
+    {
+        AppendReportChar(writer, ' ');
+    }
+    AppendReportBytes(writer, text, length);
+}
+
+// Одна запись выводится столбиком "подпись значение единицы", как раньше
+// печатал Calculate; несколько записей - таблицей с заголовком из имен.
+internal void
+WriteReportTable(ReportWriter *writer, Report *report)
+{
+    if (report->RecordCount == 1)
+    {
+        for (u32 fieldIndex = 0; fieldIndex < report->FieldCount; ++fieldIndex)
+        {
+            ReportField *field = report->Fields + fieldIndex;
+            f64 value = field->Values[0];
+
+            AppendReportString(writer, field->Label ? field->Label : field->Name);
+            AppendReportF64(writer, value, field->Decimals);
+            if (field->Unit[0])
+            {
+                AppendReportChar(writer, ' ');
+                AppendReportString(writer, field->Unit);
+            }
+            if (field->ShareOf >= 0)
+            {
+                AppendReportString(writer, " \t\t");
+                AppendReportF64(writer, value / report->Fields[field->ShareOf].Values[0] * 100, 1);
+                AppendReportChar(writer, '%');
+            }
+            AppendReportChar(writer, '\n');
+        }
+    }
+    else
+    {
+        if (report->Title)
+        {
+            AppendReportString(writer, report->Title);
+            AppendReportChar(writer, '\n');
+        }
+        for (u32 fieldIndex = 0; fieldIndex < report->FieldCount; ++fieldIndex)
+        {
+            const char *name = report->Fields[fieldIndex].Name;
+            AppendReportPadded(writer, name, strlen(name), REPORT_TABLE_COLUMN_WIDTH);
+        }
+        AppendReportChar(writer, '\n');
+
+        char number[REPORT_MAX_NUMBER_LENGTH];
+        for (u64 record = 0; record < report->RecordCount; ++record)
+        {
+            for (u32 fieldIndex = 0; fieldIndex < report->FieldCount; ++fieldIndex)
+            {
+                ReportField *field = report->Fields + fieldIndex;
+                char *end = FormatF64(number, field->Values[record], field->Decimals);
+                AppendReportPadded(writer, number, end - number, REPORT_TABLE_COLUMN_WIDTH);
+            }
+            AppendReportChar(writer, '\n');
+        }
+    }
+}
+
+internal void
+WriteReportCSV(ReportWriter *writer, Report *report)
+{
+    if (writer->BytesWritten || writer->Used)
+    {
+        AppendReportChar(writer, '\n');
+    }
+    if (report->Name)
+    {
+        AppendReportString(writer, "# ");
+        AppendReportString(writer, report->Name);
+        AppendReportChar(writer, '\n');
+    }
+
+    for (u32 fieldIndex = 0; fieldIndex < report->FieldCount; ++fieldIndex)
+    {
+        ReportField *field = report->Fields + fieldIndex;
+        if (fieldIndex)
+        {
+            AppendReportChar(writer, ',');
+        }
+        AppendReportString(writer, field->Name);
+        if (field->Unit[0])
+        {
+            AppendReportChar(writer, '[');
+            AppendReportString(writer, field->Unit);
+            AppendReportChar(writer, ']');
+        }
+    }
+    AppendReportChar(writer, '\n');
+
+    for (u64 record = 0; record < report->RecordCount; ++record)
+    {
+        // NOTE: One reservation per row keeps the inner loop free of flush checks.
+        u64 rowSize = report->FieldCount * (REPORT_MAX_NUMBER_LENGTH + 1) + 1;
+        char *dest = ReserveReportBytes(writer, rowSize);
+        char *start = dest;
+        for (u32 fieldIndex = 0; fieldIndex < report->FieldCount; ++fieldIndex)
+        {
+            if (fieldIndex)
+            {
+                *dest++ = ',';
+            }
+            dest = FormatF64(dest, report->Fields[fieldIndex].Values[record], REPORT_CSV_DECIMALS);
+        }
+        *dest++ = '\n';
+        writer->Used += dest - start;
+    }
+}
+
+inline void
+AppendReportShortString(ReportWriter *writer, const char *string)
+{
+    u64 length = strlen(string);
+    u8 length8 = (u8)((length < 255) ? length : 255);
+    AppendReportBytes(writer, &length8, sizeof(length8));
+    AppendReportBytes(writer, string, length8);
+}
+
+internal void
+WriteReportBinary(ReportWriter *writer, Report *report)
+{
+    u32 magic = REPORT_BINARY_MAGIC;
+    AppendReportBytes(writer, &magic, sizeof(magic));
+    AppendReportBytes(writer, &report->FieldCount, sizeof(report->FieldCount));
+    AppendReportBytes(writer, &report->RecordCount, sizeof(report->RecordCount));
+    AppendReportShortString(writer, report->Name ? report->Name : "");
+
+    for (u32 fieldIndex = 0; fieldIndex < report->FieldCount; ++fieldIndex)
+    {
+        AppendReportShortString(writer, report->Fields[fieldIndex].Name);
+        AppendReportShortString(writer, report->Fields[fieldIndex].Unit);
+    }
+
+    u64 recordSize = report->FieldCount * sizeof(f64);
+    for (u64 record = 0; record < report->RecordCount; ++record)
+    {
+        f64 *dest = (f64 *)ReserveReportBytes(writer, recordSize);
+        for (u32 fieldIndex = 0; fieldIndex < report->FieldCount; ++fieldIndex)
+        {
+            memcpy(dest + fieldIndex, report->Fields[fieldIndex].Values + record, sizeof(f64));
+        }
+        writer->Used += recordSize;
+    }
+}
+
+internal void
+WriteReport(ReportWriter *writer, Report *report, u32 format)
+{
+    switch (format)
+    {
+        case ReportFormat_CSV:
+        {
+            WriteReportCSV(writer, report);
+        }
+        break;
+
+        case ReportFormat_Binary:
+        {
+            WriteReportBinary(writer, report);
+        }
+        break;
+
+        default:
+        {
+            WriteReportTable(writer, report);
+        }
+        break;
+    }
+}
+
+// Столбцы BoilerBatchOutput в порядке объявления
+global const char *BoilerOutputNames[] = {
+    "R", "Ht", "Hd", "L0", "Bh", "BhFact", "T1", "T2", "T3", "Tabs",
+    "Q0", "Q21", "Q22", "Q3", "Q4", "Qt", "Omega", "K1", "M", "N"};
+global const char *BoilerOutputUnits[] = {
+    "м2", "м2", "м2", "кг", "кг", "кг", "°C", "°C", "°C", "°C",
+    "кал/час", "кал/час", "кал/час", "кал/час", "кал/час", "кал/час", "м/с", "", "", ""};
+
+global const char *SweepParameterNames[] = {
+    "TopLengh", "TopWidth", "BottomLength", "BottomWidth", "FrontHeight", "RearHeight",
+    "DOut", "DIn", "Ld", "Nd", "U", "q22"};
+global const char *SweepParameterUnits[] = {
+    "м", "м", "м", "м", "м", "м", "м", "м", "м", "", "кг/м2 час", "%"};
+
+// Отчет по всем вариантам перебора: перебираемые параметры (их значения
+// восстанавливаются по номеру варианта в arena) и все выходы котла.
+internal b32
+BuildSweepReport(MemoryArena *arena, Report *report, SweepSpec *spec, BoilerBatchOutput *output, u64 count)
+{
+    static_assert(ArrayCount(BoilerOutputNames) == sizeof(BoilerBatchOutput) / sizeof(f64 *), "");
+    static_assert(ArrayCount(BoilerOutputUnits) == ArrayCount(BoilerOutputNames), "");
+    static_assert(ArrayCount(SweepParameterNames) == SweepParameter_Count, "");
+    static_assert(ArrayCount(SweepParameterUnits) == SweepParameter_Count, "");
+
+    BeginReport(report, "sweep_variants", count);
+    report->Title = "Варианты перебора";
+
+    u32 parameters[SweepParameter_Count];
+    u32 parameterCount = 0;
+    for (u32 parameter = 0; parameter < SweepParameter_Count; ++parameter)
+    {
+        if (GetSweepSteps(spec->Ranges[parameter]) > 1)
+        {
+            f64 *values = PushArray(arena, count, f64);
+            if (!values)
+            {
+                return false;
+            }
+
+            parameters[parameterCount++] = parameter;
+            AddReportField(report, SweepParameterNames[parameter], 0, SweepParameterUnits[parameter], values,
+                           (parameter == SweepParameter_Nd) ? 0 : 3);
+        }
+    }
+
+    f64 variant[SweepParameter_Count];
+    for (u64 index = 0; index < count; ++index)
+    {
+        GetSweepVariant(spec, index, variant);
+        for (u32 field = 0; field < parameterCount; ++field)
+        {
+            report->Fields[field].Values[index] = variant[parameters[field]];
+        }
+    }
+
+    f64 **columns = (f64 **)output;
+    for (u32 column = 0; column < ArrayCount(BoilerOutputNames); ++column)
+    {
+        AddReportField(report, BoilerOutputNames[column], 0, BoilerOutputUnits[column], columns[column]);
+    }
+
+    return true;
+}
@@ -0,0 +1,202 @@
+// Отчеты стадий Calculate в постоянной памяти. Стадия, отчеты которой уже
+// сохранены для тех же входных данных, библиотеки топлив, формата вывода,
+// сборки кода и режима математики, не пересчитывается: ее отчеты выводятся
+// из кэша. Так перезагрузка кода без изменений и воспроизведение снимка той
+// же сборкой выводят результат сразу, а после правки кода пересчитывается все.
+// NOTE: Stages ask for the cache with BeginStage/EndStage; WriteStageReport
+// stores every report written in between. A stage whose reports did not all
+// fit is not marked valid and simply runs again next time.
+
+global const char *CalculationStageNames[] = {
+    "перебор", "обратная задача", "тяга", "поездки", "парк", "оптимизация", "Монте-Карло",
+    "библиотека топлив", "чувствительность", "граф", "дымогарные трубы по участкам", "газовый тракт"};
+
+// Ключ кэша, 0 - кэш не используется (сборка кода неизвестна)
+// NOTE: The input is hashed as raw bytes, padding included. SetDefaultInput
+// starts from a zeroed struct, so the padding is stable; if it ever is not,
+// the worst case is a cache miss, never a stale result.
+internal u64
+GetStageCacheKey(CalculationInput *input, AppMemory *memory)
+{
+    if (!memory->CodeIdentity)
+    {
+        return 0;
+    }
+
+    u64 result = HashBytes(input, sizeof(*input));
+    result = HashBytes(memory->FuelLibrary, memory->FuelLibrary ? memory->FuelLibrarySize : 0, result);
+    result = HashBytes(&memory->ReportFormat, sizeof(memory->ReportFormat), result);
+    result = HashBytes(&memory->ReportSweep, sizeof(memory->ReportSweep), result);
+    result = HashBytes(&memory->CodeIdentity, sizeof(memory->CodeIdentity), result);
+    result = HashBytes(&memory->MathMode, sizeof(memory->MathMode), result);
+    return result ? result : 1;
+}
+
+internal void
+PrepareStageCache(StageCache *cache, u64 key)
+{
+    if (cache->Key != key)
+    {
+        PopTo(&cache->Arena, cache->Arena.Base);
+        cache->Key = key;
+        cache->ValidStages = 0;
+        cache->ReportCount = 0;
+    }
+    cache->Stage = 0;
+}
+
+inline const char *
+CopyStageString(MemoryArena *arena, const char *string)
+{
+    if (!string)
+    {
+        return 0;
+    }
+
+    u64 size = strlen(string) + 1;
+    char *result = (char *)PushSize(arena, size, 1);
+    memcpy(result, string, size);
+    return result;
+}
+
+// Копия отчета в память кэша: строки и значения копируются, указатели
+// копии смотрят только в кэш.
+internal b32
+StoreStageReport(StageCache *cache, Report *report, b32 rows)
+{
+    auto arena = &cache->Arena;
+
+    u64 size = sizeof(Report) + ARENA_DEFAULT_ALIGNMENT;
+    size += (report->Name ? strlen(report->Name) + 1 : 0) + (report->Title ? strlen(report->Title) + 1 : 0);
+    for (u32 fieldIndex = 0; fieldIndex < report->FieldCount; ++fieldIndex)
+    {
+        ReportField *field = report->Fields + fieldIndex;
+        size += strlen(field->Name) + 1 + (field->Label ? strlen(field->Label) + 1 : 0) + strlen(field->Unit) + 1;
+        size += report->RecordCount * sizeof(f64) + ARENA_DEFAULT_ALIGNMENT;
+    }
+    if ((cache->ReportCount == ArrayCount(cache->Reports)) || (size > GetArenaSizeRemaining(arena)))
+    {
+        return false;
+    }
+
+    auto stored = PushStruct(arena, Report);
+    *stored = *report;
+    stored->Name = CopyStageString(arena, report->Name);
+    stored->Title = CopyStageString(arena, report->Title);
+    for (u32 fieldIndex = 0; fieldIndex < report->FieldCount; ++fieldIndex)
+    {
+        ReportField *field = stored->Fields + fieldIndex;
+        field->Name = CopyStageString(arena, field->Name);
+        field->Label = CopyStageString(arena, field->Label);
+        field->Unit = CopyStageString(arena, field->Unit);
+
+        f64 *values = PushArray(arena, report->RecordCount, f64);
+        memcpy(values, report->Fields[fieldIndex].Values, report->RecordCount * sizeof(f64));
+        field->Values = values;
+    }
+
+    cache->ReportStages[cache->ReportCount] = cache->Stage;
+    cache->ReportRows[cache->ReportCount] = rows;
+    cache->Reports[cache->ReportCount] = stored;
+    ++cache->ReportCount;
+
+    return true;
+}
+
+// Отчет стадии в stdout; он же сохраняется в кэш для текущей стадии. С -rows
+// машинные форматы несут только таблицу перебора (rows).
+internal void
+WriteStageReport(StageCache *cache, AppMemory *memory, ReportWriter *writer, Report *report, b32 rows = false)
+{
+    if (rows || !memory->ReportSweep || (memory->ReportFormat == ReportFormat_Table))
+    {
+        WriteReport(writer, report, memory->ReportFormat);
+        FlushReportWriter(writer);
+    }
+
+    if (cache->Key && cache->Stage && !cache->StoreFailed)
+    {
+        cache->StoreFailed = !StoreStageReport(cache, report, rows);
+    }
+}
+
+// Возвращает true, если стадию надо считать. Иначе выводит ее сохраненные
+// отчеты и возвращает false.
+internal b32
+BeginStage(StageCache *cache, u32 stage, AppMemory *memory, ReportWriter *writer, FILE *log)
+{
+    Assert(!cache->Stage);
+
+    if (cache->ValidStages & stage)
+    {
+        u32 bit = 0;
+        while (!((stage >> bit) & 1))
+        {
+            ++bit;
+        }
+        Assert(bit < ArrayCount(CalculationStageNames));
+        fprintf(log, "Стадия \"%s\" - из кэша, без пересчета\n", CalculationStageNames[bit]);
+
+        for (u32 index = 0; index < cache->ReportCount; ++index)
+        {
+            if (cache->ReportStages[index] == stage)
+            {
+                WriteStageReport(cache, memory, writer, cache->Reports[index], cache->ReportRows[index]);
+            }
+        }
+        return false;
+    }
+
+    // NOTE: Reports left by an earlier run of this stage that did not fit
+    // are dropped from the list; their bytes stay until the key changes.
+    u32 kept = 0;
+    for (u32 index = 0; index < cache->ReportCount; ++index)
+    {
+        if (cache->ReportStages[index] != stage)
+        {
+            cache->ReportStages[kept] = cache->ReportStages[index];
+            cache->ReportRows[kept] = cache->ReportRows[index];
+            cache->Reports[kept] = cache->Reports[index];
+            ++kept;
+        }
+    }
+    cache->ReportCount = kept;
+
+    cache->Stage = stage;
+    cache->StoreFailed = false;
+    return true;
+}
+
+internal void
+EndStage(StageCache *cache)
+{
+    Assert(cache->Stage);
+    if (cache->Key && !cache->StoreFailed)
+    {
+        cache->ValidStages |= cache->Stage;
+    }
+    cache->Stage = 0;
+}
+
+// Значение поля name из сохраненного отчета reportName (из одной записи)
+internal b32
+GetStageCacheValue(StageCache *cache, const char *reportName, const char *name, f64 *value)
+{
+    for (u32 index = 0; index < cache->ReportCount; ++index)
+    {
+        Report *stored = cache->Reports[index];
+        if (stored->Name && (strcmp(stored->Name, reportName) == 0) && (stored->RecordCount == 1))
+        {
+            for (u32 fieldIndex = 0; fieldIndex < stored->FieldCount; ++fieldIndex)
+            {
+                if (strcmp(stored->Fields[fieldIndex].Name, name) == 0)
+                {
+                    *value = stored->Fields[fieldIndex].Values[0];
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,429 @@
+// Перебор вариантов котла по сетке параметров на всех ядрах.
+//
+// Вариант с номером index раскладывается по параметрам как число в смешанной
+// системе счисления (первый параметр меняется быстрее всех). Варианты режутся
+// на куски по SWEEP_CHUNK_SIZE, каждый поток получает непрерывный диапазон
+// кусков и, закончив свой, крадет половину чужого. Результат куска пишется
+// по его номерам вариантов, поэтому порядок вывода не зависит от числа потоков.
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#define SWEEP_CHUNK_SIZE 4096
+#define SWEEP_MAX_THREADS 64
+
+// NOTE: Set by Calculate from AppMemory. Tools that link the calculation
+// code directly (ss_bench, ss_fuelc) have no platform pool and leave it zero.
+global PlatformAPI GlobalPlatform;
+
+// Потоки расчета: proc(data, threadIndex) для threadIndex от 0 до
+// threadCount - 1, 0 - на вызывающем потоке. Остальные - на потоках очереди
+// платформы, если она есть, иначе на своих std::thread.
+#define PARALLEL_PROC(name) void name(void *data, u32 threadIndex)
+typedef PARALLEL_PROC(ParallelProc);
+
+struct ParallelEntry
+{
+    ParallelProc *Proc;
+    void *Data;
+    u32 ThreadIndex;
+};
+
+internal PLATFORM_WORK_QUEUE_CALLBACK(DoParallelEntry)
+{
+    auto entry = (ParallelEntry *)data;
+    entry->Proc(entry->Data, entry->ThreadIndex);
+}
+
+// число потоков "по числу ядер"
+internal u32
+GetDefaultThreadCount()
+{
+    if (GlobalPlatform.WorkQueue)
+    {
+        return GlobalPlatform.ThreadCount;
+    }
+    return std::thread::hardware_concurrency();
+}
+
+internal void
+RunParallel(ParallelProc *proc, void *data, u32 threadCount)
+{
+    Assert((threadCount >= 1) && (threadCount <= SWEEP_MAX_THREADS));
+
+    if (GlobalPlatform.WorkQueue)
+    {
+        ParallelEntry entries[SWEEP_MAX_THREADS];
+        for (u32 threadIndex = 1; threadIndex < threadCount; ++threadIndex)
+        {
+            entries[threadIndex] = {proc, data, threadIndex};
+            GlobalPlatform.AddEntry(GlobalPlatform.WorkQueue, DoParallelEntry, entries + threadIndex);
+        }
+        proc(data, 0);
+        GlobalPlatform.CompleteAllWork(GlobalPlatform.WorkQueue);
+    }
+    else
+    {
+        std::thread threads[SWEEP_MAX_THREADS];
+        for (u32 threadIndex = 1; threadIndex < threadCount; ++threadIndex)
+        {
+            threads[threadIndex] = std::thread(proc, data, threadIndex);
+        }
+        proc(data, 0);
+        for (u32 threadIndex = 1; threadIndex < threadCount; ++threadIndex)
+        {
+            threads[threadIndex].join();
+        }
+    }
+}
+
+inline u32
+GetSweepSteps(SweepRange range)
+{
+    return (range.Steps > 1) ? range.Steps : 1;
+}
+
+inline f64
+GetSweepValue(SweepRange range, u32 step)
+{
+    f64 result = range.Min;
+    if (range.Steps > 1)
+    {
+        result = Map((f64)step, 0.0, (f64)(range.Steps - 1), range.Min, range.Max);
+    }
+    return result;
+}
+
+internal u64
+GetSweepVariantCount(SweepSpec *spec)
+{
+    u64 result = 1;
+    for (u32 parameter = 0; parameter < SweepParameter_Count; ++parameter)
+    {
+        result *= GetSweepSteps(spec->Ranges[parameter]);
+    }
+    return result;
+}
+
+internal void
+GetSweepSteps(SweepSpec *spec, u64 index, u32 *steps)
+{
+    for (u32 parameter = 0; parameter < SweepParameter_Count; ++parameter)
+    {
+        u32 count = GetSweepSteps(spec->Ranges[parameter]);
+        steps[parameter] = (u32)(index % count);
+        index /= count;
+    }
+}
+
+// значения параметров варианта с номером index
+internal void
+GetSweepVariant(SweepSpec *spec, u64 index, f64 *values)
+{
+    u32 steps[SweepParameter_Count];
+    GetSweepSteps(spec, index, steps);
+    for (u32 parameter = 0; parameter < SweepParameter_Count; ++parameter)
+    {
+        values[parameter] = GetSweepValue(spec->Ranges[parameter], steps[parameter]);
+    }
+}
+
+struct SweepChunkInput
+{
+    f64 Values[SweepParameter_Count - 1][SWEEP_CHUNK_SIZE]; // все кроме Nd
+    u16 Nd[SWEEP_CHUNK_SIZE];
+};
+
+// Вход пакетного расчета из заполненного SweepChunkInput
+internal BoilerBatchInput
+GetSweepChunkBatchInput(SweepSpec *spec, SweepChunkInput *chunkInput, u32 count)
+{
+    BoilerBatchInput input = {};
+    input.Count = count;
+    input.TopLengh = chunkInput->Values[SweepParameter_TopLengh];
+    input.TopWidth = chunkInput->Values[SweepParameter_TopWidth];
+    input.BottomLength = chunkInput->Values[SweepParameter_BottomLength];
+    input.BottomWidth = chunkInput->Values[SweepParameter_BottomWidth];
+    input.FrontHeight = chunkInput->Values[SweepParameter_FrontHeight];
+    input.RearHeight = chunkInput->Values[SweepParameter_RearHeight];
+    input.DOut = chunkInput->Values[SweepParameter_DOut];
+    input.DIn = chunkInput->Values[SweepParameter_DIn];
+    input.Ld = chunkInput->Values[SweepParameter_Ld];
+    input.Nd = chunkInput->Nd;
+    input.U = chunkInput->Values[SweepParameter_U - 1];
+    input.q22 = chunkInput->Values[SweepParameter_q22 - 1];
+    input.Fuels = &spec->BaseFuel;
+    input.t = spec->t;
+    return input;
+}
+
+inline void
+SetSweepChunkVariant(SweepChunkInput *chunkInput, u32 index, f64 *values)
+{
+    u32 column = 0;
+    for (u32 parameter = 0; parameter < SweepParameter_Count; ++parameter)
+    {
+        if (parameter == SweepParameter_Nd)
+        {
+            chunkInput->Nd[index] = (u16)(values[parameter] + 0.5);
+        }
+        else
+        {
+            chunkInput->Values[column++][index] = values[parameter];
+        }
+    }
+}
+
+// f32Block не 0 - отбор в f32 (см. RunSweep), это его рабочая память.
+// Возвращает число вариантов, пересчитанных в f64 (только для отбора)
+internal u32
+CalculateSweepChunk(SweepSpec *spec, BoilerBatchOutput *output, SweepChunkInput *chunkInput,
+                    u64 first, u32 count, u32 stages, BoilerBatchF32Block *f32Block)
+{
+    TIMED_FUNCTION();
+
+    u32 steps[SweepParameter_Count];
+    GetSweepSteps(spec, first, steps);
+
+    for (u32 index = 0; index < count; ++index)
+    {
+        f64 values[SweepParameter_Count];
+        for (u32 parameter = 0; parameter < SweepParameter_Count; ++parameter)
+        {
+            values[parameter] = GetSweepValue(spec->Ranges[parameter], steps[parameter]);
+        }
+        SetSweepChunkVariant(chunkInput, index, values);
+
+        // следующий вариант: прибавляем единицу к "одометру"
+        for (u32 parameter = 0; parameter < SweepParameter_Count; ++parameter)
+        {
+            if (++steps[parameter] < GetSweepSteps(spec->Ranges[parameter]))
+            {
+                break;
+            }
+            steps[parameter] = 0;
+        }
+    }
+
+    auto input = GetSweepChunkBatchInput(spec, chunkInput, count);
+
+    // выходные массивы общие на весь перебор, сдвигаем их на начало куска
+    BoilerBatchOutput chunkOutput = *output;
+    f64 **columns = (f64 **)&chunkOutput;
+    for (u32 column = 0; column < sizeof(chunkOutput) / sizeof(f64 *); ++column)
+    {
+        columns[column] += first;
+    }
+
+    // NOTE: The f32 path always computes every stage.
+    if (f32Block && (stages == BoilerStage_All))
+    {
+        return CalculateBoilerBatchF32(f32Block, &input, &chunkOutput, 0, count);
+    }
+
+    CalculateBoilerBatch(&input, &chunkOutput, stages);
+    return 0;
+}
+
+// Диапазон кусков [Begin, End) упакован в одно 64-битное слово, чтобы
+// владелец и воры меняли его одним compare-exchange.
+struct alignas(64) SweepWorkQueue
+{
+    std::atomic<u64> Range;
+};
+
+inline u64
+PackChunkRange(u32 begin, u32 end)
+{
+    return ((u64)end << 32) | begin;
+}
+
+struct SweepWork
+{
+    SweepSpec *Spec;
+    BoilerBatchOutput *Output;
+    u64 VariantCount;
+    u32 ThreadCount;
+    u8 *ChunkStages;
+    SweepChunkInput *ChunkInputs; // по одному на поток
+    BoilerBatchF32Block *F32Blocks; // по одному на поток, 0 - без отбора в f32
+    SweepWorkQueue Queues[SWEEP_MAX_THREADS];
+    std::atomic<u32> StolenChunks;
+    std::atomic<u32> ReusedChunks;
+    std::atomic<u64> ComputedVariants;
+    std::atomic<u64> ReusedVariants;
+    std::atomic<u64> FallbackCount;
+};
+
+// берет первый кусок из своей очереди
+internal b32
+PopSweepChunk(SweepWorkQueue *queue, u32 *chunk)
+{
+    u64 range = queue->Range.load();
+    for (;;)
+    {
+        u32 begin = (u32)range;
+        u32 end = (u32)(range >> 32);
+        if (begin >= end)
+        {
+            return false;
+        }
+        if (queue->Range.compare_exchange_weak(range, PackChunkRange(begin + 1, end)))
+        {
+            *chunk = begin;
+            return true;
+        }
+    }
+}
+
+// забирает себе вторую половину чужой очереди
+internal b32
+StealSweepChunks(SweepWork *work, u32 thiefIndex)
+{
+    for (u32 offset = 1; offset < work->ThreadCount; ++offset)
+    {
+        auto victim = &work->Queues[(thiefIndex + offset) % work->ThreadCount];
+        u64 range = victim->Range.load();
+        for (;;)
+        {
+            u32 begin = (u32)range;
+            u32 end = (u32)(range >> 32);
+            if (begin >= end)
+            {
+                break;
+            }
+
+            u32 middle = begin + (end - begin) / 2;
+            if (victim->Range.compare_exchange_weak(range, PackChunkRange(begin, middle)))
+            {
+                work->Queues[thiefIndex].Range.store(PackChunkRange(middle, end));
+                work->StolenChunks += end - middle;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+internal PARALLEL_PROC(SweepWorkerProc)
+{
+    auto work = (SweepWork *)data;
+    auto chunkInput = work->ChunkInputs + threadIndex;
+    auto f32Block = work->F32Blocks ? (work->F32Blocks + threadIndex) : 0;
+    auto queue = &work->Queues[threadIndex];
+    for (;;)
+    {
+        u32 chunk;
+        if (PopSweepChunk(queue, &chunk))
+        {
+            u64 first = (u64)chunk * SWEEP_CHUNK_SIZE;
+            u64 count = work->VariantCount - first;
+            if (count > SWEEP_CHUNK_SIZE)
+            {
+                count = SWEEP_CHUNK_SIZE;
+            }
+            u32 stages = BoilerStage_All;
+            if (work->ChunkStages)
+            {
+                stages &= ~work->ChunkStages[chunk];
+            }
+
+            if (stages)
+            {
+                work->FallbackCount += CalculateSweepChunk(work->Spec, work->Output, chunkInput, first, (u32)count,
+                                                           stages, f32Block);
+                if (work->ChunkStages)
+                {
+                    work->ChunkStages[chunk] |= stages;
+                }
+                work->ComputedVariants += count;
+            }
+            else
+            {
+                ++work->ReusedChunks;
+                work->ReusedVariants += count;
+            }
+        }
+        else if (!StealSweepChunks(work, threadIndex))
+        {
+            // NOTE: Work never grows, so once every queue is empty we are done.
+            break;
+        }
+    }
+}
+
+// Выходные массивы output должны вмещать GetSweepVariantCount(spec) вариантов.
+// Рабочая память потоков берется из arena и возвращается по окончании.
+// chunkStages (может быть 0) - маски уже посчитанных стадий по кускам, такие
+// стадии не пересчитываются, посчитанные добавляются в маску.
+// threadCount = 0 - по числу ядер.
+// singlePrecision - отбор: варианты считаются CalculateBoilerBatchF32 (ошибка
+// выходов не больше BOILER_BATCH_F32_TOLERANCE, сомнительные - в f64).
+internal SweepStats
+RunSweep(MemoryArena *arena, SweepSpec *spec, BoilerBatchOutput *output, u8 *chunkStages, u32 threadCount,
+         b32 singlePrecision = false)
+{
+    SweepStats stats = {};
+
+    if (threadCount == 0)
+    {
+        threadCount = GetDefaultThreadCount();
+    }
+    threadCount = (u32)LimitI(threadCount, 1, SWEEP_MAX_THREADS);
+
+    auto tempMem = BeginTemporaryMemory(arena);
+
+    auto work = PushStruct(arena, SweepWork);
+    auto chunkInputs = PushArray(arena, threadCount, SweepChunkInput);
+    auto f32Blocks = singlePrecision ? PushArray(arena, threadCount, BoilerBatchF32Block) : 0;
+    if (!work || !chunkInputs || (singlePrecision && !f32Blocks))
+    {
+        EndTemporaryMemory(tempMem);
+        return stats;
+    }
+    ZeroSize(sizeof(*work), work);
+
+    work->Spec = spec;
+    work->Output = output;
+    work->VariantCount = GetSweepVariantCount(spec);
+    work->ThreadCount = threadCount;
+    work->ChunkStages = chunkStages;
+    work->ChunkInputs = chunkInputs;
+    work->F32Blocks = f32Blocks;
+
+    u64 chunkCount = (work->VariantCount + SWEEP_CHUNK_SIZE - 1) / SWEEP_CHUNK_SIZE;
+    Assert(chunkCount <= 0xFFFFFFFF);
+
+    // начальное разбиение: поровну непрерывными диапазонами
+    for (u32 threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+    {
+        u32 begin = (u32)(chunkCount * threadIndex / threadCount);
+        u32 end = (u32)(chunkCount * (threadIndex + 1) / threadCount);
+        work->Queues[threadIndex].Range.store(PackChunkRange(begin, end));
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    RunParallel(SweepWorkerProc, work, threadCount);
+
+    auto endTime = std::chrono::steady_clock::now();
+
+    stats.VariantCount = work->VariantCount;
+    stats.ChunkCount = (u32)chunkCount;
+    stats.ThreadCount = threadCount;
+    stats.StolenChunks = work->StolenChunks;
+    stats.ComputedVariants = work->ComputedVariants;
+    stats.ReusedVariants = work->ReusedVariants;
+    stats.ReusedChunks = work->ReusedChunks;
+    stats.FallbackCount = work->FallbackCount;
+    stats.Seconds = std::chrono::duration<f64>(endTime - startTime).count();
+    // NOTE: Reused chunks cost next to nothing, so the rate counts only
+    // computed variants; otherwise a warm cache would report absurd speeds.
+    stats.VariantsPerSecond = (stats.Seconds > 0.0) ? (stats.ComputedVariants / stats.Seconds) : 0.0;
+
+    EndTemporaryMemory(tempMem);
+
+    return stats;
+}
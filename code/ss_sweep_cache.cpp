@@ -0,0 +1,175 @@
+// Кэш результатов перебора в постоянной памяти. Блок памяти платформы не
+// меняется при перезагрузке кода, поэтому посчитанные куски переживают
+// перекомпиляцию. Кэш сбрасывается целиком, если изменились входные данные
+// перебора (хэш SweepSpec). Если изменилась сборка кода (CodeIdentity), в
+// каждом куске заново считается один пробный вариант и сравнивается с кэшем
+// бит в бит: стадии с расхождением пересчитываются, остальные берутся как есть.
+// NOTE: The check is still a sample, one variant per chunk. A formula change
+// that leaves every probe bit-identical (say, a branch only some variants of
+// a chunk take) keeps stale results; drop the cache (change the sweep input
+// or restart the host) after such edits.
+
+internal u64
+HashSweepSpec(SweepSpec *spec)
+{
+    // NOTE: Field by field, SweepRange has padding that is not guaranteed to be zero.
+    u64 result = HashBytes(&spec->BaseFuel, sizeof(spec->BaseFuel));
+    result = HashBytes(&spec->t, sizeof(spec->t), result);
+    for (u32 parameter = 0; parameter < SweepParameter_Count; ++parameter)
+    {
+        auto range = &spec->Ranges[parameter];
+        result = HashBytes(&range->Min, sizeof(range->Min), result);
+        result = HashBytes(&range->Max, sizeof(range->Max), result);
+        result = HashBytes(&range->Steps, sizeof(range->Steps), result);
+    }
+    return result;
+}
+
+#define STAGE_MAX_COLUMNS 13
+
+// Выходы стадии по номеру бита boiler_stage, не больше STAGE_MAX_COLUMNS
+internal u32
+GetStageColumns(BoilerBatchOutput *output, u32 stage, f64 **columns)
+{
+    f64 *front[] = {output->R, output->Ht, output->Hd, output->L0, output->Bh, output->BhFact, output->M,
+                    output->N, output->Q0, output->Q21, output->Q22, output->T1, output->Q4};
+    f64 *fireTubes[] = {output->T2, output->T3, output->Tabs, output->Omega, output->K1};
+    f64 *losses[] = {output->Q3, output->Qt};
+
+    f64 **stageColumns[] = {front, fireTubes, losses};
+    u32 stageColumnCounts[] = {ArrayCount(front), ArrayCount(fireTubes), ArrayCount(losses)};
+    Assert(stage < ArrayCount(stageColumns));
+
+    u32 result = stageColumnCounts[stage];
+    for (u32 column = 0; column < result; ++column)
+    {
+        columns[column] = stageColumns[stage][column];
+    }
+    return result;
+}
+
+// Пересчитывает по одному варианту из каждого куска и сравнивает с кэшем.
+// Возвращает маску стадий, у которых хоть один вариант разошелся.
+internal u32
+VerifySweepCache(MemoryArena *arena, SweepSpec *spec, SweepCache *cache)
+{
+    u32 result = 0;
+
+    auto tempMem = BeginTemporaryMemory(arena);
+
+    auto chunkInput = PushStruct(arena, SweepChunkInput);
+    auto output = PushBoilerBatchOutput(arena, SWEEP_CHUNK_SIZE);
+    auto probes = PushArray(arena, SWEEP_CHUNK_SIZE, u64);
+    if (chunkInput && output.R && probes)
+    {
+        for (u32 firstChunk = 0; firstChunk < cache->ChunkCount; firstChunk += SWEEP_CHUNK_SIZE)
+        {
+            u32 onePastLastChunk = (u32)Minimum((u64)firstChunk + SWEEP_CHUNK_SIZE, (u64)cache->ChunkCount);
+            u32 probeCount = 0;
+            for (u32 chunk = firstChunk; chunk < onePastLastChunk; ++chunk)
+            {
+                u64 first = (u64)chunk * SWEEP_CHUNK_SIZE;
+                u64 count = Minimum(cache->VariantCount - first, (u64)SWEEP_CHUNK_SIZE);
+                // NOTE: A different offset in every chunk, so the probes do not all
+                // sit at the same corner of the inner sweep parameters.
+                u64 variant = first + ((u64)chunk * 2654435761u) % count;
+
+                f64 values[SweepParameter_Count];
+                GetSweepVariant(spec, variant, values);
+                SetSweepChunkVariant(chunkInput, probeCount, values);
+                probes[probeCount++] = variant;
+            }
+
+            auto input = GetSweepChunkBatchInput(spec, chunkInput, probeCount);
+            CalculateBoilerBatch(&input, &output);
+
+            for (u32 stage = 0; stage < 3; ++stage)
+            {
+                f64 *cached[STAGE_MAX_COLUMNS];
+                f64 *probed[STAGE_MAX_COLUMNS];
+                u32 columnCount = GetStageColumns(&cache->Output, stage, cached);
+                GetStageColumns(&output, stage, probed);
+
+                for (u32 probe = 0; probe < probeCount; ++probe)
+                {
+                    if (!(cache->ChunkStages[firstChunk + probe] & (1 << stage)))
+                    {
+                        continue;
+                    }
+                    for (u32 column = 0; column < columnCount; ++column)
+                    {
+                        if (memcmp(&cached[column][probes[probe]], &probed[column][probe], sizeof(f64)) != 0)
+                        {
+                            result |= (1 << stage);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    else
+    {
+        result = BoilerStage_All;
+    }
+
+    EndTemporaryMemory(tempMem);
+
+    return result;
+}
+
+// Готовит кэш к перебору spec сборкой кода codeIdentity (0 - неизвестна, кэш
+// тогда проверяется при каждом вызове). Возвращает маску стадий boiler_stage,
+// которые придется пересчитать, или 0, если все уже посчитано. Если памяти
+// на кэш не хватает, cache->ChunkStages остается нулевым.
+internal u32
+PrepareSweepCache(AppState *appState, SweepSpec *spec, u64 codeIdentity)
+{
+    u32 result = 0;
+
+    auto cache = &appState->Sweep;
+    auto permanentArena = &appState->PermanentArena;
+
+    auto inputHash = HashSweepSpec(spec);
+
+    if (!cache->ChunkStages || (cache->InputHash != inputHash))
+    {
+        if (cache->Memory)
+        {
+            PopTo(permanentArena, cache->Memory);
+        }
+        ZeroStruct(*cache);
+
+        cache->Memory = permanentArena->Base + permanentArena->Used;
+        cache->InputHash = inputHash;
+        cache->VariantCount = GetSweepVariantCount(spec);
+        cache->ChunkCount = (u32)((cache->VariantCount + SWEEP_CHUNK_SIZE - 1) / SWEEP_CHUNK_SIZE);
+
+        if ((GetBoilerBatchOutputSize(cache->VariantCount) + cache->ChunkCount + ARENA_DEFAULT_ALIGNMENT) <=
+            GetArenaSizeRemaining(permanentArena))
+        {
+            cache->Output = PushBoilerBatchOutput(permanentArena, cache->VariantCount);
+            cache->ChunkStages = PushArray(permanentArena, cache->ChunkCount, u8);
+            ZeroSize(cache->ChunkCount, cache->ChunkStages);
+        }
+
+        result = BoilerStage_All;
+    }
+    else
+    {
+        u32 stale = 0;
+        if (!codeIdentity || (cache->CodeIdentity != codeIdentity))
+        {
+            stale = VerifySweepCache(&appState->TransientArena, spec, cache);
+        }
+
+        for (u32 chunk = 0; chunk < cache->ChunkCount; ++chunk)
+        {
+            cache->ChunkStages[chunk] &= ~stale;
+            result |= BoilerStage_All & ~cache->ChunkStages[chunk];
+        }
+    }
+
+    cache->CodeIdentity = codeIdentity;
+
+    return result;
+}
@@ -4,18 +4,21 @@ void CatStrings(size_t sourceACount, char *sourceA,
                 size_t sourceBCount, char *sourceB,
                 size_t destCount, char *dest)
 {
-
-    for (i32 index = 0; index < sourceACount; ++index)
+    // NOTE: Truncates to what fits in destCount, terminator included.
+    for (size_t index = 0; (index < sourceACount) && (destCount > 1); ++index, --destCount)
     {
         *dest++ = *sourceA++;
     }
 
-    for (i32 index = 0; index < sourceBCount; ++index)
+    for (size_t index = 0; (index < sourceBCount) && (destCount > 1); ++index, --destCount)
     {
         *dest++ = *sourceB++;
     }
 
-    *dest++ = 0;
+    if (destCount)
+    {
+        *dest++ = 0;
+    }
 }
 
 int StringLength(char *string)
@@ -27,3 +30,76 @@ int StringLength(char *string)
     }
     return count;
 }
+
+#if EDITOR_PROFILE
+
+#define DEBUG_REPORT_ROW_COUNT 24
+
+// Hottest timed blocks of the last Calculate, by cycles summed over all
+// threads, then a reset for the next call. Must run before the code that
+// owns the record strings is unloaded.
+void ReportDebugCounters(DebugCounterTable *table, FILE *out)
+{
+    u32 threadCount = table->ThreadCount;
+    if (threadCount > DEBUG_MAX_THREADS)
+    {
+        threadCount = DEBUG_MAX_THREADS;
+    }
+
+    u32 order[DEBUG_MAX_COUNTERS];
+    u64 cycles[DEBUG_MAX_COUNTERS];
+    u64 hits[DEBUG_MAX_COUNTERS];
+    u32 recordCount = 0;
+    for (u32 counterIndex = 0; counterIndex < DEBUG_MAX_COUNTERS; ++counterIndex)
+    {
+        if (!table->Records[counterIndex].BlockName)
+        {
+            continue;
+        }
+
+        cycles[counterIndex] = 0;
+        hits[counterIndex] = 0;
+        for (u32 threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+        {
+            DebugCounter *counter = table->Counters[threadIndex] + counterIndex;
+            cycles[counterIndex] += counter->CycleCount;
+            hits[counterIndex] += counter->HitCount;
+        }
+
+        // NOTE: Insertion by cycles, there are only a few hundred records.
+        u32 at = recordCount++;
+        while ((at > 0) && (cycles[order[at - 1]] < cycles[counterIndex]))
+        {
+            order[at] = order[at - 1];
+            --at;
+        }
+        order[at] = counterIndex;
+    }
+
+    if (recordCount)
+    {
+        fprintf(out, "Timed blocks (cycles include nested blocks, %u threads%s):\n", threadCount,
+                (table->ThreadCount > DEBUG_MAX_THREADS) ? ", later threads not counted" : "");
+        fprintf(out, "%14s %12s %12s  %s\n", "Mcycles", "hits", "cycles/hit", "block");
+        for (u32 row = 0; (row < recordCount) && (row < DEBUG_REPORT_ROW_COUNT); ++row)
+        {
+            u32 counterIndex = order[row];
+            DebugCounterRecord *record = table->Records + counterIndex;
+            fprintf(out, "%14.3f %12llu %12.1f  %s%s (%s:%u)\n", cycles[counterIndex] / 1e6,
+                    (unsigned long long)hits[counterIndex],
+                    hits[counterIndex] ? ((f64)cycles[counterIndex] / hits[counterIndex]) : 0.0,
+                    record->Prefix ? record->Prefix : "", record->BlockName, record->FileName,
+                    record->LineNumber);
+        }
+    }
+
+    memset(table->Records, 0, sizeof(table->Records));
+    memset(table->Counters, 0, threadCount * sizeof(table->Counters[0]));
+    table->ThreadCount = 0;
+    if (++table->Generation == 0)
+    {
+        table->Generation = 1;
+    }
+}
+
+#endif
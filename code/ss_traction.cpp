@@ -0,0 +1,311 @@
+// Движение поезда по профилю пути с шагом Dt. На каждом шаге:
+//  - сила тяги - меньшая из GetF (по машине), силы сцепления и силы, на
+//    которую хватает пара: испарение котла при текущем напряжении решетки за
+//    вычетом охлаждения GetQ4 при текущей скорости, деленное на расход пара
+//    на л.с. в час;
+//  - сопротивление - основное (A + B V + C V^2 на тонну), подъем и кривые
+//    (700 / R на тонну);
+//  - машинист держит ограничение скорости: тяга ниже ограничения, торможение
+//    выше него и перед участком с меньшим ограничением (по тормозному пути),
+//    между ними скорость держится тягой или тормозами.
+// Котел для каждого паровоза считается один раз CalculateBoilerBatch в
+// TRACTION_FIRING_LEVELS точках по напряжению решетки, на шаге - линейная
+// интерполяция. Состояние поездки - несколько чисел на стеке, память на шаге
+// не выделяется.
+
+#include <chrono>
+
+#define TRACTION_HOLD_BAND (0.5 / 3.6) // зона удержания скорости под ограничением, м/с
+#define TRACTION_Q4_SPEED_STEP 0.25    // через сколько км/ч пересчитывать GetQ4
+
+// формулы шага, общие с векторным путем парка
+#define WIDE f64
+#include "ss_traction_formulas.inl"
+#undef WIDE
+
+// Тепло, которое котел отдает воде без потерь на охлаждение, и расход топлива
+// по точкам напряжения решетки
+struct TractionFiring
+{
+    f64 Q[TRACTION_FIRING_LEVELS];
+    f64 Bh[TRACTION_FIRING_LEVELS];
+};
+
+struct TractionTrip
+{
+    f64 Time;
+    f64 Fuel;
+    f64 Steam;
+    f64 MaxSpeed;
+    u64 Steps;
+};
+
+inline f64
+GetTractionFiringU(TractionSpec *spec, u32 level)
+{
+    return Map(level, 0, TRACTION_FIRING_LEVELS - 1, spec->UIdle, spec->UMax);
+}
+
+// Ускорение поезда массы mass (т) на кг силы, м/с^2
+inline f64
+GetTractionAccelerationPerForce(TractionSpec *spec, f64 mass)
+{
+    return 9.81 / (1000.0 * mass * (1.0 + spec->Rotating));
+}
+
+// Сила тяги при трогании: по машине и по сцеплению, кг
+inline f64
+GetTractionStartForce(TractionSpec *spec, Locomotive *locomotive)
+{
+    return Minimum(GetF(locomotive->CylinderD, locomotive->Stroke, locomotive->Pressure, locomotive->WheelD) * 1000.0,
+                   spec->Adhesion * locomotive->AdhesionMass * 1000.0);
+}
+
+// Сопротивление от подъема и кривых участка, кг/т
+inline f64
+GetTractionSectionResistance(RouteSection *section)
+{
+    return section->Grade + ((section->CurveRadius > 0.0) ? (700.0 / section->CurveRadius) : 0.0);
+}
+
+// Ограничение скорости с учетом тормозного пути до следующих участков, м/с
+inline f64
+GetTractionAllowedSpeed(TractionSpec *spec, TractionRoute *route, u32 sectionIndex, f64 toSectionEnd, f64 V)
+{
+    f64 result = route->Sections[sectionIndex].SpeedLimit / 3.6;
+
+    f64 lookAhead = (V * V) / (2.0 * spec->Brake) + V * spec->Dt;
+    f64 distance = toSectionEnd;
+    for (u32 next = sectionIndex + 1; (next < route->SectionCount) && (distance < lookAhead); ++next)
+    {
+        f64 limit = route->Sections[next].SpeedLimit / 3.6;
+        result = Minimum(result, sqrt(limit * limit + 2.0 * spec->Brake * distance));
+        distance += route->Sections[next].Length;
+    }
+
+    return result;
+}
+
+internal traction_status
+SimulateTractionTrip(TractionSpec *spec, TractionRoute *route, Locomotive *locomotive, TractionFiring *firing,
+                     f64 trainMass, f64 tb, TractionTrip *trip)
+{
+    ZeroStruct(*trip);
+
+    f64 length = 0.0;
+    for (u32 index = 0; index < route->SectionCount; ++index)
+    {
+        length += route->Sections[index].Length;
+    }
+
+    f64 mass = locomotive->Mass + trainMass;
+    f64 accelerationPerForce = GetTractionAccelerationPerForce(spec, mass);
+    f64 startForce = GetTractionStartForce(spec, locomotive);
+    f64 steamHeat = spec->SteamEnthalpy - spec->FeedT;
+    f64 firingScale = (TRACTION_FIRING_LEVELS - 1) / (spec->UMax - spec->UIdle);
+    f64 dt = spec->Dt;
+    f64 lag = Minimum(dt / spec->FiringLag, 1.0);
+
+    traction_status result = TractionStatus_Arrived;
+
+    // NOTE: The fire is built up before departure.
+    f64 U = spec->UMax;
+    f64 V = 0.0;
+    f64 position = 0.0;
+    u32 sectionIndex = 0;
+    f64 sectionEnd = route->Sections[0].Length;
+    f64 Q4 = GetQ4(locomotive->Phi, locomotive->H0, 0.0, tb, spec->tk);
+    f64 Q4Speed = 0.0;
+    while (position < length)
+    {
+        if (trip->Time >= spec->MaxTime)
+        {
+            result = TractionStatus_TimeOut;
+            break;
+        }
+
+        while ((position >= sectionEnd) && (sectionIndex + 1 < route->SectionCount))
+        {
+            ++sectionIndex;
+            sectionEnd += route->Sections[sectionIndex].Length;
+        }
+        RouteSection *section = route->Sections + sectionIndex;
+
+        // сопротивление поезда, кг
+        f64 speed = V * 3.6;
+        f64 W = GetTractionResistance(spec, mass, speed, GetTractionSectionResistance(section));
+
+        // пар при текущей форсировке и скорости, кг/час
+        f64 x = LimitF((U - spec->UIdle) * firingScale, 0.0, TRACTION_FIRING_LEVELS - 1);
+        u32 level = Minimum((u32)x, TRACTION_FIRING_LEVELS - 2);
+        f64 fraction = x - level;
+        f64 Q = firing->Q[level] + fraction * (firing->Q[level + 1] - firing->Q[level]);
+        f64 Bh = firing->Bh[level] + fraction * (firing->Bh[level + 1] - firing->Bh[level]);
+        if (fabs(speed - Q4Speed) > TRACTION_Q4_SPEED_STEP)
+        {
+            // NOTE: Q4 changes by well under 0.1% per 0.25 km/h, so it is
+            // only refreshed when the speed has moved that far.
+            Q4 = GetQ4(locomotive->Phi, locomotive->H0, speed, tb, spec->tk);
+            Q4Speed = speed;
+        }
+        f64 D = GetTractionSteamFlow(Q, Q4, steamHeat);
+
+        f64 steamForce = GetTractionSteamForce(D, locomotive->SteamRate, speed);
+        f64 maxForce = Minimum(startForce, steamForce);
+
+        f64 allowed = GetTractionAllowedSpeed(spec, route, sectionIndex, sectionEnd - position, V);
+        f64 F = 0.0;
+        f64 a;
+        if (V > allowed)
+        {
+            a = GetTractionBrakeAcceleration(spec, W, accelerationPerForce);
+        }
+        else if (V < allowed - TRACTION_HOLD_BAND)
+        {
+            F = maxForce;
+            a = GetTractionAcceleration(F, W, accelerationPerForce);
+            if ((V <= 0.0) && (a <= 0.0))
+            {
+                result = TractionStatus_Stalled;
+                break;
+            }
+        }
+        else
+        {
+            // держим скорость: тяга против сопротивления, лишнее - тормозами
+            F = GetTractionHoldForce(W, maxForce);
+            a = GetTractionHoldAcceleration(F, W, accelerationPerForce);
+        }
+
+        trip->Steam += GetTractionStepSteam(F, speed, locomotive->SteamRate, dt);
+        trip->Fuel += GetTractionStepFuel(Bh, dt);
+
+        f64 targetU = (F > 0.0) ? spec->UMax : spec->UIdle;
+        U = GetTractionFiringStep(U, targetU, lag);
+
+        V = Maximum(V + a * dt, 0.0);
+        position += V * dt;
+        trip->Time += dt;
+        trip->MaxSpeed = Maximum(trip->MaxSpeed, V * 3.6);
+        ++trip->Steps;
+    }
+
+    if ((result == TractionStatus_Arrived) && (V > 0.0))
+    {
+        // последний шаг заканчивается за концом пути
+        trip->Time -= (position - length) / V;
+    }
+
+    return result;
+}
+
+// Таблицы котла для паровозов boilers (по варианту на паровоз) в arena,
+// 0 - если не хватает памяти
+internal TractionFiring *
+PushTractionFirings(MemoryArena *arena, TractionSpec *spec, BoilerBatchInput *boilers)
+{
+    u32 locomotiveCount = boilers->Count;
+    u32 levelCount = locomotiveCount * TRACTION_FIRING_LEVELS;
+
+    auto result = PushArray(arena, locomotiveCount, TractionFiring);
+    if (!result)
+    {
+        return result;
+    }
+
+    auto tempMem = BeginTemporaryMemory(arena);
+    auto levels = PushBoilerBatchInput(arena, levelCount);
+    auto levelOutput = PushBoilerBatchOutput(arena, levelCount);
+    if (!levels.Ld || !levelOutput.T3)
+    {
+        EndTemporaryMemory(tempMem);
+        return 0;
+    }
+
+    levels.Fuels = boilers->Fuels;
+    levels.FuelRecords = boilers->FuelRecords;
+    levels.t = boilers->t;
+    for (u32 locomotive = 0; locomotive < locomotiveCount; ++locomotive)
+    {
+        for (u32 level = 0; level < TRACTION_FIRING_LEVELS; ++level)
+        {
+            u32 slot = locomotive * TRACTION_FIRING_LEVELS + level;
+            CopyBoilerBatchVariant(&levels, slot, boilers, locomotive);
+            levels.U[slot] = GetTractionFiringU(spec, level);
+        }
+    }
+    CalculateBoilerBatch(&levels, &levelOutput);
+
+    for (u32 locomotive = 0; locomotive < locomotiveCount; ++locomotive)
+    {
+        TractionFiring *firing = result + locomotive;
+        for (u32 level = 0; level < TRACTION_FIRING_LEVELS; ++level)
+        {
+            // NOTE: Q4 of the batch (a fixed share of Q0) is left out here;
+            // the trip takes GetQ4 at its actual speed instead.
+            u32 slot = locomotive * TRACTION_FIRING_LEVELS + level;
+            firing->Q[level] = levelOutput.Q0[slot] - levelOutput.Q21[slot] - levelOutput.Q22[slot] -
+                               levelOutput.Q3[slot];
+            firing->Bh[level] = levelOutput.Bh[slot];
+        }
+    }
+
+    EndTemporaryMemory(tempMem);
+    return result;
+}
+
+internal TractionStats
+SolveTractionBatch(MemoryArena *arena, TractionSpec *spec, TractionBatch *batch)
+{
+    TIMED_FUNCTION();
+
+    TractionStats stats = {};
+    stats.TripCount = batch->Count;
+
+    Assert((spec->Dt > 0.0) && (spec->UIdle < spec->UMax) && (spec->Brake > 0.0));
+
+    auto tempMem = BeginTemporaryMemory(arena);
+
+    BoilerBatchInput *boilers = batch->Boilers;
+    u32 locomotiveCount = boilers->Count;
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    auto firings = PushTractionFirings(arena, spec, boilers);
+    if (!firings)
+    {
+        EndTemporaryMemory(tempMem);
+        return stats;
+    }
+
+    for (u32 index = 0; index < batch->Count; ++index)
+    {
+        u32 locomotive = batch->LocomotiveIndex[index];
+        Assert(locomotive < locomotiveCount);
+
+        TractionTrip trip;
+        auto status = SimulateTractionTrip(spec, batch->Routes + batch->RouteIndex[index],
+                                           batch->Locomotives + locomotive, firings + locomotive,
+                                           batch->TrainMass[index], boilers->t, &trip);
+
+        batch->Time[index] = trip.Time;
+        batch->Fuel[index] = trip.Fuel;
+        batch->Steam[index] = trip.Steam;
+        batch->MaxSpeed[index] = trip.MaxSpeed;
+        if (batch->Status)
+        {
+            batch->Status[index] = (u8)status;
+        }
+
+        stats.Steps += trip.Steps;
+        stats.Arrived += (status == TractionStatus_Arrived);
+        stats.Stalled += (status == TractionStatus_Stalled);
+        stats.TimedOut += (status == TractionStatus_TimeOut);
+    }
+
+    auto endTime = std::chrono::steady_clock::now();
+    stats.Seconds = std::chrono::duration<f64>(endTime - startTime).count();
+
+    EndTemporaryMemory(tempMem);
+    return stats;
+}
@@ -0,0 +1,78 @@
+// NOTE: The trip step formulas of SimulateTractionTrip, written once over
+// WIDE. ss_traction.cpp includes this with WIDE defined to f64; ss_fleet.cpp
+// includes it once per wide type (f64x1 too), inside the matching target
+// region, for ss_fleet_wide.inl. The scalar trip picks one driver mode with
+// branches, the wide one computes all of them and blends with Select; the
+// formulas are the same.
+
+// Сопротивление поезда, кг
+// mass  - масса поезда с паровозом, т
+// speed - скорость, км/ч
+// wi    - сопротивление от подъема и кривых, кг/т
+internal inline WIDE
+GetTractionResistance(TractionSpec *spec, WIDE mass, WIDE speed, WIDE wi)
+{
+    WIDE w0 = spec->ResistanceA + spec->ResistanceB * speed + spec->ResistanceC * speed * speed;
+    return mass * (w0 + wi);
+}
+
+// Пар для машины, кг/час: тепло котла Q за вычетом охлаждения Q4
+internal inline WIDE
+GetTractionSteamFlow(WIDE Q, WIDE Q4, f64 steamHeat)
+{
+    return Max(Q - Q4, 0.0) / steamHeat;
+}
+
+// Сила тяги, на которую хватает пара D, кг
+// NOTE: F V / 270 is the power in hp for F in kg and V in km/h.
+internal inline WIDE
+GetTractionSteamForce(WIDE D, WIDE steamRate, WIDE speed)
+{
+    return 270.0 * (D / steamRate) / Max(speed, 1.0);
+}
+
+// Ускорения, м/с^2: торможение, тяга силой F; apf - ускорение на кг силы
+internal inline WIDE
+GetTractionBrakeAcceleration(TractionSpec *spec, WIDE W, WIDE apf)
+{
+    return -W * apf - spec->Brake;
+}
+
+internal inline WIDE
+GetTractionAcceleration(WIDE F, WIDE W, WIDE apf)
+{
+    return (F - W) * apf;
+}
+
+// Удержание скорости: тяга против сопротивления, лишнее - тормозами
+internal inline WIDE
+GetTractionHoldForce(WIDE W, WIDE maxForce)
+{
+    return Min(Max(W, 0.0), maxForce);
+}
+
+internal inline WIDE
+GetTractionHoldAcceleration(WIDE F, WIDE W, WIDE apf)
+{
+    return Min(GetTractionAcceleration(F, W, apf), 0.0);
+}
+
+// Пар и топливо за шаг dt, кг
+internal inline WIDE
+GetTractionStepSteam(WIDE F, WIDE speed, WIDE steamRate, f64 dt)
+{
+    return F * speed / 270.0 * steamRate * dt / 3600.0;
+}
+
+internal inline WIDE
+GetTractionStepFuel(WIDE Bh, f64 dt)
+{
+    return Bh * dt / 3600.0;
+}
+
+// Напряжение решетки тянется к targetU с запаздыванием lag за шаг
+internal inline WIDE
+GetTractionFiringStep(WIDE U, WIDE targetU, f64 lag)
+{
+    return U + (targetU - U) * lag;
+}
@@ -1,5 +1,9 @@
 #include "win32_ss.h"
 #include "ss_tools.h"
+#include <fcntl.h>
+#include <io.h>
+#include <stdlib.h>
+#include <string.h>
 
 internal void
 Win32GetEXEFileName(Win32State *state)
@@ -128,9 +132,9 @@ Win32LoadAppCode(char *sourceDLLName, char *tempDLLName)
     Win32AppCode result = {};
 
     // TODO: Need to get the proper path here!
-    // TODO: Automatic determination of when updates are necessary.
 
     result.DLLLastWriteTime = Win32GetLastWriteTime(sourceDLLName);
+    result.CodeIdentity = ((u64)result.DLLLastWriteTime.dwHighDateTime << 32) | result.DLLLastWriteTime.dwLowDateTime;
     CopyFile(sourceDLLName, tempDLLName, FALSE);
 
     result.AppCodeDLL = LoadLibraryA(tempDLLName);
@@ -163,7 +167,443 @@ Win32UnloadAppCode(Win32AppCode *appCode)
     appCode->Calculate = CalculateStub;
 }
 
-int main()
+// Polls until a new version of the DLL has been written.
+// NOTE: No change notification here: the compiler writes the DLL in several
+// steps, so the write time has to stay put for one more poll before the new
+// version is loaded.
+internal b32
+Win32WaitForAppCodeChange(char *sourceDLLName, FILETIME lastWriteTime)
+{
+    b32 result = false;
+
+    while (!result)
+    {
+        Sleep(250);
+        FILETIME writeTime = Win32GetLastWriteTime(sourceDLLName);
+        if (CompareFileTime(&writeTime, &lastWriteTime) != 0)
+        {
+            FILETIME settledTime;
+            do
+            {
+                settledTime = writeTime;
+                Sleep(250);
+                writeTime = Win32GetLastWriteTime(sourceDLLName);
+            } while (CompareFileTime(&writeTime, &settledTime) != 0);
+
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+// Large pages need SeLockMemoryPrivilege, which has to be switched on in
+// the process token before VirtualAlloc will accept MEM_LARGE_PAGES.
+internal b32
+Win32EnableLockMemoryPrivilege()
+{
+    b32 result = false;
+
+    HANDLE token;
+    if (OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+    {
+        TOKEN_PRIVILEGES privileges = {};
+        privileges.PrivilegeCount = 1;
+        privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+        if (LookupPrivilegeValueA(0, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid))
+        {
+            AdjustTokenPrivileges(token, FALSE, &privileges, 0, 0, 0);
+            result = (GetLastError() == ERROR_SUCCESS);
+        }
+
+        CloseHandle(token);
+    }
+
+    return result;
+}
+
+internal void *
+Win32AllocateMemoryBlock(void *baseAddress, u64 totalSize, b32 *largePages)
+{
+    void *result = 0;
+
+    *largePages = false;
+
+    SIZE_T largePageSize = GetLargePageMinimum();
+    if (largePageSize && Win32EnableLockMemoryPrivilege())
+    {
+        u64 largeSize = (totalSize + largePageSize - 1) & ~((u64)largePageSize - 1);
+        result = VirtualAlloc(baseAddress, (size_t)largeSize,
+                              MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        *largePages = (result != 0);
+    }
+
+    if (!result)
+    {
+        result = VirtualAlloc(baseAddress, (size_t)totalSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+
+    return result;
+}
+
+internal void
+Win32GetSnapshotFileName(Win32State *state, i32 slotIndex, int destCount, char *dest)
+{
+    char temp[64];
+    snprintf(temp, sizeof(temp), "ss_snapshot_%d.sss", slotIndex);
+    Win32BuildEXEPathFileName(state, temp, destCount, dest);
+}
+
+internal void
+Win32BeginRecordingInput(Win32State *state, i32 inputRecordingIndex)
+{
+    char fileName[WIN32_STATE_FILE_NAME_COUNT];
+    Win32GetSnapshotFileName(state, inputRecordingIndex, sizeof(fileName), fileName);
+
+    state->RecordingHandle = CreateFileA(fileName, GENERIC_READ | GENERIC_WRITE, 0, 0, CREATE_ALWAYS, 0, 0);
+    if (state->RecordingHandle != INVALID_HANDLE_VALUE)
+    {
+        state->InputRecordingIndex = inputRecordingIndex;
+    }
+    else
+    {
+        // TODO: Logging
+    }
+}
+
+internal void
+Win32EndRecordingInput(Win32State *state)
+{
+    CloseHandle(state->RecordingHandle);
+    state->RecordingHandle = INVALID_HANDLE_VALUE;
+    state->InputRecordingIndex = 0;
+}
+
+// Writes the input set and the used part of permanent storage (the input
+// lives there) through a mapping of the snapshot file.
+internal b32
+Win32RecordSnapshot(Win32State *state, AppMemory *memory)
+{
+    b32 result = false;
+
+    u64 dataSize = (memory->PermanentStorageUsed + SNAPSHOT_DATA_ALIGNMENT - 1) & ~(SNAPSHOT_DATA_ALIGNMENT - 1);
+    if (dataSize > memory->PermanentStorageSize)
+    {
+        dataSize = memory->PermanentStorageSize;
+    }
+    u64 fileSize = SNAPSHOT_DATA_OFFSET + dataSize;
+
+    // NOTE: Shrink first so stale bytes of a previous recording do not survive.
+    LARGE_INTEGER zero = {};
+    SetFilePointerEx(state->RecordingHandle, zero, 0, FILE_BEGIN);
+    SetEndOfFile(state->RecordingHandle);
+
+    HANDLE fileMap = CreateFileMappingA(state->RecordingHandle, 0, PAGE_READWRITE,
+                                        (DWORD)(fileSize >> 32), (DWORD)(fileSize & 0xFFFFFFFF), 0);
+    if (fileMap)
+    {
+        void *view = MapViewOfFile(fileMap, FILE_MAP_WRITE, 0, 0, (SIZE_T)fileSize);
+        if (view)
+        {
+            auto header = (SnapshotHeader *)view;
+            header->Magic = SNAPSHOT_MAGIC;
+            header->HeaderSize = sizeof(SnapshotHeader);
+            header->BaseAddress = (u64)state->AppMemoryBlock;
+            header->PermanentStorageSize = memory->PermanentStorageSize;
+            header->TransientStorageSize = memory->TransientStorageSize;
+            header->DataSize = dataSize;
+
+            CopyMemory((u8 *)view + SNAPSHOT_DATA_OFFSET, memory->PermanentStorage, memory->PermanentStorageUsed);
+
+            UnmapViewOfFile(view);
+            result = true;
+        }
+        CloseHandle(fileMap);
+    }
+
+    if (!result)
+    {
+        // TODO: Logging
+    }
+
+    return result;
+}
+
+// Opens a snapshot and reads its header; the caller has to allocate the app
+// memory block at header->BaseAddress before Win32BeginInputPlayBack.
+internal b32
+Win32OpenSnapshot(Win32State *state, i32 inputPlayingIndex, SnapshotHeader *header)
+{
+    b32 result = false;
+
+    char fileName[WIN32_STATE_FILE_NAME_COUNT];
+    Win32GetSnapshotFileName(state, inputPlayingIndex, sizeof(fileName), fileName);
+
+    state->PlaybackHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0);
+    if (state->PlaybackHandle != INVALID_HANDLE_VALUE)
+    {
+        DWORD bytesRead;
+        LARGE_INTEGER fileSize;
+        if (ReadFile(state->PlaybackHandle, header, sizeof(*header), &bytesRead, 0) &&
+            (bytesRead == sizeof(*header)) &&
+            (header->Magic == SNAPSHOT_MAGIC) &&
+            (header->HeaderSize == sizeof(SnapshotHeader)) &&
+            GetFileSizeEx(state->PlaybackHandle, &fileSize) &&
+            ((u64)fileSize.QuadPart >= SNAPSHOT_DATA_OFFSET + header->DataSize))
+        {
+            state->InputPlayingIndex = inputPlayingIndex;
+            result = true;
+        }
+        else
+        {
+            CloseHandle(state->PlaybackHandle);
+            state->PlaybackHandle = INVALID_HANDLE_VALUE;
+        }
+    }
+
+    if (!result)
+    {
+        // TODO: Logging
+    }
+
+    return result;
+}
+
+// NOTE: A view cannot replace part of a VirtualAlloc region, so unlike the
+// Linux host the snapshot is mapped once and copied into the block.
+internal b32
+Win32BeginInputPlayBack(Win32State *state, AppMemory *memory, SnapshotHeader *header)
+{
+    b32 result = false;
+
+    if ((header->BaseAddress == (u64)state->AppMemoryBlock) &&
+        (header->PermanentStorageSize == memory->PermanentStorageSize) &&
+        (header->DataSize <= memory->PermanentStorageSize))
+    {
+        HANDLE fileMap = CreateFileMappingA(state->PlaybackHandle, 0, PAGE_READONLY, 0, 0, 0);
+        if (fileMap)
+        {
+            u64 offset = SNAPSHOT_DATA_OFFSET;
+            void *view = MapViewOfFile(fileMap, FILE_MAP_READ, (DWORD)(offset >> 32),
+                                       (DWORD)(offset & 0xFFFFFFFF), (SIZE_T)header->DataSize);
+            if (view)
+            {
+                CopyMemory(memory->PermanentStorage, view, (size_t)header->DataSize);
+                UnmapViewOfFile(view);
+                result = true;
+            }
+            CloseHandle(fileMap);
+        }
+    }
+
+    if (result)
+    {
+        memory->IsInitialized = true;
+        memory->PlayingBack = true;
+    }
+    else
+    {
+        // TODO: Logging
+    }
+
+    return result;
+}
+
+internal void
+Win32EndInputPlayBack(Win32State *state)
+{
+    CloseHandle(state->PlaybackHandle);
+    state->PlaybackHandle = INVALID_HANDLE_VALUE;
+    state->InputPlayingIndex = 0;
+}
+
+// Maps the fuel library read-only; records are used in place, so pages are
+// only read from the file cache as fuels are touched.
+internal b32
+Win32MapFuelLibrary(char *fileName, AppMemory *memory)
+{
+    b32 result = false;
+
+    HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0);
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(file, &fileSize) && (fileSize.QuadPart > 0))
+        {
+            HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+            if (mapping)
+            {
+                void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                if (view)
+                {
+                    memory->FuelLibrary = view;
+                    memory->FuelLibrarySize = fileSize.QuadPart;
+                    result = true;
+                }
+
+                // NOTE: The view keeps its own reference to the mapping and the file.
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+    }
+
+    return result;
+}
+
+// NOTE: The context of the pool worker (or of the main thread) running on
+// this thread, so entries run by AddEntry and CompleteAllWork on the caller's
+// thread get the caller's context.
+global thread_local ThreadContext *Win32CurrentThread;
+global ThreadContext Win32MainThread;
+
+// Takes and runs one entry; false if the queue was empty.
+internal b32
+Win32DoNextWorkQueueEntry(PlatformWorkQueue *queue)
+{
+    u64 position = queue->NextEntryToRead.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Win32WorkQueueEntry *entry = queue->Entries + (position & (WIN32_WORK_QUEUE_SIZE - 1));
+        u64 sequence = entry->Sequence.load(std::memory_order_acquire);
+        i64 difference = (i64)(sequence - (position + 1));
+        if (difference == 0)
+        {
+            if (queue->NextEntryToRead.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                PlatformWorkQueueCallback *callback = entry->Callback;
+                void *data = entry->Data;
+                entry->Sequence.store(position + WIN32_WORK_QUEUE_SIZE, std::memory_order_release);
+
+                ThreadContext *thread = Win32CurrentThread ? Win32CurrentThread : &Win32MainThread;
+                callback(thread, queue, data);
+                ++queue->CompletionCount;
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            return false;
+        }
+        else
+        {
+            position = queue->NextEntryToRead.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+internal PLATFORM_ADD_ENTRY(Win32AddEntry)
+{
+    ++queue->CompletionGoal;
+
+    u64 position = queue->NextEntryToWrite.load(std::memory_order_relaxed);
+    Win32WorkQueueEntry *entry;
+    for (;;)
+    {
+        entry = queue->Entries + (position & (WIN32_WORK_QUEUE_SIZE - 1));
+        u64 sequence = entry->Sequence.load(std::memory_order_acquire);
+        i64 difference = (i64)(sequence - position);
+        if (difference == 0)
+        {
+            if (queue->NextEntryToWrite.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            // NOTE: Full; make room by doing an entry here rather than wait.
+            Win32DoNextWorkQueueEntry(queue);
+            position = queue->NextEntryToWrite.load(std::memory_order_relaxed);
+        }
+        else
+        {
+            position = queue->NextEntryToWrite.load(std::memory_order_relaxed);
+        }
+    }
+
+    entry->Callback = callback;
+    entry->Data = data;
+    entry->Sequence.store(position + 1, std::memory_order_release);
+
+    ReleaseSemaphore(queue->SemaphoreHandle, 1, 0);
+}
+
+internal PLATFORM_COMPLETE_ALL_WORK(Win32CompleteAllWork)
+{
+    for (;;)
+    {
+        // NOTE: Count first, see LinuxCompleteAllWork.
+        u64 count = queue->CompletionCount;
+        if (count == queue->CompletionGoal)
+        {
+            break;
+        }
+        if (!Win32DoNextWorkQueueEntry(queue))
+        {
+            _mm_pause();
+        }
+    }
+}
+
+DWORD WINAPI
+Win32WorkerThreadProc(LPVOID parameter)
+{
+    auto startup = (Win32WorkerStartup *)parameter;
+    Win32CurrentThread = &startup->Context;
+
+    PlatformWorkQueue *queue = startup->Queue;
+    for (;;)
+    {
+        if (!Win32DoNextWorkQueueEntry(queue))
+        {
+            WaitForSingleObjectEx(queue->SemaphoreHandle, INFINITE, FALSE);
+        }
+    }
+}
+
+// Starts up to workerCount workers; the main thread works in CompleteAllWork.
+// Returns the number of threads running entries, main included, 0 on failure.
+internal u32
+Win32MakeWorkQueue(PlatformWorkQueue *queue, Win32WorkerStartup *startups, u32 workerCount)
+{
+    queue->NextEntryToWrite = 0;
+    queue->NextEntryToRead = 0;
+    queue->CompletionGoal = 0;
+    queue->CompletionCount = 0;
+    for (u32 index = 0; index < WIN32_WORK_QUEUE_SIZE; ++index)
+    {
+        queue->Entries[index].Sequence = index;
+    }
+    queue->SemaphoreHandle = CreateSemaphoreEx(0, 0, WIN32_WORK_QUEUE_SIZE + WIN32_MAX_WORKER_THREADS, 0, 0,
+                                               SEMAPHORE_ALL_ACCESS);
+    if (!queue->SemaphoreHandle)
+    {
+        return 0;
+    }
+
+    Win32CurrentThread = &Win32MainThread;
+    u32 result = 1;
+    for (u32 workerIndex = 0; workerIndex < workerCount; ++workerIndex)
+    {
+        Win32WorkerStartup *startup = startups + workerIndex;
+        startup->Context.ThreadIndex = workerIndex + 1;
+        startup->Queue = queue;
+
+        HANDLE threadHandle = CreateThread(0, 0, Win32WorkerThreadProc, startup, 0, 0);
+        if (!threadHandle)
+        {
+            // NOTE: Entries still get done by whoever waits for them.
+            break;
+        }
+        CloseHandle(threadHandle);
+        ++result;
+    }
+
+    return result;
+}
+
+int main(int argc, char **argv)
 {
     Win32State win32State = {};
     Win32GetEXEFileName(&win32State);
@@ -176,8 +616,193 @@ int main()
     Win32BuildEXEPathFileName(&win32State, "ss_temp.dll",
                               sizeof(tempAppCodeDLLFullPath), tempAppCodeDLLFullPath);
 
+    win32State.RecordingHandle = INVALID_HANDLE_VALUE;
+    win32State.PlaybackHandle = INVALID_HANDLE_VALUE;
+
+    i32 recordIndex = 0;
+    i32 playIndex = 0;
+    u32 reportFormat = ReportFormat_Table;
+    b32 reportSweep = false;
+    u32 mathMode = EDITOR_FAST_MATH ? MathMode_Fast : MathMode_Reference;
+    char *fuelLibraryFileName = 0;
+    b32 watch = false;
+    for (int argIndex = 1; argIndex < argc; ++argIndex)
+    {
+        if (strcmp(argv[argIndex], "-watch") == 0)
+        {
+            watch = true;
+        }
+        else if ((strcmp(argv[argIndex], "-record") == 0) && (argIndex + 1 < argc))
+        {
+            recordIndex = atoi(argv[++argIndex]);
+        }
+        else if ((strcmp(argv[argIndex], "-play") == 0) && (argIndex + 1 < argc))
+        {
+            playIndex = atoi(argv[++argIndex]);
+        }
+        else if ((strcmp(argv[argIndex], "-format") == 0) && (argIndex + 1 < argc))
+        {
+            char *format = argv[++argIndex];
+            if (strcmp(format, "csv") == 0)
+            {
+                reportFormat = ReportFormat_CSV;
+            }
+            else if (strcmp(format, "binary") == 0)
+            {
+                reportFormat = ReportFormat_Binary;
+            }
+            else
+            {
+                reportFormat = ReportFormat_Table;
+            }
+        }
+        else if (strcmp(argv[argIndex], "-rows") == 0)
+        {
+            reportSweep = true;
+        }
+        else if ((strcmp(argv[argIndex], "-math") == 0) && (argIndex + 1 < argc))
+        {
+            char *mode = argv[++argIndex];
+            mathMode = (strcmp(mode, "fast") == 0) ? MathMode_Fast : MathMode_Reference;
+        }
+        else if ((strcmp(argv[argIndex], "-fuels") == 0) && (argIndex + 1 < argc))
+        {
+            fuelLibraryFileName = argv[++argIndex];
+        }
+    }
+
+#if EDITOR_INTERNAL
+    LPVOID baseAddress = (LPVOID)Terabytes(2);
+#else
+    LPVOID baseAddress = 0;
+#endif
+
+    // NOTE: A snapshot stores raw pointers, so the block has to live where
+    // it lived when the snapshot was recorded.
+    SnapshotHeader snapshotHeader = {};
+    if (playIndex)
+    {
+        if (!Win32OpenSnapshot(&win32State, playIndex, &snapshotHeader))
+        {
+            return 1;
+        }
+        baseAddress = (LPVOID)snapshotHeader.BaseAddress;
+    }
+
+    AppMemory appMemory = {};
+    appMemory.PermanentStorageSize = Megabytes(64);
+    appMemory.TransientStorageSize = Gigabytes(1);
+    appMemory.ReportFormat = reportFormat;
+    appMemory.ReportSweep = reportSweep;
+    appMemory.MathMode = mathMode;
+
+    // NOTE: Without -fuels the library next to the executable is optional.
+    if (fuelLibraryFileName)
+    {
+        if (!Win32MapFuelLibrary(fuelLibraryFileName, &appMemory))
+        {
+            fprintf(stderr, "Unable to map fuel library %s\n", fuelLibraryFileName);
+            return 1;
+        }
+    }
+    else
+    {
+        char defaultFuelLibraryFileName[WIN32_STATE_FILE_NAME_COUNT];
+        Win32BuildEXEPathFileName(&win32State, "fuels.ssf",
+                                  sizeof(defaultFuelLibraryFileName), defaultFuelLibraryFileName);
+        Win32MapFuelLibrary(defaultFuelLibraryFileName, &appMemory);
+    }
+    if (reportFormat == ReportFormat_Binary)
+    {
+        // NOTE: Otherwise the CRT turns every 0x0A byte of the records into CR LF.
+        _setmode(_fileno(stdout), _O_BINARY);
+    }
+
+    win32State.TotalSize = appMemory.PermanentStorageSize + appMemory.TransientStorageSize;
+    win32State.AppMemoryBlock = Win32AllocateMemoryBlock(baseAddress, win32State.TotalSize, &appMemory.LargePages);
+    if (!win32State.AppMemoryBlock)
+    {
+        // TODO: Logging
+        return 1;
+    }
+
+    appMemory.PermanentStorage = win32State.AppMemoryBlock;
+    appMemory.TransientStorage = ((u8 *)appMemory.PermanentStorage + appMemory.PermanentStorageSize);
+
+    if (win32State.InputPlayingIndex)
+    {
+        if (!Win32BeginInputPlayBack(&win32State, &appMemory, &snapshotHeader))
+        {
+            return 1;
+        }
+        Win32EndInputPlayBack(&win32State);
+    }
+
+    if (recordIndex)
+    {
+        Win32BeginRecordingInput(&win32State, recordIndex);
+    }
+
+#if EDITOR_PROFILE
+    // NOTE: Static, so a code reload does not lose it; zero until the first timed block.
+    local DebugCounterTable debugTable;
+    debugTable.Generation = 1;
+    appMemory.DebugTable = &debugTable;
+#endif
+
+    // NOTE: Created once; the pool and its threads outlive the loaded code.
+    local PlatformWorkQueue workQueue;
+    local Win32WorkerStartup workerStartups[WIN32_MAX_WORKER_THREADS];
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    u32 workerCount = (u32)LimitI((i64)systemInfo.dwNumberOfProcessors - 1, 0, WIN32_MAX_WORKER_THREADS);
+    u32 poolThreadCount = Win32MakeWorkQueue(&workQueue, workerStartups, workerCount);
+    if (poolThreadCount)
+    {
+        appMemory.Platform.WorkQueue = &workQueue;
+        appMemory.Platform.ThreadCount = poolThreadCount;
+        appMemory.Platform.AddEntry = Win32AddEntry;
+        appMemory.Platform.CompleteAllWork = Win32CompleteAllWork;
+    }
+
+    ThreadContext *thread = &Win32MainThread;
+
     auto app = Win32LoadAppCode(sourceAppCodeDLLFullPath, tempAppCodeDLLFullPath);
+    appMemory.CodeIdentity = app.CodeIdentity;
+
+    app.Calculate(thread, &appMemory);
+#if EDITOR_PROFILE
+    ReportDebugCounters(appMemory.DebugTable, stderr);
+#endif
+    if (win32State.InputRecordingIndex)
+    {
+        Win32RecordSnapshot(&win32State, &appMemory);
+    }
+
+    if (watch)
+    {
+        while (Win32WaitForAppCodeChange(sourceAppCodeDLLFullPath, app.DLLLastWriteTime))
+        {
+            Win32UnloadAppCode(&app);
+            app = Win32LoadAppCode(sourceAppCodeDLLFullPath, tempAppCodeDLLFullPath);
+            appMemory.CodeIdentity = app.CodeIdentity;
+
+            app.Calculate(thread, &appMemory);
+#if EDITOR_PROFILE
+            ReportDebugCounters(appMemory.DebugTable, stderr);
+#endif
+            if (win32State.InputRecordingIndex)
+            {
+                Win32RecordSnapshot(&win32State, &appMemory);
+            }
+            fflush(stdout);
+        }
+    }
+
+    if (win32State.InputRecordingIndex)
+    {
+        Win32EndRecordingInput(&win32State);
+    }
 
-    app.Calculate();
     return 0;
 }
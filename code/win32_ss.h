@@ -30,8 +30,39 @@ struct Win32AppCode
 {
     HMODULE AppCodeDLL;
     FILETIME DLLLastWriteTime;
+    u64 CodeIdentity; // DLLLastWriteTime as one number
 
     CalculateType *Calculate;
 
     b32 IsValid;
-};
\ No newline at end of file
+};
+
+// NOTE: Same bounded MPMC ring as on Linux (see linux_ss.h).
+#define WIN32_WORK_QUEUE_SIZE 256 // NOTE: Must be a power of two
+#define WIN32_MAX_WORKER_THREADS 63
+
+struct Win32WorkQueueEntry
+{
+    std::atomic<u64> Sequence;
+    PlatformWorkQueueCallback *Callback;
+    void *Data;
+};
+
+struct PlatformWorkQueue
+{
+    alignas(64) std::atomic<u64> NextEntryToWrite;
+    alignas(64) std::atomic<u64> NextEntryToRead;
+
+    alignas(64) std::atomic<u64> CompletionGoal;
+    std::atomic<u64> CompletionCount;
+
+    HANDLE SemaphoreHandle;
+
+    Win32WorkQueueEntry Entries[WIN32_WORK_QUEUE_SIZE];
+};
+
+struct Win32WorkerStartup
+{
+    ThreadContext Context;
+    PlatformWorkQueue *Queue;
+};